@@ -0,0 +1,48 @@
+// Microbenchmark for vector/color/matrix argument marshalling (no GL needed).
+//
+// Runs the same call with each supported input form and prints ns/call, so
+// Array and object inputs can be compared with the Float32Array fast path.
+// Run with: qjsm bench-input.js [iterations]
+
+import { LerpRGBA, RGBA, Transform, TransformPoint } from 'nanovg';
+
+const N = +(scriptArgs[1] ?? 200000);
+
+function bench(name, fn) {
+  for(let i = 0; i < 1000; i++) fn(i); // warm-up
+  const t0 = Date.now();
+  for(let i = 0; i < N; i++) fn(i);
+  const ns = ((Date.now() - t0) * 1e6) / N;
+  console.log(`${name.padEnd(36)} ${ns.toFixed(1).padStart(8)} ns/call`);
+}
+
+const out = new Float32Array(2);
+const trf = Transform.Translate(10, 20);
+
+const forms = {
+  Float32Array: {
+    color: new Float32Array([1, 0, 0, 1]),
+    point: new Float32Array([1, 2]),
+    matrix: new Float32Array([1, 0, 0, 1, 10, 20]),
+  },
+  Array: {
+    color: [1, 0, 0, 1],
+    point: [1, 2],
+    matrix: [1, 0, 0, 1, 10, 20],
+  },
+  object: {
+    color: { r: 1, g: 0, b: 0, a: 1 },
+    point: { x: 1, y: 2 },
+    matrix: { a: 1, b: 0, c: 0, d: 1, e: 10, f: 20 },
+  },
+};
+
+const other = RGBA(0, 0, 255, 255);
+
+bench('LerpRGBA(Color, Color)', i => LerpRGBA(other, other, 0.5));
+
+for(const [form, v] of Object.entries(forms)) {
+  bench(`LerpRGBA(${form}, Color)`, i => LerpRGBA(v.color, other, 0.5));
+  bench(`TransformPoint(out, trf, ${form})`, i => TransformPoint(out, trf, v.point));
+  bench(`TransformPoint(out, ${form}, x, y)`, i => TransformPoint(out, v.matrix, 1, 2));
+}
@@ -0,0 +1,112 @@
+// Frame-time benchmark of the CPU renderer (CreateSoftware) against a GL
+// context on the Mesa software rasterizer (CreateHeadless on llvmpipe).
+//
+// Both draw the same chart-like scene (grid, filled area, polyline, candles)
+// for a number of frames and print ms/frame. Each GL frame ends with a
+// ReadPixels so that both sides include getting the pixels into memory.
+// Run with: LIBGL_ALWAYS_SOFTWARE=1 qjsm bench-software.js [frames] [width] [height]
+
+import { ANTIALIAS, CreateHeadless, CreateSoftware, DeleteHeadless, DeleteSoftware, RGB, RGBA } from 'nanovg';
+
+const FRAMES = +(scriptArgs[1] ?? 200);
+const W = +(scriptArgs[2] ?? 1024);
+const H = +(scriptArgs[3] ?? 640);
+const N = 240; // samples / candles
+
+const COL = {
+  bg: RGB(18, 22, 30),
+  grid: RGBA(255, 255, 255, 18),
+  area: RGBA(38, 166, 154, 60),
+  line: RGB(245, 200, 70),
+  bull: RGB(38, 166, 154),
+  bear: RGB(239, 83, 80),
+};
+
+// Deterministic random walk so both backends draw identical frames
+let seed = 1;
+const random = () => ((seed = (seed * 1103515245 + 12345) & 0x7fffffff) / 0x7fffffff);
+const data = [];
+
+for(let i = 0, v = H / 2; i < N + FRAMES; i++) data.push((v += (random() - 0.5) * 12));
+
+function scene(nvg, frame) {
+  const step = W / N;
+  const y = i => data[frame + i];
+
+  nvg.BeginFrame(W, H, 1);
+
+  nvg.BeginPath();
+  nvg.Rect(0, 0, W, H);
+  nvg.FillColor(COL.bg);
+  nvg.Fill();
+
+  nvg.BeginPath();
+  for(let x = 0.5; x < W; x += 64) nvg.MoveTo(x, 0), nvg.LineTo(x, H);
+  for(let v = 0.5; v < H; v += 48) nvg.MoveTo(0, v), nvg.LineTo(W, v);
+  nvg.StrokeColor(COL.grid);
+  nvg.StrokeWidth(1);
+  nvg.Stroke();
+
+  nvg.BeginPath();
+  nvg.MoveTo(0, H);
+  for(let i = 0; i < N; i++) nvg.LineTo(i * step, y(i));
+  nvg.LineTo((N - 1) * step, H);
+  nvg.FillColor(COL.area);
+  nvg.Fill();
+
+  nvg.BeginPath();
+  nvg.MoveTo(0, y(0));
+  for(let i = 1; i < N; i++) nvg.LineTo(i * step, y(i));
+  nvg.StrokeColor(COL.line);
+  nvg.StrokeWidth(1.5);
+  nvg.Stroke();
+
+  for(let i = 1; i < N; i++) {
+    const open = y(i - 1) + 40, close = y(i) + 40;
+    const color = close < open ? COL.bull : COL.bear;
+
+    nvg.BeginPath();
+    nvg.MoveTo(i * step + step / 2, Math.min(open, close) - 6);
+    nvg.LineTo(i * step + step / 2, Math.max(open, close) + 6);
+    nvg.StrokeColor(color);
+    nvg.StrokeWidth(1);
+    nvg.Stroke();
+
+    nvg.BeginPath();
+    nvg.Rect(i * step + 1, Math.min(open, close), step - 2, Math.max(Math.abs(close - open), 1));
+    nvg.FillColor(color);
+    nvg.Fill();
+  }
+
+  nvg.EndFrame();
+}
+
+function bench(name, nvg, finish) {
+  for(let i = 0; i < 5; i++) scene(nvg, 0), finish(); // warm-up
+  const t0 = Date.now();
+  for(let i = 0; i < FRAMES; i++) scene(nvg, i), finish();
+  const ms = (Date.now() - t0) / FRAMES;
+  console.log(`${name.padEnd(36)} ${ms.toFixed(2).padStart(8)} ms/frame`);
+  return ms;
+}
+
+console.log(`${FRAMES} frames at ${W}x${H}`);
+
+const sw = CreateSoftware(W, H, ANTIALIAS);
+const cpu = bench('CreateSoftware', sw, () => {});
+DeleteSoftware(sw);
+
+let hl;
+
+try {
+  hl = CreateHeadless(W, H, ANTIALIAS);
+} catch(e) {
+  console.log(`CreateHeadless unavailable: ${e.message}`);
+}
+
+if(hl) {
+  const target = new Uint8Array(W * H * 4);
+  const gl = bench(`CreateHeadless (${hl.backend})`, hl.context, () => hl.ReadPixels(target));
+  DeleteHeadless(hl);
+  console.log(`speedup ${(gl / cpu).toFixed(2)}x`);
+}
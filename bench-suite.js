@@ -0,0 +1,426 @@
+// Benchmark suite: argument marshalling microbenchmarks and scene frame times,
+// written as JSON so that builds can be compared.
+//
+// The microbenchmarks call the same functions with every input form the
+// bindings accept (scalar arguments, Float32Array, Array, {x, y} style
+// objects and other iterables) and report ns/call and ops/sec. The scenes are
+// modelled on test-graph.js (candle chart), curve-editor.js (bezier paths with
+// handles) and a text-heavy layout; they report ms/frame and percentiles of
+// Context.stats frame/flush times (and GPU times where timer queries exist).
+//
+// Draws into CreateHeadless(), or CreateSoftware() with --software or when no
+// headless GL is available. The text scene is skipped without a DejaVu font.
+// Run with: LIBGL_ALWAYS_SOFTWARE=1 qjsm bench-suite.js [--quick] [--software] [--frames N] [--out file]
+// or `make bench` in the build directory (writes bench.json).
+
+import * as std from 'std';
+import {
+  ALIGN_LEFT,
+  ALIGN_MIDDLE,
+  ALIGN_TOP,
+  ANTIALIAS,
+  CreateHeadless,
+  CreateSoftware,
+  DeleteHeadless,
+  DeleteSoftware,
+  RGB,
+  RGBA,
+  STAT_CALLS,
+  STAT_DRAWS,
+  STAT_FLUSH_MS,
+  STAT_FRAME_MS,
+  STAT_TRIANGLES,
+  STENCIL_STROKES,
+  Transform,
+  TransformPoint,
+} from 'nanovg';
+
+const opts = { quick: false, software: false, frames: 300, out: null, width: 1024, height: 640 };
+
+for(let i = 1; i < scriptArgs.length; i++) {
+  const arg = scriptArgs[i];
+  if(arg == '--quick') opts.quick = true;
+  else if(arg == '--software') opts.software = true;
+  else if(arg == '--frames') opts.frames = +scriptArgs[++i];
+  else if(arg == '--out') opts.out = scriptArgs[++i];
+  else if(arg == '--size') [opts.width, opts.height] = scriptArgs[++i].split('x').map(Number);
+  else throw new Error(`unknown argument: ${arg}`);
+}
+
+if(opts.quick) opts.frames = Math.min(opts.frames, 60);
+
+const W = opts.width, H = opts.height;
+const MIN_MS = opts.quick ? 40 : 250; // minimum run time of a microbenchmark
+
+// ---- Context -----------------------------------------------------------------
+
+let hl, nvg, backend, finish;
+
+if(!opts.software) {
+  try {
+    hl = CreateHeadless(W, H, ANTIALIAS | STENCIL_STROKES);
+  } catch(e) {
+    console.log(`CreateHeadless unavailable: ${e.message}`);
+  }
+}
+
+if(hl) {
+  const target = new Uint8Array(W * H * 4);
+  nvg = hl.context;
+  backend = `headless (${hl.backend})`;
+  // Read back so that frames include the GPU work, as in bench-software.js
+  finish = () => hl.ReadPixels(target);
+} else {
+  nvg = CreateSoftware(W, H, ANTIALIAS);
+  backend = 'software';
+  finish = () => {};
+}
+
+function loadFont() {
+  for(let path of ['/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf', '/usr/share/fonts/TTF/DejaVuSans.ttf', '/usr/share/fonts/dejavu/DejaVuSans.ttf']) {
+    if(nvg.CreateFont('sans', path) >= 0) return true;
+  }
+  return false;
+}
+
+const hasText = loadFont();
+
+// Deterministic random numbers so that runs draw identical frames
+let seed = 1;
+const random = () => (seed = (seed * 1103515245 + 12345) & 0x7fffffff) / 0x7fffffff;
+
+// ---- Microbenchmarks -----------------------------------------------------------
+
+const micro = [];
+
+// Runs fn in batches of 1000 calls until MIN_MS have passed
+function bench(name, form, fn) {
+  for(let i = 0; i < 1000; i++) fn(i); // warm-up
+  let calls = 0, ms;
+  const t0 = Date.now();
+  do {
+    for(let i = 0; i < 1000; i++) fn(i);
+    calls += 1000;
+  } while((ms = Date.now() - t0) < MIN_MS);
+  const ns = (ms * 1e6) / calls;
+  micro.push({ name, form, calls, ns_per_call: +ns.toFixed(2), ops_per_sec: Math.round(1e9 / ns) });
+  console.log(`${`${name} [${form}]`.padEnd(44)} ${ns.toFixed(1).padStart(8)} ns/call`);
+}
+
+// A user-defined vector type: neither an Array nor carrying the named keys,
+// so the bindings read it through Symbol.iterator
+class Vec {
+  constructor(...v) {
+    this.v = v;
+  }
+  [Symbol.iterator]() {
+    return this.v.values();
+  }
+}
+
+const forms = {
+  Float32Array: {
+    color: new Float32Array([1, 0, 0, 1]),
+    point: new Float32Array([1, 2]),
+    matrix: new Float32Array([1, 0, 0, 1, 10, 20]),
+  },
+  Array: {
+    color: [1, 0, 0, 1],
+    point: [1, 2],
+    matrix: [1, 0, 0, 1, 10, 20],
+  },
+  object: {
+    color: { r: 1, g: 0, b: 0, a: 1 },
+    point: { x: 1, y: 2 },
+    matrix: { a: 1, b: 0, c: 0, d: 1, e: 10, f: 20 },
+  },
+  iterable: {
+    color: new Vec(1, 0, 0, 1),
+    point: new Vec(1, 2),
+    matrix: new Vec(1, 0, 0, 1, 10, 20),
+  },
+};
+
+const out = new Float32Array(2);
+const trf = Transform.Translate(10, 20);
+const acc = Transform.Identity();
+const pts = new Float32Array(64 * 2).map((_, i) => (i & 1 ? random() * H : (i >> 1) * 16));
+
+// Context calls happen inside a frame; paths and transforms are reset now and
+// then so that they do not grow without bound
+nvg.BeginFrame(W, H, 1);
+
+bench('MoveTo(x, y)', 'scalar', i => (i & 1023 || nvg.BeginPath(), nvg.MoveTo(i, 1)));
+bench('Rect(x, y, w, h)', 'scalar', i => (i & 1023 || nvg.BeginPath(), nvg.Rect(i, 1, 2, 3)));
+bench('StrokeWidth(w)', 'scalar', i => nvg.StrokeWidth(1));
+bench('Translate(x, y)', 'scalar', i => (i & 1023 || nvg.ResetTransform(), nvg.Translate(1, 2)));
+bench('Transform(a, b, c, d, e, f)', 'scalar', i => (i & 1023 || nvg.ResetTransform(), nvg.Transform(1, 0, 0, 1, 1, 2)));
+bench('TransformPoint(out, trf, x, y)', 'scalar', i => TransformPoint(out, trf, 1, 2));
+bench('Transform#Translate(x, y)', 'scalar', i => acc.Translate(1, 2));
+
+for(const [form, v] of Object.entries(forms)) {
+  bench('FillColor(color)', form, i => nvg.FillColor(v.color));
+  bench('TransformPoint(out, trf, point)', form, i => TransformPoint(out, trf, v.point));
+  bench('TransformPoint(out, matrix, x, y)', form, i => TransformPoint(out, v.matrix, 1, 2));
+  bench('Transform(matrix)', form, i => (i & 1023 || nvg.ResetTransform(), nvg.Transform(v.matrix)));
+  bench('Transform#Translate(point)', form, i => acc.Translate(v.point));
+}
+
+bench('Polyline(64 points)', 'Float32Array', i => (nvg.BeginPath(), nvg.Polyline(pts)));
+
+nvg.CancelFrame();
+
+// ---- Scenes ----------------------------------------------------------------------
+
+const COL = {
+  bg: RGB(18, 22, 30),
+  grid: RGBA(255, 255, 255, 18),
+  line: RGB(245, 200, 70),
+  bull: RGB(38, 166, 154),
+  bear: RGB(239, 83, 80),
+  text: RGB(200, 205, 215),
+  handle: RGB(40, 90, 160),
+  ctrl: RGB(200, 140, 70),
+  ctrlLine: RGB(120, 125, 135),
+  outline: RGB(230, 235, 240),
+  panel: RGBA(40, 46, 58, 230),
+};
+
+function text(x, y, str, size = 13, color = COL.text) {
+  nvg.FontFace('sans');
+  nvg.FontSize(size);
+  nvg.FillColor(color);
+  nvg.TextAlign(ALIGN_LEFT | ALIGN_MIDDLE);
+  nvg.Text(x, y, str);
+}
+
+function background() {
+  nvg.BeginPath();
+  nvg.Rect(0, 0, W, H);
+  nvg.FillColor(COL.bg);
+  nvg.Fill();
+}
+
+// test-graph.js: grid, candles with wicks, close line and price labels
+const CANDLES = 160;
+const candles = [];
+
+for(let i = 0, price = 1.1; i < CANDLES + opts.frames + 16; i++) {
+  const open = price;
+  let high = price, low = price;
+  for(let t = 0; t < 20; t++) {
+    price += (random() - 0.5) * 0.0004;
+    high = Math.max(high, price);
+    low = Math.min(low, price);
+  }
+  candles.push({ open, high, low, close: price });
+}
+
+function chart(frame) {
+  const view = candles.slice(frame, frame + CANDLES);
+  const lo = Math.min(...view.map(c => c.low)), hi = Math.max(...view.map(c => c.high));
+  const pad = 60, cw = (W - pad) / CANDLES;
+  const y = p => H - 20 - ((p - lo) / (hi - lo)) * (H - 40);
+
+  background();
+
+  nvg.BeginPath();
+  for(let x = 0.5; x < W - pad; x += 64) nvg.MoveTo(x, 0), nvg.LineTo(x, H);
+  for(let v = 0.5; v < H; v += 48) nvg.MoveTo(0, v), nvg.LineTo(W - pad, v);
+  nvg.StrokeColor(COL.grid);
+  nvg.StrokeWidth(1);
+  nvg.Stroke();
+
+  for(let i = 0; i < view.length; i++) {
+    const c = view[i], x = i * cw;
+    const color = c.close >= c.open ? COL.bull : COL.bear;
+    const top = y(Math.max(c.open, c.close)), bottom = y(Math.min(c.open, c.close));
+
+    nvg.BeginPath();
+    nvg.MoveTo(x + cw / 2, y(c.high));
+    nvg.LineTo(x + cw / 2, y(c.low));
+    nvg.StrokeColor(color);
+    nvg.Stroke();
+
+    nvg.BeginPath();
+    nvg.Rect(x + 1, top, cw - 2, Math.max(bottom - top, 1));
+    nvg.FillColor(color);
+    nvg.Fill();
+  }
+
+  nvg.BeginPath();
+  nvg.MoveTo(cw / 2, y(view[0].close));
+  for(let i = 1; i < view.length; i++) nvg.LineTo(i * cw + cw / 2, y(view[i].close));
+  nvg.StrokeColor(COL.line);
+  nvg.StrokeWidth(1.5);
+  nvg.Stroke();
+
+  if(hasText)
+    for(let v = 24; v < H; v += 48) text(W - pad + 6, v, (lo + ((H - 20 - v) / (H - 40)) * (hi - lo)).toFixed(5), 12);
+}
+
+// curve-editor.js: cubic and quadratic paths, control polygons and handles
+const CURVES = 12, ANCHORS = 10;
+const curves = [];
+
+for(let c = 0; c < CURVES; c++) {
+  const p = [];
+  for(let i = 0; i < ANCHORS; i++) p.push({ x: (i + 0.5) * (W / ANCHORS), y: random() * H, dx: random() * 80 - 40, dy: random() * 80 - 40 });
+  curves.push({ cubic: c % 3 != 0, pts: p });
+}
+
+function curveEditor(frame) {
+  const t = frame / 30;
+
+  background();
+
+  for(const { cubic, pts } of curves) {
+    const ctl = pts.map(({ x, y, dx, dy }) => ({ x: x + dx * Math.cos(t), y: y + dy * Math.sin(t) }));
+
+    nvg.BeginPath();
+    nvg.MoveTo(pts[0].x, pts[0].y);
+    for(let i = 1; i < pts.length; i++) {
+      const b = pts[i];
+      if(cubic) nvg.BezierTo(ctl[i - 1].x, ctl[i - 1].y, ctl[i].x, ctl[i].y, b.x, b.y);
+      else nvg.QuadTo(ctl[i].x, ctl[i].y, b.x, b.y);
+    }
+    nvg.StrokeColor(COL.line);
+    nvg.StrokeWidth(2);
+    nvg.Stroke();
+
+    nvg.BeginPath();
+    for(let i = 1; i < pts.length; i++) {
+      nvg.MoveTo(pts[i - 1].x, pts[i - 1].y);
+      nvg.LineTo(ctl[i].x, ctl[i].y);
+      nvg.LineTo(pts[i].x, pts[i].y);
+    }
+    nvg.StrokeColor(COL.ctrlLine);
+    nvg.StrokeWidth(1);
+    nvg.Stroke();
+
+    for(let i = 0; i < pts.length; i++) {
+      nvg.BeginPath();
+      nvg.Circle(pts[i].x, pts[i].y, 6);
+      nvg.FillColor(COL.handle);
+      nvg.Fill();
+      nvg.StrokeColor(COL.outline);
+      nvg.StrokeWidth(1.5);
+      nvg.Stroke();
+
+      nvg.BeginPath();
+      nvg.Rect(ctl[i].x - 5, ctl[i].y - 5, 10, 10);
+      nvg.FillColor(COL.ctrl);
+      nvg.Fill();
+    }
+  }
+
+  nvg.BeginPath();
+  nvg.RoundedRect(8, 8, 220, 32, 6);
+  nvg.FillColor(COL.panel);
+  nvg.Fill();
+
+  if(hasText) text(20, 24, 'Line   Quad   Cubic   Save', 14);
+}
+
+// Text-heavy layout: a table of numbers and wrapped paragraphs
+const WORDS = 'lorem ipsum dolor sit amet consectetur adipiscing elit sed do eiusmod tempor incididunt ut labore et dolore magna aliqua'.split(' ');
+const paragraphs = [];
+
+for(let i = 0; i < 6; i++) paragraphs.push(Array.from({ length: 60 }, () => WORDS[Math.floor(random() * WORDS.length)]).join(' '));
+
+function textLayout(frame) {
+  const rows = Math.floor((H - 20) / 18), cols = 6, colW = (W / 2 - 20) / cols;
+
+  background();
+
+  nvg.FontFace('sans');
+  nvg.FontSize(13);
+  nvg.FillColor(COL.text);
+  nvg.TextAlign(ALIGN_LEFT | ALIGN_TOP);
+
+  for(let r = 0; r < rows; r++)
+    for(let c = 0; c < cols; c++) nvg.Text(10 + c * colW, 10 + r * 18, ((r * 7919 + c * 104729 + frame) % 100000 / 100).toFixed(2));
+
+  nvg.FontSize(15);
+
+  for(let i = 0, y = 10; i < paragraphs.length; i++, y += (H - 20) / paragraphs.length)
+    nvg.TextBox(W / 2 + 10, y, W / 2 - 20, paragraphs[(i + frame) % paragraphs.length]);
+}
+
+const percentile = (sorted, p) => (sorted.length ? sorted[Math.min(sorted.length - 1, Math.floor((p / 100) * sorted.length))] : null);
+
+function summary(samples) {
+  const sorted = samples.filter(v => v >= 0).sort((a, b) => a - b);
+  const round = v => (v == null ? null : +v.toFixed(3));
+  return sorted.length ? { p50: round(percentile(sorted, 50)), p90: round(percentile(sorted, 90)), p99: round(percentile(sorted, 99)), max: round(sorted[sorted.length - 1]) } : null;
+}
+
+const scenes = [];
+
+function scene(name, draw) {
+  const frame = [], flush = [], gpu = [];
+  let calls = 0, triangles = 0, draws = 0;
+
+  const run = i => {
+    nvg.BeginFrame(W, H, 1);
+    draw(i);
+    nvg.EndFrame();
+    finish();
+  };
+
+  for(let i = 0; i < 10; i++) run(i); // warm-up, fills the font atlas
+
+  const t0 = Date.now();
+
+  for(let i = 0; i < opts.frames; i++) {
+    run(i);
+    frame.push(nvg.stats[STAT_FRAME_MS]);
+    flush.push(nvg.stats[STAT_FLUSH_MS]);
+    calls += nvg.stats[STAT_CALLS];
+    triangles += nvg.stats[STAT_TRIANGLES];
+    draws += nvg.stats[STAT_DRAWS];
+    // collected a few frames late; the history holds the newest first
+    if(nvg.gpuTimeMs && i % 30 == 29) gpu.push(...nvg.gpuTimeMs.slice(0, 30).filter(v => !isNaN(v)));
+  }
+
+  const ms = (Date.now() - t0) / opts.frames;
+  const n = opts.frames;
+
+  scenes.push({
+    name,
+    frames: n,
+    ms_per_frame: +ms.toFixed(3),
+    frame_ms: summary(frame),
+    flush_ms: summary(flush),
+    gpu_ms: summary(gpu),
+    calls_per_frame: Math.round(calls / n),
+    triangles_per_frame: Math.round(triangles / n),
+    draws_per_frame: Math.round(draws / n),
+  });
+
+  const { p50, p99 } = scenes.at(-1).frame_ms ?? {};
+  console.log(`${name.padEnd(44)} ${ms.toFixed(2).padStart(8)} ms/frame (p50 ${p50} ms, p99 ${p99} ms)`);
+}
+
+scene('chart', chart);
+scene('curve-editor', curveEditor);
+
+if(hasText) scene('text-layout', textLayout);
+else console.log('text-layout skipped: no DejaVuSans.ttf');
+
+if(hl) DeleteHeadless(hl);
+else DeleteSoftware(nvg);
+
+// ---- Output --------------------------------------------------------------------
+
+const result = { date: new Date().toISOString(), backend, width: W, height: H, quick: opts.quick, micro, scenes };
+const json = JSON.stringify(result, null, 2);
+
+if(opts.out) {
+  const f = std.open(opts.out, 'w');
+  f.puts(json + '\n');
+  f.close();
+  console.log(`wrote ${opts.out}`);
+} else {
+  console.log(json);
+}
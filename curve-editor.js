@@ -14,7 +14,7 @@
 
 import * as glfw from 'glfw';
 import * as std from 'std';
-import { ALIGN_CENTER, ALIGN_LEFT, ALIGN_MIDDLE, ALIGN_RIGHT, ANTIALIAS, CreateGL3, DeleteGL3, RGB, STENCIL_STROKES } from 'nanovg';
+import { ALIGN_CENTER, ALIGN_LEFT, ALIGN_MIDDLE, ALIGN_RIGHT, ANTIALIAS, CreateGL3, DeleteGL3, RGB, SpatialIndex, STENCIL_STROKES } from 'nanovg';
 
 // glfw.so does not export the mouse-button / action enums, so spell them out.
 // (GLFW_MOUSE_BUTTON_LEFT = 0, GLFW_MOUSE_BUTTON_RIGHT = 1; GLFW_PRESS = 1.)
@@ -111,7 +111,7 @@ function main() {
   const typeBtns = TYPES.map((type, i) => ({ type, x: 16 + i * 84, y: 16, w: 76, h: 34 }));
 
   let mouse = { x: width / 2, y: height / 2 };
-  let drag = null; // { pl, pt, ctrl } currently being dragged
+  let drag = null; // { pl, pt, ctrl, id } currently being dragged
   let active = 0; // path that left-clicks append to / buttons retype
   let savedAt = 0; // timestamp of last save, for on-screen feedback
   let running = true;
@@ -142,20 +142,44 @@ function main() {
     }
   }
 
+  // Every handle in a native spatial index; handles[id] is { pl, pt, ctrl, id }.
+  let handles;
+  let index;
+  const hits = new Int32Array(64);
+
+  // Rebuild after handles were inserted, removed or retyped (ids shift).
+  function reindex() {
+    const xy = [];
+    handles = [];
+    eachHandle((pl, pt, ctrl) => {
+      const o = ctrl ? polylines[pl].pts[pt][ctrl] : polylines[pl].pts[pt];
+      handles.push({ pl, pt, ctrl, id: handles.length });
+      xy.push(o.x, o.y);
+    });
+    index = new SpatialIndex(new Float32Array(xy), 2, HIT_R);
+  }
+  reindex();
+
   // Nearest handle within HIT_R of (mx, my), or null.
   function hitHandle(mx, my, anchorsOnly) {
+    if(!anchorsOnly) {
+      const id = index.Nearest(mx, my, HIT_R);
+      return id < 0 ? null : handles[id];
+    }
+    // Anchors only: pick among the handles around the mouse.
+    const n = Math.min(index.QueryPoint(mx, my, HIT_R, hits), hits.length);
     let best = null;
-    let bestD2 = HIT_R * HIT_R;
-    eachHandle((pl, pt, ctrl) => {
-      const o = ctrl ? polylines[pl].pts[pt][ctrl] : polylines[pl].pts[pt];
-      const dx = o.x - mx;
-      const dy = o.y - my;
-      const d2 = dx * dx + dy * dy;
-      if(d2 <= bestD2) {
+    let bestD2 = Infinity;
+    for(let i = 0; i < n; i++) {
+      const h = handles[hits[i]];
+      if(h.ctrl) continue;
+      const o = ptOf(h);
+      const d2 = (o.x - mx) ** 2 + (o.y - my) ** 2;
+      if(d2 < bestD2 || (d2 === bestD2 && h.id > best.id)) {
         bestD2 = d2;
-        best = { pl, pt, ctrl };
+        best = h;
       }
-    }, anchorsOnly);
+    }
     return best;
   }
 
@@ -183,6 +207,7 @@ function main() {
         const o = ptOf(drag);
         o.x = x;
         o.y = y;
+        index.Update(drag.id, x, y);
       }
     },
     handleMouseButton(button, action) {
@@ -198,6 +223,7 @@ function main() {
         for(const b of typeBtns) {
           if(inRect(mouse, b)) {
             setType(polylines[active], b.type);
+            reindex();
             return;
           }
         }
@@ -209,10 +235,14 @@ function main() {
           const p = polylines[active];
           p.pts.push({ x: mouse.x, y: mouse.y });
           if(p.pts.length >= 2) initSegment(p, p.pts.length - 1);
+          reindex();
         }
       } else if(button === MB_RIGHT) {
         const hit = hitHandle(mouse.x, mouse.y, true); // anchors only
-        if(hit && polylines[hit.pl].pts.length > 2) polylines[hit.pl].pts.splice(hit.pt, 1);
+        if(hit && polylines[hit.pl].pts.length > 2) {
+          polylines[hit.pl].pts.splice(hit.pt, 1);
+          reindex();
+        }
       }
     },
     handleKey(keyCode, scancode, action) {
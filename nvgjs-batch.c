@@ -0,0 +1,445 @@
+#include "nanovg.h"
+#include "nvgjs-batch.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+const unsigned char nvgjs_batch_stride[NVGJS_BATCH_SHAPE_COUNT] = {
+ [NVGJS_BATCH_RECT] = 4,
+ [NVGJS_BATCH_CIRCLE] = 3,
+ [NVGJS_BATCH_ELLIPSE] = 4,
+ [NVGJS_BATCH_ROUNDED_RECT] = 5,
+};
+
+static inline void
+nvgjs_batch_shape(NVGcontext* nvg, int shape, const float* a) {
+  switch(shape) {
+    case NVGJS_BATCH_RECT: nvgRect(nvg, a[0], a[1], a[2], a[3]); break;
+    case NVGJS_BATCH_CIRCLE: nvgCircle(nvg, a[0], a[1], a[2]); break;
+    case NVGJS_BATCH_ELLIPSE: nvgEllipse(nvg, a[0], a[1], a[2], a[3]); break;
+    case NVGJS_BATCH_ROUNDED_RECT: nvgRoundedRect(nvg, a[0], a[1], a[2], a[3], a[4]); break;
+  }
+}
+
+void
+nvgjs_batch_polyline(NVGcontext* nvg, const float* pts, size_t count, int closed) {
+  if(count < 1)
+    return;
+
+  nvgMoveTo(nvg, pts[0], pts[1]);
+
+  for(size_t i = 1; i < count; i++)
+    nvgLineTo(nvg, pts[i * 2], pts[i * 2 + 1]);
+
+  if(closed)
+    nvgClosePath(nvg);
+}
+
+/* Lowest and highest non-NaN value in y[0..n), +/-INFINITY if there is none */
+static void
+nvgjs_batch_minmax(const float* y, size_t n, float* pmin, float* pmax) {
+  float lo = INFINITY, hi = -INFINITY;
+  size_t i = 0;
+
+#ifdef __SSE2__
+  if(n >= 8) {
+    __m128 vlo = _mm_set1_ps(INFINITY), vhi = _mm_set1_ps(-INFINITY);
+    float a[4], b[4];
+
+    /* minps/maxps return the second operand if either is NaN: the
+       accumulator, which never is */
+    for(; i + 4 <= n; i += 4) {
+      __m128 v = _mm_loadu_ps(y + i);
+
+      vlo = _mm_min_ps(v, vlo);
+      vhi = _mm_max_ps(v, vhi);
+    }
+
+    _mm_storeu_ps(a, vlo);
+    _mm_storeu_ps(b, vhi);
+
+    for(int k = 0; k < 4; k++) {
+      lo = a[k] < lo ? a[k] : lo;
+      hi = b[k] > hi ? b[k] : hi;
+    }
+  }
+#endif
+
+  for(; i < n; i++) {
+    if(y[i] < lo)
+      lo = y[i];
+
+    if(y[i] > hi)
+      hi = y[i];
+  }
+
+  *pmin = lo;
+  *pmax = hi;
+}
+
+/* Index of the first value equal to v in y[0..n), n if none */
+static size_t
+nvgjs_batch_find(const float* y, size_t n, float v) {
+  size_t i = 0;
+
+#ifdef __SSE2__
+  __m128 k = _mm_set1_ps(v);
+
+  for(; i + 4 <= n; i += 4) {
+    int mask = _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(y + i), k));
+
+    if(mask)
+      return i + __builtin_ctz(mask);
+  }
+#endif
+
+  for(; i < n; i++)
+    if(y[i] == v)
+      break;
+
+  return i;
+}
+
+/* Sample i of a decimated polyline: packed pairs, or ys[i] at x0 + i * dx */
+static inline void
+nvgjs_batch_sample(const float* pts, const float* ys, double x0, double dx, size_t i, float* x, float* y) {
+  if(pts) {
+    *x = pts[i * 2];
+    *y = pts[i * 2 + 1];
+  } else {
+    *x = x0 + i * dx;
+    *y = ys[i];
+  }
+}
+
+/* Emit the samples first <= a <= b <= last of a column, each once */
+static size_t
+nvgjs_batch_column(NVGcontext* nvg,
+                   size_t n,
+                   const float* pts,
+                   const float* ys,
+                   double x0,
+                   double dx,
+                   size_t first,
+                   size_t a,
+                   size_t b,
+                   size_t last) {
+  const size_t idx[4] = {first, a, b, last};
+  float x, y;
+
+  for(int k = 0; k < 4; k++) {
+    if(k && idx[k] == idx[k - 1])
+      continue;
+
+    nvgjs_batch_sample(pts, ys, x0, dx, idx[k], &x, &y);
+
+    if(n++)
+      nvgLineTo(nvg, x, y);
+    else
+      nvgMoveTo(nvg, x, y);
+  }
+
+  return n;
+}
+
+/* Any transform: columns and extremes are taken on transformed points */
+static size_t
+nvgjs_batch_decimate(NVGcontext* nvg,
+                     const float t[6],
+                     float column,
+                     const float* pts,
+                     const float* ys,
+                     double x0,
+                     double dx,
+                     size_t count) {
+  size_t n = 0, first = SIZE_MAX, last = 0, lo = 0, hi = 0;
+  double col = 0, ylo = 0, yhi = 0;
+
+  for(size_t i = 0; i <= count; i++) {
+    double px = 0, py = 0, c = 0;
+
+    if(i < count) {
+      float x, y;
+
+      nvgjs_batch_sample(pts, ys, x0, dx, i, &x, &y);
+
+      if(isnan(x) || isnan(y))
+        continue;
+
+      px = (double)t[0] * x + (double)t[2] * y + t[4];
+      py = (double)t[1] * x + (double)t[3] * y + t[5];
+      c = floor(px / column);
+
+      if(first != SIZE_MAX && c == col) {
+        last = i;
+
+        if(py < ylo) {
+          ylo = py;
+          lo = i;
+        }
+
+        if(py > yhi) {
+          yhi = py;
+          hi = i;
+        }
+
+        continue;
+      }
+    }
+
+    if(first != SIZE_MAX)
+      n = nvgjs_batch_column(nvg, n, pts, ys, x0, dx, first, lo < hi ? lo : hi, lo < hi ? hi : lo, last);
+
+    first = last = lo = hi = i;
+    ylo = yhi = py;
+    col = c;
+  }
+
+  return n;
+}
+
+/* End of the run of samples from i that share its column, x = X0 + i * S */
+static size_t
+nvgjs_batch_run_end(double X0, double S, double inv, size_t i, size_t count) {
+  double c = floor((X0 + i * S) * inv), steps;
+  size_t j;
+
+  if(S == 0)
+    return count;
+
+  /* estimate where x crosses into the next column, then fix rounding */
+  steps = ((S > 0 ? c + 1 : c) / inv - (X0 + i * S)) / S;
+  j = !(steps < (double)(count - i)) ? count : i + 1 + (size_t)(steps > 0 ? steps : 0);
+
+  while(j > i + 1 && floor((X0 + (j - 1) * S) * inv) != c)
+    j--;
+
+  while(j < count && floor((X0 + j * S) * inv) == c)
+    j++;
+
+  return j;
+}
+
+size_t
+nvgjs_batch_polyline_decimated(NVGcontext* nvg, const float* ys, size_t count, double x0, double dx, float column) {
+  float t[6];
+  double X0, S, inv = 1.0 / column;
+  size_t n = 0;
+
+  nvgCurrentTransform(nvg, t);
+
+  /* rotated or skewed, the columns depend on y */
+  if(t[1] != 0 || t[2] != 0)
+    return nvgjs_batch_decimate(nvg, t, column, 0, ys, x0, dx, count);
+
+  X0 = (double)t[0] * x0 + t[4];
+  S = (double)t[0] * dx;
+
+  /* x is linear in i: find each column's run arithmetically, then reduce
+     its ys; with y scaled alone, its extremes are the transformed ones */
+  for(size_t i = 0, j; i < count; i = j) {
+    const float* y = ys + i;
+    size_t f = 0, l, m;
+    float lo, hi;
+
+    j = nvgjs_batch_run_end(X0, S, inv, i, count);
+    m = j - i;
+
+    while(f < m && isnan(y[f]))
+      f++;
+
+    if(f == m)
+      continue;
+
+    for(l = m - 1; isnan(y[l]); l--)
+      ;
+
+    nvgjs_batch_minmax(y + f, l - f + 1, &lo, &hi);
+
+    size_t a = f + nvgjs_batch_find(y + f, l - f + 1, lo);
+    size_t b = f + nvgjs_batch_find(y + f, l - f + 1, hi);
+
+    n = nvgjs_batch_column(nvg, n, 0, ys, x0, dx, i + f, i + (a < b ? a : b), i + (a < b ? b : a), i + l);
+  }
+
+  return n;
+}
+
+size_t
+nvgjs_batch_polyline_decimated_xy(NVGcontext* nvg, const float* pts, size_t count, float column) {
+  float t[6];
+
+  nvgCurrentTransform(nvg, t);
+  return nvgjs_batch_decimate(nvg, t, column, pts, 0, 0, 0, count);
+}
+
+static inline int
+nvgjs_batch_candle_valid(const float* c) {
+  return !isnan(c[0]) && !isnan(c[1]) && !isnan(c[2]) && !isnan(c[3]);
+}
+
+size_t
+nvgjs_batch_candles(NVGcontext* nvg,
+                    const float* ohlc,
+                    size_t count,
+                    double x0,
+                    double dx,
+                    double y_scale,
+                    double y_offset,
+                    float body_width,
+                    const float bull[4],
+                    const float bear[4]) {
+  const float* colors[2] = {bear, bull};
+  size_t n = 0;
+
+  nvgSave(nvg);
+
+  /* all wicks first, so that no body is crossed by a neighbour's wick */
+  for(int up = 1; up >= 0; up--) {
+    NVGcolor color;
+
+    nvgBeginPath(nvg);
+
+    for(size_t i = 0; i < count; i++) {
+      const float* c = &ohlc[i * 4];
+      float x = x0 + i * dx;
+
+      if(!nvgjs_batch_candle_valid(c) || (c[3] >= c[0]) != up)
+        continue;
+
+      nvgMoveTo(nvg, x, y_offset + c[1] * y_scale);
+      nvgLineTo(nvg, x, y_offset + c[2] * y_scale);
+    }
+
+    memcpy(color.rgba, colors[up], sizeof(color.rgba));
+    nvgStrokeColor(nvg, color);
+    nvgStroke(nvg);
+  }
+
+  for(int up = 1; up >= 0; up--) {
+    NVGcolor color;
+
+    nvgBeginPath(nvg);
+
+    for(size_t i = 0; i < count; i++) {
+      const float* c = &ohlc[i * 4];
+      float yo, yc, top, h;
+
+      if(!nvgjs_batch_candle_valid(c) || (c[3] >= c[0]) != up)
+        continue;
+
+      yo = y_offset + c[0] * y_scale;
+      yc = y_offset + c[3] * y_scale;
+      top = yo < yc ? yo : yc;
+      h = fabsf(yc - yo);
+
+      /* doji: a 1 unit bar centered on the price */
+      if(h < 1) {
+        top -= (1 - h) * 0.5f;
+        h = 1;
+      }
+
+      nvgRect(nvg, x0 + i * dx - body_width * 0.5f, top, body_width, h);
+      n++;
+    }
+
+    memcpy(color.rgba, colors[up], sizeof(color.rgba));
+    nvgFillColor(nvg, color);
+    nvgFill(nvg);
+  }
+
+  nvgRestore(nvg);
+  return n;
+}
+
+void
+nvgjs_batch_shapes(NVGcontext* nvg, int shape, const float* data, size_t count) {
+  const int stride = nvgjs_batch_stride[shape];
+
+  for(size_t i = 0; i < count; i++)
+    nvgjs_batch_shape(nvg, shape, &data[i * stride]);
+}
+
+/* Hash table slots used for color grouping: next power of two >= 2 * count */
+static size_t
+nvgjs_batch_slots(size_t count) {
+  size_t n = 16;
+
+  while(n < count * 2)
+    n *= 2;
+
+  return n;
+}
+
+size_t
+nvgjs_batch_scratch_size(size_t count) {
+  /* next[count] + first[count] + last[count] + table[slots] */
+  return (count * 3 + nvgjs_batch_slots(count)) * sizeof(uint32_t);
+}
+
+static inline uint32_t
+nvgjs_batch_hash(const float color[4]) {
+  uint32_t w[4], h = 2166136261u;
+
+  memcpy(w, color, sizeof(w));
+
+  for(int i = 0; i < 4; i++)
+    h = (h ^ w[i]) * 16777619u;
+
+  return h ^ (h >> 15);
+}
+
+size_t
+nvgjs_batch_shapes_colored(
+ NVGcontext* nvg, int shape, const float* data, const float* colors, size_t count, void* scratch) {
+  const int stride = nvgjs_batch_stride[shape];
+  const size_t slots = nvgjs_batch_slots(count);
+  uint32_t *next = scratch, *first = next + count, *last = first + count, *table = last + count;
+  size_t ngroups = 0;
+
+  /* table holds group index + 1, 0 marks an empty slot */
+  memset(table, 0, slots * sizeof(uint32_t));
+
+  for(size_t i = 0; i < count; i++) {
+    const float* color = &colors[i * 4];
+    size_t slot = nvgjs_batch_hash(color) & (slots - 1);
+    uint32_t g;
+
+    while((g = table[slot])) {
+      if(!memcmp(&colors[first[g - 1] * 4], color, 4 * sizeof(float)))
+        break;
+
+      slot = (slot + 1) & (slots - 1);
+    }
+
+    next[i] = UINT32_MAX;
+
+    if(g) {
+      next[last[g - 1]] = i;
+      last[g - 1] = i;
+    } else {
+      first[ngroups] = last[ngroups] = i;
+      table[slot] = ++ngroups;
+    }
+  }
+
+  for(size_t g = 0; g < ngroups; g++) {
+    NVGcolor color;
+
+    nvgBeginPath(nvg);
+
+    for(uint32_t i = first[g]; i != UINT32_MAX; i = next[i])
+      nvgjs_batch_shape(nvg, shape, &data[i * stride]);
+
+    memcpy(color.rgba, &colors[first[g] * 4], sizeof(color.rgba));
+    nvgFillColor(nvg, color);
+    nvgFill(nvg);
+  }
+
+  return ngroups;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file nvgjs-batch.h
+ */
+#ifndef NVGJS_BATCH_H
+#define NVGJS_BATCH_H
+
+#include <stddef.h>
+
+struct NVGcontext;
+
+/**
+ * @brief Append a polyline sub-path from packed x,y pairs.
+ *
+ * Emits one nvgMoveTo for the first vertex and nvgLineTo for the remaining
+ * ones, optionally closing the sub-path. Nothing is emitted for @p count < 1.
+ *
+ * @param nvg     Target NanoVG context.
+ * @param pts     Vertex data, 2 floats (x, y) per vertex.
+ * @param count   Number of vertices.
+ * @param closed  Non-zero to close the sub-path (nvgClosePath).
+ */
+void nvgjs_batch_polyline(struct NVGcontext*, const float* pts, size_t count, int closed);
+
+/**
+ * @brief Append a polyline through (x0 + i * dx, ys[i]), reduced to at most
+ * 4 vertices per pixel column.
+ *
+ * Columns are @p column units wide along the x axis of the current
+ * transform (the units of nvgBeginFrame()'s width). Each keeps its first,
+ * lowest, highest and last sample, in sample order, so the line covers the
+ * same pixels as the full-resolution one. NaN samples are skipped.
+ *
+ * @return Number of vertices emitted.
+ */
+size_t nvgjs_batch_polyline_decimated(
+ struct NVGcontext*, const float* ys, size_t count, double x0, double dx, float column);
+
+/**
+ * @brief nvgjs_batch_polyline_decimated() for packed x,y pairs. The points
+ * should be ordered along x; a column is closed whenever the next point
+ * falls into another one.
+ */
+size_t nvgjs_batch_polyline_decimated_xy(struct NVGcontext*, const float* pts, size_t count, float column);
+
+/**
+ * @brief Draw OHLC candles: wicks from high to low stroked, bodies from
+ * open to close filled, one pass per color.
+ *
+ * Candle i is centered on x0 + i * dx, prices map to y_offset + price *
+ * y_scale. Candles closing at or above their open are @p bull, the rest
+ * @p bear. Bodies are at least 1 unit tall. Candles with a NaN value are
+ * skipped. Replaces the current path; fill and stroke color are restored,
+ * the wicks use the current stroke width. The mapping is evaluated in
+ * double precision, as price ranges are often narrow next to the prices.
+ *
+ * @param ohlc   4 floats per candle: open, high, low, close.
+ * @param bull   Color as 4 floats (r, g, b, a in 0..1).
+ * @param bear   Same.
+ * @return Number of candles drawn.
+ */
+size_t nvgjs_batch_candles(struct NVGcontext*,
+                           const float* ohlc,
+                           size_t count,
+                           double x0,
+                           double dx,
+                           double y_scale,
+                           double y_offset,
+                           float body_width,
+                           const float bull[4],
+                           const float bear[4]);
+
+/**
+ * @brief Primitive kinds handled by nvgjs_batch_shapes().
+ */
+enum nvgjs_batch_shape {
+  NVGJS_BATCH_RECT,          /* x y w h */
+  NVGJS_BATCH_CIRCLE,        /* cx cy r */
+  NVGJS_BATCH_ELLIPSE,       /* cx cy rx ry */
+  NVGJS_BATCH_ROUNDED_RECT,  /* x y w h r */
+  NVGJS_BATCH_SHAPE_COUNT,
+};
+
+/**
+ * @brief Number of floats per item for each enum nvgjs_batch_shape.
+ */
+extern const unsigned char nvgjs_batch_stride[NVGJS_BATCH_SHAPE_COUNT];
+
+/**
+ * @brief Append @p count primitives of one kind to the current path.
+ *
+ * @param nvg    Target NanoVG context.
+ * @param shape  An enum nvgjs_batch_shape value.
+ * @param data   Item data, nvgjs_batch_stride[shape] floats per item.
+ * @param count  Number of items.
+ */
+void nvgjs_batch_shapes(struct NVGcontext*, int shape, const float* data, size_t count);
+
+/**
+ * @brief Size in bytes of the scratch buffer nvgjs_batch_shapes_colored()
+ * needs for @p count items.
+ */
+size_t nvgjs_batch_scratch_size(size_t count);
+
+/**
+ * @brief Fill @p count primitives, one fill per distinct color.
+ *
+ * Items are grouped by their color (exact match on the 4 floats); each group
+ * becomes one path filled once with that color. Groups are drawn in order of
+ * their first item, so the relative order of differently colored items that
+ * overlap is not preserved.
+ *
+ * @param nvg      Target NanoVG context.
+ * @param shape    An enum nvgjs_batch_shape value.
+ * @param data     Item data, nvgjs_batch_stride[shape] floats per item.
+ * @param colors   Item colors, 4 floats (r, g, b, a in 0..1) per item.
+ * @param count    Number of items.
+ * @param scratch  Work buffer of nvgjs_batch_scratch_size(count) bytes.
+ * @return Number of fills issued.
+ */
+size_t nvgjs_batch_shapes_colored(struct NVGcontext*,
+                                  int shape,
+                                  const float* data,
+                                  const float* colors,
+                                  size_t count,
+                                  void* scratch);
+
+#endif /* defined NVGJS_BATCH_H */
@@ -0,0 +1,196 @@
+#include "nanovg.h"
+#include "nvgjs-command.h"
+
+#include <limits.h>
+#include <string.h>
+
+const unsigned char nvgjs_command_arity[NVGJS_OP_COUNT] = {
+ [NVGJS_OP_NOP] = 0,
+ [NVGJS_OP_SAVE] = 0,
+ [NVGJS_OP_RESTORE] = 0,
+ [NVGJS_OP_RESET] = 0,
+ [NVGJS_OP_SHAPE_ANTIALIAS] = 1,
+ [NVGJS_OP_BEGIN_PATH] = 0,
+ [NVGJS_OP_MOVE_TO] = 2,
+ [NVGJS_OP_LINE_TO] = 2,
+ [NVGJS_OP_BEZIER_TO] = 6,
+ [NVGJS_OP_QUAD_TO] = 4,
+ [NVGJS_OP_ARC_TO] = 5,
+ [NVGJS_OP_ARC] = 6,
+ [NVGJS_OP_RECT] = 4,
+ [NVGJS_OP_ROUNDED_RECT] = 5,
+ [NVGJS_OP_ROUNDED_RECT_VARYING] = 8,
+ [NVGJS_OP_ELLIPSE] = 4,
+ [NVGJS_OP_CIRCLE] = 3,
+ [NVGJS_OP_CLOSE_PATH] = 0,
+ [NVGJS_OP_PATH_WINDING] = 1,
+ [NVGJS_OP_FILL] = 0,
+ [NVGJS_OP_STROKE] = 0,
+ [NVGJS_OP_FILL_COLOR] = 4,
+ [NVGJS_OP_STROKE_COLOR] = 4,
+ [NVGJS_OP_STROKE_WIDTH] = 1,
+ [NVGJS_OP_MITER_LIMIT] = 1,
+ [NVGJS_OP_LINE_CAP] = 1,
+ [NVGJS_OP_LINE_JOIN] = 1,
+ [NVGJS_OP_GLOBAL_ALPHA] = 1,
+ [NVGJS_OP_FILL_LINEAR_GRADIENT] = 12,
+ [NVGJS_OP_STROKE_LINEAR_GRADIENT] = 12,
+ [NVGJS_OP_FILL_BOX_GRADIENT] = 14,
+ [NVGJS_OP_STROKE_BOX_GRADIENT] = 14,
+ [NVGJS_OP_FILL_RADIAL_GRADIENT] = 12,
+ [NVGJS_OP_STROKE_RADIAL_GRADIENT] = 12,
+ [NVGJS_OP_FILL_IMAGE_PATTERN] = 7,
+ [NVGJS_OP_STROKE_IMAGE_PATTERN] = 7,
+ [NVGJS_OP_RESET_TRANSFORM] = 0,
+ [NVGJS_OP_TRANSFORM] = 6,
+ [NVGJS_OP_TRANSLATE] = 2,
+ [NVGJS_OP_ROTATE] = 1,
+ [NVGJS_OP_SKEW_X] = 1,
+ [NVGJS_OP_SKEW_Y] = 1,
+ [NVGJS_OP_SCALE] = 2,
+ [NVGJS_OP_SCISSOR] = 4,
+ [NVGJS_OP_INTERSECT_SCISSOR] = 4,
+ [NVGJS_OP_RESET_SCISSOR] = 0,
+};
+
+static inline NVGcolor
+nvgjs_command_color(const float* a) {
+  NVGcolor c;
+  memcpy(c.rgba, a, sizeof(c.rgba));
+  return c;
+}
+
+static inline void
+nvgjs_command_paint(NVGcontext* nvg, int stroke, NVGpaint paint) {
+  if(stroke)
+    nvgStrokePaint(nvg, paint);
+  else
+    nvgFillPaint(nvg, paint);
+}
+
+int
+nvgjs_command_intarg(int op, const float* a) {
+  float f;
+
+  switch(op) {
+    case NVGJS_OP_PATH_WINDING:
+    case NVGJS_OP_LINE_CAP:
+    case NVGJS_OP_LINE_JOIN: f = a[0]; break;
+    case NVGJS_OP_ARC:
+    case NVGJS_OP_FILL_IMAGE_PATTERN:
+    case NVGJS_OP_STROKE_IMAGE_PATTERN: f = a[5]; break;
+    default: return 1;
+  }
+
+  return f >= (float)INT_MIN && f < -(float)INT_MIN;
+}
+
+int
+nvgjs_command_execute(NVGcontext* nvg, const float* cmd, size_t len, size_t* perror) {
+  size_t pos = 0;
+  int n = 0;
+
+  while(pos < len) {
+    const float* a = &cmd[pos + 1];
+    int op = -1;
+
+    /* range-check as float first: converting NaN or out-of-range values to
+       int is undefined */
+    if(cmd[pos] >= 0 && cmd[pos] < NVGJS_OP_COUNT)
+      op = (int)cmd[pos];
+
+    if(op < 0 || (float)op != cmd[pos] || pos + 1 + nvgjs_command_arity[op] > len || !nvgjs_command_intarg(op, a)) {
+      if(perror)
+        *perror = pos;
+
+      return -1;
+    }
+
+    switch(op) {
+      case NVGJS_OP_NOP: break;
+      case NVGJS_OP_SAVE: nvgSave(nvg); break;
+      case NVGJS_OP_RESTORE: nvgRestore(nvg); break;
+      case NVGJS_OP_RESET: nvgReset(nvg); break;
+      case NVGJS_OP_SHAPE_ANTIALIAS: nvgShapeAntiAlias(nvg, a[0] != 0); break;
+      case NVGJS_OP_BEGIN_PATH: nvgBeginPath(nvg); break;
+      case NVGJS_OP_MOVE_TO: nvgMoveTo(nvg, a[0], a[1]); break;
+      case NVGJS_OP_LINE_TO: nvgLineTo(nvg, a[0], a[1]); break;
+      case NVGJS_OP_BEZIER_TO: nvgBezierTo(nvg, a[0], a[1], a[2], a[3], a[4], a[5]); break;
+      case NVGJS_OP_QUAD_TO: nvgQuadTo(nvg, a[0], a[1], a[2], a[3]); break;
+      case NVGJS_OP_ARC_TO: nvgArcTo(nvg, a[0], a[1], a[2], a[3], a[4]); break;
+      case NVGJS_OP_ARC: nvgArc(nvg, a[0], a[1], a[2], a[3], a[4], (int)a[5]); break;
+      case NVGJS_OP_RECT: nvgRect(nvg, a[0], a[1], a[2], a[3]); break;
+      case NVGJS_OP_ROUNDED_RECT: nvgRoundedRect(nvg, a[0], a[1], a[2], a[3], a[4]); break;
+      case NVGJS_OP_ROUNDED_RECT_VARYING:
+        nvgRoundedRectVarying(nvg, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+        break;
+      case NVGJS_OP_ELLIPSE: nvgEllipse(nvg, a[0], a[1], a[2], a[3]); break;
+      case NVGJS_OP_CIRCLE: nvgCircle(nvg, a[0], a[1], a[2]); break;
+      case NVGJS_OP_CLOSE_PATH: nvgClosePath(nvg); break;
+      case NVGJS_OP_PATH_WINDING: nvgPathWinding(nvg, (int)a[0]); break;
+      case NVGJS_OP_FILL: nvgFill(nvg); break;
+      case NVGJS_OP_STROKE: nvgStroke(nvg); break;
+      case NVGJS_OP_FILL_COLOR: nvgFillColor(nvg, nvgjs_command_color(a)); break;
+      case NVGJS_OP_STROKE_COLOR: nvgStrokeColor(nvg, nvgjs_command_color(a)); break;
+      case NVGJS_OP_STROKE_WIDTH: nvgStrokeWidth(nvg, a[0]); break;
+      case NVGJS_OP_MITER_LIMIT: nvgMiterLimit(nvg, a[0]); break;
+      case NVGJS_OP_LINE_CAP: nvgLineCap(nvg, (int)a[0]); break;
+      case NVGJS_OP_LINE_JOIN: nvgLineJoin(nvg, (int)a[0]); break;
+      case NVGJS_OP_GLOBAL_ALPHA: nvgGlobalAlpha(nvg, a[0]); break;
+
+      case NVGJS_OP_FILL_LINEAR_GRADIENT:
+      case NVGJS_OP_STROKE_LINEAR_GRADIENT:
+        nvgjs_command_paint(nvg,
+                            op == NVGJS_OP_STROKE_LINEAR_GRADIENT,
+                            nvgLinearGradient(
+                             nvg, a[0], a[1], a[2], a[3], nvgjs_command_color(&a[4]), nvgjs_command_color(&a[8])));
+        break;
+
+      case NVGJS_OP_FILL_BOX_GRADIENT:
+      case NVGJS_OP_STROKE_BOX_GRADIENT:
+        nvgjs_command_paint(nvg,
+                            op == NVGJS_OP_STROKE_BOX_GRADIENT,
+                            nvgBoxGradient(nvg,
+                                           a[0],
+                                           a[1],
+                                           a[2],
+                                           a[3],
+                                           a[4],
+                                           a[5],
+                                           nvgjs_command_color(&a[6]),
+                                           nvgjs_command_color(&a[10])));
+        break;
+
+      case NVGJS_OP_FILL_RADIAL_GRADIENT:
+      case NVGJS_OP_STROKE_RADIAL_GRADIENT:
+        nvgjs_command_paint(nvg,
+                            op == NVGJS_OP_STROKE_RADIAL_GRADIENT,
+                            nvgRadialGradient(
+                             nvg, a[0], a[1], a[2], a[3], nvgjs_command_color(&a[4]), nvgjs_command_color(&a[8])));
+        break;
+
+      case NVGJS_OP_FILL_IMAGE_PATTERN:
+      case NVGJS_OP_STROKE_IMAGE_PATTERN:
+        nvgjs_command_paint(nvg,
+                            op == NVGJS_OP_STROKE_IMAGE_PATTERN,
+                            nvgImagePattern(nvg, a[0], a[1], a[2], a[3], a[4], (int)a[5], a[6]));
+        break;
+
+      case NVGJS_OP_RESET_TRANSFORM: nvgResetTransform(nvg); break;
+      case NVGJS_OP_TRANSFORM: nvgTransform(nvg, a[0], a[1], a[2], a[3], a[4], a[5]); break;
+      case NVGJS_OP_TRANSLATE: nvgTranslate(nvg, a[0], a[1]); break;
+      case NVGJS_OP_ROTATE: nvgRotate(nvg, a[0]); break;
+      case NVGJS_OP_SKEW_X: nvgSkewX(nvg, a[0]); break;
+      case NVGJS_OP_SKEW_Y: nvgSkewY(nvg, a[0]); break;
+      case NVGJS_OP_SCALE: nvgScale(nvg, a[0], a[1]); break;
+      case NVGJS_OP_SCISSOR: nvgScissor(nvg, a[0], a[1], a[2], a[3]); break;
+      case NVGJS_OP_INTERSECT_SCISSOR: nvgIntersectScissor(nvg, a[0], a[1], a[2], a[3]); break;
+      case NVGJS_OP_RESET_SCISSOR: nvgResetScissor(nvg); break;
+    }
+
+    pos += 1 + nvgjs_command_arity[op];
+    n++;
+  }
+
+  return n;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file nvgjs-command.h
+ */
+#ifndef NVGJS_COMMAND_H
+#define NVGJS_COMMAND_H
+
+#include <stddef.h>
+
+struct NVGcontext;
+
+/**
+ * @brief Opcodes of the encoded draw-command stream.
+ *
+ * A command stream is a flat array of 32-bit floats. Each command is one
+ * float holding the opcode, followed by a fixed number of float operands (see
+ * nvgjs_command_arity). Integer operands (line cap, winding, image id, ...)
+ * are stored as floats; colors are stored inline as 4 floats r, g, b, a in the
+ * 0..1 range (the raw NVGcolor layout).
+ *
+ * Paint operations take their gradient/pattern arguments inline and apply the
+ * resulting NVGpaint straight away, since a float stream can't reference Paint
+ * objects.
+ */
+enum nvgjs_opcode {
+  NVGJS_OP_NOP = 0,
+
+  /* state */
+  NVGJS_OP_SAVE,           /* */
+  NVGJS_OP_RESTORE,        /* */
+  NVGJS_OP_RESET,          /* */
+  NVGJS_OP_SHAPE_ANTIALIAS, /* enabled */
+
+  /* path */
+  NVGJS_OP_BEGIN_PATH,           /* */
+  NVGJS_OP_MOVE_TO,              /* x y */
+  NVGJS_OP_LINE_TO,              /* x y */
+  NVGJS_OP_BEZIER_TO,            /* c1x c1y c2x c2y x y */
+  NVGJS_OP_QUAD_TO,              /* cx cy x y */
+  NVGJS_OP_ARC_TO,               /* x1 y1 x2 y2 radius */
+  NVGJS_OP_ARC,                  /* cx cy r a0 a1 dir */
+  NVGJS_OP_RECT,                 /* x y w h */
+  NVGJS_OP_ROUNDED_RECT,         /* x y w h r */
+  NVGJS_OP_ROUNDED_RECT_VARYING, /* x y w h rtl rtr rbr rbl */
+  NVGJS_OP_ELLIPSE,              /* cx cy rx ry */
+  NVGJS_OP_CIRCLE,               /* cx cy r */
+  NVGJS_OP_CLOSE_PATH,           /* */
+  NVGJS_OP_PATH_WINDING,         /* dir */
+  NVGJS_OP_FILL,                 /* */
+  NVGJS_OP_STROKE,               /* */
+
+  /* style */
+  NVGJS_OP_FILL_COLOR,   /* r g b a */
+  NVGJS_OP_STROKE_COLOR, /* r g b a */
+  NVGJS_OP_STROKE_WIDTH, /* width */
+  NVGJS_OP_MITER_LIMIT,  /* limit */
+  NVGJS_OP_LINE_CAP,     /* cap */
+  NVGJS_OP_LINE_JOIN,    /* join */
+  NVGJS_OP_GLOBAL_ALPHA, /* alpha */
+
+  /* paint */
+  NVGJS_OP_FILL_LINEAR_GRADIENT,   /* sx sy ex ey icol[4] ocol[4] */
+  NVGJS_OP_STROKE_LINEAR_GRADIENT, /* sx sy ex ey icol[4] ocol[4] */
+  NVGJS_OP_FILL_BOX_GRADIENT,      /* x y w h r f icol[4] ocol[4] */
+  NVGJS_OP_STROKE_BOX_GRADIENT,    /* x y w h r f icol[4] ocol[4] */
+  NVGJS_OP_FILL_RADIAL_GRADIENT,   /* cx cy inr outr icol[4] ocol[4] */
+  NVGJS_OP_STROKE_RADIAL_GRADIENT, /* cx cy inr outr icol[4] ocol[4] */
+  NVGJS_OP_FILL_IMAGE_PATTERN,     /* ox oy ex ey angle image alpha */
+  NVGJS_OP_STROKE_IMAGE_PATTERN,   /* ox oy ex ey angle image alpha */
+
+  /* transform */
+  NVGJS_OP_RESET_TRANSFORM, /* */
+  NVGJS_OP_TRANSFORM,       /* a b c d e f */
+  NVGJS_OP_TRANSLATE,       /* x y */
+  NVGJS_OP_ROTATE,          /* angle */
+  NVGJS_OP_SKEW_X,          /* angle */
+  NVGJS_OP_SKEW_Y,          /* angle */
+  NVGJS_OP_SCALE,           /* x y */
+
+  /* scissor */
+  NVGJS_OP_SCISSOR,           /* x y w h */
+  NVGJS_OP_INTERSECT_SCISSOR, /* x y w h */
+  NVGJS_OP_RESET_SCISSOR,     /* */
+
+  NVGJS_OP_COUNT,
+};
+
+/**
+ * @brief Number of float operands following each opcode.
+ *
+ * Indexed by enum nvgjs_opcode.
+ */
+extern const unsigned char nvgjs_command_arity[NVGJS_OP_COUNT];
+
+/**
+ * @brief Check the integer operand of a command, if it has one.
+ *
+ * Line caps, joins, windings, arc directions and image ids are stored as
+ * floats and cast to int when executed.
+ *
+ * @param op  Opcode.
+ * @param a   Its operands.
+ * @return 1 if the operand is within the range of an int or @p op has none,
+ *         0 otherwise.
+ */
+int nvgjs_command_intarg(int op, const float* a);
+
+/**
+ * @brief Replay an encoded command stream against a NanoVG context.
+ *
+ * Executes commands from @p cmd in order until @p len floats have been
+ * consumed. Stops at the first unknown opcode, truncated operand list or
+ * integer operand outside the range of an int; commands preceding it have
+ * already been applied.
+ *
+ * @param      nvg     Target NanoVG context.
+ * @param      cmd     Command stream.
+ * @param      len     Number of floats in @p cmd.
+ * @param[out] perror  Receives the float offset of the offending command on
+ *                     error (may be NULL).
+ * @return Number of commands executed, or -1 on a malformed stream.
+ */
+int nvgjs_command_execute(struct NVGcontext*, const float* cmd, size_t len, size_t* perror);
+
+#endif /* defined NVGJS_COMMAND_H */
@@ -0,0 +1,66 @@
+#include <GL/glew.h>
+
+#include "nvgjs-gputimer.h"
+
+#include <string.h>
+
+int
+nvgjs_gputimer_begin(NVGJSGpuTimer* t) {
+  if(!t->supported)
+    t->supported = GLEW_VERSION_3_3 || GLEW_ARB_timer_query ? 1 : -1;
+
+  if(t->supported < 0 || t->active || t->pending == NVGJS_GPUTIMER_SLOTS)
+    return -1;
+
+  if(!t->query[0])
+    glGenQueries(NVGJS_GPUTIMER_SLOTS, t->query);
+
+  glBeginQuery(GL_TIME_ELAPSED, t->query[(t->head + t->pending) % NVGJS_GPUTIMER_SLOTS]);
+  t->active = 1;
+  return 0;
+}
+
+void
+nvgjs_gputimer_end(NVGJSGpuTimer* t) {
+  if(!t->active)
+    return;
+
+  glEndQuery(GL_TIME_ELAPSED);
+  t->active = 0;
+  t->pending++;
+}
+
+int
+nvgjs_gputimer_collect(NVGJSGpuTimer* t, double* ms, int max) {
+  int n = 0;
+
+  while(n < max && t->pending) {
+    GLuint query = t->query[t->head];
+    GLint available = 0;
+    GLuint64 ns = 0;
+
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+
+    if(!available)
+      break;
+
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+    ms[n++] = ns / 1e6;
+
+    t->head = (t->head + 1) % NVGJS_GPUTIMER_SLOTS;
+    t->pending--;
+  }
+
+  return n;
+}
+
+void
+nvgjs_gputimer_free(NVGJSGpuTimer* t) {
+  if(t->active)
+    glEndQuery(GL_TIME_ELAPSED);
+
+  if(t->query[0])
+    glDeleteQueries(NVGJS_GPUTIMER_SLOTS, t->query);
+
+  memset(t, 0, sizeof(*t));
+}
@@ -0,0 +1,58 @@
+/**
+ * @file nvgjs-gputimer.h
+ */
+#ifndef NVGJS_GPUTIMER_H
+#define NVGJS_GPUTIMER_H
+
+/**
+ * @brief Number of GL_TIME_ELAPSED queries in a timer ring.
+ *
+ * Results are typically available one or two frames after the query ended;
+ * four slots leave room for a GPU that runs a couple of frames behind. When
+ * all of them are still pending the frame goes untimed rather than stalling.
+ */
+#define NVGJS_GPUTIMER_SLOTS 4
+
+/**
+ * @brief Ring of timer queries bracketing each frame's flush.
+ *
+ * Zero-initialize before use. All functions must be called with the GL
+ * context that owns the queries current.
+ */
+typedef struct NVGJSGpuTimer {
+  unsigned int query[NVGJS_GPUTIMER_SLOTS];  /* created on first use */
+  int head;       /* oldest pending slot */
+  int pending;    /* ended queries whose result has not been read */
+  int active;     /* 1 between begin and end */
+  int supported;  /* 0 unknown, 1 yes, -1 no timer queries */
+} NVGJSGpuTimer;
+
+/**
+ * @brief Start timing GPU work (glBeginQuery(GL_TIME_ELAPSED)).
+ *
+ * @return 0 if a query was started, -1 if timer queries are unsupported or
+ *         every slot still waits for its result.
+ */
+int nvgjs_gputimer_begin(NVGJSGpuTimer*);
+
+/**
+ * @brief End the query started by nvgjs_gputimer_begin(), if any.
+ */
+void nvgjs_gputimer_end(NVGJSGpuTimer*);
+
+/**
+ * @brief Read finished results without waiting, oldest first.
+ *
+ * Stops at the first query whose result is not available yet.
+ *
+ * @param ms   Receives up to @p max elapsed times in milliseconds.
+ * @return Number of results stored.
+ */
+int nvgjs_gputimer_collect(NVGJSGpuTimer*, double* ms, int max);
+
+/**
+ * @brief Delete the queries.
+ */
+void nvgjs_gputimer_free(NVGJSGpuTimer*);
+
+#endif /* defined(NVGJS_GPUTIMER_H) */
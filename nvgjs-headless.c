@@ -0,0 +1,244 @@
+#include <GL/glew.h>
+
+#ifdef HAVE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#ifdef HAVE_OSMESA
+#include <GL/osmesa.h>
+#endif
+
+#include "nvgjs-headless.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+/* GLEW's function pointers are process-wide; contexts created on other
+   threads must not reload them concurrently */
+static pthread_mutex_t glew_lock = PTHREAD_MUTEX_INITIALIZER;
+
+const char* const nvgjs_headless_backend_names[] = {
+ [NVGJS_HEADLESS_EGL] = "egl",
+ [NVGJS_HEADLESS_OSMESA] = "osmesa",
+};
+
+#ifdef HAVE_EGL
+static int
+nvgjs_headless_egl(NVGJSHeadless* hl) {
+  static const EGLint config_attribs[] = {
+   EGL_SURFACE_TYPE,
+   EGL_DONT_CARE,
+   EGL_RENDERABLE_TYPE,
+   EGL_OPENGL_BIT,
+   EGL_NONE,
+  };
+  static const EGLint context_attribs[] = {
+   EGL_CONTEXT_MAJOR_VERSION,
+   3,
+   EGL_CONTEXT_MINOR_VERSION,
+   3,
+   EGL_CONTEXT_OPENGL_PROFILE_MASK,
+   EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+   EGL_NONE,
+  };
+  PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display;
+  EGLDisplay display;
+  EGLConfig config = 0;
+  EGLContext context;
+  EGLint n = 0;
+
+  if(!(get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT")))
+    return -1;
+
+  if((display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, 0)) == EGL_NO_DISPLAY)
+    return -1;
+
+  if(!eglInitialize(display, 0, 0) || !eglBindAPI(EGL_OPENGL_API))
+    return -1;
+
+  /* no surface is ever created, so the config only matters for drivers
+     without EGL_KHR_no_config_context */
+  if(!eglChooseConfig(display, config_attribs, &config, 1, &n) || n < 1)
+    config = 0;
+
+  if((context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs)) == EGL_NO_CONTEXT)
+    return -1;
+
+  if(!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+    eglDestroyContext(display, context);
+    return -1;
+  }
+
+  hl->backend = NVGJS_HEADLESS_EGL;
+  hl->display = display;
+  hl->context = context;
+  return 0;
+}
+#endif
+
+#ifdef HAVE_OSMESA
+static int
+nvgjs_headless_osmesa(NVGJSHeadless* hl) {
+  static const int attribs[] = {
+   OSMESA_FORMAT,
+   OSMESA_RGBA,
+   OSMESA_DEPTH_BITS,
+   24,
+   OSMESA_STENCIL_BITS,
+   8,
+   OSMESA_PROFILE,
+   OSMESA_CORE_PROFILE,
+   OSMESA_CONTEXT_MAJOR_VERSION,
+   3,
+   OSMESA_CONTEXT_MINOR_VERSION,
+   3,
+   0,
+  };
+  OSMesaContext context;
+
+  if(!(context = OSMesaCreateContextAttribs(attribs, 0)))
+    return -1;
+
+  /* rendering goes to the framebuffer object; the window-system buffer
+     only has to exist */
+  if(!OSMesaMakeCurrent(context, hl->osmesa_buffer, GL_UNSIGNED_BYTE, 1, 1)) {
+    OSMesaDestroyContext(context);
+    return -1;
+  }
+
+  hl->backend = NVGJS_HEADLESS_OSMESA;
+  hl->context = context;
+  return 0;
+}
+#endif
+
+static void
+nvgjs_headless_release(NVGJSHeadless* hl) {
+  switch(hl->backend) {
+#ifdef HAVE_EGL
+    case NVGJS_HEADLESS_EGL:
+      eglMakeCurrent(hl->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+      eglDestroyContext(hl->display, hl->context);
+      break;
+#endif
+#ifdef HAVE_OSMESA
+    case NVGJS_HEADLESS_OSMESA: OSMesaDestroyContext(hl->context); break;
+#endif
+  }
+
+  free(hl);
+}
+
+NVGJSHeadless*
+nvgjs_headless_create(int width, int height, const char** perror) {
+  NVGJSHeadless* hl;
+  int ret = -1;
+  GLenum err;
+
+  if(!(hl = calloc(1, sizeof(NVGJSHeadless)))) {
+    *perror = "out of memory";
+    return 0;
+  }
+
+  hl->width = width;
+  hl->height = height;
+
+#ifdef HAVE_EGL
+  ret = nvgjs_headless_egl(hl);
+#endif
+#ifdef HAVE_OSMESA
+  if(ret)
+    ret = nvgjs_headless_osmesa(hl);
+#endif
+
+  if(ret) {
+#if defined(HAVE_EGL) || defined(HAVE_OSMESA)
+    *perror = "could not create an OpenGL 3.3 core context";
+#else
+    *perror = "built without EGL and OSMesa support";
+#endif
+    free(hl);
+    return 0;
+  }
+
+  pthread_mutex_lock(&glew_lock);
+  glewExperimental = GL_TRUE;
+  err = glewInit();
+  pthread_mutex_unlock(&glew_lock);
+
+  /* GLEW >= 2.1 also probes GLX, which fails without an X display */
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+  if(err == GLEW_ERROR_NO_GLX_DISPLAY)
+    err = GLEW_OK;
+#endif
+
+  /* glewInit() leaves a GL error behind from glGetString(GL_EXTENSIONS) */
+  glGetError();
+
+  if(err != GLEW_OK) {
+    *perror = "could not init glew";
+    nvgjs_headless_release(hl);
+    return 0;
+  }
+
+  glGenFramebuffers(1, &hl->fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, hl->fbo);
+
+  glGenRenderbuffers(1, &hl->color);
+  glBindRenderbuffer(GL_RENDERBUFFER, hl->color);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, hl->color);
+
+  /* NanoVG fills through the stencil buffer */
+  glGenRenderbuffers(1, &hl->depth_stencil);
+  glBindRenderbuffer(GL_RENDERBUFFER, hl->depth_stencil);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, hl->depth_stencil);
+
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    *perror = "framebuffer object incomplete";
+    nvgjs_headless_delete(hl);
+    return 0;
+  }
+
+  glViewport(0, 0, width, height);
+  return hl;
+}
+
+int
+nvgjs_headless_make_current(NVGJSHeadless* hl) {
+  switch(hl->backend) {
+#ifdef HAVE_EGL
+    case NVGJS_HEADLESS_EGL:
+      if(!eglMakeCurrent(hl->display, EGL_NO_SURFACE, EGL_NO_SURFACE, hl->context))
+        return -1;
+      break;
+#endif
+#ifdef HAVE_OSMESA
+    case NVGJS_HEADLESS_OSMESA:
+      if(!OSMesaMakeCurrent(hl->context, hl->osmesa_buffer, GL_UNSIGNED_BYTE, 1, 1))
+        return -1;
+      break;
+#endif
+    default: return -1;
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, hl->fbo);
+  glViewport(0, 0, hl->width, hl->height);
+  return 0;
+}
+
+void
+nvgjs_headless_delete(NVGJSHeadless* hl) {
+  if(!nvgjs_headless_make_current(hl)) {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &hl->fbo);
+    glDeleteRenderbuffers(1, &hl->color);
+    glDeleteRenderbuffers(1, &hl->depth_stencil);
+  }
+
+  nvgjs_headless_release(hl);
+}
@@ -0,0 +1,59 @@
+/**
+ * @file nvgjs-headless.h
+ */
+#ifndef NVGJS_HEADLESS_H
+#define NVGJS_HEADLESS_H
+
+/**
+ * @brief Window-system backends of a headless GL context.
+ */
+enum nvgjs_headless_backend {
+  NVGJS_HEADLESS_EGL,     /* EGL_MESA_platform_surfaceless (HAVE_EGL) */
+  NVGJS_HEADLESS_OSMESA,  /* Mesa off-screen rendering (HAVE_OSMESA) */
+};
+
+/**
+ * @brief An off-screen OpenGL 3.3 core context rendering into its own framebuffer object.
+ */
+typedef struct NVGJSHeadless {
+  int width, height;
+  int backend;                     /* enum nvgjs_headless_backend */
+  void *display, *context;         /* EGLDisplay + EGLContext, or OSMesaContext */
+  unsigned char osmesa_buffer[4];  /* 1x1 default framebuffer required by OSMesaMakeCurrent */
+  unsigned int fbo, color, depth_stencil;
+} NVGJSHeadless;
+
+/**
+ * @brief Create a headless context and make it current.
+ *
+ * Tries EGL first, then OSMesa, whichever the module was built with. Once
+ * the context is current, GLEW is initialized and a @p width x @p height
+ * RGBA8 + depth24/stencil8 framebuffer object is created and bound as both
+ * the draw and read framebuffer.
+ *
+ * @param perror  Receives a static error message on failure.
+ * @return malloc()'d context, or NULL.
+ */
+NVGJSHeadless* nvgjs_headless_create(int width, int height, const char** perror);
+
+/**
+ * @brief Make the context current again and bind its framebuffer object and viewport.
+ *
+ * @return 0 on success, -1 if the window-system call failed.
+ */
+int nvgjs_headless_make_current(NVGJSHeadless*);
+
+/**
+ * @brief Delete the framebuffer object and the GL context, and free @p hl.
+ *
+ * Anything created in the context (NanoVG contexts included) must have been
+ * deleted before.
+ */
+void nvgjs_headless_delete(NVGJSHeadless* hl);
+
+/**
+ * @brief Backend names, indexed by enum nvgjs_headless_backend ("egl", "osmesa").
+ */
+extern const char* const nvgjs_headless_backend_names[];
+
+#endif /* defined(NVGJS_HEADLESS_H) */
@@ -0,0 +1,357 @@
+#include "nvgjs-image.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NVGJS_IMAGE_SSSE3 1
+#include <tmmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+const char* const nvgjs_image_format_names[NVGJS_IMAGE_FORMAT_COUNT] = {
+ [NVGJS_IMAGE_PNG] = "png",
+ [NVGJS_IMAGE_PPM] = "ppm",
+ [NVGJS_IMAGE_QOI] = "qoi",
+};
+
+#ifdef NVGJS_IMAGE_SSSE3
+/* Compiled for SSSE3 regardless of -march; only called after a CPU check.
+   Each step loads 4 pixels and stores 16 bytes of which 12 are kept, so stop
+   while the row still has room for the 4 spare bytes. */
+__attribute__((target("ssse3"))) static int
+nvgjs_image_rgb_ssse3(uint8_t* dst, const uint8_t* src, int w) {
+  const __m128i shuf = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+  int x = 0;
+
+  for(; x + 6 <= w; x += 4)
+    _mm_storeu_si128((__m128i*)(dst + x * 3), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + x * 4)), shuf));
+
+  return x;
+}
+#elif defined(__ARM_NEON)
+static int
+nvgjs_image_rgb_neon(uint8_t* dst, const uint8_t* src, int w) {
+  int x = 0;
+
+  for(; x + 16 <= w; x += 16) {
+    uint8x16x4_t v = vld4q_u8(src + x * 4);
+    uint8x16x3_t o = {{v.val[0], v.val[1], v.val[2]}};
+
+    vst3q_u8(dst + x * 3, o);
+  }
+
+  return x;
+}
+#endif
+
+void
+nvgjs_image_pack(uint8_t* dst, size_t dst_stride, const uint8_t* src, int w, int h, int channels, int flip) {
+  size_t src_stride = (size_t)w * 4;
+#ifdef NVGJS_IMAGE_SSSE3
+  int simd = channels == 3 && __builtin_cpu_supports("ssse3");
+#endif
+
+  for(int y = 0; y < h; y++) {
+    const uint8_t* s = src + (size_t)(flip ? h - 1 - y : y) * src_stride;
+    uint8_t* d = dst + (size_t)y * dst_stride;
+    int x = 0;
+
+    if(channels == 4) {
+      memcpy(d, s, src_stride);
+      continue;
+    }
+
+#ifdef NVGJS_IMAGE_SSSE3
+    if(simd)
+      x = nvgjs_image_rgb_ssse3(d, s, w);
+#elif defined(__ARM_NEON)
+    x = nvgjs_image_rgb_neon(d, s, w);
+#endif
+
+    for(; x < w; x++) {
+      d[x * 3] = s[x * 4];
+      d[x * 3 + 1] = s[x * 4 + 1];
+      d[x * 3 + 2] = s[x * 4 + 2];
+    }
+  }
+}
+
+static inline uint8_t*
+nvgjs_image_be32(uint8_t* p, uint32_t v) {
+  p[0] = v >> 24;
+  p[1] = v >> 16;
+  p[2] = v >> 8;
+  p[3] = v;
+  return p + 4;
+}
+
+static uint8_t*
+nvgjs_image_ppm(const uint8_t* rgba, int w, int h, int flags, size_t* plen) {
+  char header[64];
+  int n = snprintf(header, sizeof(header), "P6\n%d %d\n255\n", w, h);
+  size_t size = (size_t)w * h * 3;
+  uint8_t* out;
+
+  if(!(out = malloc(n + size)))
+    return 0;
+
+  memcpy(out, header, n);
+  nvgjs_image_pack(out + n, (size_t)w * 3, rgba, w, h, 3, flags & NVGJS_IMAGE_FLIPY);
+
+  *plen = n + size;
+  return out;
+}
+
+static void
+nvgjs_image_crc_table(uint32_t table[256]) {
+  for(uint32_t n = 0; n < 256; n++) {
+    uint32_t c = n;
+
+    for(int k = 0; k < 8; k++)
+      c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+
+    table[n] = c;
+  }
+}
+
+static uint32_t
+nvgjs_image_crc(const uint32_t table[256], const uint8_t* p, size_t n) {
+  uint32_t c = 0xffffffffu;
+
+  while(n--)
+    c = table[(c ^ *p++) & 0xff] ^ (c >> 8);
+
+  return c ^ 0xffffffffu;
+}
+
+/* Finish a PNG chunk whose 4-byte type and len bytes of data are already at
+   p + 4; returns the end of the chunk. */
+static uint8_t*
+nvgjs_image_chunk(uint8_t* p, size_t len, const uint32_t table[256]) {
+  nvgjs_image_be32(p, len);
+  return nvgjs_image_be32(p + 8 + len, nvgjs_image_crc(table, p + 4, len + 4));
+}
+
+#ifndef HAVE_ZLIB
+/* zlib stream made of stored (uncompressed) deflate blocks */
+static size_t
+nvgjs_image_stored(uint8_t* out, const uint8_t* data, size_t len) {
+  uint32_t a = 1, b = 0;
+  uint8_t* p = out;
+  size_t pos = 0;
+
+  *p++ = 0x78;
+  *p++ = 0x01;
+
+  do {
+    size_t n = len - pos < 65535 ? len - pos : 65535;
+
+    *p++ = pos + n == len;
+    *p++ = n & 0xff;
+    *p++ = n >> 8;
+    *p++ = ~n & 0xff;
+    *p++ = (~n >> 8) & 0xff;
+    memcpy(p, data + pos, n);
+    p += n;
+    pos += n;
+  } while(pos < len);
+
+  /* adler32, reducing every 5552 bytes so the sums can't overflow */
+  for(pos = 0; pos < len;) {
+    size_t end = pos + 5552 < len ? pos + 5552 : len;
+
+    for(; pos < end; pos++) {
+      a += data[pos];
+      b += a;
+    }
+
+    a %= 65521;
+    b %= 65521;
+  }
+
+  return nvgjs_image_be32(p, (b << 16) | a) - out;
+}
+#endif
+
+static uint8_t*
+nvgjs_image_png(const uint8_t* rgba, int w, int h, int flags, size_t* plen) {
+  static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+  int channels = flags & NVGJS_IMAGE_ALPHA ? 4 : 3;
+  size_t stride = 1 + (size_t)w * channels, rawlen = stride * h, bound, zlen;
+  uint32_t table[256];
+  uint8_t *raw, *out, *p;
+
+  if(!(raw = malloc(rawlen)))
+    return 0;
+
+  /* filter type 0 (None) in front of every row */
+  nvgjs_image_pack(raw + 1, stride, rgba, w, h, channels, flags & NVGJS_IMAGE_FLIPY);
+
+  for(int y = 0; y < h; y++)
+    raw[y * stride] = 0;
+
+#ifdef HAVE_ZLIB
+  bound = compressBound(rawlen);
+#else
+  bound = 2 + rawlen + 5 * (rawlen / 65535 + 1) + 4;
+#endif
+
+  if(!(out = malloc(sizeof(signature) + 25 + 12 + bound + 12))) {
+    free(raw);
+    return 0;
+  }
+
+  nvgjs_image_crc_table(table);
+  memcpy(out, signature, sizeof(signature));
+  p = out + sizeof(signature);
+
+  memcpy(p + 4, "IHDR", 4);
+  nvgjs_image_be32(p + 8, w);
+  nvgjs_image_be32(p + 12, h);
+  p[16] = 8;                         /* bit depth */
+  p[17] = channels == 4 ? 6 : 2;     /* color type: RGBA / RGB */
+  p[18] = p[19] = p[20] = 0;         /* deflate, adaptive filtering, no interlace */
+  p = nvgjs_image_chunk(p, 13, table);
+
+  memcpy(p + 4, "IDAT", 4);
+#ifdef HAVE_ZLIB
+  {
+    uLongf len = bound;
+
+    if(compress2(p + 8, &len, raw, rawlen, Z_BEST_SPEED) != Z_OK) {
+      free(raw);
+      free(out);
+      return 0;
+    }
+
+    zlen = len;
+  }
+#else
+  zlen = nvgjs_image_stored(p + 8, raw, rawlen);
+#endif
+  p = nvgjs_image_chunk(p, zlen, table);
+
+  memcpy(p + 4, "IEND", 4);
+  p = nvgjs_image_chunk(p, 0, table);
+
+  free(raw);
+  *plen = p - out;
+  return out;
+}
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xc0
+#define QOI_OP_RGB 0xfe
+#define QOI_OP_RGBA 0xff
+
+static uint8_t*
+nvgjs_image_qoi(const uint8_t* rgba, int w, int h, int flags, size_t* plen) {
+  static const uint8_t padding[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+  int channels = flags & NVGJS_IMAGE_ALPHA ? 4 : 3, run = 0;
+  uint8_t index[64][4] = {{0}}, prev[4] = {0, 0, 0, 255}, *out, *p;
+
+  if(!(out = malloc(14 + (size_t)w * h * (channels + 1) + sizeof(padding))))
+    return 0;
+
+  p = out;
+  memcpy(p, "qoif", 4);
+  p = nvgjs_image_be32(p + 4, w);
+  p = nvgjs_image_be32(p, h);
+  *p++ = channels;
+  *p++ = 0; /* sRGB with linear alpha */
+
+  for(int y = 0; y < h; y++) {
+    const uint8_t* row = rgba + (size_t)((flags & NVGJS_IMAGE_FLIPY) ? h - 1 - y : y) * w * 4;
+
+    for(int x = 0; x < w; x++) {
+      uint8_t px[4] = {row[x * 4], row[x * 4 + 1], row[x * 4 + 2], channels == 4 ? row[x * 4 + 3] : 255};
+
+      if(!memcmp(px, prev, 4)) {
+        if(++run == 62) {
+          *p++ = QOI_OP_RUN | (run - 1);
+          run = 0;
+        }
+
+        continue;
+      }
+
+      if(run) {
+        *p++ = QOI_OP_RUN | (run - 1);
+        run = 0;
+      }
+
+      int hash = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+
+      if(!memcmp(index[hash], px, 4)) {
+        *p++ = QOI_OP_INDEX | hash;
+      } else {
+        memcpy(index[hash], px, 4);
+
+        if(px[3] == prev[3]) {
+          int8_t vr = px[0] - prev[0], vg = px[1] - prev[1], vb = px[2] - prev[2];
+          int8_t vg_r = vr - vg, vg_b = vb - vg;
+
+          if(vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+            *p++ = QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2);
+          } else if(vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+            *p++ = QOI_OP_LUMA | (vg + 32);
+            *p++ = (vg_r + 8) << 4 | (vg_b + 8);
+          } else {
+            *p++ = QOI_OP_RGB;
+            *p++ = px[0];
+            *p++ = px[1];
+            *p++ = px[2];
+          }
+        } else {
+          *p++ = QOI_OP_RGBA;
+          memcpy(p, px, 4);
+          p += 4;
+        }
+      }
+
+      memcpy(prev, px, 4);
+    }
+  }
+
+  if(run)
+    *p++ = QOI_OP_RUN | (run - 1);
+
+  memcpy(p, padding, sizeof(padding));
+  p += sizeof(padding);
+
+  *plen = p - out;
+  return out;
+}
+
+uint8_t*
+nvgjs_image_encode(int format, const uint8_t* rgba, int w, int h, int flags, size_t* plen) {
+  switch(format) {
+    case NVGJS_IMAGE_PNG: return nvgjs_image_png(rgba, w, h, flags, plen);
+    case NVGJS_IMAGE_PPM: return nvgjs_image_ppm(rgba, w, h, flags, plen);
+    case NVGJS_IMAGE_QOI: return nvgjs_image_qoi(rgba, w, h, flags, plen);
+  }
+
+  return 0;
+}
+
+int
+nvgjs_image_format_of(const char* path) {
+  const char* ext = strrchr(path, '.');
+
+  if(ext)
+    for(int i = 0; i < NVGJS_IMAGE_FORMAT_COUNT; i++)
+      if(!strcasecmp(ext + 1, nvgjs_image_format_names[i]))
+        return i;
+
+  return -1;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file nvgjs-image.h
+ */
+#ifndef NVGJS_IMAGE_H
+#define NVGJS_IMAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Output formats of nvgjs_image_encode().
+ */
+enum nvgjs_image_format {
+  NVGJS_IMAGE_PNG,  /* RGB or RGBA, 8 bit, deflate (zlib when available, stored blocks otherwise) */
+  NVGJS_IMAGE_PPM,  /* binary P6, RGB only */
+  NVGJS_IMAGE_QOI,  /* "Quite OK Image", RGB or RGBA */
+  NVGJS_IMAGE_FORMAT_COUNT,
+};
+
+/**
+ * @brief Flags for nvgjs_image_encode().
+ */
+enum {
+  NVGJS_IMAGE_FLIPY = 1,  /* source rows are bottom-up (glReadPixels order) */
+  NVGJS_IMAGE_ALPHA = 2,  /* keep the alpha channel (ignored for PPM) */
+};
+
+/**
+ * @brief Format names, indexed by enum nvgjs_image_format ("png", "ppm", "qoi").
+ */
+extern const char* const nvgjs_image_format_names[NVGJS_IMAGE_FORMAT_COUNT];
+
+/**
+ * @brief Copy RGBA8 pixels to RGB8 or RGBA8 rows, optionally flipping them.
+ *
+ * The RGBA to RGB packing uses SSSE3 or NEON when the CPU has it.
+ *
+ * @param dst         Destination, @p h rows of @p dst_stride bytes.
+ * @param dst_stride  Bytes per destination row (at least @p w * @p channels).
+ * @param src         Source, @p h tightly packed rows of @p w RGBA pixels.
+ * @param w           Width in pixels.
+ * @param h           Height in pixels.
+ * @param channels    3 (RGB) or 4 (RGBA).
+ * @param flip        Non-zero to write the last source row first.
+ */
+void nvgjs_image_pack(uint8_t* dst, size_t dst_stride, const uint8_t* src, int w, int h, int channels, int flip);
+
+/**
+ * @brief Encode RGBA8 pixels to an image file in memory.
+ *
+ * Thread-safe; touches no global state.
+ *
+ * @param format  enum nvgjs_image_format.
+ * @param rgba    @p w * @p h * 4 bytes.
+ * @param flags   NVGJS_IMAGE_FLIPY, NVGJS_IMAGE_ALPHA.
+ * @param plen    Receives the encoded size.
+ * @return malloc()'d file contents, or NULL on allocation/encoder failure.
+ */
+uint8_t* nvgjs_image_encode(int format, const uint8_t* rgba, int w, int h, int flags, size_t* plen);
+
+/**
+ * @brief Guess the format from a file name's extension.
+ *
+ * @return enum nvgjs_image_format, or -1 if the extension is not known.
+ */
+int nvgjs_image_format_of(const char* path);
+
+#endif /* defined(NVGJS_IMAGE_H) */
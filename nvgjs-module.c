@@ -8,18 +8,41 @@
 
 #include "nvgjs-module.h"
 #include "nvgjs-utils.h"
+#include "nvgjs-command.h"
+#include "nvgjs-batch.h"
+#include "nvgjs-readback.h"
+#include "nvgjs-image.h"
+#include "nvgjs-worker.h"
+#include "nvgjs-headless.h"
+#include "nvgjs-software.h"
+#include "nvgjs-svg.h"
+#include "nvgjs-stats.h"
+#include "nvgjs-gputimer.h"
+#include "nvgjs-trace.h"
+#include "nvgjs-tesscache.h"
+#include "nvgjs-nanovg.h"
+#include "nvgjs-spatial.h"
+#include "nvgjs-state.h"
 
 #include <assert.h>
-
-JSClassID nvgjs_context_class_id, nvgjs_paint_class_id, nvgjs_framebuffer_class_id;
-
-static JSValue js_float32array_ctor, js_float32array_proto;
-static JSValue color_ctor, color_proto;
-static JSValue transform_ctor, transform_proto;
-static JSValue context_ctor, context_proto;
-static JSValue framebuffer_ctor, framebuffer_proto;
-
-static JSValue nvgjs_framebuffer_wrap(JSContext*, JSValueConst, NVGLUframebuffer*);
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+JSClassID nvgjs_context_class_id, nvgjs_paint_class_id, nvgjs_framebuffer_class_id, nvgjs_path_class_id,
+ nvgjs_color_class_id, nvgjs_transform_class_id, nvgjs_headless_class_id, nvgjs_spatial_class_id;
+
+static JSValue nvgjs_framebuffer_wrap(JSContext*, NVGLUframebuffer*);
+static void nvgjs_wrap_methods(JSContext*);
+NVGJS_DECL(func, ProfileStart);
+NVGJS_DECL(func, ProfileStop);
+NVGJS_DECL(func, ProfileResults);
 
 static void
 nvgjs_arraybuffer_free(JSRuntime* rt, void* opaque, void* ptr) {
@@ -27,10 +50,14 @@ nvgjs_arraybuffer_free(JSRuntime* rt, void* opaque, void* ptr) {
   js_free_rt(rt, ptr);
 }
 
-static const char* const nvgjs_color_keys[] = {"r", "g", "b", "a"};
+static const char* const nvgjs_color_names[] = {"r", "g", "b", "a"};
+static const char* const nvgjs_transform_names[] = {"a", "b", "c", "d", "e", "f"};
+static const char* const nvgjs_vector_names[] = {"x", "y"};
+static const char* const nvgjs_bounds_names[] = {"xmin", "ymin", "xmax", "ymax"};
+static const char* const nvgjs_size_names[] = {"width", "height"};
 
 static void
-nvgjs_copy(JSContext* ctx, JSValueConst value, const char* const prop_map[], const float vec[], int vlen) {
+nvgjs_copy(JSContext* ctx, JSValueConst value, const JSAtom prop_map[], const float vec[], int vlen) {
   if(JS_IsArray(ctx, value) == TRUE)
     nvgjs_copyarray(ctx, value, vec, vlen);
   else
@@ -39,47 +66,149 @@ nvgjs_copy(JSContext* ctx, JSValueConst value, const char* const prop_map[], con
 
 static float*
 nvgjs_transform_output(JSContext* ctx, JSValueConst value) {
-  if(nvgjs_same_object(value, transform_ctor))
+  float* mat;
+
+  if((mat = JS_GetOpaque(value, nvgjs_transform_class_id)))
+    return mat;
+
+  if(nvgjs_same_object(value, nvgjs_state(ctx)->transform_ctor))
     return 0;
 
   return nvgjs_output(ctx, 6, value);
 }
 
-static const char* const nvgjs_transform_keys[] = {"a", "b", "c", "d", "e", "f"};
+/* A Transform argument is modified in place; anything else goes through
+ * nvgjs_inputoutputarray() */
+static float*
+nvgjs_transform_inout(JSContext* ctx, float tmp[6], JSValueConst value, NVGJSHint* hint) {
+  float* mat;
+
+  if((mat = JS_GetOpaque(value, nvgjs_transform_class_id)))
+    return mat;
+
+  return nvgjs_inputoutputarray(ctx, tmp, 6, value, hint);
+}
+
+static int
+nvgjs_totransform(JSContext* ctx, float vec[6], JSValueConst value, NVGJSHint* hint) {
+  float* mat;
+
+  if((mat = JS_GetOpaque(value, nvgjs_transform_class_id))) {
+    memcpy(vec, mat, 6 * sizeof(float));
+    return 0;
+  }
+
+  return nvgjs_input(ctx, vec, 6, nvgjs_state(ctx)->transform_keys, value, hint);
+}
+
+/* nvgjs_arguments() for a 6-float matrix, reading Transform objects directly */
+static int
+nvgjs_transform_arguments(JSContext* ctx, float vec[6], NVGJSHint* hint, int argc, JSValueConst argv[]) {
+  float* mat;
+
+  if(argc >= 1 && (mat = JS_GetOpaque(argv[0], nvgjs_transform_class_id))) {
+    memcpy(vec, mat, 6 * sizeof(float));
+    return 1;
+  }
+
+  return nvgjs_arguments(ctx, vec, 6, nvgjs_state(ctx)->transform_keys, hint, argc, argv);
+}
 
 static JSValue
 nvgjs_transform_copy(JSContext* ctx, JSValueConst value, const float transform[6]) {
+  float* mat;
+
   assert(JS_IsObject(value));
-  assert(!nvgjs_same_object(value, transform_ctor));
+  assert(!nvgjs_same_object(value, nvgjs_state(ctx)->transform_ctor));
+
+  if((mat = JS_GetOpaque(value, nvgjs_transform_class_id)))
+    memcpy(mat, transform, 6 * sizeof(float));
+  else
+    nvgjs_copy(ctx, value, nvgjs_state(ctx)->transform_keys, transform, 6);
 
-  nvgjs_copy(ctx, value, nvgjs_transform_keys, transform, 6);
   return JS_UNDEFINED;
 }
 
-static const char* const nvgjs_vector_keys[] = {"x", "y"};
+/* Resolve a Float32Array argument plus optional offset/count arguments
+ * (counted in items of `stride` floats) to a pointer into its storage. */
+static float*
+nvgjs_items(JSContext* ctx, size_t* pcount, int stride, int argc, JSValueConst argv[]) {
+  float* ptr;
+  int length;
+  int64_t offset = 0, count;
+  size_t n;
+
+  if(!(ptr = nvgjs_outputarray(ctx, &length, argv[0])))
+    return 0;
+
+  n = length / stride;
+
+  if(argc > 1 && !JS_IsUndefined(argv[1]) && JS_ToInt64(ctx, &offset, argv[1]))
+    return 0;
+
+  if(offset < 0 || (size_t)offset > n) {
+    JS_ThrowRangeError(ctx, "offset %" PRId64 " out of range (%zu items)", offset, n);
+    return 0;
+  }
+
+  n -= offset;
+  count = n;
+
+  if(argc > 2 && !JS_IsUndefined(argv[2]) && JS_ToInt64(ctx, &count, argv[2]))
+    return 0;
+
+  if(count < 0 || (size_t)count > n) {
+    JS_ThrowRangeError(ctx, "count %" PRId64 " out of range (%zu available items)", count, n);
+    return 0;
+  }
 
+  *pcount = count;
+  return ptr + offset * stride;
+}
+
+/* Color argument: Color object, or 3/4 floats as Float32Array, Array,
+ * {r, g, b[, a]} or iterable; alpha defaults to 1 */
 static int
-nvgjs_tocolor(JSContext* ctx, NVGcolor* color, JSValueConst value) {
-  if(!nvgjs_inputarray(ctx, color->rgba, 4, value))
+nvgjs_tocolor(JSContext* ctx, NVGcolor* color, JSValueConst value, NVGJSHint* hint) {
+  NVGcolor* c;
+  int form;
+
+  if((c = JS_GetOpaque(value, nvgjs_color_class_id))) {
+    *color = *c;
     return 0;
+  }
 
-  /* 4-element read failed and left an exception on ctx; discard it so the
-     3-element fallback (with default alpha=1) can throw its own on failure. */
-  JS_FreeValue(ctx, JS_GetException(ctx));
+  form = nvgjs_form(ctx, value, nvgjs_state(ctx)->color_keys, hint);
   color->a = 1;
-  return nvgjs_inputarray(ctx, color->rgba, 3, value);
+
+  return nvgjs_inputform(ctx, color->rgba, 3, 4, nvgjs_state(ctx)->color_keys, value, form) < 0 ? -1 : 0;
 }
 
+/* An undefined proto means the class prototype of this context */
 static JSValue
-nvgjs_color_new(JSContext* ctx, NVGcolor color) {
-  JSValue buf = JS_NewArrayBufferCopy(ctx, (const void*)&color, sizeof(color));
-  JSValue obj = JS_CallConstructor(ctx, js_float32array_ctor, 1, &buf);
-  JS_FreeValue(ctx, buf);
-  JS_SetPrototype(ctx, obj, color_proto);
+nvgjs_color_wrap(JSContext* ctx, JSValueConst proto, NVGcolor color) {
+  NVGcolor* c;
+  JSValue obj = JS_IsUndefined(proto) ? JS_NewObjectClass(ctx, nvgjs_color_class_id)
+                                      : JS_NewObjectProtoClass(ctx, proto, nvgjs_color_class_id);
+
+  if(JS_IsException(obj))
+    return obj;
+
+  if(!(c = js_malloc(ctx, sizeof(NVGcolor)))) {
+    JS_FreeValue(ctx, obj);
+    return JS_EXCEPTION;
+  }
 
+  *c = color;
+  JS_SetOpaque(obj, c);
   return obj;
 }
 
+static JSValue
+nvgjs_color_new(JSContext* ctx, NVGcolor color) {
+  return nvgjs_color_wrap(ctx, JS_UNDEFINED, color);
+}
+
 static JSValue
 nvgjs_point_new(JSContext* ctx, float point[2]) {
   JSValue ret = JS_NewArray(ctx);
@@ -90,45 +219,164 @@ nvgjs_point_new(JSContext* ctx, float point[2]) {
 
 static JSValue
 nvgjs_color_get(JSContext* ctx, JSValueConst this_val, int magic) {
-  return JS_GetPropertyUint32(ctx, this_val, magic);
+  NVGcolor* c;
+
+  if(!(c = JS_GetOpaque2(ctx, this_val, nvgjs_color_class_id)))
+    return JS_EXCEPTION;
+
+  return JS_NewFloat64(ctx, c->rgba[magic]);
 }
 
 static JSValue
 nvgjs_color_set(JSContext* ctx, JSValueConst this_val, JSValueConst value, int magic) {
-  JS_SetPropertyUint32(ctx, this_val, magic, JS_DupValue(ctx, value));
+  NVGcolor* c;
+
+  if(!(c = JS_GetOpaque2(ctx, this_val, nvgjs_color_class_id)))
+    return JS_EXCEPTION;
+
+  if(nvgjs_tofloat32(ctx, &c->rgba[magic], value))
+    return JS_EXCEPTION;
+
   return JS_UNDEFINED;
 }
 
+static JSValue
+nvgjs_color_constructor(JSContext* ctx, JSValueConst new_target, int argc, JSValueConst argv[]) {
+  static NVGJSHint hints[1];
+  NVGcolor color = {{{0, 0, 0, 0}}};
+  JSValue proto, obj;
+
+  if(argc >= 3) {
+    color.a = 1;
+
+    for(int i = 0; i < argc && i < 4; i++)
+      if(nvgjs_tofloat32(ctx, &color.rgba[i], argv[i]))
+        return JS_EXCEPTION;
+  } else if(argc > 0 && !JS_IsUndefined(argv[0])) {
+    if(nvgjs_tocolor(ctx, &color, argv[0], &hints[0]))
+      return JS_EXCEPTION;
+  }
+
+  proto = JS_GetPropertyStr(ctx, new_target, "prototype");
+  if(JS_IsException(proto))
+    return JS_EXCEPTION;
+
+  obj = nvgjs_color_wrap(ctx, proto, color);
+  JS_FreeValue(ctx, proto);
+  return obj;
+}
+
+static void
+nvgjs_color_finalizer(JSRuntime* rt, JSValue val) {
+  NVGcolor* c;
+
+  if((c = JS_GetOpaque(val, nvgjs_color_class_id)))
+    js_free_rt(rt, c);
+}
+
+static JSClassDef nvgjs_color_class = {
+ "nvgColor",
+ .finalizer = nvgjs_color_finalizer,
+};
+
+/* Indexed getters keep Color usable wherever a 4-element array was expected
+ * (c[0] .. c[3], c.length, spreading via Array.prototype.values). */
 static const JSCFunctionListEntry nvgjs_color_methods[] = {
  JS_CGETSET_MAGIC_DEF("r", nvgjs_color_get, nvgjs_color_set, 0),
  JS_CGETSET_MAGIC_DEF("g", nvgjs_color_get, nvgjs_color_set, 1),
  JS_CGETSET_MAGIC_DEF("b", nvgjs_color_get, nvgjs_color_set, 2),
  JS_CGETSET_MAGIC_DEF("a", nvgjs_color_get, nvgjs_color_set, 3),
+ JS_CGETSET_MAGIC_DEF("0", nvgjs_color_get, nvgjs_color_set, 0),
+ JS_CGETSET_MAGIC_DEF("1", nvgjs_color_get, nvgjs_color_set, 1),
+ JS_CGETSET_MAGIC_DEF("2", nvgjs_color_get, nvgjs_color_set, 2),
+ JS_CGETSET_MAGIC_DEF("3", nvgjs_color_get, nvgjs_color_set, 3),
+ JS_PROP_INT32_DEF("length", 4, JS_PROP_CONFIGURABLE),
  JS_PROP_STRING_DEF("[Symbol.toStringTag]", "nvgColor", JS_PROP_CONFIGURABLE),
 };
 
 static JSValue
-nvgjs_transform_new(JSContext* ctx, float transform[6]) {
-  JSValue buf = JS_NewArrayBufferCopy(ctx, (void*)transform, 6 * sizeof(float));
-  JSValue obj = JS_CallConstructor(ctx, js_float32array_ctor, 1, &buf);
-  JS_FreeValue(ctx, buf);
-  JS_SetPrototype(ctx, obj, transform_proto);
+nvgjs_transform_wrap(JSContext* ctx, JSValueConst proto, const float transform[6]) {
+  float* mat;
+  JSValue obj = JS_IsUndefined(proto) ? JS_NewObjectClass(ctx, nvgjs_transform_class_id)
+                                      : JS_NewObjectProtoClass(ctx, proto, nvgjs_transform_class_id);
+
+  if(JS_IsException(obj))
+    return obj;
+
+  if(!(mat = js_malloc(ctx, 6 * sizeof(float)))) {
+    JS_FreeValue(ctx, obj);
+    return JS_EXCEPTION;
+  }
 
+  memcpy(mat, transform, 6 * sizeof(float));
+  JS_SetOpaque(obj, mat);
   return obj;
 }
 
+static JSValue
+nvgjs_transform_new(JSContext* ctx, float transform[6]) {
+  return nvgjs_transform_wrap(ctx, JS_UNDEFINED, transform);
+}
+
 static JSValue
 nvgjs_transform_get(JSContext* ctx, JSValueConst this_val, int magic) {
-  return JS_GetPropertyUint32(ctx, this_val, magic);
+  float* mat;
+
+  if(!(mat = JS_GetOpaque2(ctx, this_val, nvgjs_transform_class_id)))
+    return JS_EXCEPTION;
+
+  return JS_NewFloat64(ctx, mat[magic]);
 }
 
 static JSValue
 nvgjs_transform_set(JSContext* ctx, JSValueConst this_val, JSValueConst value, int magic) {
-  JS_SetPropertyUint32(ctx, this_val, magic, JS_DupValue(ctx, value));
+  float* mat;
+
+  if(!(mat = JS_GetOpaque2(ctx, this_val, nvgjs_transform_class_id)))
+    return JS_EXCEPTION;
+
+  if(nvgjs_tofloat32(ctx, &mat[magic], value))
+    return JS_EXCEPTION;
+
   return JS_UNDEFINED;
 }
 
+static JSValue
+nvgjs_transform_constructor(JSContext* ctx, JSValueConst new_target, int argc, JSValueConst argv[]) {
+  static NVGJSHint hints[1];
+  float mat[6];
+  JSValue proto, obj;
+
+  nvgTransformIdentity(mat);
+
+  if(argc > 0 && !JS_IsUndefined(argv[0]))
+    if(!nvgjs_transform_arguments(ctx, mat, &hints[0], argc, argv))
+      return JS_ThrowTypeError(ctx, "expecting a transform or 6 numbers");
+
+  proto = JS_GetPropertyStr(ctx, new_target, "prototype");
+  if(JS_IsException(proto))
+    return JS_EXCEPTION;
+
+  obj = nvgjs_transform_wrap(ctx, proto, mat);
+  JS_FreeValue(ctx, proto);
+  return obj;
+}
+
+static void
+nvgjs_transform_finalizer(JSRuntime* rt, JSValue val) {
+  float* mat;
+
+  if((mat = JS_GetOpaque(val, nvgjs_transform_class_id)))
+    js_free_rt(rt, mat);
+}
+
+static JSClassDef nvgjs_transform_class = {
+ "nvgTransform",
+ .finalizer = nvgjs_transform_finalizer,
+};
+
 NVGJS_DECL(Transform, Identity) {
+  static NVGJSHint hints[1];
   float tmp[6], *mat;
   int i = 0;
 
@@ -136,7 +384,7 @@ NVGJS_DECL(Transform, Identity) {
     mat = tmp;
 
     if(argc > 0) {
-      if(!(mat = nvgjs_inputoutputarray(ctx, tmp, 6, argv[i++])))
+      if(!(mat = nvgjs_transform_inout(ctx, tmp, argv[i++], &hints[0])))
         return JS_EXCEPTION;
     }
   }
@@ -150,17 +398,18 @@ NVGJS_DECL(Transform, Identity) {
 }
 
 NVGJS_DECL(Transform, Translate) {
+  static NVGJSHint hints[2];
   float tmp[6], vec[2], *mat;
   int i = 0;
 
   if(!(mat = nvgjs_transform_output(ctx, this_obj))) {
-    if(argc > 1 && JS_IsObject(argv[0]) && (mat = nvgjs_inputoutputarray(ctx, tmp, 6, argv[0])))
+    if(argc > 1 && JS_IsObject(argv[0]) && (mat = nvgjs_transform_inout(ctx, tmp, argv[0], &hints[0])))
       i++;
     else
       mat = tmp;
   }
 
-  if(!nvgjs_arguments(ctx, vec, 2, argc - i, argv + i))
+  if(!nvgjs_arguments(ctx, vec, 2, nvgjs_state(ctx)->vector_keys, &hints[1], argc - i, argv + i))
     return JS_ThrowInternalError(ctx, "need x, y arguments");
 
   nvgTransformTranslate(mat, vec[0], vec[1]);
@@ -172,17 +421,18 @@ NVGJS_DECL(Transform, Translate) {
 }
 
 NVGJS_DECL(Transform, Scale) {
+  static NVGJSHint hints[2];
   float tmp[6], vec[2], *mat;
   int i = 0;
 
   if(!(mat = nvgjs_transform_output(ctx, this_obj))) {
-    if(argc > 1 && JS_IsObject(argv[0]) && (mat = nvgjs_inputoutputarray(ctx, tmp, 6, argv[0])))
+    if(argc > 1 && JS_IsObject(argv[0]) && (mat = nvgjs_transform_inout(ctx, tmp, argv[0], &hints[0])))
       i++;
     else
       mat = tmp;
   }
 
-  if(!nvgjs_arguments(ctx, vec, 2, argc - i, argv + i))
+  if(!nvgjs_arguments(ctx, vec, 2, nvgjs_state(ctx)->vector_keys, &hints[1], argc - i, argv + i))
     return JS_ThrowInternalError(ctx, "need x, y or vector arguments");
 
   nvgTransformScale(mat, vec[0], vec[1]);
@@ -194,12 +444,13 @@ NVGJS_DECL(Transform, Scale) {
 }
 
 NVGJS_DECL(Transform, Rotate) {
+  static NVGJSHint hints[1];
   float tmp[6], *mat;
   double angle;
   int i = 0;
 
   if(!(mat = nvgjs_transform_output(ctx, this_obj))) {
-    if(argc > 1 && JS_IsObject(argv[0]) && (mat = nvgjs_inputoutputarray(ctx, tmp, 6, argv[0])))
+    if(argc > 1 && JS_IsObject(argv[0]) && (mat = nvgjs_transform_inout(ctx, tmp, argv[0], &hints[0])))
       i++;
     else
       mat = tmp;
@@ -220,12 +471,13 @@ NVGJS_DECL(Transform, Rotate) {
 }
 
 NVGJS_DECL(Transform, SkewX) {
+  static NVGJSHint hints[1];
   float tmp[6], *mat;
   double angle;
   int i = 0;
 
   if(!(mat = nvgjs_transform_output(ctx, this_obj))) {
-    if(argc > 1 && JS_IsObject(argv[0]) && (mat = nvgjs_inputoutputarray(ctx, tmp, 6, argv[0])))
+    if(argc > 1 && JS_IsObject(argv[0]) && (mat = nvgjs_transform_inout(ctx, tmp, argv[0], &hints[0])))
       i++;
     else
       mat = tmp;
@@ -246,12 +498,13 @@ NVGJS_DECL(Transform, SkewX) {
 }
 
 NVGJS_DECL(Transform, SkewY) {
+  static NVGJSHint hints[1];
   float tmp[6], *mat;
   double angle;
   int i = 0;
 
   if(!(mat = nvgjs_transform_output(ctx, this_obj))) {
-    if(argc > 1 && JS_IsObject(argv[0]) && (mat = nvgjs_inputoutputarray(ctx, tmp, 6, argv[0])))
+    if(argc > 1 && JS_IsObject(argv[0]) && (mat = nvgjs_transform_inout(ctx, tmp, argv[0], &hints[0])))
       i++;
     else
       mat = tmp;
@@ -272,11 +525,12 @@ NVGJS_DECL(Transform, SkewY) {
 }
 
 NVGJS_DECL(Transform, Multiply) {
+  static NVGJSHint hints[2];
   float tmp[6], src[6], *mat;
   int n, i = 0;
 
   if(!(mat = nvgjs_transform_output(ctx, this_obj))) {
-    if(argc > 1 && (mat = nvgjs_inputoutputarray(ctx, tmp, 6, argv[0])))
+    if(argc > 1 && (mat = nvgjs_transform_inout(ctx, tmp, argv[0], &hints[0])))
       i++;
     else
       mat = tmp;
@@ -291,7 +545,7 @@ NVGJS_DECL(Transform, Multiply) {
     return JS_ThrowInternalError(ctx, "need %d arguments", 1 + i);
 
   while(i < argc) {
-    if(!(n = nvgjs_arguments(ctx, src, 6, argc - i, argv + i)))
+    if(!(n = nvgjs_transform_arguments(ctx, src, &hints[1], argc - i, argv + i)))
       break;
 
     nvgTransformMultiply(mat, src);
@@ -306,11 +560,12 @@ NVGJS_DECL(Transform, Multiply) {
 }
 
 NVGJS_DECL(Transform, Premultiply) {
+  static NVGJSHint hints[2];
   float tmp[6], src[6], *mat;
   int i = 0;
 
   if(!(mat = nvgjs_transform_output(ctx, this_obj))) {
-    if(argc > 1 && (mat = nvgjs_inputoutputarray(ctx, tmp, 6, argv[0])))
+    if(argc > 1 && (mat = nvgjs_transform_inout(ctx, tmp, argv[0], &hints[0])))
       i++;
     else
       mat = tmp;
@@ -325,7 +580,7 @@ NVGJS_DECL(Transform, Premultiply) {
     return JS_ThrowInternalError(ctx, "need %d arguments", 1 + i);
 
   for(int n; i < argc; i += n) {
-    if(!(n = nvgjs_arguments(ctx, src, 6, argc - i, argv + i)))
+    if(!(n = nvgjs_transform_arguments(ctx, src, &hints[1], argc - i, argv + i)))
       break;
 
     nvgTransformPremultiply(mat, src);
@@ -338,11 +593,12 @@ NVGJS_DECL(Transform, Premultiply) {
 }
 
 NVGJS_DECL(Transform, Inverse) {
+  static NVGJSHint hints[2];
   float tmp[6], src[6], *mat;
   int ret, i = 0;
 
   if(!(mat = nvgjs_transform_output(ctx, this_obj))) {
-    if(argc > 0 && (mat = nvgjs_inputoutputarray(ctx, tmp, 6, argv[0])))
+    if(argc > 0 && (mat = nvgjs_transform_inout(ctx, tmp, argv[0], &hints[0])))
       i++;
     else
       mat = tmp;
@@ -351,7 +607,8 @@ NVGJS_DECL(Transform, Inverse) {
   if(argc < 1 + i)
     return JS_ThrowInternalError(ctx, "need %d arguments", 1 + i);
 
-  nvgjs_inputarray(ctx, src, 6, argv[i]);
+  if(nvgjs_totransform(ctx, src, argv[i], &hints[1]))
+    return JS_EXCEPTION;
 
   if(!(ret = nvgTransformInverse(mat, src)))
     return JS_ThrowInternalError(ctx, "nvgTransformInverse failed");
@@ -376,8 +633,13 @@ enum {
 
 static JSValue
 nvgjs_transform_function(JSContext* ctx, JSValueConst this_obj, int argc, JSValueConst argv[], int magic) {
+  static NVGJSHint hints[3];
 
-  float *mat = nvgjs_transform_output(ctx, this_obj), tmp[6];
+  float *mat, tmp[6];
+
+  /* nvgjs_transform_output() lets the constructor through for the statics */
+  if(!(mat = nvgjs_transform_output(ctx, this_obj)))
+    return JS_ThrowTypeError(ctx, "not a Transform instance");
 
   switch(magic) {
     case TRANSFORM_TRANSLATE: {
@@ -421,7 +683,7 @@ nvgjs_transform_function(JSContext* ctx, JSValueConst this_obj, int argc, JSValu
     }
 
     case TRANSFORM_MULTIPLY: {
-      if(!nvgjs_arguments(ctx, tmp, 6, argc, argv))
+      if(!nvgjs_transform_arguments(ctx, tmp, &hints[0], argc, argv))
         nvgTransformIdentity(tmp);
 
       nvgTransformMultiply(mat, tmp);
@@ -430,7 +692,7 @@ nvgjs_transform_function(JSContext* ctx, JSValueConst this_obj, int argc, JSValu
     }
 
     case TRANSFORM_PREMULTIPLY: {
-      if(!nvgjs_arguments(ctx, tmp, 6, argc, argv))
+      if(!nvgjs_transform_arguments(ctx, tmp, &hints[1], argc, argv))
         nvgTransformIdentity(tmp);
 
       nvgTransformPremultiply(mat, tmp);
@@ -447,7 +709,7 @@ nvgjs_transform_function(JSContext* ctx, JSValueConst this_obj, int argc, JSValu
 
     case TRANSFORM_POINT: {
       float in[2], out[2];
-      nvgjs_arguments(ctx, in, 2, argc, argv);
+      nvgjs_arguments(ctx, in, 2, nvgjs_state(ctx)->vector_keys, &hints[2], argc, argv);
 
       nvgTransformPoint(&out[0], &out[1], mat, in[0], in[1]);
 
@@ -474,6 +736,14 @@ static const JSCFunctionListEntry nvgjs_transform_methods[] = {
  JS_CGETSET_MAGIC_DEF("x0", nvgjs_transform_get, nvgjs_transform_set, 4),
  JS_CGETSET_MAGIC_DEF("y0", nvgjs_transform_get, nvgjs_transform_set, 5),
 
+ JS_CGETSET_MAGIC_DEF("0", nvgjs_transform_get, nvgjs_transform_set, 0),
+ JS_CGETSET_MAGIC_DEF("1", nvgjs_transform_get, nvgjs_transform_set, 1),
+ JS_CGETSET_MAGIC_DEF("2", nvgjs_transform_get, nvgjs_transform_set, 2),
+ JS_CGETSET_MAGIC_DEF("3", nvgjs_transform_get, nvgjs_transform_set, 3),
+ JS_CGETSET_MAGIC_DEF("4", nvgjs_transform_get, nvgjs_transform_set, 4),
+ JS_CGETSET_MAGIC_DEF("5", nvgjs_transform_get, nvgjs_transform_set, 5),
+ JS_PROP_INT32_DEF("length", 6, JS_PROP_CONFIGURABLE),
+
  JS_CFUNC_MAGIC_DEF("Translate", 2, nvgjs_transform_function, TRANSFORM_TRANSLATE),
  JS_CFUNC_MAGIC_DEF("Scale", 2, nvgjs_transform_function, TRANSFORM_SCALE),
  JS_CFUNC_MAGIC_DEF("Rotate", 1, nvgjs_transform_function, TRANSFORM_ROTATE),
@@ -565,1479 +835,3426 @@ static const JSCFunctionListEntry nvgjs_paint_methods[] = {
  JS_PROP_STRING_DEF("[Symbol.toStringTag]", "nvgPaint", JS_PROP_CONFIGURABLE),
 };
 
-static JSValue
-nvgjs_context_wrap(JSContext* ctx, JSValueConst proto, NVGcontext* nvg) {
-  JSValue obj = JS_NewObjectProtoClass(ctx, proto, nvgjs_context_class_id);
-
-  if(!JS_IsException(obj))
-    JS_SetOpaque(obj, nvg);
-
-  return obj;
-}
+typedef struct {
+  float* cmds;
+  size_t len, size;
+  uint64_t hash; /* nvgjs_tesscache_hash() of cmds, 0 until needed */
+} NVGJSPath;
 
-static void
-nvgjs_context_finalizer(JSRuntime* rt, JSValue val) {
-  /* Intentionally do NOT call nvgDeleteGL[23] here: the finalizer may run
-   * after the owning GL context (owned by the glfw module) has been destroyed,
-   * in which case tearing down NanoVG's GL resources would crash. Callers
-   * that care about deterministic cleanup must call DeleteGL3(nvg) (or GL2)
-   * *before* their window is destroyed. */
-  (void)rt;
-  (void)val;
-}
+#define NVGJS_PATH(this_obj) \
+  NVGJSPath* path; \
+  if(!(path = JS_GetOpaque2(ctx, this_obj, nvgjs_path_class_id))) \
+    return JS_EXCEPTION;
 
-static JSClassDef nvgjs_context_class = {
- .class_name = "NVGcontext",
- .finalizer = nvgjs_context_finalizer,
-};
+static float*
+nvgjs_path_alloc(JSContext* ctx, NVGJSPath* path, size_t n) {
+  if(path->len + n > path->size) {
+    size_t size = path->size ? path->size * 2 : 64;
+    float* cmds;
 
-#ifdef NANOVG_GL2
-NVGJS_DECL(func, CreateGL2) {
-  int32_t flags = 0;
+    while(size < path->len + n)
+      size *= 2;
 
-  if(argc < 1)
-    return JS_ThrowInternalError(ctx, "need 1 arguments");
+    if(!(cmds = js_realloc(ctx, path->cmds, size * sizeof(float))))
+      return 0;
 
-  if(JS_ToInt32(ctx, &flags, argv[0]))
-    return JS_EXCEPTION;
+    path->cmds = cmds;
+    path->size = size;
+  }
 
-  return nvgjs_context_wrap(ctx, context_proto, nvgCreateGL2(flags));
+  path->len += n;
+  path->hash = 0;
+  return &path->cmds[path->len - n];
 }
 
-NVGJS_DECL(func, DeleteGL2) {
-  NVGJS_CONTEXT(argv[0]);
+static JSValue
+nvgjs_path_function(JSContext* ctx, JSValueConst this_obj, int argc, JSValueConst argv[], int magic) {
+  NVGJS_PATH(this_obj);
 
-  if(nvg) {
-    nvgDeleteGL2(nvg);
-    JS_SetOpaque(argv[0], 0);
-  }
+  int arity = nvgjs_command_arity[magic];
+  float args[8], *out;
 
-  return JS_UNDEFINED;
-}
+  if(argc < arity)
+    return JS_ThrowInternalError(ctx, "need %d arguments", arity);
 
-NVGJS_DECL(func, CreateImageFromHandleGL2) {
-  NVGJS_CONTEXT(argv[0]);
+  for(int i = 0; i < arity; i++)
+    if(nvgjs_tofloat32(ctx, &args[i], argv[i]))
+      return JS_EXCEPTION;
 
-  uint32_t textureId;
-  int32_t w, h, imageFlags;
+  /* replay would stop at the command, dropping the rest of the path */
+  if(!nvgjs_command_intarg(magic, args))
+    return JS_ThrowRangeError(ctx, "integer argument out of range");
 
-  if(JS_ToUint32(ctx, &textureId, argv[1]))
+  if(!(out = nvgjs_path_alloc(ctx, path, 1 + arity)))
     return JS_EXCEPTION;
 
-  if(JS_ToInt32(ctx, &w, argv[2]))
-    return JS_EXCEPTION;
+  out[0] = magic;
+  memcpy(&out[1], args, arity * sizeof(float));
 
-  if(JS_ToInt32(ctx, &h, argv[3]))
-    return JS_EXCEPTION;
+  return JS_DupValue(ctx, this_obj);
+}
 
-  if(JS_ToInt32(ctx, &imageFlags, argv[4]))
-    return JS_EXCEPTION;
+NVGJS_DECL(Path, Clear) {
+  NVGJS_PATH(this_obj);
 
-  return JS_NewInt32(ctx, nvglCreateImageFromHandleGL2(nvg, textureId, w, h, imageFlags));
+  path->len = 0;
+  path->hash = 0;
+  return JS_DupValue(ctx, this_obj);
 }
 
-NVGJS_DECL(func, ImageHandleGL2) {
-  NVGJS_CONTEXT(argv[0]);
+static JSValue
+nvgjs_path_get_length(JSContext* ctx, JSValueConst this_val) {
+  NVGJS_PATH(this_val);
 
-  int32_t imageHandle;
+  return JS_NewUint32(ctx, path->len);
+}
 
-  if(JS_ToInt32(ctx, &imageHandle, argv[1]))
-    return JS_EXCEPTION;
+static void
+nvgjs_path_finalizer(JSRuntime* rt, JSValue val) {
+  NVGJSPath* path;
 
-  return JS_NewUint32(ctx, nvglImageHandleGL2(nvg, imageHandle));
+  if((path = JS_GetOpaque(val, nvgjs_path_class_id))) {
+    js_free_rt(rt, path->cmds);
+    js_free_rt(rt, path);
+  }
 }
-#endif
 
-#ifdef NANOVG_GL3
-NVGJS_DECL(func, CreateGL3) {
-  int32_t flags = 0;
+static JSValue
+nvgjs_path_constructor(JSContext* ctx, JSValueConst new_target, int argc, JSValueConst* argv) {
+  NVGJSPath *path, *src = 0;
+  JSValue proto, obj = JS_UNDEFINED;
 
-  if(argc < 1)
-    return JS_ThrowInternalError(ctx, "need 1 arguments");
+  if(argc > 0 && !JS_IsUndefined(argv[0]))
+    if(!(src = JS_GetOpaque2(ctx, argv[0], nvgjs_path_class_id)))
+      return JS_EXCEPTION;
 
-  if(JS_ToInt32(ctx, &flags, argv[0]))
+  if(!(path = js_mallocz(ctx, sizeof(*path))))
     return JS_EXCEPTION;
 
-#ifdef NANOVG_GLEW
-  glewExperimental = GL_TRUE;
+  if(src && src->len) {
+    if(!nvgjs_path_alloc(ctx, path, src->len))
+      goto fail;
 
-  if(glewInit() != GLEW_OK) {
-    return JS_ThrowInternalError(ctx, "nvg.CreateGL3: Could not init glew.\n");
+    memcpy(path->cmds, src->cmds, src->len * sizeof(float));
   }
-#endif
 
-  // GLEW generates GL error because it calls glGetString(GL_EXTENSIONS), we'll
-  // consume it here.
-  glGetError();
+  proto = JS_GetPropertyStr(ctx, new_target, "prototype");
+  if(JS_IsException(proto))
+    goto fail;
 
-  return nvgjs_context_wrap(ctx, context_proto, nvgCreateGL3(flags));
-}
+  obj = JS_NewObjectProtoClass(ctx, proto, nvgjs_path_class_id);
+  JS_FreeValue(ctx, proto);
 
-NVGJS_DECL(func, DeleteGL3) {
-  NVGJS_CONTEXT(argv[0]);
+  if(JS_IsException(obj))
+    goto fail;
 
-  if(nvg) {
-    nvgDeleteGL3(nvg);
-    JS_SetOpaque(argv[0], 0);
-  }
+  JS_SetOpaque(obj, path);
+  return obj;
 
-  return JS_UNDEFINED;
+fail:
+  js_free(ctx, path->cmds);
+  js_free(ctx, path);
+  JS_FreeValue(ctx, obj);
+  return JS_EXCEPTION;
 }
 
-NVGJS_DECL(func, CreateImageFromHandleGL3) {
-  NVGJS_CONTEXT(argv[0]);
+static JSClassDef nvgjs_path_class = {
+ "nvgPath",
+ .finalizer = nvgjs_path_finalizer,
+};
 
-  uint32_t textureId;
-  int32_t w, h, imageFlags;
+static const JSCFunctionListEntry nvgjs_path_methods[] = {
+ JS_CFUNC_MAGIC_DEF("MoveTo", 2, nvgjs_path_function, NVGJS_OP_MOVE_TO),
+ JS_CFUNC_MAGIC_DEF("LineTo", 2, nvgjs_path_function, NVGJS_OP_LINE_TO),
+ JS_CFUNC_MAGIC_DEF("BezierTo", 6, nvgjs_path_function, NVGJS_OP_BEZIER_TO),
+ JS_CFUNC_MAGIC_DEF("QuadTo", 4, nvgjs_path_function, NVGJS_OP_QUAD_TO),
+ JS_CFUNC_MAGIC_DEF("ArcTo", 5, nvgjs_path_function, NVGJS_OP_ARC_TO),
+ JS_CFUNC_MAGIC_DEF("Arc", 6, nvgjs_path_function, NVGJS_OP_ARC),
+ JS_CFUNC_MAGIC_DEF("Rect", 4, nvgjs_path_function, NVGJS_OP_RECT),
+ JS_CFUNC_MAGIC_DEF("RoundedRect", 5, nvgjs_path_function, NVGJS_OP_ROUNDED_RECT),
+ JS_CFUNC_MAGIC_DEF("RoundedRectVarying", 8, nvgjs_path_function, NVGJS_OP_ROUNDED_RECT_VARYING),
+ JS_CFUNC_MAGIC_DEF("Ellipse", 4, nvgjs_path_function, NVGJS_OP_ELLIPSE),
+ JS_CFUNC_MAGIC_DEF("Circle", 3, nvgjs_path_function, NVGJS_OP_CIRCLE),
+ JS_CFUNC_MAGIC_DEF("ClosePath", 0, nvgjs_path_function, NVGJS_OP_CLOSE_PATH),
+ JS_CFUNC_MAGIC_DEF("PathWinding", 1, nvgjs_path_function, NVGJS_OP_PATH_WINDING),
+ NVGJS_METHOD(Path, Clear, 0),
+ JS_CGETSET_DEF("length", nvgjs_path_get_length, 0),
+ JS_PROP_STRING_DEF("[Symbol.toStringTag]", "nvgPath", JS_PROP_CONFIGURABLE),
+};
 
-  if(JS_ToUint32(ctx, &textureId, argv[1]))
+#define NVGJS_SPATIAL(this_obj) \
+  NVGJSSpatial* spatial; \
+  if(!(spatial = JS_GetOpaque2(ctx, this_obj, nvgjs_spatial_class_id))) \
     return JS_EXCEPTION;
 
-  if(JS_ToInt32(ctx, &w, argv[2]))
-    return JS_EXCEPTION;
+/* minx, miny, maxx, maxy from x, y [, x1, y1] arguments; a point without x1 */
+static int
+nvgjs_spatial_box(JSContext* ctx, float box[4], int argc, JSValueConst argv[]) {
+  int n = argc >= 4 && !JS_IsUndefined(argv[2]) ? 4 : 2;
 
-  if(JS_ToInt32(ctx, &h, argv[3]))
-    return JS_EXCEPTION;
+  if(argc < 2) {
+    JS_ThrowInternalError(ctx, "need 2 arguments");
+    return -1;
+  }
 
-  if(JS_ToInt32(ctx, &imageFlags, argv[4]))
-    return JS_EXCEPTION;
+  for(int i = 0; i < n; i++)
+    if(nvgjs_tofloat32(ctx, &box[i], argv[i]))
+      return -1;
+
+  if(n == 2) {
+    box[2] = box[0];
+    box[3] = box[1];
+  }
 
-  return JS_NewInt32(ctx, nvglCreateImageFromHandleGL3(nvg, textureId, w, h, imageFlags));
+  return 0;
 }
 
-NVGJS_DECL(func, ImageHandleGL3) {
-  NVGJS_CONTEXT(argv[0]);
+static int
+nvgjs_spatial_id(JSContext* ctx, NVGJSSpatial* spatial, size_t* pid, JSValueConst value) {
+  int64_t id;
 
-  int32_t imageHandle;
+  if(JS_ToInt64(ctx, &id, value))
+    return -1;
 
-  if(JS_ToInt32(ctx, &imageHandle, argv[1]))
-    return JS_EXCEPTION;
+  if(id < 0 || (uint64_t)id >= nvgjs_spatial_count(spatial)) {
+    JS_ThrowRangeError(ctx, "id %" PRId64 " out of range", id);
+    return -1;
+  }
 
-  return JS_NewUint32(ctx, nvglImageHandleGL3(nvg, imageHandle));
+  *pid = id;
+  return 0;
 }
-#endif
 
-NVGJS_DECL(func, CreateFramebuffer) {
-  NVGJS_CONTEXT(argv[0]);
+/* The optional Int32Array (or any buffer) query results go to */
+static int
+nvgjs_spatial_out(JSContext* ctx, int32_t** pout, size_t* pmax, int argc, JSValueConst argv[], int i) {
+  size_t len;
 
-  int32_t w, h, imageFlags;
-
-  if(JS_ToInt32(ctx, &w, argv[1]))
-    return JS_EXCEPTION;
-
-  if(JS_ToInt32(ctx, &h, argv[2]))
-    return JS_EXCEPTION;
-
-  if(JS_ToInt32(ctx, &imageFlags, argv[3]))
-    return JS_EXCEPTION;
+  *pout = 0;
+  *pmax = 0;
 
-  NVGLUframebuffer* fb;
+  if(i >= argc || JS_IsUndefined(argv[i]))
+    return 0;
 
-  if(!(fb = nvgluCreateFramebuffer(nvg, w, h, imageFlags)))
-    return JS_ThrowInternalError(ctx, "Failed creating NVGLUframebuffer [%ix%i] (%i)", w, h, imageFlags);
+  if(!(*pout = (int32_t*)nvgjs_bytes(ctx, &len, argv[i])))
+    return -1;
 
-  return nvgjs_framebuffer_wrap(ctx, framebuffer_proto, fb);
+  *pmax = len / sizeof(int32_t);
+  return 0;
 }
 
-NVGJS_DECL(func, BindFramebuffer) {
-  NVGLUframebuffer* fb = 0;
-
-  if(!JS_IsNull(argv[0]))
-    if(!(fb = JS_GetOpaque2(ctx, argv[0], nvgjs_framebuffer_class_id)))
-      return JS_EXCEPTION;
-
-  nvgluBindFramebuffer(fb);
+NVGJS_DECL(SpatialIndex, Add) {
+  NVGJS_SPATIAL(this_obj);
 
-  return JS_UNDEFINED;
-}
+  size_t id = nvgjs_spatial_count(spatial);
+  float box[4];
 
-NVGJS_DECL(func, DeleteFramebuffer) {
-  NVGJS_FRAMEBUFFER(argv[0]);
+  if(nvgjs_spatial_box(ctx, box, argc, argv))
+    return JS_EXCEPTION;
 
-  nvgluDeleteFramebuffer(fb);
-  JS_SetOpaque(argv[0], 0);
+  if(nvgjs_spatial_set(spatial, id, box))
+    return JS_ThrowOutOfMemory(ctx);
 
-  return JS_UNDEFINED;
+  return JS_NewInt64(ctx, id);
 }
 
-NVGJS_DECL(func, ReadPixels) {
-  uint32_t w, h;
+NVGJS_DECL(SpatialIndex, Update) {
+  NVGJS_SPATIAL(this_obj);
 
-  JS_ToUint32(ctx, &w, argv[0]);
-  JS_ToUint32(ctx, &h, argv[1]);
+  size_t id;
+  float box[4];
 
-  void* image;
+  if(argc < 3)
+    return JS_ThrowInternalError(ctx, "need 3 arguments");
 
-  /* XXX: better write to a provided ArrayBuffer */
-  if(!(image = js_malloc(ctx, w * h * 4)))
+  if(nvgjs_spatial_id(ctx, spatial, &id, argv[0]) || nvgjs_spatial_box(ctx, box, argc - 1, argv + 1))
     return JS_EXCEPTION;
 
-  glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, image);
+  if(nvgjs_spatial_set(spatial, id, box))
+    return JS_ThrowOutOfMemory(ctx);
 
-  return JS_NewArrayBuffer(ctx, image, w * h * 4, nvgjs_arraybuffer_free, NULL, FALSE);
+  return JS_UNDEFINED;
 }
 
-NVGJS_DECL(func, DegToRad) {
-  double arg;
-
-  if(argc < 1)
-    return JS_ThrowInternalError(ctx, "need 1 arguments");
-
-  if(JS_ToFloat64(ctx, &arg, argv[0]))
-    return JS_EXCEPTION;
-
-  return JS_NewFloat64(ctx, nvgDegToRad(arg));
-}
+NVGJS_DECL(SpatialIndex, Remove) {
+  NVGJS_SPATIAL(this_obj);
 
-NVGJS_DECL(func, RadToDeg) {
-  double arg;
+  static const float none[4] = {NAN, NAN, NAN, NAN};
+  size_t id;
 
   if(argc < 1)
     return JS_ThrowInternalError(ctx, "need 1 arguments");
 
-  if(JS_ToFloat64(ctx, &arg, argv[0]))
+  if(nvgjs_spatial_id(ctx, spatial, &id, argv[0]))
     return JS_EXCEPTION;
 
-  return JS_NewFloat64(ctx, nvgRadToDeg(arg));
+  nvgjs_spatial_set(spatial, id, none);
+  return JS_UNDEFINED;
 }
 
-NVGJS_DECL(func, RGB) {
-  int32_t r, g, b;
-
-  if(argc < 3)
-    return JS_ThrowInternalError(ctx, "need 3 arguments");
-
-  if(JS_ToInt32(ctx, &r, argv[0]) || JS_ToInt32(ctx, &g, argv[1]) || JS_ToInt32(ctx, &b, argv[2]))
-    return JS_EXCEPTION;
-
-  return nvgjs_color_new(ctx, nvgRGB(r, g, b));
-}
+NVGJS_DECL(SpatialIndex, QueryPoint) {
+  NVGJS_SPATIAL(this_obj);
 
-NVGJS_DECL(func, RGBf) {
-  double r, g, b;
+  float pt[4], radius;
+  int32_t* out;
+  size_t max;
 
   if(argc < 3)
     return JS_ThrowInternalError(ctx, "need 3 arguments");
 
-  if(JS_ToFloat64(ctx, &r, argv[0]) || JS_ToFloat64(ctx, &g, argv[1]) || JS_ToFloat64(ctx, &b, argv[2]))
+  if(nvgjs_tofloat32(ctx, &pt[0], argv[0]) || nvgjs_tofloat32(ctx, &pt[1], argv[1]) ||
+     nvgjs_tofloat32(ctx, &radius, argv[2]))
     return JS_EXCEPTION;
 
-  return nvgjs_color_new(ctx, nvgRGBf(r, g, b));
-}
-
-NVGJS_DECL(func, RGBA) {
-  int32_t r, g, b, a;
-
-  if(argc < 4)
-    return JS_ThrowInternalError(ctx, "need 4 arguments");
+  if(!(radius >= 0))
+    return JS_ThrowRangeError(ctx, "radius must be >= 0");
 
-  if(JS_ToInt32(ctx, &r, argv[0]) || JS_ToInt32(ctx, &g, argv[1]) || JS_ToInt32(ctx, &b, argv[2]) ||
-     JS_ToInt32(ctx, &a, argv[3]))
+  if(nvgjs_spatial_out(ctx, &out, &max, argc, argv, 3))
     return JS_EXCEPTION;
 
-  return nvgjs_color_new(ctx, nvgRGBA(r, g, b, a));
+  pt[2] = pt[0];
+  pt[3] = pt[1];
+
+  return JS_NewInt64(ctx, nvgjs_spatial_query(spatial, pt, radius, out, max));
 }
 
-NVGJS_DECL(func, RGBAf) {
-  double r, g, b, a;
+NVGJS_DECL(SpatialIndex, QueryRect) {
+  NVGJS_SPATIAL(this_obj);
+
+  float rect[4];
+  int32_t* out;
+  size_t max;
 
   if(argc < 4)
     return JS_ThrowInternalError(ctx, "need 4 arguments");
 
-  if(JS_ToFloat64(ctx, &r, argv[0]) || JS_ToFloat64(ctx, &g, argv[1]) || JS_ToFloat64(ctx, &b, argv[2]) ||
-     JS_ToFloat64(ctx, &a, argv[3]))
-    return JS_EXCEPTION;
-
-  return nvgjs_color_new(ctx, nvgRGBAf(r, g, b, a));
-}
+  for(int i = 0; i < 4; i++)
+    if(nvgjs_tofloat32(ctx, &rect[i], argv[i]))
+      return JS_EXCEPTION;
 
-NVGJS_DECL(func, LerpRGBA) {
-  NVGcolor c0, c1;
-  double u;
+  if(nvgjs_spatial_out(ctx, &out, &max, argc, argv, 4))
+    return JS_EXCEPTION;
 
-  if(argc < 3)
-    return JS_ThrowInternalError(ctx, "need 3 arguments");
+  /* corners in any order, as for Update() */
+  if(rect[0] > rect[2]) {
+    float t = rect[0];
+    rect[0] = rect[2];
+    rect[2] = t;
+  }
 
-  if(nvgjs_tocolor(ctx, &c0, argv[0]) || nvgjs_tocolor(ctx, &c1, argv[1]) || JS_ToFloat64(ctx, &u, argv[2]))
-    return JS_EXCEPTION;
+  if(rect[1] > rect[3]) {
+    float t = rect[1];
+    rect[1] = rect[3];
+    rect[3] = t;
+  }
 
-  return nvgjs_color_new(ctx, nvgLerpRGBA(c0, c1, u));
+  return JS_NewInt64(ctx, nvgjs_spatial_query(spatial, rect, 0, out, max));
 }
 
-NVGJS_DECL(func, TransRGBA) {
-  NVGcolor c;
-  int32_t a;
+NVGJS_DECL(SpatialIndex, Nearest) {
+  NVGJS_SPATIAL(this_obj);
+
+  float x, y, radius = INFINITY;
 
   if(argc < 2)
     return JS_ThrowInternalError(ctx, "need 2 arguments");
 
-  if(nvgjs_tocolor(ctx, &c, argv[0]) || JS_ToInt32(ctx, &a, argv[1]))
+  if(nvgjs_tofloat32(ctx, &x, argv[0]) || nvgjs_tofloat32(ctx, &y, argv[1]))
     return JS_EXCEPTION;
 
-  return nvgjs_color_new(ctx, nvgTransRGBA(c, a));
-}
-
-NVGJS_DECL(func, TransRGBAf) {
-  NVGcolor c;
-  double a;
-
-  if(argc < 2)
-    return JS_ThrowInternalError(ctx, "need 2 arguments");
-
-  if(nvgjs_tocolor(ctx, &c, argv[0]) || JS_ToFloat64(ctx, &a, argv[1]))
+  if(argc > 2 && !JS_IsUndefined(argv[2]) && nvgjs_tofloat32(ctx, &radius, argv[2]))
     return JS_EXCEPTION;
 
-  return nvgjs_color_new(ctx, nvgTransRGBAf(c, a));
+  if(!(radius >= 0))
+    return JS_ThrowRangeError(ctx, "radius must be >= 0");
+
+  return JS_NewInt32(ctx, nvgjs_spatial_nearest(spatial, x, y, radius));
 }
 
-NVGJS_DECL(func, HSL) {
-  double h, s, l;
+static JSValue
+nvgjs_spatial_get_length(JSContext* ctx, JSValueConst this_val) {
+  NVGJS_SPATIAL(this_val);
 
-  if(argc < 3)
-    return JS_ThrowInternalError(ctx, "need 3 arguments");
+  return JS_NewInt64(ctx, nvgjs_spatial_count(spatial));
+}
 
-  if(JS_ToFloat64(ctx, &h, argv[0]) || JS_ToFloat64(ctx, &s, argv[1]) || JS_ToFloat64(ctx, &l, argv[2]))
-    return JS_EXCEPTION;
+static JSValue
+nvgjs_spatial_get_cell_size(JSContext* ctx, JSValueConst this_val) {
+  NVGJS_SPATIAL(this_val);
 
-  return nvgjs_color_new(ctx, nvgHSL(h, s, l));
+  return JS_NewFloat64(ctx, nvgjs_spatial_cell(spatial));
 }
 
-NVGJS_DECL(func, HSLA) {
-  double h, s, l;
-  int32_t a;
+static void
+nvgjs_spatial_finalizer(JSRuntime* rt, JSValue val) {
+  nvgjs_spatial_free(JS_GetOpaque(val, nvgjs_spatial_class_id));
+}
 
-  if(argc < 4)
-    return JS_ThrowInternalError(ctx, "need 4 arguments");
+static JSValue
+nvgjs_spatial_constructor(JSContext* ctx, JSValueConst new_target, int argc, JSValueConst* argv) {
+  NVGJSSpatial* spatial;
+  JSValue proto, obj;
+  float *coords = 0, cell = 0;
+  int32_t stride = 2;
+  int length = 0;
+
+  if(argc > 0 && !JS_IsUndefined(argv[0]) && !JS_IsNull(argv[0]))
+    if(!(coords = nvgjs_outputarray(ctx, &length, argv[0])))
+      return JS_EXCEPTION;
 
-  if(JS_ToFloat64(ctx, &h, argv[0]) || JS_ToFloat64(ctx, &s, argv[1]) || JS_ToFloat64(ctx, &l, argv[2]) ||
-     JS_ToInt32(ctx, &a, argv[3]))
+  if(argc > 1 && !JS_IsUndefined(argv[1]) && JS_ToInt32(ctx, &stride, argv[1]))
     return JS_EXCEPTION;
 
-  return nvgjs_color_new(ctx, nvgHSLA(h, s, l, a));
-}
-
-NVGJS_DECL(func, TransformPoint) {
-  float trf[6], *dst, src[2];
-  int size, i = 0;
-
-  if(argc < 2)
-    return JS_ThrowInternalError(ctx, "need 2 arguments");
+  if(stride != 2 && stride != 4)
+    return JS_ThrowRangeError(ctx, "stride must be 2 (points) or 4 (boxes)");
 
-  if(!(dst = nvgjs_outputarray(ctx, &size, argv[0])))
+  if(argc > 2 && !JS_IsUndefined(argv[2]) && nvgjs_tofloat32(ctx, &cell, argv[2]))
     return JS_EXCEPTION;
 
-  if(nvgjs_inputarray(ctx, trf, 6, argv[1]))
-    return JS_EXCEPTION;
+  if(!(cell >= 0 && cell < INFINITY))
+    return JS_ThrowRangeError(ctx, "cellSize must be finite and >= 0");
 
-  if(argc > 2) {
-    for(; size >= 2; size -= 2, dst += 2, i++) {
-      int r;
+  if(!(spatial = nvgjs_spatial_new(coords, length / stride, stride, cell)))
+    return JS_ThrowOutOfMemory(ctx);
 
-      if(!(r = nvgjs_arguments(ctx, src, 2, argc - 2, argv + 2)))
-        break;
+  proto = JS_GetPropertyStr(ctx, new_target, "prototype");
+  if(JS_IsException(proto))
+    goto fail;
 
-      argc -= r;
-      argv += r;
+  obj = JS_NewObjectProtoClass(ctx, proto, nvgjs_spatial_class_id);
+  JS_FreeValue(ctx, proto);
 
-      nvgTransformPoint(&dst[0], &dst[1], trf, src[0], src[1]);
-    }
+  if(JS_IsException(obj))
+    goto fail;
 
-  } else {
-    for(; size >= 2; size -= 2, dst += 2, i++)
-      nvgTransformPoint(&dst[0], &dst[1], trf, dst[0], dst[1]);
-  }
+  JS_SetOpaque(obj, spatial);
+  return obj;
 
-  return JS_NewInt32(ctx, i);
+fail:
+  nvgjs_spatial_free(spatial);
+  return JS_EXCEPTION;
 }
 
-NVGJS_DECL(Context, CreateFont) {
-  NVGJS_CONTEXT(this_obj);
+static JSClassDef nvgjs_spatial_class = {
+ "nvgSpatialIndex",
+ .finalizer = nvgjs_spatial_finalizer,
+};
 
-  if(argc < 2)
-    return JS_ThrowInternalError(ctx, "need 2 arguments");
+static const JSCFunctionListEntry nvgjs_spatial_methods[] = {
+ NVGJS_METHOD(SpatialIndex, Add, 2),
+ NVGJS_METHOD(SpatialIndex, Update, 3),
+ NVGJS_METHOD(SpatialIndex, Remove, 1),
+ NVGJS_METHOD(SpatialIndex, QueryPoint, 3),
+ NVGJS_METHOD(SpatialIndex, QueryRect, 4),
+ NVGJS_METHOD(SpatialIndex, Nearest, 2),
+ JS_CGETSET_DEF("length", nvgjs_spatial_get_length, 0),
+ JS_CGETSET_DEF("cellSize", nvgjs_spatial_get_cell_size, 0),
+ JS_PROP_STRING_DEF("[Symbol.toStringTag]", "nvgSpatialIndex", JS_PROP_CONFIGURABLE),
+};
 
-  const char* name = JS_ToCString(ctx, argv[0]);
-  if(!name)
+/* A Float64Array of n elements over memory of our own, returned in *pdata */
+static JSValue
+nvgjs_float64array(JSContext* ctx, size_t n, double** pdata) {
+  JSValue buffer, array;
+  double* data;
+
+  if(!(data = js_mallocz(ctx, sizeof(double) * n)))
     return JS_EXCEPTION;
 
-  const char* file = JS_ToCString(ctx, argv[1]);
-  if(!file) {
-    JS_FreeCString(ctx, name);
+  buffer = JS_NewArrayBuffer(ctx, (uint8_t*)data, sizeof(double) * n, nvgjs_arraybuffer_free, NULL, FALSE);
+
+  if(JS_IsException(buffer)) {
+    js_free(ctx, data);
     return JS_EXCEPTION;
   }
 
-  int ret = nvgCreateFont(nvg, name, file);
+  array = JS_NewTypedArray(ctx, 1, &buffer, JS_TYPED_ARRAY_FLOAT64);
+  JS_FreeValue(ctx, buffer);
+  *pdata = data;
+  return array;
+}
 
-  JS_FreeCString(ctx, name);
-  JS_FreeCString(ctx, file);
-  return JS_NewInt32(ctx, ret);
+static int
+nvgjs_is_gl(NVGcontext* nvg) {
+#ifdef NANOVG_GL_IMPLEMENTATION
+  /* renderFlush is the record's once it has one (see nvgjs-nanovg.h) */
+  return nvgInternalParams(nvg)->renderDelete == glnvg__renderDelete;
+#else
+  return 0;
+#endif
 }
 
-NVGJS_DECL(Context, CreateFontAtIndex) {
-  NVGJS_CONTEXT(this_obj);
+/* Also gives the context its "stats": a Float64Array the last frame's
+   counters are copied into by EndFrame() (see nvgjs-stats.h), and on GL
+   "gpuTimeMs", the GPU time of recent frames, newest first */
+static JSValue
+nvgjs_context_wrap(JSContext* ctx, NVGcontext* nvg) {
+  JSValue obj = JS_NewObjectClass(ctx, nvgjs_context_class_id), stats, gpu = JS_UNDEFINED;
+  NVGJSContextData* rec;
+  double *out, *history = 0;
 
-  if(argc < 3)
-    return JS_ThrowInternalError(ctx, "need 3 arguments");
+  if(JS_IsException(obj) || !nvg)
+    return obj;
 
-  const char* name = JS_ToCString(ctx, argv[0]);
-  if(!name)
-    return JS_EXCEPTION;
+  if(JS_IsException((stats = nvgjs_float64array(ctx, NVGJS_STAT_COUNT, &out))))
+    goto fail;
 
-  const char* file = JS_ToCString(ctx, argv[1]);
-  if(!file) {
-    JS_FreeCString(ctx, name);
-    return JS_EXCEPTION;
+  if(nvgjs_is_gl(nvg)) {
+    if(JS_IsException((gpu = nvgjs_float64array(ctx, NVGJS_STATS_GPU_HISTORY, &history))))
+      goto fail;
+
+    for(int i = 0; i < NVGJS_STATS_GPU_HISTORY; i++)
+      history[i] = NAN;
   }
 
-  int32_t index;
-  if(JS_ToInt32(ctx, &index, argv[2])) {
-    JS_FreeCString(ctx, name);
-    JS_FreeCString(ctx, file);
-    return JS_EXCEPTION;
+  if(!(rec = nvgjs_nvg_data_new(nvg)) || nvgjs_stats_attach(nvg, out, history)) {
+    nvgjs_nvg_data_free(nvg);
+    JS_ThrowOutOfMemory(ctx);
+    goto fail;
   }
 
-  int ret = nvgCreateFontAtIndex(nvg, name, file, index);
+  /* the arrays (and with them out and history) live at least as long as the object */
+  JS_DefinePropertyValueStr(ctx, obj, "stats", stats, JS_PROP_ENUMERABLE);
 
-  JS_FreeCString(ctx, name);
-  JS_FreeCString(ctx, file);
-  return JS_NewInt32(ctx, ret);
-}
+  if(history)
+    JS_DefinePropertyValueStr(ctx, obj, "gpuTimeMs", gpu, JS_PROP_ENUMERABLE);
 
-NVGJS_DECL(Context, FindFont) {
-  NVGJS_CONTEXT(this_obj);
+  JS_SetOpaque(obj, rec);
+  return obj;
 
-  if(argc < 1)
-    return JS_ThrowInternalError(ctx, "need 1 arguments");
+fail:
+  JS_FreeValue(ctx, gpu);
+  JS_FreeValue(ctx, stats);
+  JS_FreeValue(ctx, obj);
+  return JS_EXCEPTION;
+}
 
-  const char* name = JS_ToCString(ctx, argv[0]);
-  if(!name)
-    return JS_EXCEPTION;
+/* Drop what the binding keeps per context, before the context is deleted */
+static void
+nvgjs_context_forget(NVGcontext* nvg) {
+  nvgjs_stats_detach(nvg);
+  nvgjs_tesscache_free(nvg);
+  nvgjs_nvg_data_free(nvg);
+}
 
-  int ret = nvgFindFont(nvg, name);
+#ifdef NANOVG_GL3
+static void nvgjs_headless_unref(JSRuntime*, struct NVGJSHeadlessHandle*);
+#endif
 
-  JS_FreeCString(ctx, name);
-  return JS_NewInt32(ctx, ret);
-}
+static void
+nvgjs_context_finalizer(JSRuntime* rt, JSValue val) {
+  NVGJSContextData* rec;
+  NVGcontext* nvg;
 
-NVGJS_DECL(Context, BeginFrame) {
-  NVGJS_CONTEXT(this_obj);
+  /* Intentionally do NOT call nvgDeleteGL[23] here: the finalizer may run
+   * after the owning GL context (owned by the glfw module) has been destroyed,
+   * in which case tearing down NanoVG's GL resources would crash. Callers
+   * that care about deterministic cleanup must call DeleteGL3(nvg) (or GL2)
+   * *before* their window is destroyed. Software and SVG contexts hold no GL
+   * state and are always safe to delete; the latter finish their document.
+   * Headless contexts belong to their handle (see nvgjs_headless_unref()). */
+  (void)rt;
 
-  double w, h, ratio;
+  if(!(rec = JS_GetOpaque(val, nvgjs_context_class_id)))
+    return;
 
-  if(argc < 3)
-    return JS_ThrowInternalError(ctx, "need 3 arguments");
+#ifdef NANOVG_GL3
+  if(rec->headless) {
+    nvgjs_headless_unref(rt, rec->headless);
+    return;
+  }
+#endif
 
-  if(JS_ToFloat64(ctx, &w, argv[0]) || JS_ToFloat64(ctx, &h, argv[1]) || JS_ToFloat64(ctx, &ratio, argv[2]))
-    return JS_EXCEPTION;
+  /* the stats array may be gone already */
+  nvg = rec->nvg;
+  nvgjs_context_forget(nvg);
 
-  nvgBeginFrame(nvg, w, h, ratio);
-  return JS_UNDEFINED;
+  if(nvgjs_software_is(nvg))
+    nvgjs_software_delete(nvg);
+  else if(nvgjs_svg_is(nvg))
+    nvgjs_svg_delete(nvg);
 }
 
-NVGJS_DECL(Context, EndFrame) {
+/* Before deleting a GL context while it is current: also frees the queries */
+static void
+nvgjs_context_detach(NVGcontext* nvg) {
+  NVGJSGpuTimer* timer;
+
+  if((timer = nvgjs_stats_gputimer(nvg)))
+    nvgjs_gputimer_free(timer);
+
+  nvgjs_context_forget(nvg);
+}
+
+static JSClassDef nvgjs_context_class = {
+ .class_name = "NVGcontext",
+ .finalizer = nvgjs_context_finalizer,
+};
+
+#ifdef NANOVG_GL2
+NVGJS_DECL(func, CreateGL2) {
+  int32_t flags = 0;
+
+  if(argc < 1)
+    return JS_ThrowInternalError(ctx, "need 1 arguments");
+
+  if(JS_ToInt32(ctx, &flags, argv[0]))
+    return JS_EXCEPTION;
+
+  return nvgjs_context_wrap(ctx, nvgCreateGL2(flags));
+}
+
+NVGJS_DECL(func, DeleteGL2) {
+  NVGJS_CONTEXT(argv[0]);
+
+  if(rec->headless)
+    return JS_ThrowTypeError(ctx, "headless context: use DeleteHeadless()");
+
+  if(nvg) {
+    nvgjs_context_detach(nvg);
+    nvgDeleteGL2(nvg);
+    JS_SetOpaque(argv[0], 0);
+  }
+
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(func, CreateImageFromHandleGL2) {
+  NVGJS_CONTEXT(argv[0]);
+
+  uint32_t textureId;
+  int32_t w, h, imageFlags;
+  NVGparams params;
+  int image;
+
+  if(JS_ToUint32(ctx, &textureId, argv[1]))
+    return JS_EXCEPTION;
+
+  if(JS_ToInt32(ctx, &w, argv[2]))
+    return JS_EXCEPTION;
+
+  if(JS_ToInt32(ctx, &h, argv[3]))
+    return JS_EXCEPTION;
+
+  if(JS_ToInt32(ctx, &imageFlags, argv[4]))
+    return JS_EXCEPTION;
+
+  nvgjs_nvg_suspend(rec, &params);
+  image = nvglCreateImageFromHandleGL2(nvg, textureId, w, h, imageFlags);
+  nvgjs_nvg_resume(rec, &params);
+
+  return JS_NewInt32(ctx, image);
+}
+
+NVGJS_DECL(func, ImageHandleGL2) {
+  NVGJS_CONTEXT(argv[0]);
+
+  int32_t imageHandle;
+  NVGparams params;
+  GLuint handle;
+
+  if(JS_ToInt32(ctx, &imageHandle, argv[1]))
+    return JS_EXCEPTION;
+
+  nvgjs_nvg_suspend(rec, &params);
+  handle = nvglImageHandleGL2(nvg, imageHandle);
+  nvgjs_nvg_resume(rec, &params);
+
+  return JS_NewUint32(ctx, handle);
+}
+#endif
+
+#ifdef NANOVG_GL3
+NVGJS_DECL(func, CreateGL3) {
+  int32_t flags = 0;
+
+  if(argc < 1)
+    return JS_ThrowInternalError(ctx, "need 1 arguments");
+
+  if(JS_ToInt32(ctx, &flags, argv[0]))
+    return JS_EXCEPTION;
+
+#ifdef NANOVG_GLEW
+  glewExperimental = GL_TRUE;
+
+  if(glewInit() != GLEW_OK) {
+    return JS_ThrowInternalError(ctx, "nvg.CreateGL3: Could not init glew.\n");
+  }
+#endif
+
+  // GLEW generates GL error because it calls glGetString(GL_EXTENSIONS), we'll
+  // consume it here.
+  glGetError();
+
+  return nvgjs_context_wrap(ctx, nvgCreateGL3(flags));
+}
+
+NVGJS_DECL(func, DeleteGL3) {
+  NVGJS_CONTEXT(argv[0]);
+
+  if(rec->headless)
+    return JS_ThrowTypeError(ctx, "headless context: use DeleteHeadless()");
+
+  if(nvg) {
+    nvgjs_context_detach(nvg);
+    nvgDeleteGL3(nvg);
+    JS_SetOpaque(argv[0], 0);
+  }
+
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(func, CreateImageFromHandleGL3) {
+  NVGJS_CONTEXT(argv[0]);
+
+  uint32_t textureId;
+  int32_t w, h, imageFlags;
+  NVGparams params;
+  int image;
+
+  if(JS_ToUint32(ctx, &textureId, argv[1]))
+    return JS_EXCEPTION;
+
+  if(JS_ToInt32(ctx, &w, argv[2]))
+    return JS_EXCEPTION;
+
+  if(JS_ToInt32(ctx, &h, argv[3]))
+    return JS_EXCEPTION;
+
+  if(JS_ToInt32(ctx, &imageFlags, argv[4]))
+    return JS_EXCEPTION;
+
+  nvgjs_nvg_suspend(rec, &params);
+  image = nvglCreateImageFromHandleGL3(nvg, textureId, w, h, imageFlags);
+  nvgjs_nvg_resume(rec, &params);
+
+  return JS_NewInt32(ctx, image);
+}
+
+NVGJS_DECL(func, ImageHandleGL3) {
+  NVGJS_CONTEXT(argv[0]);
+
+  int32_t imageHandle;
+  NVGparams params;
+  GLuint handle;
+
+  if(JS_ToInt32(ctx, &imageHandle, argv[1]))
+    return JS_EXCEPTION;
+
+  nvgjs_nvg_suspend(rec, &params);
+  handle = nvglImageHandleGL3(nvg, imageHandle);
+  nvgjs_nvg_resume(rec, &params);
+
+  return JS_NewUint32(ctx, handle);
+}
+#endif
+
+NVGJS_DECL(func, CreateFramebuffer) {
+  NVGJS_CONTEXT(argv[0]);
+
+  int32_t w, h, imageFlags;
+
+  if(JS_ToInt32(ctx, &w, argv[1]))
+    return JS_EXCEPTION;
+
+  if(JS_ToInt32(ctx, &h, argv[2]))
+    return JS_EXCEPTION;
+
+  if(JS_ToInt32(ctx, &imageFlags, argv[3]))
+    return JS_EXCEPTION;
+
+  NVGLUframebuffer* fb;
+  NVGparams params;
+
+  /* reads the userPtr of the GL renderer */
+  nvgjs_nvg_suspend(rec, &params);
+  fb = nvgluCreateFramebuffer(nvg, w, h, imageFlags);
+  nvgjs_nvg_resume(rec, &params);
+
+  if(!fb)
+    return JS_ThrowInternalError(ctx, "Failed creating NVGLUframebuffer [%ix%i] (%i)", w, h, imageFlags);
+
+  return nvgjs_framebuffer_wrap(ctx, fb);
+}
+
+NVGJS_DECL(func, BindFramebuffer) {
+  NVGLUframebuffer* fb = 0;
+
+  if(!JS_IsNull(argv[0]))
+    if(!(fb = JS_GetOpaque2(ctx, argv[0], nvgjs_framebuffer_class_id)))
+      return JS_EXCEPTION;
+
+  nvgluBindFramebuffer(fb);
+
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(func, DeleteFramebuffer) {
+  NVGJS_FRAMEBUFFER(argv[0]);
+
+  nvgluDeleteFramebuffer(fb);
+  JS_SetOpaque(argv[0], 0);
+
+  return JS_UNDEFINED;
+}
+
+/* Parse ([x, y,] w, h [, target]); the 2/3-argument form reads from the origin. */
+static int
+nvgjs_readpixels_args(JSContext* ctx, int32_t rect[4], JSValueConst* ptarget, int argc, JSValueConst argv[]) {
+  int i, n = 2;
+
+  rect[0] = rect[1] = 0;
+  *ptarget = JS_UNDEFINED;
+
+  if(argc >= 4 && !JS_IsObject(argv[2]))
+    n = 4;
+  else if(argc < 2) {
+    JS_ThrowInternalError(ctx, "need 2 arguments");
+    return -1;
+  }
+
+  for(i = 0; i < n; i++)
+    if(JS_ToInt32(ctx, &rect[4 - n + i], argv[i]))
+      return -1;
+
+  if(rect[2] < 0 || rect[3] < 0 || (uint64_t)rect[2] * rect[3] > INT32_MAX / 4) {
+    JS_ThrowRangeError(ctx, "invalid size %" PRId32 "x%" PRId32, rect[2], rect[3]);
+    return -1;
+  }
+
+  if(argc > n && !JS_IsUndefined(argv[n]))
+    *ptarget = argv[n];
+
+  return 0;
+}
+
+/* Bytes of a caller-supplied ArrayBuffer/TypedArray, checked against size */
+static uint8_t*
+nvgjs_readpixels_target(JSContext* ctx, JSValueConst target, size_t size) {
+  size_t len;
+  uint8_t* ptr;
+
+  if(!(ptr = nvgjs_bytes(ctx, &len, target)))
+    return 0;
+
+  if(len < size) {
+    JS_ThrowRangeError(ctx, "target has %zu bytes, need %zu", len, size);
+    return 0;
+  }
+
+  return ptr;
+}
+
+NVGJS_DECL(func, ReadPixels) {
+  int32_t r[4];
+  JSValueConst target;
+  uint8_t* image;
+  size_t size;
+
+  if(nvgjs_readpixels_args(ctx, r, &target, argc, argv))
+    return JS_EXCEPTION;
+
+  size = (size_t)r[2] * r[3] * 4;
+
+  if(!JS_IsUndefined(target)) {
+    if(!(image = nvgjs_readpixels_target(ctx, target, size)))
+      return JS_EXCEPTION;
+
+    glReadPixels(r[0], r[1], r[2], r[3], GL_RGBA, GL_UNSIGNED_BYTE, image);
+    return JS_DupValue(ctx, target);
+  }
+
+  if(!(image = js_malloc(ctx, size)))
+    return JS_EXCEPTION;
+
+  glReadPixels(r[0], r[1], r[2], r[3], GL_RGBA, GL_UNSIGNED_BYTE, image);
+
+  return JS_NewArrayBuffer(ctx, image, size, nvgjs_arraybuffer_free, NULL, FALSE);
+}
+
+/* How long ReadPixelsAsync() blocks on the oldest read when every slot is busy */
+#define NVGJS_READBACK_TIMEOUT 1000000000ull
+
+/* Copy a finished (or failed) read out of its slot and settle its promise */
+static void
+nvgjs_readback_settle(JSContext* ctx, int slot, BOOL ok) {
+  NVGJSState* st = nvgjs_state(ctx);
+  JSValue result = JS_UNDEFINED, ret, *p = &st->readback_promise[slot].resolve;
+  size_t size = st->readback.slot[slot].size;
+  uint8_t* ptr = 0;
+  BOOL fail = TRUE;
+
+  if(!ok)
+    JS_ThrowInternalError(ctx, "glClientWaitSync failed");
+  else if(!JS_IsUndefined(st->readback_promise[slot].target))
+    ptr = nvgjs_readpixels_target(ctx, st->readback_promise[slot].target, size);
+  else
+    ptr = js_malloc(ctx, size);
+
+  if(ptr && nvgjs_readback_finish(&st->readback, slot, ptr)) {
+    JS_ThrowInternalError(ctx, "glMapBufferRange failed");
+  } else if(ptr) {
+    fail = FALSE;
+    result = JS_IsUndefined(st->readback_promise[slot].target)
+              ? JS_NewArrayBuffer(ctx, ptr, size, nvgjs_arraybuffer_free, NULL, FALSE)
+              : JS_DupValue(ctx, st->readback_promise[slot].target);
+    ptr = 0;
+  }
+
+  /* release the slot on every error path, too */
+  if(st->readback.slot[slot].fence)
+    nvgjs_readback_finish(&st->readback, slot, 0);
+
+  if(ptr && JS_IsUndefined(st->readback_promise[slot].target))
+    js_free(ctx, ptr);
+
+  if(fail) {
+    result = JS_GetException(ctx);
+    p = &st->readback_promise[slot].reject;
+  }
+
+  ret = JS_Call(ctx, *p, JS_UNDEFINED, 1, (JSValueConst*)&result);
+
+  JS_FreeValue(ctx, ret);
+  JS_FreeValue(ctx, result);
+  JS_FreeValue(ctx, st->readback_promise[slot].resolve);
+  JS_FreeValue(ctx, st->readback_promise[slot].reject);
+  JS_FreeValue(ctx, st->readback_promise[slot].target);
+}
+
+/* Settle every finished read in submission order. Only the oldest one is
+   waited for (up to timeout_ns), the rest are just polled. */
+static int
+nvgjs_readback_poll(JSContext* ctx, uint64_t timeout_ns) {
+  NVGJSState* st = nvgjs_state(ctx);
+  int slot, ret, n = 0;
+
+  while((slot = nvgjs_readback_oldest(&st->readback)) != -1) {
+    if(!(ret = nvgjs_readback_wait(&st->readback, slot, n ? 0 : timeout_ns)))
+      break;
+
+    nvgjs_readback_settle(ctx, slot, ret > 0);
+    n++;
+  }
+
+  return n;
+}
+
+NVGJS_DECL(func, ReadPixelsAsync) {
+  NVGJSState* st = nvgjs_state(ctx);
+  int32_t r[4];
+  JSValueConst target;
+  JSValue promise, funcs[2];
+  int slot;
+
+  if(nvgjs_readpixels_args(ctx, r, &target, argc, argv))
+    return JS_EXCEPTION;
+
+  /* fail early rather than when the promise settles */
+  if(!JS_IsUndefined(target) && !nvgjs_readpixels_target(ctx, target, (size_t)r[2] * r[3] * 4))
+    return JS_EXCEPTION;
+
+  /* all slots busy: retire the oldest read synchronously */
+  if((slot = nvgjs_readback_start(&st->readback, r[0], r[1], r[2], r[3])) == -1 &&
+     nvgjs_readback_oldest(&st->readback) != -1) {
+    nvgjs_readback_poll(ctx, NVGJS_READBACK_TIMEOUT);
+    slot = nvgjs_readback_start(&st->readback, r[0], r[1], r[2], r[3]);
+  }
+
+  if(slot == -1)
+    return JS_ThrowInternalError(ctx, "glReadPixels into pixel buffer failed");
+
+  if(JS_IsException((promise = JS_NewPromiseCapability(ctx, funcs)))) {
+    nvgjs_readback_finish(&st->readback, slot, 0);
+    return JS_EXCEPTION;
+  }
+
+  st->readback_promise[slot].resolve = funcs[0];
+  st->readback_promise[slot].reject = funcs[1];
+  st->readback_promise[slot].target = JS_DupValue(ctx, target);
+  return promise;
+}
+
+typedef struct {
+  NVGJSJob job;
+  JSValue resolve, reject;
+  uint8_t* pixels;  /* private copy of the input, freed by the worker */
+  int w, h, format, flags;
+  char* path;       /* SaveImage() only */
+  uint8_t* data;    /* encoded file, EncodeImage() only */
+  size_t len;
+  int error;        /* errno of a failed write, -1 if encoding failed */
+} NVGJSImageJob;
+
+static void
+nvgjs_image_free(JSRuntime* rt, void* opaque, void* ptr) {
+  (void)rt;
+  (void)opaque;
+  free(ptr);
+}
+
+/* Runs on the worker thread */
+static void
+nvgjs_image_run(NVGJSJob* job) {
+  NVGJSImageJob* ij = (NVGJSImageJob*)job;
+  FILE* f;
+
+  if(!(ij->data = nvgjs_image_encode(ij->format, ij->pixels, ij->w, ij->h, ij->flags, &ij->len))) {
+    ij->error = -1;
+  } else if(ij->path) {
+    if(!(f = fopen(ij->path, "wb")))
+      ij->error = errno;
+    else if((fwrite(ij->data, 1, ij->len, f) != ij->len) | fclose(f))
+      ij->error = errno ? errno : EIO;
+
+    free(ij->data);
+    ij->data = 0;
+  }
+
+  free(ij->pixels);
+  ij->pixels = 0;
+}
+
+/* Settle the promises of finished EncodeImage()/SaveImage() jobs */
+static int
+nvgjs_image_settle(JSContext* ctx, NVGJSJob* list) {
+  int n = 0;
+
+  while(list) {
+    NVGJSImageJob* ij = (NVGJSImageJob*)list;
+    JSValue result, ret;
+
+    list = list->next;
+
+    if(ij->error == -1)
+      JS_ThrowInternalError(ctx, "encoding %s failed", nvgjs_image_format_names[ij->format]);
+    else if(ij->error)
+      JS_ThrowInternalError(ctx, "%s: %s", ij->path, strerror(ij->error));
+
+    if(ij->error)
+      result = JS_GetException(ctx);
+    else if(ij->path)
+      result = JS_NewInt64(ctx, ij->len);
+    else
+      result = JS_NewArrayBuffer(ctx, ij->data, ij->len, nvgjs_image_free, NULL, FALSE);
+
+    ret = JS_Call(ctx, ij->error ? ij->reject : ij->resolve, JS_UNDEFINED, 1, (JSValueConst*)&result);
+
+    JS_FreeValue(ctx, ret);
+    JS_FreeValue(ctx, result);
+    JS_FreeValue(ctx, ij->resolve);
+    JS_FreeValue(ctx, ij->reject);
+    free(ij->path);
+    free(ij);
+    n++;
+  }
+
+  return n;
+}
+
+/* Shared by EncodeImage(buffer, w, h[, options]) and SaveImage(path, ...) */
+static JSValue
+nvgjs_image_submit(JSContext* ctx, const char* path, int argc, JSValueConst argv[]) {
+  NVGJSImageJob* ij;
+  JSValue promise, funcs[2], v;
+  int32_t w, h;
+  uint8_t* ptr;
+  int format = path ? nvgjs_image_format_of(path) : -1, flags = 0;
+
+  if(argc < 3)
+    return JS_ThrowInternalError(ctx, "need %d arguments", path ? 4 : 3);
+
+  if(JS_ToInt32(ctx, &w, argv[1]) || JS_ToInt32(ctx, &h, argv[2]))
+    return JS_EXCEPTION;
+
+  if(w <= 0 || h <= 0 || (uint64_t)w * h > INT32_MAX / 4)
+    return JS_ThrowRangeError(ctx, "invalid size %" PRId32 "x%" PRId32, w, h);
+
+  if(argc > 3 && JS_IsObject(argv[3])) {
+    v = JS_GetPropertyStr(ctx, argv[3], "format");
+
+    if(!JS_IsUndefined(v)) {
+      const char* s = JS_ToCString(ctx, v);
+
+      JS_FreeValue(ctx, v);
+
+      if(!s)
+        return JS_EXCEPTION;
+
+      for(format = NVGJS_IMAGE_FORMAT_COUNT - 1; format >= 0; format--)
+        if(!strcasecmp(s, nvgjs_image_format_names[format]))
+          break;
+
+      if(format < 0)
+        JS_ThrowRangeError(ctx, "unknown image format '%s'", s);
+
+      JS_FreeCString(ctx, s);
+
+      if(format < 0)
+        return JS_EXCEPTION;
+    }
+
+    v = JS_GetPropertyStr(ctx, argv[3], "flipY");
+    flags |= JS_ToBool(ctx, v) ? NVGJS_IMAGE_FLIPY : 0;
+    JS_FreeValue(ctx, v);
+
+    v = JS_GetPropertyStr(ctx, argv[3], "alpha");
+    flags |= JS_IsUndefined(v) || JS_ToBool(ctx, v) ? NVGJS_IMAGE_ALPHA : 0;
+    JS_FreeValue(ctx, v);
+  } else {
+    flags |= NVGJS_IMAGE_ALPHA;
+  }
+
+  if(format < 0)
+    format = NVGJS_IMAGE_PNG;
+
+  if(!(ptr = nvgjs_readpixels_target(ctx, argv[0], (size_t)w * h * 4)))
+    return JS_EXCEPTION;
+
+  if(!(ij = calloc(1, sizeof(NVGJSImageJob))) || !(ij->pixels = malloc((size_t)w * h * 4)) ||
+     (path && !(ij->path = strdup(path)))) {
+    if(ij) {
+      free(ij->pixels);
+      free(ij);
+    }
+
+    return JS_ThrowOutOfMemory(ctx);
+  }
+
+  /* the worker gets its own copy, so the caller may reuse the buffer at once */
+  memcpy(ij->pixels, ptr, (size_t)w * h * 4);
+  ij->job.run = nvgjs_image_run;
+  ij->w = w;
+  ij->h = h;
+  ij->format = format;
+  ij->flags = flags;
+
+  if(JS_IsException((promise = JS_NewPromiseCapability(ctx, funcs))))
+    goto fail;
+
+  ij->resolve = funcs[0];
+  ij->reject = funcs[1];
+
+  if(nvgjs_worker_submit(&nvgjs_state(ctx)->worker, &ij->job)) {
+    JS_FreeValue(ctx, promise);
+    JS_FreeValue(ctx, ij->resolve);
+    JS_FreeValue(ctx, ij->reject);
+    JS_ThrowInternalError(ctx, "could not start worker thread");
+    goto fail;
+  }
+
+  return promise;
+
+fail:
+  free(ij->pixels);
+  free(ij->path);
+  free(ij);
+  return JS_EXCEPTION;
+}
+
+NVGJS_DECL(func, EncodeImage) {
+  return nvgjs_image_submit(ctx, 0, argc, argv);
+}
+
+NVGJS_DECL(func, SaveImage) {
+  const char* path;
+  JSValue ret;
+
+  if(argc < 4)
+    return JS_ThrowInternalError(ctx, "need 4 arguments");
+
+  if(!(path = JS_ToCString(ctx, argv[0])))
+    return JS_EXCEPTION;
+
+  ret = nvgjs_image_submit(ctx, path, argc - 1, argv + 1);
+  JS_FreeCString(ctx, path);
+  return ret;
+}
+
+/* Settle finished asynchronous work: ReadPixelsAsync() reads and
+   EncodeImage()/SaveImage() jobs. If nothing is ready, wait up to timeout_ns
+   for the next one. */
+static int
+nvgjs_poll(JSContext* ctx, uint64_t timeout_ns) {
+  NVGJSState* st = nvgjs_state(ctx);
+  int n = nvgjs_image_settle(ctx, nvgjs_worker_take(&st->worker, 0)) + nvgjs_readback_poll(ctx, 0);
+
+  if(n || !timeout_ns)
+    return n;
+
+  if(nvgjs_readback_oldest(&st->readback) != -1)
+    return nvgjs_readback_poll(ctx, timeout_ns) + nvgjs_image_settle(ctx, nvgjs_worker_take(&st->worker, 0));
+
+  return nvgjs_image_settle(ctx, nvgjs_worker_take(&st->worker, timeout_ns));
+}
+
+NVGJS_DECL(func, Poll) {
+  double timeout = 0;
+  uint64_t ns = 0;
+
+  if(argc > 0 && JS_ToFloat64(ctx, &timeout, argv[0]))
+    return JS_EXCEPTION;
+
+  /* milliseconds; Infinity waits until something settles */
+  if(timeout * 1e6 >= (double)UINT64_MAX)
+    ns = UINT64_MAX;
+  else if(timeout > 0)
+    ns = timeout * 1e6;
+
+  return JS_NewInt32(ctx, nvgjs_poll(ctx, ns));
+}
+
+NVGJS_DECL(func, TraceStart) {
+  uint32_t capacity = 65536, sample = 16;
+
+  if(argc > 0 && JS_IsObject(argv[0])) {
+    JSValue v;
+    int r;
+
+    v = JS_GetPropertyStr(ctx, argv[0], "capacity");
+    r = !JS_IsUndefined(v) && JS_ToUint32(ctx, &capacity, v);
+    JS_FreeValue(ctx, v);
+
+    if(r)
+      return JS_EXCEPTION;
+
+    v = JS_GetPropertyStr(ctx, argv[0], "sample");
+    r = !JS_IsUndefined(v) && JS_ToUint32(ctx, &sample, v);
+    JS_FreeValue(ctx, v);
+
+    if(r)
+      return JS_EXCEPTION;
+  }
+
+  if(nvgjs_trace_start(capacity, sample))
+    return JS_ThrowOutOfMemory(ctx);
+
+  /* sample: 0 leaves method calls out */
+  nvgjs_state(ctx)->trace_methods = sample > 0;
+  nvgjs_wrap_methods(ctx);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(func, TraceStop) {
+  nvgjs_trace_stop();
+  nvgjs_state(ctx)->trace_methods = FALSE;
+  nvgjs_wrap_methods(ctx);
+  return JS_UNDEFINED;
+}
+
+/* NVGJSState.finalize: the context is going away, so outstanding promises are
+   dropped unsettled. Queued image jobs still run (files get written), the
+   readback buffers are leaked since their GL context may be gone already. */
+static void
+nvgjs_state_finalize(JSRuntime* rt, NVGJSState* st) {
+  NVGJSJob* list = nvgjs_worker_stop(&st->worker);
+
+  while(list) {
+    NVGJSImageJob* ij = (NVGJSImageJob*)list;
+
+    list = list->next;
+    JS_FreeValueRT(rt, ij->resolve);
+    JS_FreeValueRT(rt, ij->reject);
+    free(ij->data);
+    free(ij->path);
+    free(ij);
+  }
+
+  for(int slot = 0; slot < NVGJS_READBACK_SLOTS; slot++)
+    if(st->readback.slot[slot].fence) {
+      JS_FreeValueRT(rt, st->readback_promise[slot].resolve);
+      JS_FreeValueRT(rt, st->readback_promise[slot].reject);
+      JS_FreeValueRT(rt, st->readback_promise[slot].target);
+    }
+}
+
+#ifdef NANOVG_GL3
+/* Opaque of the object returned by CreateHeadless(), also held by the record
+   of its Context: refs counts the two objects */
+typedef struct NVGJSHeadlessHandle {
+  NVGJSHeadless* hl;
+  NVGcontext* nvg;
+  int refs;
+} NVGJSHeadlessHandle;
+
+enum {
+  HEADLESS_WIDTH,
+  HEADLESS_HEIGHT,
+  HEADLESS_BACKEND,
+  HEADLESS_FBO,
+};
+
+/* Tear down the NanoVG context, then the GL context it lives in */
+static void
+nvgjs_headless_destroy(NVGJSHeadlessHandle* hh) {
+  if(hh->nvg && !nvgjs_headless_make_current(hh->hl)) {
+    nvgjs_context_detach(hh->nvg);
+    nvgDeleteGL3(hh->nvg);
+  } else if(hh->nvg) {
+    nvgjs_context_forget(hh->nvg);
+  }
+
+  nvgjs_headless_delete(hh->hl);
+  hh->hl = 0;
+  hh->nvg = 0;
+}
+
+/* The handle and the Context reference each other, so the GC finalizes them
+   in either order: whichever goes last tears down, and neither reads the
+   record after that. Unlike windowed contexts the GL context is ours. */
+static void
+nvgjs_headless_unref(JSRuntime* rt, NVGJSHeadlessHandle* hh) {
+  if(--hh->refs > 0)
+    return;
+
+  if(hh->hl)
+    nvgjs_headless_destroy(hh);
+
+  js_free_rt(rt, hh);
+}
+
+static void
+nvgjs_headless_finalizer(JSRuntime* rt, JSValue val) {
+  NVGJSHeadlessHandle* hh;
+
+  if((hh = JS_GetOpaque(val, nvgjs_headless_class_id)))
+    nvgjs_headless_unref(rt, hh);
+}
+
+static JSClassDef nvgjs_headless_class = {
+ .class_name = "NVGheadless",
+ .finalizer = nvgjs_headless_finalizer,
+};
+
+NVGJS_DECL(func, CreateHeadless) {
+  NVGJSHeadlessHandle* hh;
+  NVGJSContextData* rec;
+  JSValue obj, context;
+  int32_t w, h, flags = 0;
+  const char* error;
+
+  if(argc < 2)
+    return JS_ThrowInternalError(ctx, "need 2 arguments");
+
+  if(JS_ToInt32(ctx, &w, argv[0]) || JS_ToInt32(ctx, &h, argv[1]) ||
+     (argc > 2 && JS_ToInt32(ctx, &flags, argv[2])))
+    return JS_EXCEPTION;
+
+  if(w <= 0 || h <= 0)
+    return JS_ThrowRangeError(ctx, "invalid size %" PRId32 "x%" PRId32, w, h);
+
+  if(!(hh = js_mallocz(ctx, sizeof(NVGJSHeadlessHandle))))
+    return JS_EXCEPTION;
+
+  if(!(hh->hl = nvgjs_headless_create(w, h, &error))) {
+    js_free(ctx, hh);
+    return JS_ThrowInternalError(ctx, "nvg.CreateHeadless: %s", error);
+  }
+
+  if(!(hh->nvg = nvgCreateGL3(flags))) {
+    nvgjs_headless_destroy(hh);
+    js_free(ctx, hh);
+    return JS_ThrowInternalError(ctx, "nvg.CreateHeadless: nvgCreateGL3 failed");
+  }
+
+  if(JS_IsException((obj = JS_NewObjectClass(ctx, nvgjs_headless_class_id)))) {
+    nvgjs_headless_destroy(hh);
+    js_free(ctx, hh);
+    return JS_EXCEPTION;
+  }
+
+  hh->refs = 1;
+  JS_SetOpaque(obj, hh);
+
+  if(JS_IsException((context = nvgjs_context_wrap(ctx, hh->nvg)))) {
+    JS_FreeValue(ctx, obj);
+    return JS_EXCEPTION;
+  }
+
+  rec = JS_GetOpaque(context, nvgjs_context_class_id);
+  rec->headless = hh;
+  hh->refs++;
+
+  /* each keeps the other alive; the GC collects the pair */
+  JS_DefinePropertyValueStr(ctx, context, "headless", JS_DupValue(ctx, obj), 0);
+  JS_DefinePropertyValueStr(ctx, obj, "context", context, JS_PROP_ENUMERABLE);
+  return obj;
+}
+
+NVGJS_DECL(func, DeleteHeadless) {
+  NVGJSHeadlessHandle* hh;
+  JSValue context;
+
+  if(!(hh = JS_GetOpaque2(ctx, argv[0], nvgjs_headless_class_id)))
+    return JS_EXCEPTION;
+
+  if(hh->hl) {
+    /* the Context lets go of the record and of the handle */
+    context = JS_GetPropertyStr(ctx, argv[0], "context");
+
+    if(JS_GetOpaque(context, nvgjs_context_class_id)) {
+      JS_SetOpaque(context, 0);
+      hh->refs--;
+    }
+
+    JS_FreeValue(ctx, context);
+    nvgjs_headless_destroy(hh);
+  }
+
+  return JS_UNDEFINED;
+}
+
+static JSValue
+nvgjs_headless_get(JSContext* ctx, JSValueConst this_val, int magic) {
+  NVGJS_HEADLESS(this_val);
+
+  switch(magic) {
+    case HEADLESS_WIDTH: return JS_NewInt32(ctx, hh->hl->width);
+    case HEADLESS_HEIGHT: return JS_NewInt32(ctx, hh->hl->height);
+    case HEADLESS_BACKEND: return JS_NewString(ctx, nvgjs_headless_backend_names[hh->hl->backend]);
+    case HEADLESS_FBO: return JS_NewUint32(ctx, hh->hl->fbo);
+  }
+
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Headless, MakeCurrent) {
+  NVGJS_HEADLESS(this_obj);
+
+  if(nvgjs_headless_make_current(hh->hl))
+    return JS_ThrowInternalError(ctx, "could not make the headless context current");
+
+  return JS_UNDEFINED;
+}
+
+/* ReadPixels([target]) / ReadPixelsAsync([target]) of the whole framebuffer */
+NVGJS_DECL(Headless, ReadPixels) {
+  NVGJS_HEADLESS(this_obj);
+
+  JSValueConst args[5] = {
+   JS_NewInt32(ctx, 0),
+   JS_NewInt32(ctx, 0),
+   JS_NewInt32(ctx, hh->hl->width),
+   JS_NewInt32(ctx, hh->hl->height),
+   argc > 0 ? argv[0] : JS_UNDEFINED,
+  };
+
+  if(nvgjs_headless_make_current(hh->hl))
+    return JS_ThrowInternalError(ctx, "could not make the headless context current");
+
+  return magic ? nvgjs_func_ReadPixelsAsync(ctx, JS_UNDEFINED, 5, args, 0)
+               : nvgjs_func_ReadPixels(ctx, JS_UNDEFINED, 5, args, 0);
+}
+
+static const JSCFunctionListEntry nvgjs_headless_methods[] = {
+ JS_CGETSET_MAGIC_DEF("width", nvgjs_headless_get, 0, HEADLESS_WIDTH),
+ JS_CGETSET_MAGIC_DEF("height", nvgjs_headless_get, 0, HEADLESS_HEIGHT),
+ JS_CGETSET_MAGIC_DEF("backend", nvgjs_headless_get, 0, HEADLESS_BACKEND),
+ JS_CGETSET_MAGIC_DEF("fbo", nvgjs_headless_get, 0, HEADLESS_FBO),
+ NVGJS_METHOD(Headless, MakeCurrent, 0),
+ JS_CFUNC_MAGIC_DEF("ReadPixels", 0, nvgjs_Headless_ReadPixels, 0),
+ JS_CFUNC_MAGIC_DEF("ReadPixelsAsync", 0, nvgjs_Headless_ReadPixels, 1),
+ JS_PROP_STRING_DEF("[Symbol.toStringTag]", "NVGheadless", JS_PROP_CONFIGURABLE),
+};
+#endif
+
+NVGJS_DECL(func, CreateSoftware) {
+  NVGcontext* nvg;
+  JSValue obj, buffer;
+  int32_t w, h, flags = NVG_ANTIALIAS;
+  uint8_t* pixels;
+  size_t size;
+
+  if(argc < 2)
+    return JS_ThrowInternalError(ctx, "need 2 arguments");
+
+  if(JS_ToInt32(ctx, &w, argv[0]) || JS_ToInt32(ctx, &h, argv[1]) ||
+     (argc > 2 && JS_ToInt32(ctx, &flags, argv[2])))
+    return JS_EXCEPTION;
+
+  if(w <= 0 || h <= 0 || (int64_t)w * h > INT32_MAX / 4)
+    return JS_ThrowRangeError(ctx, "invalid size %" PRId32 "x%" PRId32, w, h);
+
+  size = (size_t)w * h * 4;
+
+  if(!(pixels = js_mallocz(ctx, size)))
+    return JS_EXCEPTION;
+
+  if(!(nvg = nvgjs_software_create(pixels, w, h, flags))) {
+    js_free(ctx, pixels);
+    return JS_ThrowInternalError(ctx, "nvg.CreateSoftware: out of memory");
+  }
+
+  /* the ArrayBuffer owns the pixels and the Context keeps it alive */
+  if(JS_IsException((buffer = JS_NewArrayBuffer(ctx, pixels, size, nvgjs_arraybuffer_free, NULL, FALSE)))) {
+    nvgjs_software_delete(nvg);
+    js_free(ctx, pixels);
+    return JS_EXCEPTION;
+  }
+
+  if(JS_IsException((obj = nvgjs_context_wrap(ctx, nvg)))) {
+    nvgjs_software_delete(nvg);
+    JS_FreeValue(ctx, buffer);
+    return JS_EXCEPTION;
+  }
+
+  JS_DefinePropertyValueStr(ctx, obj, "pixels", buffer, JS_PROP_ENUMERABLE);
+  JS_DefinePropertyValueStr(ctx, obj, "width", JS_NewInt32(ctx, w), JS_PROP_ENUMERABLE);
+  JS_DefinePropertyValueStr(ctx, obj, "height", JS_NewInt32(ctx, h), JS_PROP_ENUMERABLE);
+  return obj;
+}
+
+NVGJS_DECL(func, DeleteSoftware) {
+  NVGJS_CONTEXT(argv[0]);
+
+  if(!nvgjs_software_is(nvg))
+    return JS_ThrowTypeError(ctx, "not a software context");
+
+  nvgjs_context_forget(nvg);
+  nvgjs_software_delete(nvg);
+  JS_SetOpaque(argv[0], 0);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(func, CreateSVG) {
+  NVGcontext* nvg;
+  JSValue obj;
+  int32_t w, h, fd = -1;
+  int flags = 0;
+
+  if(argc < 2)
+    return JS_ThrowInternalError(ctx, "need 2 arguments");
+
+  if(JS_ToInt32(ctx, &w, argv[0]) || JS_ToInt32(ctx, &h, argv[1]))
+    return JS_EXCEPTION;
+
+  if(w <= 0 || h <= 0)
+    return JS_ThrowRangeError(ctx, "invalid size %" PRId32 "x%" PRId32, w, h);
+
+  if(argc > 2 && JS_IsString(argv[2])) {
+    const char* path;
+
+    if(!(path = JS_ToCString(ctx, argv[2])))
+      return JS_EXCEPTION;
+
+    if((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666)) == -1) {
+      JS_ThrowInternalError(ctx, "%s: %s", path, strerror(errno));
+      JS_FreeCString(ctx, path);
+      return JS_EXCEPTION;
+    }
+
+    JS_FreeCString(ctx, path);
+    flags |= NVGJS_SVG_CLOSE;
+  } else if(argc > 2 && !JS_IsUndefined(argv[2])) {
+    if(JS_ToInt32(ctx, &fd, argv[2]))
+      return JS_EXCEPTION;
+
+    if(fd < 0)
+      return JS_ThrowRangeError(ctx, "invalid file descriptor %" PRId32, fd);
+  }
+
+  /* closes fd on failure, too */
+  if(!(nvg = nvgjs_svg_create(w, h, fd, flags)))
+    return JS_ThrowInternalError(ctx, "nvg.CreateSVG: out of memory");
+
+  if(JS_IsException((obj = nvgjs_context_wrap(ctx, nvg)))) {
+    nvgjs_svg_delete(nvg);
+    return JS_EXCEPTION;
+  }
+
+  JS_DefinePropertyValueStr(ctx, obj, "width", JS_NewInt32(ctx, w), JS_PROP_ENUMERABLE);
+  JS_DefinePropertyValueStr(ctx, obj, "height", JS_NewInt32(ctx, h), JS_PROP_ENUMERABLE);
+  return obj;
+}
+
+/* Finish the document: an ArrayBuffer in memory mode, else the bytes written */
+NVGJS_DECL(func, DeleteSVG) {
+  uint8_t* data = 0;
+  int64_t size;
+  JSValue ret;
+
+  NVGJS_CONTEXT(argv[0]);
+
+  if(!nvgjs_svg_is(nvg))
+    return JS_ThrowTypeError(ctx, "not an SVG context");
+
+  /* gives the renderer its userPtr back */
+  nvgjs_context_forget(nvg);
+  JS_SetOpaque(argv[0], 0);
+
+  size = nvgjs_svg_finish(nvg, &data);
+
+  if(size < 0)
+    ret = JS_ThrowInternalError(ctx, "nvg.DeleteSVG: %s", strerror(errno));
+  else if(data)
+    ret = JS_NewArrayBuffer(ctx, data, size, nvgjs_image_free, NULL, FALSE);
+  else
+    ret = JS_NewInt64(ctx, size);
+
+  nvgjs_svg_delete(nvg);
+  return ret;
+}
+
+NVGJS_DECL(func, DegToRad) {
+  double arg;
+
+  if(argc < 1)
+    return JS_ThrowInternalError(ctx, "need 1 arguments");
+
+  if(JS_ToFloat64(ctx, &arg, argv[0]))
+    return JS_EXCEPTION;
+
+  return JS_NewFloat64(ctx, nvgDegToRad(arg));
+}
+
+NVGJS_DECL(func, RadToDeg) {
+  double arg;
+
+  if(argc < 1)
+    return JS_ThrowInternalError(ctx, "need 1 arguments");
+
+  if(JS_ToFloat64(ctx, &arg, argv[0]))
+    return JS_EXCEPTION;
+
+  return JS_NewFloat64(ctx, nvgRadToDeg(arg));
+}
+
+NVGJS_DECL(func, RGB) {
+  int32_t r, g, b;
+
+  if(argc < 3)
+    return JS_ThrowInternalError(ctx, "need 3 arguments");
+
+  if(JS_ToInt32(ctx, &r, argv[0]) || JS_ToInt32(ctx, &g, argv[1]) || JS_ToInt32(ctx, &b, argv[2]))
+    return JS_EXCEPTION;
+
+  return nvgjs_color_new(ctx, nvgRGB(r, g, b));
+}
+
+NVGJS_DECL(func, RGBf) {
+  double r, g, b;
+
+  if(argc < 3)
+    return JS_ThrowInternalError(ctx, "need 3 arguments");
+
+  if(JS_ToFloat64(ctx, &r, argv[0]) || JS_ToFloat64(ctx, &g, argv[1]) || JS_ToFloat64(ctx, &b, argv[2]))
+    return JS_EXCEPTION;
+
+  return nvgjs_color_new(ctx, nvgRGBf(r, g, b));
+}
+
+NVGJS_DECL(func, RGBA) {
+  int32_t r, g, b, a;
+
+  if(argc < 4)
+    return JS_ThrowInternalError(ctx, "need 4 arguments");
+
+  if(JS_ToInt32(ctx, &r, argv[0]) || JS_ToInt32(ctx, &g, argv[1]) || JS_ToInt32(ctx, &b, argv[2]) ||
+     JS_ToInt32(ctx, &a, argv[3]))
+    return JS_EXCEPTION;
+
+  return nvgjs_color_new(ctx, nvgRGBA(r, g, b, a));
+}
+
+NVGJS_DECL(func, RGBAf) {
+  double r, g, b, a;
+
+  if(argc < 4)
+    return JS_ThrowInternalError(ctx, "need 4 arguments");
+
+  if(JS_ToFloat64(ctx, &r, argv[0]) || JS_ToFloat64(ctx, &g, argv[1]) || JS_ToFloat64(ctx, &b, argv[2]) ||
+     JS_ToFloat64(ctx, &a, argv[3]))
+    return JS_EXCEPTION;
+
+  return nvgjs_color_new(ctx, nvgRGBAf(r, g, b, a));
+}
+
+NVGJS_DECL(func, LerpRGBA) {
+  static NVGJSHint hints[2];
+  NVGcolor c0, c1;
+  double u;
+
+  if(argc < 3)
+    return JS_ThrowInternalError(ctx, "need 3 arguments");
+
+  if(nvgjs_tocolor(ctx, &c0, argv[0], &hints[0]) || nvgjs_tocolor(ctx, &c1, argv[1], &hints[1]) ||
+     JS_ToFloat64(ctx, &u, argv[2]))
+    return JS_EXCEPTION;
+
+  return nvgjs_color_new(ctx, nvgLerpRGBA(c0, c1, u));
+}
+
+NVGJS_DECL(func, TransRGBA) {
+  static NVGJSHint hints[1];
+  NVGcolor c;
+  int32_t a;
+
+  if(argc < 2)
+    return JS_ThrowInternalError(ctx, "need 2 arguments");
+
+  if(nvgjs_tocolor(ctx, &c, argv[0], &hints[0]) || JS_ToInt32(ctx, &a, argv[1]))
+    return JS_EXCEPTION;
+
+  return nvgjs_color_new(ctx, nvgTransRGBA(c, a));
+}
+
+NVGJS_DECL(func, TransRGBAf) {
+  static NVGJSHint hints[1];
+  NVGcolor c;
+  double a;
+
+  if(argc < 2)
+    return JS_ThrowInternalError(ctx, "need 2 arguments");
+
+  if(nvgjs_tocolor(ctx, &c, argv[0], &hints[0]) || JS_ToFloat64(ctx, &a, argv[1]))
+    return JS_EXCEPTION;
+
+  return nvgjs_color_new(ctx, nvgTransRGBAf(c, a));
+}
+
+NVGJS_DECL(func, HSL) {
+  double h, s, l;
+
+  if(argc < 3)
+    return JS_ThrowInternalError(ctx, "need 3 arguments");
+
+  if(JS_ToFloat64(ctx, &h, argv[0]) || JS_ToFloat64(ctx, &s, argv[1]) || JS_ToFloat64(ctx, &l, argv[2]))
+    return JS_EXCEPTION;
+
+  return nvgjs_color_new(ctx, nvgHSL(h, s, l));
+}
+
+NVGJS_DECL(func, HSLA) {
+  double h, s, l;
+  int32_t a;
+
+  if(argc < 4)
+    return JS_ThrowInternalError(ctx, "need 4 arguments");
+
+  if(JS_ToFloat64(ctx, &h, argv[0]) || JS_ToFloat64(ctx, &s, argv[1]) || JS_ToFloat64(ctx, &l, argv[2]) ||
+     JS_ToInt32(ctx, &a, argv[3]))
+    return JS_EXCEPTION;
+
+  return nvgjs_color_new(ctx, nvgHSLA(h, s, l, a));
+}
+
+NVGJS_DECL(func, TransformPoint) {
+  static NVGJSHint hints[2];
+  float trf[6], *dst, src[2];
+  int size, i = 0;
+
+  if(argc < 2)
+    return JS_ThrowInternalError(ctx, "need 2 arguments");
+
+  if(!(dst = nvgjs_outputarray(ctx, &size, argv[0])))
+    return JS_EXCEPTION;
+
+  if(nvgjs_totransform(ctx, trf, argv[1], &hints[0]))
+    return JS_EXCEPTION;
+
+  if(argc > 2) {
+    for(; size >= 2; size -= 2, dst += 2, i++) {
+      int r;
+
+      if(!(r = nvgjs_arguments(ctx, src, 2, nvgjs_state(ctx)->vector_keys, &hints[1], argc - 2, argv + 2)))
+        break;
+
+      argc -= r;
+      argv += r;
+
+      nvgTransformPoint(&dst[0], &dst[1], trf, src[0], src[1]);
+    }
+
+  } else {
+    for(; size >= 2; size -= 2, dst += 2, i++)
+      nvgTransformPoint(&dst[0], &dst[1], trf, dst[0], dst[1]);
+  }
+
+  return JS_NewInt32(ctx, i);
+}
+
+NVGJS_DECL(Context, CreateFont) {
+  NVGJS_CONTEXT(this_obj);
+
+  if(argc < 2)
+    return JS_ThrowInternalError(ctx, "need 2 arguments");
+
+  const char* name = JS_ToCString(ctx, argv[0]);
+  if(!name)
+    return JS_EXCEPTION;
+
+  const char* file = JS_ToCString(ctx, argv[1]);
+  if(!file) {
+    JS_FreeCString(ctx, name);
+    return JS_EXCEPTION;
+  }
+
+  NVGJS_PROFILE_MARK();
+  int ret = nvgCreateFont(nvg, name, file);
+
+  JS_FreeCString(ctx, name);
+  JS_FreeCString(ctx, file);
+  return JS_NewInt32(ctx, ret);
+}
+
+NVGJS_DECL(Context, CreateFontAtIndex) {
+  NVGJS_CONTEXT(this_obj);
+
+  if(argc < 3)
+    return JS_ThrowInternalError(ctx, "need 3 arguments");
+
+  const char* name = JS_ToCString(ctx, argv[0]);
+  if(!name)
+    return JS_EXCEPTION;
+
+  const char* file = JS_ToCString(ctx, argv[1]);
+  if(!file) {
+    JS_FreeCString(ctx, name);
+    return JS_EXCEPTION;
+  }
+
+  int32_t index;
+  if(JS_ToInt32(ctx, &index, argv[2])) {
+    JS_FreeCString(ctx, name);
+    JS_FreeCString(ctx, file);
+    return JS_EXCEPTION;
+  }
+
+  NVGJS_PROFILE_MARK();
+  int ret = nvgCreateFontAtIndex(nvg, name, file, index);
+
+  JS_FreeCString(ctx, name);
+  JS_FreeCString(ctx, file);
+  return JS_NewInt32(ctx, ret);
+}
+
+NVGJS_DECL(Context, FindFont) {
+  NVGJS_CONTEXT(this_obj);
+
+  if(argc < 1)
+    return JS_ThrowInternalError(ctx, "need 1 arguments");
+
+  const char* name = JS_ToCString(ctx, argv[0]);
+  if(!name)
+    return JS_EXCEPTION;
+
+  NVGJS_PROFILE_MARK();
+  int ret = nvgFindFont(nvg, name);
+
+  JS_FreeCString(ctx, name);
+  return JS_NewInt32(ctx, ret);
+}
+
+#ifdef NANOVG_GL_IMPLEMENTATION
+/* GL draw calls glnvg__renderFlush() is about to issue for the queued calls,
+   following its glnvg__fill() / __convexFill() / __stroke() / __triangles() */
+static int
+nvgjs_gl_draws(NVGJSContextData* rec) {
+  GLNVGcontext* gl;
+  int n = 0;
+
+  if(!nvgjs_is_gl(rec->nvg))
+    return 0;
+
+  gl = rec->params.userPtr;
+
+  for(int i = 0; i < gl->ncalls; i++) {
+    const GLNVGcall* call = &gl->calls[i];
+
+    switch(call->type) {
+      case GLNVG_FILL:
+        /* stencil fans, anti-aliased fringes, cover quad */
+        n += call->pathCount * (gl->flags & NVG_ANTIALIAS ? 2 : 1) + 1;
+        break;
+      case GLNVG_CONVEXFILL:
+        for(int j = 0; j < call->pathCount; j++)
+          n += 1 + (gl->paths[call->pathOffset + j].strokeCount > 0);
+        break;
+      case GLNVG_STROKE:
+        /* stencil, anti-aliased pass and stencil clear */
+        n += call->pathCount * (gl->flags & NVG_STENCIL_STROKES ? 3 : 1);
+        break;
+      case GLNVG_TRIANGLES: n++; break;
+    }
+  }
+
+  return n;
+}
+#endif
+
+NVGJS_DECL(Context, BeginFrame) {
+  NVGJS_CONTEXT(this_obj);
+
+  double w, h, ratio;
+
+  if(argc < 3)
+    return JS_ThrowInternalError(ctx, "need 3 arguments");
+
+  if(JS_ToFloat64(ctx, &w, argv[0]) || JS_ToFloat64(ctx, &h, argv[1]) || JS_ToFloat64(ctx, &ratio, argv[2]))
+    return JS_EXCEPTION;
+
+  NVGJS_TRACE_BEGIN(t0);
+  nvgjs_stats_begin(nvg);
+  NVGJS_PROFILE_MARK();
+  nvgBeginFrame(nvg, w, h, ratio);
+  NVGJS_TRACE_END(t0, "BeginFrame", "frame", -1);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Context, EndFrame) {
+  NVGJS_CONTEXT(this_obj);
+
+  NVGJS_TRACE_BEGIN(t0);
+  NVGJSGpuTimer* timer = nvgjs_stats_gputimer(nvg);
+  double* stats;
+
+  if((stats = nvgjs_stats(nvg))) {
+#ifdef NANOVG_GL_IMPLEMENTATION
+    stats[NVGJS_STAT_DRAWS] += nvgjs_gl_draws(rec);
+#endif
+    nvgjs_stats_flush(nvg);
+  }
+
+  if(timer)
+    nvgjs_gputimer_begin(timer);
+
+  NVGJS_PROFILE_MARK();
+  nvgEndFrame(nvg);
+
+  if(timer) {
+    double ms[NVGJS_GPUTIMER_SLOTS];
+
+    nvgjs_gputimer_end(timer);
+    /* results of earlier frames, never waiting for the one just ended */
+    nvgjs_stats_gpu(nvg, ms, nvgjs_gputimer_collect(timer, ms, NVGJS_GPUTIMER_SLOTS));
+  }
+
+  nvgjs_stats_end(nvg);
+  NVGJS_TRACE_END(t0, "EndFrame", "frame", -1);
+
+  /* settle asynchronous reads and image jobs that have finished by now */
+  nvgjs_poll(ctx, 0);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Context, DumpTrace) {
+  NVGJS_CONTEXT(this_obj);
+
+  const char* path;
+  FILE* f;
+  int64_t n;
+
+  (void)nvg;
+
+  if(argc < 1)
+    return JS_ThrowInternalError(ctx, "need 1 arguments");
+
+  if(!(path = JS_ToCString(ctx, argv[0])))
+    return JS_EXCEPTION;
+
+  if(!(f = fopen(path, "w"))) {
+    JS_ThrowInternalError(ctx, "nvg.DumpTrace: '%s': %s", path, strerror(errno));
+    JS_FreeCString(ctx, path);
+    return JS_EXCEPTION;
+  }
+
+  JS_FreeCString(ctx, path);
+
+  if((n = nvgjs_trace_dump(f)) < 0) {
+    int err = errno;
+
+    fclose(f);
+    return JS_ThrowInternalError(ctx, "nvg.DumpTrace: %s", strerror(err));
+  }
+
+  if(fclose(f))
+    return JS_ThrowInternalError(ctx, "nvg.DumpTrace: %s", strerror(errno));
+
+  return JS_NewInt64(ctx, n);
+}
+
+NVGJS_DECL(Context, CancelFrame) {
+  NVGJS_CONTEXT(this_obj);
+
+  NVGJS_PROFILE_MARK();
+  nvgCancelFrame(nvg);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Context, Save) {
+  NVGJS_CONTEXT(this_obj);
+
+  NVGJS_PROFILE_MARK();
+  nvgSave(nvg);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Context, Restore) {
+  NVGJS_CONTEXT(this_obj);
+
+  NVGJS_PROFILE_MARK();
+  nvgRestore(nvg);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Context, Reset) {
+  NVGJS_CONTEXT(this_obj);
+
+  NVGJS_PROFILE_MARK();
+  nvgReset(nvg);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Context, ShapeAntiAlias) {
+  NVGJS_CONTEXT(this_obj);
+
+  NVGJS_PROFILE_MARK();
+  nvgShapeAntiAlias(nvg, JS_ToBool(ctx, argv[0]));
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Context, Rect) {
+  NVGJS_CONTEXT(this_obj);
+
+  double x, y, w, h;
+
+  if(argc < 4)
+    return JS_ThrowInternalError(ctx, "need 4 arguments");
+
+  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]) || JS_ToFloat64(ctx, &w, argv[2]) ||
+     JS_ToFloat64(ctx, &h, argv[3]))
+    return JS_EXCEPTION;
+
+  NVGJS_PROFILE_MARK();
+  nvgRect(nvg, x, y, w, h);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Context, Circle) {
+  NVGJS_CONTEXT(this_obj);
+
+  double cx, cy, r;
+
+  if(argc < 3)
+    return JS_ThrowInternalError(ctx, "need 3 arguments");
+
+  if(JS_ToFloat64(ctx, &cx, argv[0]) || JS_ToFloat64(ctx, &cy, argv[1]) || JS_ToFloat64(ctx, &r, argv[2]))
+    return JS_EXCEPTION;
+
+  NVGJS_PROFILE_MARK();
+  nvgCircle(nvg, cx, cy, r);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Context, Ellipse) {
+  NVGJS_CONTEXT(this_obj);
+
+  double cx, cy, rx, ry;
+
+  if(argc < 4)
+    return JS_ThrowInternalError(ctx, "need 4 arguments");
+
+  if(JS_ToFloat64(ctx, &cx, argv[0]) || JS_ToFloat64(ctx, &cy, argv[1]) || JS_ToFloat64(ctx, &rx, argv[2]) ||
+     JS_ToFloat64(ctx, &ry, argv[3]))
+    return JS_EXCEPTION;
+
+  NVGJS_PROFILE_MARK();
+  nvgEllipse(nvg, cx, cy, rx, ry);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Context, PathWinding) {
+  NVGJS_CONTEXT(this_obj);
+
+  int dir;
+
+  if(argc < 1)
+    return JS_ThrowInternalError(ctx, "need 1 arguments");
+
+  if(JS_ToInt32(ctx, &dir, argv[0]))
+    return JS_EXCEPTION;
+
+  NVGJS_PROFILE_MARK();
+  nvgPathWinding(nvg, dir);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Context, MoveTo) {
+  NVGJS_CONTEXT(this_obj);
+
+  double x, y;
+
+  if(argc < 2)
+    return JS_ThrowInternalError(ctx, "need 2 arguments");
+
+  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]))
+    return JS_EXCEPTION;
+
+  NVGJS_PROFILE_MARK();
+  nvgMoveTo(nvg, x, y);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Context, LineTo) {
+  NVGJS_CONTEXT(this_obj);
+
+  double x, y;
+
+  if(argc < 2)
+    return JS_ThrowInternalError(ctx, "need 2 arguments");
+
+  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]))
+    return JS_EXCEPTION;
+
+  NVGJS_PROFILE_MARK();
+  nvgLineTo(nvg, x, y);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Context, BezierTo) {
+  NVGJS_CONTEXT(this_obj);
+
+  double c1x, c1y, c2x, c2y, x, y;
+
+  if(argc < 6)
+    return JS_ThrowInternalError(ctx, "need 6 arguments");
+
+  if(JS_ToFloat64(ctx, &c1x, argv[0]) || JS_ToFloat64(ctx, &c1y, argv[1]) || JS_ToFloat64(ctx, &c2x, argv[2]) ||
+     JS_ToFloat64(ctx, &c2y, argv[3]) || JS_ToFloat64(ctx, &x, argv[4]) || JS_ToFloat64(ctx, &y, argv[5]))
+    return JS_EXCEPTION;
+
+  NVGJS_PROFILE_MARK();
+  nvgBezierTo(nvg, c1x, c1y, c2x, c2y, x, y);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Context, QuadTo) {
+  NVGJS_CONTEXT(this_obj);
+
+  double cx, cy, x, y;
+
+  if(argc < 4)
+    return JS_ThrowInternalError(ctx, "need 4 arguments");
+
+  if(JS_ToFloat64(ctx, &cx, argv[0]) || JS_ToFloat64(ctx, &cy, argv[1]) || JS_ToFloat64(ctx, &x, argv[2]) ||
+     JS_ToFloat64(ctx, &y, argv[3]))
+    return JS_EXCEPTION;
+
+  NVGJS_PROFILE_MARK();
+  nvgQuadTo(nvg, cx, cy, x, y);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Context, ArcTo) {
+  NVGJS_CONTEXT(this_obj);
+
+  double x1, y1, x2, y2, radius;
+
+  if(argc < 5)
+    return JS_ThrowInternalError(ctx, "need 5 arguments");
+
+  if(JS_ToFloat64(ctx, &x1, argv[0]) || JS_ToFloat64(ctx, &y1, argv[1]) || JS_ToFloat64(ctx, &x2, argv[2]) ||
+     JS_ToFloat64(ctx, &y2, argv[3]) || JS_ToFloat64(ctx, &radius, argv[4]))
+    return JS_EXCEPTION;
+
+  NVGJS_PROFILE_MARK();
+  nvgArcTo(nvg, x1, y1, x2, y2, radius);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Context, Arc) {
+  NVGJS_CONTEXT(this_obj);
+
+  double cx, cy, r, a0, a1;
+  int32_t dir;
+
+  if(argc < 6)
+    return JS_ThrowInternalError(ctx, "need 6 arguments");
+
+  if(JS_ToFloat64(ctx, &cx, argv[0]) || JS_ToFloat64(ctx, &cy, argv[1]) || JS_ToFloat64(ctx, &r, argv[2]) ||
+     JS_ToFloat64(ctx, &a0, argv[3]) || JS_ToFloat64(ctx, &a1, argv[4]) || JS_ToInt32(ctx, &dir, argv[5]))
+    return JS_EXCEPTION;
+
+  NVGJS_PROFILE_MARK();
+  nvgArc(nvg, cx, cy, r, a0, a1, dir);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Context, ClosePath) {
   NVGJS_CONTEXT(this_obj);
 
-  nvgEndFrame(nvg);
+  NVGJS_PROFILE_MARK();
+  nvgClosePath(nvg);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, CancelFrame) {
+NVGJS_DECL(Context, FontSize) {
   NVGJS_CONTEXT(this_obj);
 
-  nvgCancelFrame(nvg);
+  double size;
+
+  if(argc < 1)
+    return JS_ThrowInternalError(ctx, "need 1 arguments");
+
+  if(JS_ToFloat64(ctx, &size, argv[0]))
+    return JS_EXCEPTION;
+
+  NVGJS_PROFILE_MARK();
+  nvgFontSize(nvg, size);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, Save) {
+NVGJS_DECL(Context, FontBlur) {
   NVGJS_CONTEXT(this_obj);
 
-  nvgSave(nvg);
+  double blur;
+
+  if(argc < 1)
+    return JS_ThrowInternalError(ctx, "need 1 arguments");
+
+  if(JS_ToFloat64(ctx, &blur, argv[0]))
+    return JS_EXCEPTION;
+
+  NVGJS_PROFILE_MARK();
+  nvgFontBlur(nvg, blur);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, Restore) {
+NVGJS_DECL(Context, TextLetterSpacing) {
   NVGJS_CONTEXT(this_obj);
 
-  nvgRestore(nvg);
+  double spacing;
+
+  if(argc < 1)
+    return JS_ThrowInternalError(ctx, "need 1 arguments");
+
+  if(JS_ToFloat64(ctx, &spacing, argv[0]))
+    return JS_EXCEPTION;
+
+  NVGJS_PROFILE_MARK();
+  nvgTextLetterSpacing(nvg, spacing);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, Reset) {
+NVGJS_DECL(Context, TextLineHeight) {
   NVGJS_CONTEXT(this_obj);
 
-  nvgReset(nvg);
+  double height;
+
+  if(argc < 1)
+    return JS_ThrowInternalError(ctx, "need 1 arguments");
+
+  if(JS_ToFloat64(ctx, &height, argv[0]))
+    return JS_EXCEPTION;
+
+  NVGJS_PROFILE_MARK();
+  nvgTextLineHeight(nvg, height);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, ShapeAntiAlias) {
+NVGJS_DECL(Context, BeginPath) {
   NVGJS_CONTEXT(this_obj);
 
-  nvgShapeAntiAlias(nvg, JS_ToBool(ctx, argv[0]));
+  NVGJS_PROFILE_MARK();
+  nvgBeginPath(nvg);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, Rect) {
+NVGJS_DECL(Context, RoundedRect) {
   NVGJS_CONTEXT(this_obj);
 
-  double x, y, w, h;
+  double x, y, w, h, r;
 
-  if(argc < 4)
-    return JS_ThrowInternalError(ctx, "need 4 arguments");
+  if(argc < 5)
+    return JS_ThrowInternalError(ctx, "need 5 arguments");
 
   if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]) || JS_ToFloat64(ctx, &w, argv[2]) ||
-     JS_ToFloat64(ctx, &h, argv[3]))
+     JS_ToFloat64(ctx, &h, argv[3]) || JS_ToFloat64(ctx, &r, argv[4]))
     return JS_EXCEPTION;
 
-  nvgRect(nvg, x, y, w, h);
+  NVGJS_PROFILE_MARK();
+  nvgRoundedRect(nvg, x, y, w, h, r);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, Circle) {
+NVGJS_DECL(Context, RoundedRectVarying) {
   NVGJS_CONTEXT(this_obj);
 
-  double cx, cy, r;
+  double x, y, w, h, rtl, rtr, rbr, rbl;
 
-  if(argc < 3)
-    return JS_ThrowInternalError(ctx, "need 3 arguments");
+  if(argc < 8)
+    return JS_ThrowInternalError(ctx, "need 8 arguments");
 
-  if(JS_ToFloat64(ctx, &cx, argv[0]) || JS_ToFloat64(ctx, &cy, argv[1]) || JS_ToFloat64(ctx, &r, argv[2]))
+  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]) || JS_ToFloat64(ctx, &w, argv[2]) ||
+     JS_ToFloat64(ctx, &h, argv[3]) || JS_ToFloat64(ctx, &rtl, argv[4]) || JS_ToFloat64(ctx, &rtr, argv[5]) ||
+     JS_ToFloat64(ctx, &rbr, argv[6]) || JS_ToFloat64(ctx, &rbl, argv[7]))
     return JS_EXCEPTION;
 
-  nvgCircle(nvg, cx, cy, r);
+  NVGJS_PROFILE_MARK();
+  nvgRoundedRectVarying(nvg, x, y, w, h, rtl, rtr, rbr, rbl);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, Ellipse) {
+NVGJS_DECL(Context, Scissor) {
   NVGJS_CONTEXT(this_obj);
 
-  double cx, cy, rx, ry;
+  double x, y, w, h;
 
   if(argc < 4)
     return JS_ThrowInternalError(ctx, "need 4 arguments");
 
-  if(JS_ToFloat64(ctx, &cx, argv[0]) || JS_ToFloat64(ctx, &cy, argv[1]) || JS_ToFloat64(ctx, &rx, argv[2]) ||
-     JS_ToFloat64(ctx, &ry, argv[3]))
+  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]) || JS_ToFloat64(ctx, &w, argv[2]) ||
+     JS_ToFloat64(ctx, &h, argv[3]))
     return JS_EXCEPTION;
 
-  nvgEllipse(nvg, cx, cy, rx, ry);
+  NVGJS_PROFILE_MARK();
+  nvgScissor(nvg, x, y, w, h);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, PathWinding) {
+NVGJS_DECL(Context, IntersectScissor) {
   NVGJS_CONTEXT(this_obj);
 
-  int dir;
+  double x, y, w, h;
+
+  if(argc < 4)
+    return JS_ThrowInternalError(ctx, "need 4 arguments");
+
+  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]) || JS_ToFloat64(ctx, &w, argv[2]) ||
+     JS_ToFloat64(ctx, &h, argv[3]))
+    return JS_EXCEPTION;
+
+  NVGJS_PROFILE_MARK();
+  nvgIntersectScissor(nvg, x, y, w, h);
+
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Context, ResetScissor) {
+  NVGJS_CONTEXT(this_obj);
+
+  NVGJS_PROFILE_MARK();
+  nvgResetScissor(nvg);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Context, FillPaint) {
+  NVGJS_CONTEXT(this_obj);
+
+  NVGpaint* paint;
 
   if(argc < 1)
     return JS_ThrowInternalError(ctx, "need 1 arguments");
 
-  if(JS_ToInt32(ctx, &dir, argv[0]))
+  if(!(paint = JS_GetOpaque2(ctx, argv[0], nvgjs_paint_class_id)))
     return JS_EXCEPTION;
 
-  nvgPathWinding(nvg, dir);
+  NVGJS_PROFILE_MARK();
+  nvgFillPaint(nvg, *paint);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, MoveTo) {
+NVGJS_DECL(Context, Fill) {
   NVGJS_CONTEXT(this_obj);
 
-  double x, y;
+  NVGJS_PROFILE_MARK();
+  nvgFill(nvg);
+  return JS_UNDEFINED;
+}
 
-  if(argc < 2)
-    return JS_ThrowInternalError(ctx, "need 2 arguments");
+NVGJS_DECL(Context, MiterLimit) {
+  NVGJS_CONTEXT(this_obj);
 
-  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]))
+  double miterLimit;
+
+  if(JS_ToFloat64(ctx, &miterLimit, argv[0]))
     return JS_EXCEPTION;
 
-  nvgMoveTo(nvg, x, y);
+  NVGJS_PROFILE_MARK();
+  nvgMiterLimit(nvg, miterLimit);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, LineTo) {
+NVGJS_DECL(Context, LineCap) {
   NVGJS_CONTEXT(this_obj);
 
-  double x, y;
+  int32_t lineCap;
 
-  if(argc < 2)
-    return JS_ThrowInternalError(ctx, "need 2 arguments");
+  if(JS_ToInt32(ctx, &lineCap, argv[0]))
+    return JS_EXCEPTION;
 
-  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]))
+  NVGJS_PROFILE_MARK();
+  nvgLineCap(nvg, lineCap);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Context, LineJoin) {
+  NVGJS_CONTEXT(this_obj);
+
+  int32_t lineJoin;
+
+  if(JS_ToInt32(ctx, &lineJoin, argv[0]))
     return JS_EXCEPTION;
 
-  nvgLineTo(nvg, x, y);
+  NVGJS_PROFILE_MARK();
+  nvgLineJoin(nvg, lineJoin);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, BezierTo) {
+NVGJS_DECL(Context, GlobalAlpha) {
   NVGJS_CONTEXT(this_obj);
 
-  double c1x, c1y, c2x, c2y, x, y;
+  double alpha;
 
-  if(argc < 6)
-    return JS_ThrowInternalError(ctx, "need 6 arguments");
+  if(JS_ToFloat64(ctx, &alpha, argv[0]))
+    return JS_EXCEPTION;
 
-  if(JS_ToFloat64(ctx, &c1x, argv[0]) || JS_ToFloat64(ctx, &c1y, argv[1]) || JS_ToFloat64(ctx, &c2x, argv[2]) ||
-     JS_ToFloat64(ctx, &c2y, argv[3]) || JS_ToFloat64(ctx, &x, argv[4]) || JS_ToFloat64(ctx, &y, argv[5]))
+  NVGJS_PROFILE_MARK();
+  nvgGlobalAlpha(nvg, alpha);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(Context, StrokeColor) {
+  static NVGJSHint hints[1];
+  NVGJS_CONTEXT(this_obj);
+
+  NVGcolor color;
+
+  if(argc < 1)
+    return JS_ThrowInternalError(ctx, "need 1 arguments");
+
+  if(nvgjs_tocolor(ctx, &color, argv[0], &hints[0]))
     return JS_EXCEPTION;
 
-  nvgBezierTo(nvg, c1x, c1y, c2x, c2y, x, y);
+  NVGJS_PROFILE_MARK();
+  nvgStrokeColor(nvg, color);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, QuadTo) {
+NVGJS_DECL(Context, Stroke) {
   NVGJS_CONTEXT(this_obj);
 
-  double cx, cy, x, y;
+  NVGJS_PROFILE_MARK();
+  nvgStroke(nvg);
+  return JS_UNDEFINED;
+}
 
-  if(argc < 4)
-    return JS_ThrowInternalError(ctx, "need 4 arguments");
+NVGJS_DECL(Context, StrokePaint) {
+  NVGJS_CONTEXT(this_obj);
 
-  if(JS_ToFloat64(ctx, &cx, argv[0]) || JS_ToFloat64(ctx, &cy, argv[1]) || JS_ToFloat64(ctx, &x, argv[2]) ||
-     JS_ToFloat64(ctx, &y, argv[3]))
+  NVGpaint* paint;
+
+  if(argc < 1)
+    return JS_ThrowInternalError(ctx, "need 1 arguments");
+
+  if(!(paint = JS_GetOpaque(argv[0], nvgjs_paint_class_id)))
     return JS_EXCEPTION;
 
-  nvgQuadTo(nvg, cx, cy, x, y);
+  NVGJS_PROFILE_MARK();
+  nvgStrokePaint(nvg, *paint);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, ArcTo) {
+NVGJS_DECL(Context, FillColor) {
+  static NVGJSHint hints[1];
   NVGJS_CONTEXT(this_obj);
 
-  double x1, y1, x2, y2, radius;
+  NVGcolor color;
 
-  if(argc < 5)
-    return JS_ThrowInternalError(ctx, "need 5 arguments");
+  if(argc < 1)
+    return JS_ThrowInternalError(ctx, "need 1 arguments");
 
-  if(JS_ToFloat64(ctx, &x1, argv[0]) || JS_ToFloat64(ctx, &y1, argv[1]) || JS_ToFloat64(ctx, &x2, argv[2]) ||
-     JS_ToFloat64(ctx, &y2, argv[3]) || JS_ToFloat64(ctx, &radius, argv[4]))
+  if(nvgjs_tocolor(ctx, &color, argv[0], &hints[0]))
     return JS_EXCEPTION;
 
-  nvgArcTo(nvg, x1, y1, x2, y2, radius);
+  NVGJS_PROFILE_MARK();
+  nvgFillColor(nvg, color);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, Arc) {
+NVGJS_DECL(Context, LinearGradient) {
+  static NVGJSHint hints[2];
   NVGJS_CONTEXT(this_obj);
 
-  double cx, cy, r, a0, a1;
-  int32_t dir;
+  double sx, sy, ex, ey;
+  NVGcolor icol, ocol;
 
   if(argc < 6)
     return JS_ThrowInternalError(ctx, "need 6 arguments");
 
-  if(JS_ToFloat64(ctx, &cx, argv[0]) || JS_ToFloat64(ctx, &cy, argv[1]) || JS_ToFloat64(ctx, &r, argv[2]) ||
-     JS_ToFloat64(ctx, &a0, argv[3]) || JS_ToFloat64(ctx, &a1, argv[4]) || JS_ToInt32(ctx, &dir, argv[5]))
+  if(JS_ToFloat64(ctx, &sx, argv[0]) || JS_ToFloat64(ctx, &sy, argv[1]) || JS_ToFloat64(ctx, &ex, argv[2]) ||
+     JS_ToFloat64(ctx, &ey, argv[3]) || nvgjs_tocolor(ctx, &icol, argv[4], &hints[0]) ||
+     nvgjs_tocolor(ctx, &ocol, argv[5], &hints[1]))
     return JS_EXCEPTION;
 
-  nvgArc(nvg, cx, cy, r, a0, a1, dir);
-  return JS_UNDEFINED;
+  NVGJS_PROFILE_MARK();
+  return nvgjs_paint_new(ctx, nvgLinearGradient(nvg, sx, sy, ex, ey, icol, ocol));
 }
 
-NVGJS_DECL(Context, ClosePath) {
+NVGJS_DECL(Context, BoxGradient) {
+  static NVGJSHint hints[2];
   NVGJS_CONTEXT(this_obj);
 
-  nvgClosePath(nvg);
-  return JS_UNDEFINED;
+  double x, y, w, h, r, f;
+  NVGcolor icol, ocol;
+
+  if(argc < 8)
+    return JS_ThrowInternalError(ctx, "need 8 arguments");
+
+  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]) || JS_ToFloat64(ctx, &w, argv[2]) ||
+     JS_ToFloat64(ctx, &h, argv[3]) || JS_ToFloat64(ctx, &r, argv[4]) || JS_ToFloat64(ctx, &f, argv[5]) ||
+     nvgjs_tocolor(ctx, &icol, argv[6], &hints[0]) || nvgjs_tocolor(ctx, &ocol, argv[7], &hints[1]))
+    return JS_EXCEPTION;
+
+  NVGJS_PROFILE_MARK();
+  return nvgjs_paint_new(ctx, nvgBoxGradient(nvg, x, y, w, h, r, f, icol, ocol));
+}
+
+NVGJS_DECL(Context, RadialGradient) {
+  static NVGJSHint hints[2];
+  NVGJS_CONTEXT(this_obj);
+
+  double cx, cy, inr, outr;
+  NVGcolor icol, ocol;
+
+  if(argc < 6)
+    return JS_ThrowInternalError(ctx, "need 6 arguments");
+
+  if(JS_ToFloat64(ctx, &cx, argv[0]) || JS_ToFloat64(ctx, &cy, argv[1]) || JS_ToFloat64(ctx, &inr, argv[2]) ||
+     JS_ToFloat64(ctx, &outr, argv[3]) || nvgjs_tocolor(ctx, &icol, argv[4], &hints[0]) ||
+     nvgjs_tocolor(ctx, &ocol, argv[5], &hints[1]))
+    return JS_EXCEPTION;
+
+  NVGJS_PROFILE_MARK();
+  return nvgjs_paint_new(ctx, nvgRadialGradient(nvg, cx, cy, inr, outr, icol, ocol));
 }
 
-NVGJS_DECL(Context, FontSize) {
+NVGJS_DECL(Context, TextAlign) {
   NVGJS_CONTEXT(this_obj);
 
-  double size;
+  int align;
 
   if(argc < 1)
     return JS_ThrowInternalError(ctx, "need 1 arguments");
 
-  if(JS_ToFloat64(ctx, &size, argv[0]))
+  if(JS_ToInt32(ctx, &align, argv[0]))
     return JS_EXCEPTION;
 
-  nvgFontSize(nvg, size);
+  NVGJS_PROFILE_MARK();
+  nvgTextAlign(nvg, align);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, FontBlur) {
+NVGJS_DECL(Context, FontFace) {
   NVGJS_CONTEXT(this_obj);
 
-  double blur;
+  const char* str;
 
   if(argc < 1)
     return JS_ThrowInternalError(ctx, "need 1 arguments");
 
-  if(JS_ToFloat64(ctx, &blur, argv[0]))
+  if(!(str = JS_ToCString(ctx, argv[0])))
     return JS_EXCEPTION;
 
-  nvgFontBlur(nvg, blur);
+  NVGJS_PROFILE_MARK();
+  nvgFontFace(nvg, str);
+  JS_FreeCString(ctx, str);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, TextLetterSpacing) {
+NVGJS_DECL(Context, Text) {
   NVGJS_CONTEXT(this_obj);
 
-  double spacing;
+  double x, y;
+  const char *str, *end = 0;
+  size_t len;
 
-  if(argc < 1)
-    return JS_ThrowInternalError(ctx, "need 1 arguments");
+  if(argc < 3)
+    return JS_ThrowInternalError(ctx, "need 3 arguments");
 
-  if(JS_ToFloat64(ctx, &spacing, argv[0]))
+  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]))
     return JS_EXCEPTION;
 
-  nvgTextLetterSpacing(nvg, spacing);
-  return JS_UNDEFINED;
+  if(!(str = JS_ToCStringLen(ctx, &len, argv[2])))
+    return JS_EXCEPTION;
+
+  if(argc > 3 && !JS_IsUndefined(argv[3]) && !JS_IsNull(argv[3])) {
+    int32_t pos;
+
+    if(JS_ToInt32(ctx, &pos, argv[3])) {
+      JS_FreeCString(ctx, str);
+      return JS_EXCEPTION;
+    }
+    end = str + nvgjs_utf8offset(str, len, pos);
+  }
+
+  NVGJS_TRACE_BEGIN(t0);
+  NVGJS_PROFILE_MARK();
+  float ret = nvgText(nvg, x, y, str, end);
+
+  NVGJS_TRACE_END(t0, "Text", "text", (end ? end : str + len) - str);
+
+  JS_FreeCString(ctx, str);
+
+  return JS_NewFloat64(ctx, ret);
 }
 
-NVGJS_DECL(Context, TextLineHeight) {
+NVGJS_DECL(Context, TextBox) {
   NVGJS_CONTEXT(this_obj);
 
-  double height;
+  double x, y;
+  double breakRowWidth;
+  const char *str, *end = 0;
+  size_t len;
 
-  if(argc < 1)
-    return JS_ThrowInternalError(ctx, "need 1 arguments");
+  if(argc < 4)
+    return JS_ThrowInternalError(ctx, "need 4 arguments");
 
-  if(JS_ToFloat64(ctx, &height, argv[0]))
+  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]))
     return JS_EXCEPTION;
 
-  nvgTextLineHeight(nvg, height);
-  return JS_UNDEFINED;
-}
+  if(JS_ToFloat64(ctx, &breakRowWidth, argv[2]))
+    return JS_EXCEPTION;
 
-NVGJS_DECL(Context, BeginPath) {
-  NVGJS_CONTEXT(this_obj);
+  if(!(str = JS_ToCStringLen(ctx, &len, argv[3])))
+    return JS_EXCEPTION;
+
+  if(argc > 4 && !JS_IsUndefined(argv[4]) && !JS_IsNull(argv[4])) {
+    int32_t pos;
+
+    if(JS_ToInt32(ctx, &pos, argv[4])) {
+      JS_FreeCString(ctx, str);
+      return JS_EXCEPTION;
+    }
+    end = str + nvgjs_utf8offset(str, len, pos);
+  }
+
+  NVGJS_TRACE_BEGIN(t0);
+  NVGJS_PROFILE_MARK();
+  nvgTextBox(nvg, x, y, breakRowWidth, str, end);
+  NVGJS_TRACE_END(t0, "TextBox", "text", (end ? end : str + len) - str);
+
+  JS_FreeCString(ctx, str);
 
-  nvgBeginPath(nvg);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, RoundedRect) {
+NVGJS_DECL(Context, TextBounds) {
   NVGJS_CONTEXT(this_obj);
 
-  double x, y, w, h, r;
+  double x, y;
+  const char *str, *end = 0;
+  size_t len;
+  float bounds[4];
 
   if(argc < 5)
     return JS_ThrowInternalError(ctx, "need 5 arguments");
 
-  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]) || JS_ToFloat64(ctx, &w, argv[2]) ||
-     JS_ToFloat64(ctx, &h, argv[3]) || JS_ToFloat64(ctx, &r, argv[4]))
+  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]))
     return JS_EXCEPTION;
 
-  nvgRoundedRect(nvg, x, y, w, h, r);
-  return JS_UNDEFINED;
-}
+  if(!(str = JS_ToCStringLen(ctx, &len, argv[2])))
+    return JS_EXCEPTION;
 
-NVGJS_DECL(Context, RoundedRectVarying) {
-  NVGJS_CONTEXT(this_obj);
+  if(!(JS_IsNull(argv[3]) || JS_IsUndefined(argv[3]))) {
+    int32_t pos;
 
-  double x, y, w, h, rtl, rtr, rbr, rbl;
+    if(JS_ToInt32(ctx, &pos, argv[3])) {
+      JS_FreeCString(ctx, str);
+      return JS_EXCEPTION;
+    }
+    end = str + nvgjs_utf8offset(str, len, pos);
+  }
 
-  if(argc < 8)
-    return JS_ThrowInternalError(ctx, "need 8 arguments");
+  NVGJS_TRACE_BEGIN(t0);
+  NVGJS_PROFILE_MARK();
+  float ret = nvgTextBounds(nvg, x, y, str, end, bounds);
 
-  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]) || JS_ToFloat64(ctx, &w, argv[2]) ||
-     JS_ToFloat64(ctx, &h, argv[3]) || JS_ToFloat64(ctx, &rtl, argv[4]) || JS_ToFloat64(ctx, &rtr, argv[5]) ||
-     JS_ToFloat64(ctx, &rbr, argv[6]) || JS_ToFloat64(ctx, &rbl, argv[7]))
-    return JS_EXCEPTION;
+  NVGJS_TRACE_END(t0, "TextBounds", "text", (end ? end : str + len) - str);
 
-  nvgRoundedRectVarying(nvg, x, y, w, h, rtl, rtr, rbr, rbl);
-  return JS_UNDEFINED;
+  JS_FreeCString(ctx, str);
+
+  nvgjs_copyobject(ctx, argv[4], nvgjs_state(ctx)->bounds_keys, bounds, countof(bounds));
+
+  return JS_NewFloat64(ctx, ret);
 }
 
-NVGJS_DECL(Context, Scissor) {
+NVGJS_DECL(Context, TextBoxBounds) {
   NVGJS_CONTEXT(this_obj);
 
-  double x, y, w, h;
+  double x, y;
+  double breakRowWidth;
+  const char *str, *end = 0;
+  size_t len;
+  float bounds[4];
 
-  if(argc < 4)
-    return JS_ThrowInternalError(ctx, "need 4 arguments");
+  if(argc < 6)
+    return JS_ThrowInternalError(ctx, "need 6 arguments");
 
-  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]) || JS_ToFloat64(ctx, &w, argv[2]) ||
-     JS_ToFloat64(ctx, &h, argv[3]))
+  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]))
     return JS_EXCEPTION;
 
-  nvgScissor(nvg, x, y, w, h);
+  if(JS_ToFloat64(ctx, &breakRowWidth, argv[2]))
+    return JS_EXCEPTION;
+
+  if(!(str = JS_ToCStringLen(ctx, &len, argv[3])))
+    return JS_EXCEPTION;
+
+  if(!(JS_IsNull(argv[4]) || JS_IsUndefined(argv[4]))) {
+    int32_t pos;
+
+    if(JS_ToInt32(ctx, &pos, argv[4])) {
+      JS_FreeCString(ctx, str);
+      return JS_EXCEPTION;
+    }
+    end = str + nvgjs_utf8offset(str, len, pos);
+  }
+
+  NVGJS_TRACE_BEGIN(t0);
+  NVGJS_PROFILE_MARK();
+  nvgTextBoxBounds(nvg, x, y, breakRowWidth, str, end, bounds);
+  NVGJS_TRACE_END(t0, "TextBoxBounds", "text", (end ? end : str + len) - str);
+
+  JS_FreeCString(ctx, str);
+
+  nvgjs_copyobject(ctx, argv[5], nvgjs_state(ctx)->bounds_keys, bounds, countof(bounds));
+
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, IntersectScissor) {
+NVGJS_DECL(Context, TextBounds2) {
   NVGJS_CONTEXT(this_obj);
 
-  double x, y, w, h;
+  double x, y;
+  const char* str;
 
-  if(argc < 4)
-    return JS_ThrowInternalError(ctx, "need 4 arguments");
+  if(argc < 3)
+    return JS_ThrowInternalError(ctx, "need 3 arguments");
 
-  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]) || JS_ToFloat64(ctx, &w, argv[2]) ||
-     JS_ToFloat64(ctx, &h, argv[3]))
+  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]))
     return JS_EXCEPTION;
 
-  nvgIntersectScissor(nvg, x, y, w, h);
+  if(!(str = JS_ToCString(ctx, argv[2])))
+    return JS_EXCEPTION;
 
-  return JS_UNDEFINED;
-}
+  float bounds[4] = {};
+  NVGJS_TRACE_BEGIN(t0);
+  NVGJS_PROFILE_MARK();
+  float tw = nvgTextBounds(nvg, x, y, str, NULL, bounds);
 
-NVGJS_DECL(Context, ResetScissor) {
-  NVGJS_CONTEXT(this_obj);
+  NVGJS_TRACE_END(t0, "TextBounds2", "text", strlen(str));
+  JS_FreeCString(ctx, str);
 
-  nvgResetScissor(nvg);
-  return JS_UNDEFINED;
+  return nvgjs_newobject(ctx, nvgjs_state(ctx)->size_keys, (const float[]){tw, bounds[3] - bounds[1]}, 2);
 }
 
-NVGJS_DECL(Context, FillPaint) {
+NVGJS_DECL(Context, StrokeWidth) {
   NVGJS_CONTEXT(this_obj);
 
-  NVGpaint* paint;
+  double width;
 
   if(argc < 1)
     return JS_ThrowInternalError(ctx, "need 1 arguments");
 
-  if(!(paint = JS_GetOpaque2(ctx, argv[0], nvgjs_paint_class_id)))
+  if(JS_ToFloat64(ctx, &width, argv[0]))
     return JS_EXCEPTION;
 
-  nvgFillPaint(nvg, *paint);
+  NVGJS_PROFILE_MARK();
+  nvgStrokeWidth(nvg, width);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, Fill) {
+NVGJS_DECL(Context, CreateImage) {
   NVGJS_CONTEXT(this_obj);
 
-  nvgFill(nvg);
-  return JS_UNDEFINED;
-}
+  const char* file;
+  int32_t flags = 0;
 
-NVGJS_DECL(Context, MiterLimit) {
-  NVGJS_CONTEXT(this_obj);
+  if(argc < 2)
+    return JS_ThrowInternalError(ctx, "need 2 arguments");
 
-  double miterLimit;
+  if(!(file = JS_ToCString(ctx, argv[0])))
+    return JS_EXCEPTION;
 
-  if(JS_ToFloat64(ctx, &miterLimit, argv[0]))
+  if(JS_ToInt32(ctx, &flags, argv[1])) {
+    JS_FreeCString(ctx, file);
     return JS_EXCEPTION;
+  }
 
-  nvgMiterLimit(nvg, miterLimit);
-  return JS_UNDEFINED;
+  NVGJS_PROFILE_MARK();
+  int ret = nvgCreateImage(nvg, file, flags);
+  JS_FreeCString(ctx, file);
+  return JS_NewInt32(ctx, ret);
 }
 
-NVGJS_DECL(Context, LineCap) {
+NVGJS_DECL(Context, CreateImageMem) {
   NVGJS_CONTEXT(this_obj);
 
-  int32_t lineCap;
-
-  if(JS_ToInt32(ctx, &lineCap, argv[0]))
-    return JS_EXCEPTION;
-
-  nvgLineCap(nvg, lineCap);
-  return JS_UNDEFINED;
-}
+  int32_t flags;
+  uint8_t* ptr;
+  size_t len;
 
-NVGJS_DECL(Context, LineJoin) {
-  NVGJS_CONTEXT(this_obj);
+  if(argc < 2)
+    return JS_ThrowInternalError(ctx, "need 2 arguments");
 
-  int32_t lineJoin;
+  if(JS_ToInt32(ctx, &flags, argv[0]))
+    return JS_EXCEPTION;
 
-  if(JS_ToInt32(ctx, &lineJoin, argv[0]))
+  if(!(ptr = JS_GetArrayBuffer(ctx, &len, argv[1])))
     return JS_EXCEPTION;
 
-  nvgLineJoin(nvg, lineJoin);
-  return JS_UNDEFINED;
+  NVGJS_PROFILE_MARK();
+  return JS_NewInt32(ctx, nvgCreateImageMem(nvg, flags, (void*)ptr, len));
 }
 
-NVGJS_DECL(Context, GlobalAlpha) {
+NVGJS_DECL(Context, CreateImageRGBA) {
   NVGJS_CONTEXT(this_obj);
 
-  double alpha;
+  int32_t width, height, flags;
+  uint8_t* ptr;
+  size_t len;
+
+  if(argc < 4)
+    return JS_ThrowInternalError(ctx, "need 4 arguments");
+
+  if(JS_ToInt32(ctx, &width, argv[0]) || JS_ToInt32(ctx, &height, argv[1]) || JS_ToInt32(ctx, &flags, argv[2]))
+    return JS_EXCEPTION;
 
-  if(JS_ToFloat64(ctx, &alpha, argv[0]))
+  if(!(ptr = JS_GetArrayBuffer(ctx, &len, argv[3])))
     return JS_EXCEPTION;
 
-  nvgGlobalAlpha(nvg, alpha);
-  return JS_UNDEFINED;
+  NVGJS_PROFILE_MARK();
+  return JS_NewInt32(ctx, nvgCreateImageRGBA(nvg, width, height, flags, (void*)ptr));
 }
 
-NVGJS_DECL(Context, StrokeColor) {
+NVGJS_DECL(Context, UpdateImage) {
   NVGJS_CONTEXT(this_obj);
 
-  NVGcolor color;
+  int32_t image;
+  size_t len;
+  uint8_t* ptr;
 
-  if(argc < 1)
-    return JS_ThrowInternalError(ctx, "need 1 arguments");
+  if(argc < 2)
+    return JS_ThrowInternalError(ctx, "need 2 arguments");
 
-  if(nvgjs_tocolor(ctx, &color, argv[0]))
+  if(JS_ToInt32(ctx, &image, argv[0]))
     return JS_EXCEPTION;
 
-  nvgStrokeColor(nvg, color);
-  return JS_UNDEFINED;
-}
+  if(!(ptr = JS_GetArrayBuffer(ctx, &len, argv[1])))
+    return JS_EXCEPTION;
 
-NVGJS_DECL(Context, Stroke) {
-  NVGJS_CONTEXT(this_obj);
+  NVGJS_PROFILE_MARK();
+  nvgUpdateImage(nvg, image, (void*)ptr);
 
-  nvgStroke(nvg);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, StrokePaint) {
+NVGJS_DECL(Context, ImageSize) {
   NVGJS_CONTEXT(this_obj);
 
-  NVGpaint* paint;
+  int32_t id = 0;
+  int width, height;
 
   if(argc < 1)
     return JS_ThrowInternalError(ctx, "need 1 arguments");
 
-  if(!(paint = JS_GetOpaque(argv[0], nvgjs_paint_class_id)))
+  if(JS_ToInt32(ctx, &id, argv[0]))
     return JS_EXCEPTION;
 
-  nvgStrokePaint(nvg, *paint);
-  return JS_UNDEFINED;
+  NVGJS_PROFILE_MARK();
+  nvgImageSize(nvg, id, &width, &height);
+
+  JSValue ret = JS_NewArray(ctx);
+  JS_SetPropertyUint32(ctx, ret, 0, JS_NewInt32(ctx, width));
+  JS_SetPropertyUint32(ctx, ret, 1, JS_NewInt32(ctx, height));
+  return ret;
 }
 
-NVGJS_DECL(Context, FillColor) {
+NVGJS_DECL(Context, DeleteImage) {
   NVGJS_CONTEXT(this_obj);
 
-  NVGcolor color;
+  int32_t id = 0;
 
   if(argc < 1)
     return JS_ThrowInternalError(ctx, "need 1 arguments");
 
-  if(nvgjs_tocolor(ctx, &color, argv[0]))
+  if(JS_ToInt32(ctx, &id, argv[0]))
     return JS_EXCEPTION;
 
-  nvgFillColor(nvg, color);
+  NVGJS_PROFILE_MARK();
+  nvgDeleteImage(nvg, id);
+
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, LinearGradient) {
+NVGJS_DECL(Context, ResetTransform) {
   NVGJS_CONTEXT(this_obj);
 
-  double sx, sy, ex, ey;
-  NVGcolor icol, ocol;
-
-  if(argc < 6)
-    return JS_ThrowInternalError(ctx, "need 6 arguments");
-
-  if(JS_ToFloat64(ctx, &sx, argv[0]) || JS_ToFloat64(ctx, &sy, argv[1]) || JS_ToFloat64(ctx, &ex, argv[2]) ||
-     JS_ToFloat64(ctx, &ey, argv[3]) || nvgjs_tocolor(ctx, &icol, argv[4]) || nvgjs_tocolor(ctx, &ocol, argv[5]))
-    return JS_EXCEPTION;
+  NVGJS_PROFILE_MARK();
+  nvgResetTransform(nvg);
 
-  return nvgjs_paint_new(ctx, nvgLinearGradient(nvg, sx, sy, ex, ey, icol, ocol));
+  return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, BoxGradient) {
+NVGJS_DECL(Context, Transform) {
+  static NVGJSHint hints[1];
   NVGJS_CONTEXT(this_obj);
 
-  double x, y, w, h, r, f;
-  NVGcolor icol, ocol;
+  float t[6];
 
-  if(argc < 8)
-    return JS_ThrowInternalError(ctx, "need 8 arguments");
+  if(argc < 1)
+    return JS_ThrowInternalError(ctx, "need 1/6 arguments");
 
-  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]) || JS_ToFloat64(ctx, &w, argv[2]) ||
-     JS_ToFloat64(ctx, &h, argv[3]) || JS_ToFloat64(ctx, &r, argv[4]) || JS_ToFloat64(ctx, &f, argv[5]) ||
-     nvgjs_tocolor(ctx, &icol, argv[6]) || nvgjs_tocolor(ctx, &ocol, argv[7]))
-    return JS_EXCEPTION;
+  if(!nvgjs_transform_arguments(ctx, t, &hints[0], argc, argv))
+    return JS_UNDEFINED;
 
-  return nvgjs_paint_new(ctx, nvgBoxGradient(nvg, x, y, w, h, r, f, icol, ocol));
+  NVGJS_PROFILE_MARK();
+  nvgTransform(nvg, t[0], t[1], t[2], t[3], t[4], t[5]);
+  return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, RadialGradient) {
+NVGJS_DECL(Context, Translate) {
   NVGJS_CONTEXT(this_obj);
 
-  double cx, cy, inr, outr;
-  NVGcolor icol, ocol;
+  double x, y;
 
-  if(argc < 6)
-    return JS_ThrowInternalError(ctx, "need 6 arguments");
+  if(argc < 2)
+    return JS_ThrowInternalError(ctx, "need 2 arguments");
 
-  if(JS_ToFloat64(ctx, &cx, argv[0]) || JS_ToFloat64(ctx, &cy, argv[1]) || JS_ToFloat64(ctx, &inr, argv[2]) ||
-     JS_ToFloat64(ctx, &outr, argv[3]) || nvgjs_tocolor(ctx, &icol, argv[4]) || nvgjs_tocolor(ctx, &ocol, argv[5]))
+  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]))
     return JS_EXCEPTION;
 
-  return nvgjs_paint_new(ctx, nvgRadialGradient(nvg, cx, cy, inr, outr, icol, ocol));
+  NVGJS_PROFILE_MARK();
+  nvgTranslate(nvg, x, y);
+
+  return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, TextAlign) {
+NVGJS_DECL(Context, Rotate) {
   NVGJS_CONTEXT(this_obj);
 
-  int align;
+  double angle;
 
   if(argc < 1)
     return JS_ThrowInternalError(ctx, "need 1 arguments");
 
-  if(JS_ToInt32(ctx, &align, argv[0]))
+  if(JS_ToFloat64(ctx, &angle, argv[0]))
     return JS_EXCEPTION;
 
-  nvgTextAlign(nvg, align);
+  NVGJS_PROFILE_MARK();
+  nvgRotate(nvg, angle);
+
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, FontFace) {
+NVGJS_DECL(Context, SkewX) {
   NVGJS_CONTEXT(this_obj);
 
-  const char* str;
+  double angle;
 
   if(argc < 1)
     return JS_ThrowInternalError(ctx, "need 1 arguments");
 
-  if(!(str = JS_ToCString(ctx, argv[0])))
+  if(JS_ToFloat64(ctx, &angle, argv[0]))
     return JS_EXCEPTION;
 
-  nvgFontFace(nvg, str);
-  JS_FreeCString(ctx, str);
+  NVGJS_PROFILE_MARK();
+  nvgSkewX(nvg, angle);
+
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, Text) {
+NVGJS_DECL(Context, SkewY) {
   NVGJS_CONTEXT(this_obj);
 
-  double x, y;
-  const char *str, *end = 0;
-  size_t len;
-
-  if(argc < 3)
-    return JS_ThrowInternalError(ctx, "need 3 arguments");
+  double angle;
 
-  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]))
-    return JS_EXCEPTION;
+  if(argc < 1)
+    return JS_ThrowInternalError(ctx, "need 1 arguments");
 
-  if(!(str = JS_ToCStringLen(ctx, &len, argv[2])))
+  if(JS_ToFloat64(ctx, &angle, argv[0]))
     return JS_EXCEPTION;
 
-  if(argc > 3 && !JS_IsUndefined(argv[3]) && !JS_IsNull(argv[3])) {
-    int32_t pos;
-
-    if(JS_ToInt32(ctx, &pos, argv[3])) {
-      JS_FreeCString(ctx, str);
-      return JS_EXCEPTION;
-    }
-    end = str + nvgjs_utf8offset(str, len, pos);
-  }
-
-  float ret = nvgText(nvg, x, y, str, end);
-
-  JS_FreeCString(ctx, str);
+  NVGJS_PROFILE_MARK();
+  nvgSkewY(nvg, angle);
 
-  return JS_NewFloat64(ctx, ret);
+  return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, TextBox) {
+NVGJS_DECL(Context, Scale) {
   NVGJS_CONTEXT(this_obj);
 
   double x, y;
-  double breakRowWidth;
-  const char *str, *end = 0;
-  size_t len;
 
-  if(argc < 4)
-    return JS_ThrowInternalError(ctx, "need 4 arguments");
+  if(argc < 2)
+    return JS_ThrowInternalError(ctx, "need 2 arguments");
 
   if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]))
     return JS_EXCEPTION;
 
-  if(JS_ToFloat64(ctx, &breakRowWidth, argv[2]))
-    return JS_EXCEPTION;
-
-  if(!(str = JS_ToCStringLen(ctx, &len, argv[3])))
-    return JS_EXCEPTION;
-
-  if(argc > 4 && !JS_IsUndefined(argv[4]) && !JS_IsNull(argv[4])) {
-    int32_t pos;
-
-    if(JS_ToInt32(ctx, &pos, argv[4])) {
-      JS_FreeCString(ctx, str);
-      return JS_EXCEPTION;
-    }
-    end = str + nvgjs_utf8offset(str, len, pos);
-  }
-
-  nvgTextBox(nvg, x, y, breakRowWidth, str, end);
-
-  JS_FreeCString(ctx, str);
+  NVGJS_PROFILE_MARK();
+  nvgScale(nvg, x, y);
 
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, TextBounds) {
+NVGJS_DECL(Context, CurrentTransform) {
   NVGJS_CONTEXT(this_obj);
 
-  double x, y;
-  const char *str, *end = 0;
-  size_t len;
-  float bounds[4];
-
-  if(argc < 5)
-    return JS_ThrowInternalError(ctx, "need 5 arguments");
-
-  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]))
-    return JS_EXCEPTION;
-
-  if(!(str = JS_ToCStringLen(ctx, &len, argv[2])))
-    return JS_EXCEPTION;
-
-  if(!(JS_IsNull(argv[3]) || JS_IsUndefined(argv[3]))) {
-    int32_t pos;
+  float t[6], *mat;
 
-    if(JS_ToInt32(ctx, &pos, argv[3])) {
-      JS_FreeCString(ctx, str);
-      return JS_EXCEPTION;
-    }
-    end = str + nvgjs_utf8offset(str, len, pos);
+  if(argc > 0 && (mat = JS_GetOpaque(argv[0], nvgjs_transform_class_id))) {
+    NVGJS_PROFILE_MARK();
+    nvgCurrentTransform(nvg, mat);
+    return JS_UNDEFINED;
   }
 
-  float ret = nvgTextBounds(nvg, x, y, str, end, bounds);
-
-  JS_FreeCString(ctx, str);
+  nvgCurrentTransform(nvg, t);
 
-  nvgjs_copyobject(ctx, argv[4], (const char* const[]){"xmin", "ymin", "xmax", "ymax"}, bounds, countof(bounds));
+  if(argc == 0)
+    return nvgjs_transform_new(ctx, t);
 
-  return JS_NewFloat64(ctx, ret);
+  return nvgjs_transform_copy(ctx, argv[0], t);
 }
 
-NVGJS_DECL(Context, TextBoxBounds) {
+NVGJS_DECL(Context, ImagePattern) {
   NVGJS_CONTEXT(this_obj);
 
-  double x, y;
-  double breakRowWidth;
-  const char *str, *end = 0;
-  size_t len;
-  float bounds[4];
-
-  if(argc < 6)
-    return JS_ThrowInternalError(ctx, "need 6 arguments");
-
-  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]))
-    return JS_EXCEPTION;
+  double ox, oy, ex, ey;
+  double angle, alpha;
+  int32_t image;
+  NVGpaint paint, *p;
 
-  if(JS_ToFloat64(ctx, &breakRowWidth, argv[2]))
-    return JS_EXCEPTION;
+  if(argc < 7)
+    return JS_ThrowInternalError(ctx, "need 7 arguments");
 
-  if(!(str = JS_ToCStringLen(ctx, &len, argv[3])))
+  if(JS_ToFloat64(ctx, &ox, argv[0]) || JS_ToFloat64(ctx, &oy, argv[1]) || JS_ToFloat64(ctx, &ex, argv[2]) ||
+     JS_ToFloat64(ctx, &ey, argv[3]) || JS_ToFloat64(ctx, &angle, argv[4]) || JS_ToInt32(ctx, &image, argv[5]) ||
+     JS_ToFloat64(ctx, &alpha, argv[6]))
     return JS_EXCEPTION;
 
-  if(!(JS_IsNull(argv[4]) || JS_IsUndefined(argv[4]))) {
-    int32_t pos;
-
-    if(JS_ToInt32(ctx, &pos, argv[4])) {
-      JS_FreeCString(ctx, str);
-      return JS_EXCEPTION;
-    }
-    end = str + nvgjs_utf8offset(str, len, pos);
-  }
-
-  nvgTextBoxBounds(nvg, x, y, breakRowWidth, str, end, bounds);
+  NVGJS_PROFILE_MARK();
+  return nvgjs_paint_new(ctx, nvgImagePattern(nvg, ox, oy, ex, ey, angle, image, alpha));
+}
 
-  JS_FreeCString(ctx, str);
+NVGJS_DECL(Context, Execute) {
+  NVGJS_CONTEXT(this_obj);
 
-  nvgjs_copyobject(ctx, argv[5], (const char* const[]){"xmin", "ymin", "xmax", "ymax"}, bounds, countof(bounds));
+  float* cmd;
+  int length;
+  size_t len, pos, offset = 0;
+  int64_t off = 0, count = -1;
 
-  return JS_UNDEFINED;
-}
+  if(argc < 1)
+    return JS_ThrowInternalError(ctx, "need 1 arguments");
 
-NVGJS_DECL(Context, TextBounds2) {
-  NVGJS_CONTEXT(this_obj);
+  if(nvgjs_isfloat32array(ctx, argv[0])) {
+    if(!(cmd = nvgjs_outputarray(ctx, &length, argv[0])))
+      return JS_EXCEPTION;
 
-  double x, y;
-  const char* str;
+    len = length;
+  } else {
+    if(!(cmd = (float*)JS_GetArrayBuffer(ctx, &len, argv[0])))
+      return JS_EXCEPTION;
 
-  if(argc < 3)
-    return JS_ThrowInternalError(ctx, "need 3 arguments");
+    len /= sizeof(float);
+  }
 
-  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]))
+  if(argc > 1 && JS_ToInt64(ctx, &off, argv[1]))
     return JS_EXCEPTION;
 
-  if(!(str = JS_ToCString(ctx, argv[2])))
+  if(argc > 2 && !JS_IsUndefined(argv[2]) && JS_ToInt64(ctx, &count, argv[2]))
     return JS_EXCEPTION;
 
-  float bounds[4] = {};
-  float tw = nvgTextBounds(nvg, x, y, str, NULL, bounds);
-  JS_FreeCString(ctx, str);
+  if(off < 0 || (size_t)off > len)
+    return JS_ThrowRangeError(ctx, "offset %" PRId64 " out of range (length %zu)", off, len);
+
+  offset = off;
+
+  if(count >= 0 && (size_t)count < len - offset)
+    len = offset + count;
+
+  NVGJS_PROFILE_MARK();
+  int ret = nvgjs_command_execute(nvg, cmd + offset, len - offset, &pos);
 
-  JSValue e = JS_NewObject(ctx);
-  JS_DefinePropertyValueStr(ctx, e, "width", JS_NewFloat64(ctx, tw), JS_PROP_C_W_E);
-  JS_DefinePropertyValueStr(ctx, e, "height", JS_NewFloat64(ctx, bounds[3] - bounds[1]), JS_PROP_C_W_E);
-  return e;
+  if(ret < 0)
+    return JS_ThrowRangeError(ctx, "malformed command (%g) at offset %zu", cmd[offset + pos], offset + pos);
+
+  return JS_NewInt32(ctx, ret);
 }
 
-NVGJS_DECL(Context, StrokeWidth) {
+NVGJS_DECL(Context, AppendPath) {
   NVGJS_CONTEXT(this_obj);
 
-  double width;
+  NVGJSPath* path;
 
   if(argc < 1)
     return JS_ThrowInternalError(ctx, "need 1 arguments");
 
-  if(JS_ToFloat64(ctx, &width, argv[0]))
+  if(!(path = JS_GetOpaque2(ctx, argv[0], nvgjs_path_class_id)))
     return JS_EXCEPTION;
 
-  nvgStrokeWidth(nvg, width);
+  NVGJS_PROFILE_MARK();
+  nvgjs_command_execute(nvg, path->cmds, path->len, NULL);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, CreateImage) {
+NVGJS_DECL(Context, FillPath) {
   NVGJS_CONTEXT(this_obj);
 
-  const char* file;
-  int32_t flags = 0;
+  NVGJSPath* path;
 
-  if(argc < 2)
-    return JS_ThrowInternalError(ctx, "need 2 arguments");
+  if(argc < 1)
+    return JS_ThrowInternalError(ctx, "need 1 arguments");
 
-  if(!(file = JS_ToCString(ctx, argv[0])))
+  if(!(path = JS_GetOpaque2(ctx, argv[0], nvgjs_path_class_id)))
     return JS_EXCEPTION;
 
-  if(JS_ToInt32(ctx, &flags, argv[1])) {
-    JS_FreeCString(ctx, file);
-    return JS_EXCEPTION;
-  }
+  if(!path->hash)
+    path->hash = nvgjs_tesscache_hash(path->cmds, path->len);
 
-  int ret = nvgCreateImage(nvg, file, flags);
-  JS_FreeCString(ctx, file);
-  return JS_NewInt32(ctx, ret);
+  NVGJS_PROFILE_MARK();
+  nvgjs_tesscache_draw(nvg, path->hash, path->cmds, path->len, 0);
+  return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, CreateImageMem) {
+NVGJS_DECL(Context, StrokePath) {
   NVGJS_CONTEXT(this_obj);
 
-  int32_t flags;
-  uint8_t* ptr;
-  size_t len;
+  NVGJSPath* path;
 
-  if(argc < 2)
-    return JS_ThrowInternalError(ctx, "need 2 arguments");
+  if(argc < 1)
+    return JS_ThrowInternalError(ctx, "need 1 arguments");
 
-  if(JS_ToInt32(ctx, &flags, argv[0]))
+  if(!(path = JS_GetOpaque2(ctx, argv[0], nvgjs_path_class_id)))
     return JS_EXCEPTION;
 
-  if(!(ptr = JS_GetArrayBuffer(ctx, &len, argv[1])))
-    return JS_EXCEPTION;
+  if(!path->hash)
+    path->hash = nvgjs_tesscache_hash(path->cmds, path->len);
 
-  return JS_NewInt32(ctx, nvgCreateImageMem(nvg, flags, (void*)ptr, len));
+  NVGJS_PROFILE_MARK();
+  nvgjs_tesscache_draw(nvg, path->hash, path->cmds, path->len, 1);
+  return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, CreateImageRGBA) {
-  NVGJS_CONTEXT(this_obj);
-
-  int32_t width, height, flags;
-  uint8_t* ptr;
-  size_t len;
-
-  if(argc < 4)
-    return JS_ThrowInternalError(ctx, "need 4 arguments");
-
-  if(JS_ToInt32(ctx, &width, argv[0]) || JS_ToInt32(ctx, &height, argv[1]) || JS_ToInt32(ctx, &flags, argv[2]))
-    return JS_EXCEPTION;
-
-  if(!(ptr = JS_GetArrayBuffer(ctx, &len, argv[3])))
-    return JS_EXCEPTION;
-
-  return JS_NewInt32(ctx, nvgCreateImageRGBA(nvg, width, height, flags, (void*)ptr));
+/* Make a retained path the current one, as FillPath() and StrokePath() do without a tessellation cache */
+static void
+nvgjs_context_replay(NVGcontext* nvg, NVGJSPath* path) {
+  nvgBeginPath(nvg);
+  nvgjs_command_execute(nvg, path->cmds, path->len, NULL);
 }
 
-NVGJS_DECL(Context, UpdateImage) {
+/* (x, y [, path]), magic 1 tests the stroke */
+NVGJS_DECL(Context, IsPointInFill) {
   NVGJS_CONTEXT(this_obj);
 
-  int32_t image;
-  size_t len;
-  uint8_t* ptr;
+  NVGJSPath* path = 0;
+  float pt[2];
 
   if(argc < 2)
     return JS_ThrowInternalError(ctx, "need 2 arguments");
 
-  if(JS_ToInt32(ctx, &image, argv[0]))
+  if(nvgjs_tofloat32(ctx, &pt[0], argv[0]) || nvgjs_tofloat32(ctx, &pt[1], argv[1]))
     return JS_EXCEPTION;
 
-  if(!(ptr = JS_GetArrayBuffer(ctx, &len, argv[1])))
+  if(argc > 2 && !JS_IsUndefined(argv[2]) && !(path = JS_GetOpaque2(ctx, argv[2], nvgjs_path_class_id)))
     return JS_EXCEPTION;
 
-  nvgUpdateImage(nvg, image, (void*)ptr);
+  NVGJS_PROFILE_MARK();
 
-  return JS_UNDEFINED;
+  if(path)
+    nvgjs_context_replay(nvg, path);
+
+  return JS_NewBool(ctx, nvgjs_nvg_hit_test(nvg, magic, pt, 1, NULL));
 }
 
-NVGJS_DECL(Context, ImageSize) {
+/* (points [, out [, path]]), magic 1 tests the stroke */
+NVGJS_DECL(Context, PointsInFill) {
   NVGJS_CONTEXT(this_obj);
 
-  int32_t id = 0;
-  int width, height;
+  NVGJSPath* path = 0;
+  const float* pts;
+  float* copy;
+  uint8_t* out = 0;
+  int length;
+  size_t len, inside;
 
   if(argc < 1)
     return JS_ThrowInternalError(ctx, "need 1 arguments");
 
-  if(JS_ToInt32(ctx, &id, argv[0]))
+  if(!(pts = nvgjs_inputfloats(ctx, &length, argv[0], &copy)))
     return JS_EXCEPTION;
 
-  nvgImageSize(nvg, id, &width, &height);
+  if(length & 1) {
+    JS_ThrowRangeError(ctx, "points has an odd number of floats (%d)", length);
+    goto fail;
+  }
 
-  JSValue ret = JS_NewArray(ctx);
-  JS_SetPropertyUint32(ctx, ret, 0, JS_NewInt32(ctx, width));
-  JS_SetPropertyUint32(ctx, ret, 1, JS_NewInt32(ctx, height));
-  return ret;
+  if(argc > 1 && !JS_IsUndefined(argv[1]) && !JS_IsNull(argv[1])) {
+    if(!(out = nvgjs_bytes(ctx, &len, argv[1])))
+      goto fail;
+
+    if(len < (size_t)length / 2) {
+      JS_ThrowRangeError(ctx, "out has %zu bytes, need %d", len, length / 2);
+      goto fail;
+    }
+  }
+
+  if(argc > 2 && !JS_IsUndefined(argv[2]) && !(path = JS_GetOpaque2(ctx, argv[2], nvgjs_path_class_id)))
+    goto fail;
+
+  NVGJS_PROFILE_MARK();
+
+  if(path)
+    nvgjs_context_replay(nvg, path);
+
+  inside = nvgjs_nvg_hit_test(nvg, magic, pts, length / 2, out);
+  js_free(ctx, copy);
+  return JS_NewInt64(ctx, inside);
+
+fail:
+  js_free(ctx, copy);
+  return JS_EXCEPTION;
 }
 
-NVGJS_DECL(Context, DeleteImage) {
+NVGJS_DECL(Context, SetTessellationCache) {
   NVGJS_CONTEXT(this_obj);
 
-  int32_t id = 0;
+  int64_t max_bytes;
 
   if(argc < 1)
     return JS_ThrowInternalError(ctx, "need 1 arguments");
 
-  if(JS_ToInt32(ctx, &id, argv[0]))
+  if(JS_ToInt64(ctx, &max_bytes, argv[0]))
     return JS_EXCEPTION;
 
-  nvgDeleteImage(nvg, id);
+  if(max_bytes < 0)
+    return JS_ThrowRangeError(ctx, "maxBytes must not be negative");
+
+  if(nvgjs_tesscache_set(nvg, max_bytes))
+    return JS_ThrowOutOfMemory(ctx);
 
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, ResetTransform) {
+/* (tess, dist [, lod]) in device pixels, no arguments for the defaults */
+NVGJS_DECL(Context, SetTessellationTolerance) {
   NVGJS_CONTEXT(this_obj);
 
-  nvgResetTransform(nvg);
+  double tess = 0, dist = 0;
+  int lod = 0;
 
-  return JS_UNDEFINED;
-}
+  if(argc > 0 && !JS_IsUndefined(argv[0])) {
+    if(argc < 2)
+      return JS_ThrowInternalError(ctx, "need 2 arguments");
 
-NVGJS_DECL(Context, Transform) {
-  NVGJS_CONTEXT(this_obj);
+    if(JS_ToFloat64(ctx, &tess, argv[0]) || JS_ToFloat64(ctx, &dist, argv[1]))
+      return JS_EXCEPTION;
 
-  float t[6];
+    if(!(tess > 0) || !(dist >= 0) || !isfinite(tess) || !isfinite(dist))
+      return JS_ThrowRangeError(ctx, "tolerances must be finite, tess > 0 and dist >= 0");
 
-  if(argc < 1)
-    return JS_ThrowInternalError(ctx, "need 1/6 arguments");
+    if(argc > 2 && (lod = JS_ToBool(ctx, argv[2])) < 0)
+      return JS_EXCEPTION;
+  }
 
-  if(nvgjs_arguments(ctx, t, 6, argc, argv))
-    nvgTransform(nvg, t[0], t[1], t[2], t[3], t[4], t[5]);
+  if(nvgjs_nvg_set_tolerance(nvg, tess, dist, lod))
+    return JS_ThrowOutOfMemory(ctx);
 
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, Translate) {
+/* { hits, misses, entries, bytes, maxBytes }, or null without a cache */
+NVGJS_DECL(Context, TessellationCacheStats) {
   NVGJS_CONTEXT(this_obj);
 
-  double x, y;
+  NVGJSTessCacheStats tcs;
+  JSValue ret;
 
-  if(argc < 2)
-    return JS_ThrowInternalError(ctx, "need 2 arguments");
+  if(nvgjs_tesscache_stats(nvg, &tcs))
+    return JS_NULL;
 
-  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]))
-    return JS_EXCEPTION;
+  ret = JS_NewObject(ctx);
 
-  nvgTranslate(nvg, x, y);
+  if(JS_IsException(ret))
+    return ret;
 
-  return JS_UNDEFINED;
+  JS_SetPropertyStr(ctx, ret, "hits", JS_NewFloat64(ctx, tcs.hits));
+  JS_SetPropertyStr(ctx, ret, "misses", JS_NewFloat64(ctx, tcs.misses));
+  JS_SetPropertyStr(ctx, ret, "entries", JS_NewFloat64(ctx, tcs.entries));
+  JS_SetPropertyStr(ctx, ret, "bytes", JS_NewFloat64(ctx, tcs.bytes));
+  JS_SetPropertyStr(ctx, ret, "maxBytes", JS_NewFloat64(ctx, tcs.max_bytes));
+  return ret;
 }
 
-NVGJS_DECL(Context, Rotate) {
+NVGJS_DECL(Context, Polyline) {
   NVGJS_CONTEXT(this_obj);
 
-  double angle;
+  float* pts;
+  size_t count;
+  BOOL closed = magic;
 
   if(argc < 1)
     return JS_ThrowInternalError(ctx, "need 1 arguments");
 
-  if(JS_ToFloat64(ctx, &angle, argv[0]))
+  if(!(pts = nvgjs_items(ctx, &count, 2, argc, argv)))
     return JS_EXCEPTION;
 
-  nvgRotate(nvg, angle);
+  if(!magic && argc > 3)
+    closed = JS_ToBool(ctx, argv[3]);
 
+  NVGJS_PROFILE_MARK();
+  nvgjs_batch_polyline(nvg, pts, count, closed);
   return JS_UNDEFINED;
 }
 
-NVGJS_DECL(Context, SkewX) {
+/* Column width argument: positive, 1 if undefined */
+static int
+nvgjs_column_width(JSContext* ctx, float* column, int argc, JSValueConst argv[], int i) {
+  double w = 1;
+
+  if(argc > i && !JS_IsUndefined(argv[i]) && JS_ToFloat64(ctx, &w, argv[i]))
+    return -1;
+
+  if(!(w > 0) || !isfinite(w)) {
+    JS_ThrowRangeError(ctx, "pixelWidth must be positive");
+    return -1;
+  }
+
+  *column = w;
+  return 0;
+}
+
+NVGJS_DECL(Context, PolylineDecimated) {
   NVGJS_CONTEXT(this_obj);
 
-  double angle;
+  float *ys, column;
+  double x0, dx;
+  int length;
+  int64_t count;
 
-  if(argc < 1)
-    return JS_ThrowInternalError(ctx, "need 1 arguments");
+  if(argc < 3)
+    return JS_ThrowInternalError(ctx, "need 3 arguments");
 
-  if(JS_ToFloat64(ctx, &angle, argv[0]))
+  if(!(ys = nvgjs_outputarray(ctx, &length, argv[0])))
     return JS_EXCEPTION;
 
-  nvgSkewX(nvg, angle);
+  if(JS_ToFloat64(ctx, &x0, argv[1]) || JS_ToFloat64(ctx, &dx, argv[2]))
+    return JS_EXCEPTION;
 
-  return JS_UNDEFINED;
+  count = length;
+
+  if(argc > 3 && !JS_IsUndefined(argv[3]) && JS_ToInt64(ctx, &count, argv[3]))
+    return JS_EXCEPTION;
+
+  if(count < 0 || count > length)
+    return JS_ThrowRangeError(ctx, "count %" PRId64 " out of range (%d items)", count, length);
+
+  if(nvgjs_column_width(ctx, &column, argc, argv, 4))
+    return JS_EXCEPTION;
+
+  NVGJS_PROFILE_MARK();
+  return JS_NewInt64(ctx, nvgjs_batch_polyline_decimated(nvg, ys, count, x0, dx, column));
 }
 
-NVGJS_DECL(Context, SkewY) {
+NVGJS_DECL(Context, PolylineDecimatedXY) {
   NVGJS_CONTEXT(this_obj);
 
-  double angle;
+  float *pts, column;
+  size_t count;
 
   if(argc < 1)
     return JS_ThrowInternalError(ctx, "need 1 arguments");
 
-  if(JS_ToFloat64(ctx, &angle, argv[0]))
+  if(!(pts = nvgjs_items(ctx, &count, 2, argc, argv)))
     return JS_EXCEPTION;
 
-  nvgSkewY(nvg, angle);
+  if(nvgjs_column_width(ctx, &column, argc, argv, 3))
+    return JS_EXCEPTION;
 
-  return JS_UNDEFINED;
+  NVGJS_PROFILE_MARK();
+  return JS_NewInt64(ctx, nvgjs_batch_polyline_decimated_xy(nvg, pts, count, column));
 }
 
-NVGJS_DECL(Context, Scale) {
+NVGJS_DECL(Context, Candles) {
+  static NVGJSHint hints[2];
   NVGJS_CONTEXT(this_obj);
 
-  double x, y;
+  float* ohlc;
+  double x0, dx, y_scale, y_offset, body_width;
+  NVGcolor bull, bear;
+  int length;
+  int64_t count;
 
-  if(argc < 2)
-    return JS_ThrowInternalError(ctx, "need 2 arguments");
+  if(argc < 9)
+    return JS_ThrowInternalError(ctx, "need 9 arguments");
 
-  if(JS_ToFloat64(ctx, &x, argv[0]) || JS_ToFloat64(ctx, &y, argv[1]))
+  if(!(ohlc = nvgjs_outputarray(ctx, &length, argv[0])))
     return JS_EXCEPTION;
 
-  nvgScale(nvg, x, y);
+  count = length / 4;
 
-  return JS_UNDEFINED;
-}
+  if(!JS_IsUndefined(argv[1]) && JS_ToInt64(ctx, &count, argv[1]))
+    return JS_EXCEPTION;
 
-NVGJS_DECL(Context, CurrentTransform) {
-  NVGJS_CONTEXT(this_obj);
+  if(count < 0 || count > length / 4)
+    return JS_ThrowRangeError(ctx, "count %" PRId64 " out of range (%d items)", count, length / 4);
 
-  float t[6];
+  if(JS_ToFloat64(ctx, &x0, argv[2]) || JS_ToFloat64(ctx, &dx, argv[3]) || JS_ToFloat64(ctx, &y_scale, argv[4]) ||
+     JS_ToFloat64(ctx, &y_offset, argv[5]))
+    return JS_EXCEPTION;
 
-  nvgCurrentTransform(nvg, t);
+  if(nvgjs_tocolor(ctx, &bull, argv[6], &hints[0]) || nvgjs_tocolor(ctx, &bear, argv[7], &hints[1]))
+    return JS_EXCEPTION;
 
-  if(argc == 0)
-    return nvgjs_transform_new(ctx, t);
+  if(JS_ToFloat64(ctx, &body_width, argv[8]))
+    return JS_EXCEPTION;
 
-  return nvgjs_transform_copy(ctx, argv[0], t);
-  ;
+  NVGJS_PROFILE_MARK();
+  count = nvgjs_batch_candles(nvg, ohlc, count, x0, dx, y_scale, y_offset, body_width, bull.rgba, bear.rgba);
+
+  return JS_NewInt64(ctx, count);
 }
 
-NVGJS_DECL(Context, ImagePattern) {
+static JSValue
+nvgjs_context_shapes(JSContext* ctx, JSValueConst this_obj, int argc, JSValueConst argv[], int magic) {
   NVGJS_CONTEXT(this_obj);
 
-  double ox, oy, ex, ey;
-  double angle, alpha;
-  int32_t image;
-  NVGpaint paint, *p;
+  const int stride = nvgjs_batch_stride[magic];
+  float *data, *colors;
+  int length, ncolors;
+  size_t count;
+  void* scratch;
 
-  if(argc < 7)
-    return JS_ThrowInternalError(ctx, "need 7 arguments");
+  if(argc < 1)
+    return JS_ThrowInternalError(ctx, "need 1 arguments");
 
-  if(JS_ToFloat64(ctx, &ox, argv[0]) || JS_ToFloat64(ctx, &oy, argv[1]) || JS_ToFloat64(ctx, &ex, argv[2]) ||
-     JS_ToFloat64(ctx, &ey, argv[3]) || JS_ToFloat64(ctx, &angle, argv[4]) || JS_ToInt32(ctx, &image, argv[5]) ||
-     JS_ToFloat64(ctx, &alpha, argv[6]))
+  if(!(data = nvgjs_outputarray(ctx, &length, argv[0])))
     return JS_EXCEPTION;
 
-  return nvgjs_paint_new(ctx, nvgImagePattern(nvg, ox, oy, ex, ey, angle, image, alpha));
-}
+  count = length / stride;
 
-/*NVGJS_DECL(Context, SetNextFillHoverable)
-{
-    nvgSetNextFillHoverable(nvg);
-    return JS_UNDEFINED;
-}
+  if(argc < 2 || JS_IsUndefined(argv[1]) || JS_IsNull(argv[1])) {
+    NVGJS_PROFILE_MARK();
+    nvgjs_batch_shapes(nvg, magic, data, count);
+    return JS_NewUint32(ctx, count);
+  }
 
-NVGJS_DECL(Context, IsFillHovered)
-{
-    int ret = nvgIsFillHovered(nvg);
-    return JS_NewBool(ctx, ret);
-}
+  if(!(colors = nvgjs_outputarray(ctx, &ncolors, argv[1])))
+    return JS_EXCEPTION;
+
+  if((size_t)ncolors < count * 4)
+    return JS_ThrowRangeError(ctx, "colors must have 4 floats per item (need %zu, has %d)", count * 4, ncolors);
+
+  if(!(scratch = js_malloc(ctx, nvgjs_batch_scratch_size(count))))
+    return JS_EXCEPTION;
 
-NVGJS_DECL(Context, IsNextFillClicked)
-{
-    int ret = nvgIsNextFillClicked(nvg);
-    return JS_NewBool(ctx, ret);
+  NVGJS_PROFILE_MARK();
+  count = nvgjs_batch_shapes_colored(nvg, magic, data, colors, count, scratch);
+
+  js_free(ctx, scratch);
+  return JS_NewUint32(ctx, count);
 }
-*/
 
 static const JSCFunctionListEntry nvgjs_funcs[] = {
 #ifdef NANOVG_GL2
@@ -2049,10 +4266,17 @@ static const JSCFunctionListEntry nvgjs_funcs[] = {
 #ifdef NANOVG_GL3
  NVGJS_FUNC(CreateGL3, 1),
  NVGJS_FUNC(DeleteGL3, 1),
+ NVGJS_FUNC(CreateHeadless, 2),
+ NVGJS_FUNC(DeleteHeadless, 1),
  NVGJS_FUNC(CreateImageFromHandleGL3, 5),
  NVGJS_FUNC(ImageHandleGL3, 2),
 #endif
 
+ NVGJS_FUNC(CreateSoftware, 2),
+ NVGJS_FUNC(DeleteSoftware, 1),
+ NVGJS_FUNC(CreateSVG, 2),
+ NVGJS_FUNC(DeleteSVG, 1),
+
  NVGJS_FLAG(STENCIL_STROKES),
  NVGJS_FLAG(ANTIALIAS),
  NVGJS_FLAG(DEBUG),
@@ -2064,6 +4288,15 @@ static const JSCFunctionListEntry nvgjs_funcs[] = {
  NVGJS_FUNC(DeleteFramebuffer, 1),
 
  NVGJS_FUNC(ReadPixels, 2),
+ NVGJS_FUNC(ReadPixelsAsync, 4),
+ NVGJS_FUNC(EncodeImage, 3),
+ NVGJS_FUNC(SaveImage, 4),
+ NVGJS_FUNC(Poll, 0),
+ NVGJS_FUNC(TraceStart, 0),
+ NVGJS_FUNC(TraceStop, 0),
+ NVGJS_FUNC(ProfileStart, 0),
+ NVGJS_FUNC(ProfileStop, 0),
+ NVGJS_FUNC(ProfileResults, 0),
 
  NVGJS_FUNC(RadToDeg, 1),
  NVGJS_FUNC(DegToRad, 1),
@@ -2126,6 +4359,65 @@ static const JSCFunctionListEntry nvgjs_funcs[] = {
  NVGJS_FLAG(IMAGE_NEAREST),
  NVGJS_FLAG(TEXTURE_ALPHA),
  NVGJS_FLAG(TEXTURE_RGBA),
+ NVGJS_STAT(CALLS),
+ NVGJS_STAT(PATHS),
+ NVGJS_STAT(FILLS),
+ NVGJS_STAT(STROKES),
+ NVGJS_STAT(TRIANGLES),
+ NVGJS_STAT(VERTICES),
+ NVGJS_STAT(DRAWS),
+ NVGJS_STAT(TEXTURE_UPLOADS),
+ NVGJS_STAT(TEXTURE_BYTES),
+ NVGJS_STAT(FONT_UPDATES),
+ NVGJS_STAT(FRAME_MS),
+ NVGJS_STAT(FLUSH_MS),
+
+ NVGJS_OPCODE(NOP),
+ NVGJS_OPCODE(SAVE),
+ NVGJS_OPCODE(RESTORE),
+ NVGJS_OPCODE(RESET),
+ NVGJS_OPCODE(SHAPE_ANTIALIAS),
+ NVGJS_OPCODE(BEGIN_PATH),
+ NVGJS_OPCODE(MOVE_TO),
+ NVGJS_OPCODE(LINE_TO),
+ NVGJS_OPCODE(BEZIER_TO),
+ NVGJS_OPCODE(QUAD_TO),
+ NVGJS_OPCODE(ARC_TO),
+ NVGJS_OPCODE(ARC),
+ NVGJS_OPCODE(RECT),
+ NVGJS_OPCODE(ROUNDED_RECT),
+ NVGJS_OPCODE(ROUNDED_RECT_VARYING),
+ NVGJS_OPCODE(ELLIPSE),
+ NVGJS_OPCODE(CIRCLE),
+ NVGJS_OPCODE(CLOSE_PATH),
+ NVGJS_OPCODE(PATH_WINDING),
+ NVGJS_OPCODE(FILL),
+ NVGJS_OPCODE(STROKE),
+ NVGJS_OPCODE(FILL_COLOR),
+ NVGJS_OPCODE(STROKE_COLOR),
+ NVGJS_OPCODE(STROKE_WIDTH),
+ NVGJS_OPCODE(MITER_LIMIT),
+ NVGJS_OPCODE(LINE_CAP),
+ NVGJS_OPCODE(LINE_JOIN),
+ NVGJS_OPCODE(GLOBAL_ALPHA),
+ NVGJS_OPCODE(FILL_LINEAR_GRADIENT),
+ NVGJS_OPCODE(STROKE_LINEAR_GRADIENT),
+ NVGJS_OPCODE(FILL_BOX_GRADIENT),
+ NVGJS_OPCODE(STROKE_BOX_GRADIENT),
+ NVGJS_OPCODE(FILL_RADIAL_GRADIENT),
+ NVGJS_OPCODE(STROKE_RADIAL_GRADIENT),
+ NVGJS_OPCODE(FILL_IMAGE_PATTERN),
+ NVGJS_OPCODE(STROKE_IMAGE_PATTERN),
+ NVGJS_OPCODE(RESET_TRANSFORM),
+ NVGJS_OPCODE(TRANSFORM),
+ NVGJS_OPCODE(TRANSLATE),
+ NVGJS_OPCODE(ROTATE),
+ NVGJS_OPCODE(SKEW_X),
+ NVGJS_OPCODE(SKEW_Y),
+ NVGJS_OPCODE(SCALE),
+ NVGJS_OPCODE(SCISSOR),
+ NVGJS_OPCODE(INTERSECT_SCISSOR),
+ NVGJS_OPCODE(RESET_SCISSOR),
 };
 
 static const JSCFunctionListEntry nvgjs_context_methods[] = {
@@ -2135,6 +4427,7 @@ static const JSCFunctionListEntry nvgjs_context_methods[] = {
  NVGJS_METHOD(Context, BeginFrame, 3),
  NVGJS_METHOD(Context, CancelFrame, 0),
  NVGJS_METHOD(Context, EndFrame, 0),
+ NVGJS_METHOD(Context, DumpTrace, 1),
  NVGJS_METHOD(Context, Save, 0),
  NVGJS_METHOD(Context, Restore, 0),
  NVGJS_METHOD(Context, Reset, 0),
@@ -2198,12 +4491,158 @@ static const JSCFunctionListEntry nvgjs_context_methods[] = {
  NVGJS_METHOD(Context, PathWinding, 1),
  NVGJS_METHOD(Context, Stroke, 0),
  NVGJS_METHOD(Context, Fill, 0),
- /*NVGJS_FUNC(SetNextFillHoverable, 0),
- NVGJS_FUNC(IsFillHovered, 0),
- NVGJS_FUNC(IsNextFillClicked, 0),*/
+ NVGJS_METHOD(Context, Execute, 1),
+ NVGJS_METHOD(Context, AppendPath, 1),
+ NVGJS_METHOD(Context, FillPath, 1),
+ NVGJS_METHOD(Context, StrokePath, 1),
+ NVGJS_METHOD(Context, IsPointInFill, 2),
+ JS_CFUNC_MAGIC_DEF("IsPointInStroke", 2, nvgjs_Context_IsPointInFill, 1),
+ NVGJS_METHOD(Context, PointsInFill, 1),
+ JS_CFUNC_MAGIC_DEF("PointsInStroke", 1, nvgjs_Context_PointsInFill, 1),
+ NVGJS_METHOD(Context, SetTessellationCache, 1),
+ NVGJS_METHOD(Context, TessellationCacheStats, 0),
+ NVGJS_METHOD(Context, SetTessellationTolerance, 3),
+ NVGJS_METHOD(Context, Polyline, 4),
+ JS_CFUNC_MAGIC_DEF("Polygon", 3, nvgjs_Context_Polyline, 1),
+ NVGJS_METHOD(Context, PolylineDecimated, 5),
+ NVGJS_METHOD(Context, PolylineDecimatedXY, 4),
+ NVGJS_METHOD(Context, Candles, 9),
+ JS_CFUNC_MAGIC_DEF("Rects", 1, nvgjs_context_shapes, NVGJS_BATCH_RECT),
+ JS_CFUNC_MAGIC_DEF("Circles", 1, nvgjs_context_shapes, NVGJS_BATCH_CIRCLE),
+ JS_CFUNC_MAGIC_DEF("Ellipses", 1, nvgjs_context_shapes, NVGJS_BATCH_ELLIPSE),
+ JS_CFUNC_MAGIC_DEF("RoundedRects", 1, nvgjs_context_shapes, NVGJS_BATCH_ROUNDED_RECT),
  JS_PROP_STRING_DEF("[Symbol.toStringTag]", "NVGcontext", JS_PROP_CONFIGURABLE),
 };
 
+/* Wrapper of a Context method while tracing or profiling, func_data[0] is
+   the method and magic its index in nvgjs_context_methods */
+static JSValue
+nvgjs_method_wrapper(JSContext* ctx, JSValueConst this_obj, int argc, JSValueConst argv[], int magic, JSValue* data) {
+  NVGJSState* st = nvgjs_state(ctx);
+  NVGJSProfileEntry* pe = st->profile_methods ? &st->profile[magic] : 0;
+  /* the wrappers may be installed for profiling alone, or with sample: 0 */
+  BOOL trace = st->trace_methods && nvgjs_trace_sample();
+  int64_t t0, t1, mark = 0, *outer;
+  JSValue ret;
+
+  if(!pe && !trace)
+    return JS_Call(ctx, data[0], this_obj, argc, argv);
+
+  outer = nvgjs_profile_slot;
+  nvgjs_profile_slot = &mark;
+  t0 = nvgjs_trace_now();
+  ret = JS_Call(ctx, data[0], this_obj, argc, argv);
+  t1 = nvgjs_trace_now();
+  nvgjs_profile_slot = outer;
+
+  if(trace)
+    nvgjs_trace_complete(nvgjs_context_methods[magic].name, "call", t0, -1);
+
+  if(pe) {
+    pe->calls++;
+    pe->exceptions += JS_IsException(ret);
+    pe->total_ns += t1 - t0;
+
+    /* without a mark the method threw before reaching NanoVG, or has no
+       NanoVG call */
+    if(mark) {
+      pe->convert_ns += mark - t0;
+      pe->nanovg_ns += t1 - mark;
+    } else {
+      pe->convert_ns += t1 - t0;
+    }
+  }
+
+  return ret;
+}
+
+/* Put the wrappers on the Context prototype while tracing or profiling and
+   restore the methods afterwards, so that calls cost nothing extra otherwise */
+static void
+nvgjs_wrap_methods(JSContext* ctx) {
+  NVGJSState* st = nvgjs_state(ctx);
+  BOOL enable = st->trace_methods || st->profile_methods;
+  JSValue proto;
+
+  if(st->wrapped_methods == enable)
+    return;
+
+  proto = JS_GetClassProto(ctx, nvgjs_context_class_id);
+
+  if(enable) {
+    for(size_t i = 0; i < countof(nvgjs_context_methods); i++) {
+      const JSCFunctionListEntry* e = &nvgjs_context_methods[i];
+      JSValue method, wrapper;
+
+      if(e->def_type != JS_DEF_CFUNC)
+        continue;
+
+      method = JS_GetPropertyStr(ctx, proto, e->name);
+      wrapper = JS_NewCFunctionData(ctx, nvgjs_method_wrapper, e->u.func.length, i, 1, &method);
+      JS_FreeValue(ctx, method);
+      JS_DefinePropertyValueStr(ctx, proto, e->name, wrapper, e->prop_flags);
+    }
+  } else {
+    JS_SetPropertyFunctionList(ctx, proto, nvgjs_context_methods, countof(nvgjs_context_methods));
+  }
+
+  JS_FreeValue(ctx, proto);
+  st->wrapped_methods = enable;
+}
+
+NVGJS_DECL(func, ProfileStart) {
+  NVGJSState* st = nvgjs_state(ctx);
+
+  if(!st->profile && !(st->profile = js_malloc(ctx, sizeof(NVGJSProfileEntry) * countof(nvgjs_context_methods))))
+    return JS_EXCEPTION;
+
+  memset(st->profile, 0, sizeof(NVGJSProfileEntry) * countof(nvgjs_context_methods));
+  st->profile_methods = TRUE;
+  nvgjs_wrap_methods(ctx);
+  return JS_UNDEFINED;
+}
+
+NVGJS_DECL(func, ProfileStop) {
+  NVGJSState* st = nvgjs_state(ctx);
+
+  st->profile_methods = FALSE;
+  nvgjs_wrap_methods(ctx);
+  return JS_UNDEFINED;
+}
+
+/* { method: { calls, exceptions, totalMs, convertMs, nanovgMs, nsPerCall } }
+   with the keys in order of total time */
+NVGJS_DECL(func, ProfileResults) {
+  NVGJSState* st = nvgjs_state(ctx);
+  int order[countof(nvgjs_context_methods)], n;
+  JSValue ret = JS_NewObject(ctx);
+
+  if(JS_IsException(ret) || !st->profile)
+    return ret;
+
+  n = nvgjs_profile_order(st->profile, countof(nvgjs_context_methods), order);
+
+  for(int i = 0; i < n; i++) {
+    const NVGJSProfileEntry* pe = &st->profile[order[i]];
+    JSValue entry = JS_NewObject(ctx);
+
+    if(JS_IsException(entry)) {
+      JS_FreeValue(ctx, ret);
+      return JS_EXCEPTION;
+    }
+
+    JS_SetPropertyStr(ctx, entry, "calls", JS_NewFloat64(ctx, pe->calls));
+    JS_SetPropertyStr(ctx, entry, "exceptions", JS_NewFloat64(ctx, pe->exceptions));
+    JS_SetPropertyStr(ctx, entry, "totalMs", JS_NewFloat64(ctx, pe->total_ns / 1e6));
+    JS_SetPropertyStr(ctx, entry, "convertMs", JS_NewFloat64(ctx, pe->convert_ns / 1e6));
+    JS_SetPropertyStr(ctx, entry, "nanovgMs", JS_NewFloat64(ctx, pe->nanovg_ns / 1e6));
+    JS_SetPropertyStr(ctx, entry, "nsPerCall", JS_NewFloat64(ctx, (double)pe->total_ns / pe->calls));
+    JS_SetPropertyStr(ctx, ret, nvgjs_context_methods[order[i]].name, entry);
+  }
+
+  return ret;
+}
+
 enum {
   FRAMEBUFFER_FBO,
   FRAMEBUFFER_RBO,
@@ -2228,8 +4667,8 @@ nvgjs_framebuffer_get(JSContext* ctx, JSValueConst this_val, int magic) {
 }
 
 static JSValue
-nvgjs_framebuffer_wrap(JSContext* ctx, JSValueConst proto, NVGLUframebuffer* fb) {
-  JSValue obj = JS_NewObjectProtoClass(ctx, proto, nvgjs_framebuffer_class_id);
+nvgjs_framebuffer_wrap(JSContext* ctx, NVGLUframebuffer* fb) {
+  JSValue obj = JS_NewObjectClass(ctx, nvgjs_framebuffer_class_id);
 
   if(!JS_IsException(obj))
     JS_SetOpaque(obj, fb);
@@ -2261,56 +4700,122 @@ static JSClassDef nvgjs_framebuffer_class = {
  .finalizer = nvgjs_framebuffer_finalizer,
 };
 
+/* proto[Symbol.iterator] = Array.prototype.values, which iterates any
+ * array-like through its length and indexed properties */
+static void
+nvgjs_iterable(JSContext* ctx, JSValueConst global, JSValueConst proto) {
+  JSValue symbol = JS_GetPropertyStr(ctx, global, "Symbol");
+  JSValue iterator = JS_GetPropertyStr(ctx, symbol, "iterator");
+  JSValue array = JS_GetPropertyStr(ctx, global, "Array");
+  JSValue array_proto = JS_GetPropertyStr(ctx, array, "prototype");
+  JSValue values = JS_GetPropertyStr(ctx, array_proto, "values");
+  JSAtom atom = JS_ValueToAtom(ctx, iterator);
+
+  JS_DefinePropertyValue(ctx, proto, atom, values, JS_PROP_CONFIGURABLE | JS_PROP_WRITABLE);
+
+  JS_FreeAtom(ctx, atom);
+  JS_FreeValue(ctx, array_proto);
+  JS_FreeValue(ctx, array);
+  JS_FreeValue(ctx, iterator);
+  JS_FreeValue(ctx, symbol);
+}
+
 static int
 nvgjs_init(JSContext* ctx, JSModuleDef* m) {
-  JSValue paint_proto, paint_class;
-
-  JSValue global = JS_GetGlobalObject(ctx);
-  js_float32array_ctor = JS_GetPropertyStr(ctx, global, "Float32Array");
-  js_float32array_proto = JS_GetPropertyStr(ctx, js_float32array_ctor, "prototype");
-  JS_FreeValue(ctx, global);
-
-  JS_NewClassID(&nvgjs_context_class_id);
-  JS_NewClass(JS_GetRuntime(ctx), nvgjs_context_class_id, &nvgjs_context_class);
-
-  context_proto = JS_NewObjectProto(ctx, JS_NULL);
-  JS_SetPropertyFunctionList(ctx, context_proto, nvgjs_context_methods, countof(nvgjs_context_methods));
-  context_ctor = JS_NewObjectProto(ctx, JS_NULL);
-  JS_SetConstructor(ctx, context_ctor, context_proto);
-  JS_SetModuleExport(ctx, m, "Context", context_ctor);
-
-  color_proto = JS_NewObjectProto(ctx, js_float32array_proto);
-  JS_SetPropertyFunctionList(ctx, color_proto, nvgjs_color_methods, countof(nvgjs_color_methods));
-  color_ctor = JS_NewObjectProto(ctx, JS_NULL);
-  JS_SetConstructor(ctx, color_ctor, color_proto);
-  JS_SetModuleExport(ctx, m, "Color", color_ctor);
+  JSValue proto, ctor, global;
+  NVGJSState* st;
+
+  /* everything per-runtime or per-context is kept in st, see nvgjs-state.h */
+  if(!(st = nvgjs_state_new(ctx)))
+    return -1;
+
+  st->finalize = nvgjs_state_finalize;
+  global = JS_GetGlobalObject(ctx);
+
+  nvgjs_utils_init(ctx, st);
+
+  nvgjs_atoms(ctx, st->color_keys, nvgjs_color_names, countof(st->color_keys));
+  nvgjs_atoms(ctx, st->transform_keys, nvgjs_transform_names, countof(st->transform_keys));
+  nvgjs_atoms(ctx, st->vector_keys, nvgjs_vector_names, countof(st->vector_keys));
+  nvgjs_atoms(ctx, st->bounds_keys, nvgjs_bounds_names, countof(st->bounds_keys));
+  nvgjs_atoms(ctx, st->size_keys, nvgjs_size_names, countof(st->size_keys));
+
+  nvgjs_state_register(ctx, &nvgjs_context_class_id, &nvgjs_context_class);
+
+  proto = JS_NewObjectProto(ctx, JS_NULL);
+  JS_SetPropertyFunctionList(ctx, proto, nvgjs_context_methods, countof(nvgjs_context_methods));
+  JS_SetClassProto(ctx, nvgjs_context_class_id, proto);
+  ctor = JS_NewObjectProto(ctx, JS_NULL);
+  JS_SetConstructor(ctx, ctor, proto);
+  JS_SetModuleExport(ctx, m, "Context", ctor);
+
+  nvgjs_state_register(ctx, &nvgjs_color_class_id, &nvgjs_color_class);
+
+  proto = JS_NewObject(ctx);
+  JS_SetPropertyFunctionList(ctx, proto, nvgjs_color_methods, countof(nvgjs_color_methods));
+  nvgjs_iterable(ctx, global, proto);
+  JS_SetClassProto(ctx, nvgjs_color_class_id, proto);
+  ctor = JS_NewCFunction2(ctx, nvgjs_color_constructor, "Color", 4, JS_CFUNC_constructor, 0);
+  JS_SetConstructor(ctx, ctor, proto);
+  JS_SetModuleExport(ctx, m, "Color", ctor);
+
+  nvgjs_state_register(ctx, &nvgjs_transform_class_id, &nvgjs_transform_class);
+
+  proto = JS_NewObject(ctx);
+  JS_SetPropertyFunctionList(ctx, proto, nvgjs_transform_methods, countof(nvgjs_transform_methods));
+  nvgjs_iterable(ctx, global, proto);
+  JS_SetClassProto(ctx, nvgjs_transform_class_id, proto);
+  ctor = JS_NewCFunction2(ctx, nvgjs_transform_constructor, "Transform", 6, JS_CFUNC_constructor, 0);
+  JS_SetPropertyFunctionList(ctx, ctor, nvgjs_transform_functions, countof(nvgjs_transform_functions));
+  JS_SetConstructor(ctx, ctor, proto);
+  st->transform_ctor = JS_DupValue(ctx, ctor);
+  JS_SetModuleExport(ctx, m, "Transform", ctor);
+
+  nvgjs_state_register(ctx, &nvgjs_paint_class_id, &nvgjs_paint_class);
+
+  proto = JS_NewObject(ctx);
+  JS_SetPropertyFunctionList(ctx, proto, nvgjs_paint_methods, countof(nvgjs_paint_methods));
+  JS_SetClassProto(ctx, nvgjs_paint_class_id, proto);
+  ctor = JS_NewObjectProto(ctx, JS_NULL);
+  // JS_SetConstructor(ctx, ctor, proto);
+  JS_SetModuleExport(ctx, m, "Paint", ctor);
+
+  nvgjs_state_register(ctx, &nvgjs_path_class_id, &nvgjs_path_class);
+
+  proto = JS_NewObject(ctx);
+  JS_SetPropertyFunctionList(ctx, proto, nvgjs_path_methods, countof(nvgjs_path_methods));
+  JS_SetClassProto(ctx, nvgjs_path_class_id, proto);
+  ctor = JS_NewCFunction2(ctx, nvgjs_path_constructor, "Path", 1, JS_CFUNC_constructor, 0);
+  JS_SetConstructor(ctx, ctor, proto);
+  JS_SetModuleExport(ctx, m, "Path", ctor);
+
+  nvgjs_state_register(ctx, &nvgjs_spatial_class_id, &nvgjs_spatial_class);
+
+  proto = JS_NewObject(ctx);
+  JS_SetPropertyFunctionList(ctx, proto, nvgjs_spatial_methods, countof(nvgjs_spatial_methods));
+  JS_SetClassProto(ctx, nvgjs_spatial_class_id, proto);
+  ctor = JS_NewCFunction2(ctx, nvgjs_spatial_constructor, "SpatialIndex", 1, JS_CFUNC_constructor, 0);
+  JS_SetConstructor(ctx, ctor, proto);
+  JS_SetModuleExport(ctx, m, "SpatialIndex", ctor);
+
+  nvgjs_state_register(ctx, &nvgjs_framebuffer_class_id, &nvgjs_framebuffer_class);
+
+  proto = JS_NewObjectProto(ctx, JS_NULL);
+  JS_SetPropertyFunctionList(ctx, proto, nvgjs_framebuffer_methods, countof(nvgjs_framebuffer_methods));
+  JS_SetClassProto(ctx, nvgjs_framebuffer_class_id, proto);
 
-  transform_proto = JS_NewObjectProto(ctx, js_float32array_proto);
-  JS_SetPropertyFunctionList(ctx, transform_proto, nvgjs_transform_methods, countof(nvgjs_transform_methods));
-  transform_ctor = JS_NewObjectProto(ctx, JS_NULL);
-  JS_SetPropertyFunctionList(ctx, transform_ctor, nvgjs_transform_functions, countof(nvgjs_transform_functions));
-  // JS_SetConstructor(ctx, transform_ctor, transform_proto);
-  JS_SetModuleExport(ctx, m, "Transform", transform_ctor);
-
-  JS_NewClassID(&nvgjs_paint_class_id);
-  JS_NewClass(JS_GetRuntime(ctx), nvgjs_paint_class_id, &nvgjs_paint_class);
-
-  paint_proto = JS_NewObject(ctx);
-  JS_SetPropertyFunctionList(ctx, paint_proto, nvgjs_paint_methods, countof(nvgjs_paint_methods));
-  JS_SetClassProto(ctx, nvgjs_paint_class_id, paint_proto);
-  paint_class = JS_NewObjectProto(ctx, JS_NULL);
-  // JS_SetConstructor(ctx, paint_class, paint_proto);
-  JS_SetModuleExport(ctx, m, "Paint", paint_class);
-
-  JS_NewClassID(&nvgjs_framebuffer_class_id);
-  JS_NewClass(JS_GetRuntime(ctx), nvgjs_framebuffer_class_id, &nvgjs_framebuffer_class);
+  // JS_SetModuleExport(ctx, m, "Framebuffer", framebuffer_ctor);
 
-  framebuffer_proto = JS_NewObjectProto(ctx, JS_NULL);
-  JS_SetPropertyFunctionList(ctx, framebuffer_proto, nvgjs_framebuffer_methods, countof(nvgjs_framebuffer_methods));
+#ifdef NANOVG_GL3
+  nvgjs_state_register(ctx, &nvgjs_headless_class_id, &nvgjs_headless_class);
 
-  // JS_SetModuleExport(ctx, m, "Framebuffer", framebuffer_ctor);
+  proto = JS_NewObjectProto(ctx, JS_NULL);
+  JS_SetPropertyFunctionList(ctx, proto, nvgjs_headless_methods, countof(nvgjs_headless_methods));
+  JS_SetClassProto(ctx, nvgjs_headless_class_id, proto);
+#endif
 
   JS_SetModuleExportList(ctx, m, nvgjs_funcs, countof(nvgjs_funcs));
+  JS_FreeValue(ctx, global);
   return 0;
 }
 
@@ -2336,6 +4841,8 @@ nvgjs_init_module(JSContext* ctx, const char* module_name) {
   JS_AddModuleExport(ctx, m, "Color");
   JS_AddModuleExport(ctx, m, "Transform");
   JS_AddModuleExport(ctx, m, "Paint");
+  JS_AddModuleExport(ctx, m, "Path");
+  JS_AddModuleExport(ctx, m, "SpatialIndex");
   // JS_AddModuleExport(ctx, m, "Framebuffer");
   JS_AddModuleExportList(ctx, m, nvgjs_funcs, countof(nvgjs_funcs));
   return m;
@@ -6,20 +6,34 @@
 #define NVGJS_DECL(class, fn) \
   static JSValue nvgjs_##class##_##fn(JSContext* ctx, JSValueConst this_obj, int argc, JSValueConst argv[], int magic)
 
+/* The opaque is the context's record (see nvgjs-nanovg.h) */
 #define NVGJS_CONTEXT(this_obj) \
+  NVGJSContextData* rec; \
   NVGcontext* nvg; \
-  if(!(nvg = JS_GetOpaque2(ctx, this_obj, nvgjs_context_class_id))) \
-    return JS_EXCEPTION;
+  if(!(rec = JS_GetOpaque2(ctx, this_obj, nvgjs_context_class_id))) \
+    return JS_EXCEPTION; \
+  nvg = rec->nvg; \
+  if(rec->stats) \
+    rec->stats->frame[NVGJS_STAT_CALLS]++;
 
 #define NVGJS_FRAMEBUFFER(this_obj) \
   NVGLUframebuffer* fb; \
   if(!(fb = JS_GetOpaque2(ctx, this_obj, nvgjs_framebuffer_class_id))) \
     return JS_EXCEPTION;
 
+#define NVGJS_HEADLESS(this_obj) \
+  NVGJSHeadlessHandle* hh; \
+  if(!(hh = JS_GetOpaque2(ctx, this_obj, nvgjs_headless_class_id))) \
+    return JS_EXCEPTION; \
+  if(!hh->hl) \
+    return JS_ThrowReferenceError(ctx, "headless context has been deleted");
+
 #define NVGJS_FUNC(fn, length) NVGJS_METHOD(func, fn, length)
 #define NVGJS_METHOD(class, fn, length) JS_CFUNC_MAGIC_DEF(#fn, length, nvgjs_##class##_##fn, 0)
 #define NVGJS_FLAG(name) JS_PROP_INT32_DEF(#name, NVG_##name, JS_PROP_CONFIGURABLE | JS_PROP_ENUMERABLE)
 #define NVGJS_CONST(name) JS_PROP_DOUBLE_DEF(#name, NVG_##name, JS_PROP_CONFIGURABLE | JS_PROP_ENUMERABLE)
+#define NVGJS_STAT(name) JS_PROP_INT32_DEF("STAT_" #name, NVGJS_STAT_##name, JS_PROP_CONFIGURABLE | JS_PROP_ENUMERABLE)
+#define NVGJS_OPCODE(name) JS_PROP_INT32_DEF("OP_" #name, NVGJS_OP_##name, JS_PROP_CONFIGURABLE | JS_PROP_ENUMERABLE)
 
 /* Exported entry point. When built as a shared library the symbol is renamed
  * to js_init_module via the #define in nvgjs-module.c. */
@@ -0,0 +1,435 @@
+/* NanoVG itself is compiled here, so the helpers below can reach its
+ * internals (state stack, path cache, flattening and expansion) without
+ * patching the submodule. Keep them in step with nvgFill() and nvgStroke(),
+ * which are renamed so that ours can set the tolerances first. */
+#define nvgFill nvgjs__fill
+#define nvgStroke nvgjs__stroke
+#include "nanovg.c"
+#undef nvgFill
+#undef nvgStroke
+
+#include "nvgjs-nanovg.h"
+
+#include <stdlib.h>
+
+/* Callbacks of contexts with a record: uptr is the record, forward to the
+   renderer. renderCreate and renderDelete are left alone, the record only
+   exists in between. nvgjs-stats.c puts its own over some of these. */
+static int
+nvgjs__render_create_texture(void* uptr, int type, int w, int h, int flags, const unsigned char* data) {
+  NVGJSContextData* d = uptr;
+
+  return d->params.renderCreateTexture(d->params.userPtr, type, w, h, flags, data);
+}
+
+static int
+nvgjs__render_delete_texture(void* uptr, int image) {
+  NVGJSContextData* d = uptr;
+
+  return d->params.renderDeleteTexture(d->params.userPtr, image);
+}
+
+static int
+nvgjs__render_update_texture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data) {
+  NVGJSContextData* d = uptr;
+
+  return d->params.renderUpdateTexture(d->params.userPtr, image, x, y, w, h, data);
+}
+
+static int
+nvgjs__render_texture_size(void* uptr, int image, int* w, int* h) {
+  NVGJSContextData* d = uptr;
+
+  return d->params.renderGetTextureSize(d->params.userPtr, image, w, h);
+}
+
+static void
+nvgjs__render_viewport(void* uptr, float width, float height, float devicePixelRatio) {
+  NVGJSContextData* d = uptr;
+
+  d->params.renderViewport(d->params.userPtr, width, height, devicePixelRatio);
+}
+
+static void
+nvgjs__render_cancel(void* uptr) {
+  NVGJSContextData* d = uptr;
+
+  d->params.renderCancel(d->params.userPtr);
+}
+
+/* Never replaced while the record exists: nvgjs_nvg_data() tells by it */
+static void
+nvgjs__render_flush(void* uptr) {
+  NVGJSContextData* d = uptr;
+
+  d->params.renderFlush(d->params.userPtr);
+}
+
+static void
+nvgjs__render_fill(void* uptr,
+                   NVGpaint* paint,
+                   NVGcompositeOperationState op,
+                   NVGscissor* scissor,
+                   float fringe,
+                   const float* bounds,
+                   const NVGpath* paths,
+                   int npaths) {
+  NVGJSContextData* d = uptr;
+
+  d->params.renderFill(d->params.userPtr, paint, op, scissor, fringe, bounds, paths, npaths);
+}
+
+static void
+nvgjs__render_stroke(void* uptr,
+                     NVGpaint* paint,
+                     NVGcompositeOperationState op,
+                     NVGscissor* scissor,
+                     float fringe,
+                     float strokeWidth,
+                     const NVGpath* paths,
+                     int npaths) {
+  NVGJSContextData* d = uptr;
+
+  d->params.renderStroke(d->params.userPtr, paint, op, scissor, fringe, strokeWidth, paths, npaths);
+}
+
+static void
+nvgjs__render_triangles(void* uptr,
+                        NVGpaint* paint,
+                        NVGcompositeOperationState op,
+                        NVGscissor* scissor,
+                        const NVGvertex* verts,
+                        int nverts,
+                        float fringe) {
+  NVGJSContextData* d = uptr;
+
+  d->params.renderTriangles(d->params.userPtr, paint, op, scissor, verts, nverts, fringe);
+}
+
+NVGJSContextData*
+nvgjs_nvg_data_new(NVGcontext* ctx) {
+  NVGJSContextData* d;
+
+  if((d = nvgjs_nvg_data(ctx)))
+    return d;
+
+  if(!(d = calloc(1, sizeof(NVGJSContextData))))
+    return 0;
+
+  d->params = ctx->params;
+  d->nvg = ctx;
+
+  ctx->params.userPtr = d;
+  ctx->params.renderCreateTexture = nvgjs__render_create_texture;
+  ctx->params.renderDeleteTexture = nvgjs__render_delete_texture;
+  ctx->params.renderUpdateTexture = nvgjs__render_update_texture;
+  ctx->params.renderGetTextureSize = nvgjs__render_texture_size;
+  ctx->params.renderViewport = nvgjs__render_viewport;
+  ctx->params.renderCancel = nvgjs__render_cancel;
+  ctx->params.renderFlush = nvgjs__render_flush;
+  ctx->params.renderFill = nvgjs__render_fill;
+  ctx->params.renderStroke = nvgjs__render_stroke;
+  ctx->params.renderTriangles = nvgjs__render_triangles;
+  return d;
+}
+
+void
+nvgjs_nvg_data_free(NVGcontext* ctx) {
+  NVGJSContextData* d;
+
+  if(!(d = nvgjs_nvg_data(ctx)))
+    return;
+
+  ctx->params = d->params;
+  free(d);
+}
+
+/* This runs on every fill */
+NVGJSContextData*
+nvgjs_nvg_data(NVGcontext* ctx) {
+  return ctx->params.renderFlush == nvgjs__render_flush ? ctx->params.userPtr : 0;
+}
+
+void
+nvgjs_nvg_suspend(NVGJSContextData* d, NVGparams* saved) {
+  *saved = d->nvg->params;
+  d->nvg->params = d->params;
+}
+
+void
+nvgjs_nvg_resume(NVGJSContextData* d, const NVGparams* saved) {
+  d->nvg->params = *saved;
+}
+
+/* nvgBeginFrame() resets the tolerances from the pixel ratio; set ours
+   again before each path is flattened. NanoVG flattens after the
+   transform, so they are in device pixels and curves already get fewer
+   segments when zoomed out; in LOD mode, points closer than the
+   flattening tolerance are merged too, increasingly so below scale 1. */
+static void
+nvgjs__tolerance_apply(NVGcontext* ctx) {
+  NVGJSContextData* d;
+  float dist;
+
+  if(!(d = nvgjs_nvg_data(ctx)) || d->tess <= 0)
+    return;
+
+  dist = d->dist;
+
+  if(d->lod && d->tess > dist) {
+    float scale = nvg__getAverageScale(nvg__getState(ctx)->xform);
+
+    if(scale < 1.0f)
+      dist += (d->tess - dist) * (1.0f - scale);
+  }
+
+  ctx->tessTol = d->tess / ctx->devicePxRatio;
+  ctx->distTol = dist / ctx->devicePxRatio;
+}
+
+void nvgFill(NVGcontext* ctx);
+void nvgStroke(NVGcontext* ctx);
+
+void
+nvgFill(NVGcontext* ctx) {
+  nvgjs__tolerance_apply(ctx);
+  nvgjs__fill(ctx);
+}
+
+void
+nvgStroke(NVGcontext* ctx) {
+  nvgjs__tolerance_apply(ctx);
+  nvgjs__stroke(ctx);
+}
+
+int
+nvgjs_nvg_set_tolerance(NVGcontext* ctx, float tess, float dist, int lod) {
+  NVGJSContextData* d;
+
+  if(!(d = nvgjs_nvg_data(ctx)))
+    return -1;
+
+  d->tess = tess > 0 ? tess : 0;
+  d->dist = tess > 0 ? dist : 0;
+  d->lod = tess > 0 && lod;
+
+  /* the defaults, as set by nvgBeginFrame() */
+  if(tess <= 0) {
+    ctx->tessTol = 0.25f / ctx->devicePxRatio;
+    ctx->distTol = 0.01f / ctx->devicePxRatio;
+  }
+
+  return 0;
+}
+
+/* The stroke width nvgStroke() expands with; thin strokes are widened to
+   the fringe and faded instead (applied to @p paint if given) */
+static float
+nvgjs__stroke_width(NVGcontext* ctx, NVGstate* state, NVGpaint* paint) {
+  float scale = nvg__getAverageScale(state->xform);
+  float width = nvg__clampf(state->strokeWidth * scale, 0.0f, 200.0f);
+
+  if(width < ctx->fringeWidth) {
+    float alpha = nvg__clampf(width / ctx->fringeWidth, 0.0f, 1.0f);
+
+    if(paint) {
+      paint->innerColor.a *= alpha * alpha;
+      paint->outerColor.a *= alpha * alpha;
+    }
+
+    width = ctx->fringeWidth;
+  }
+
+  return width;
+}
+
+static inline float
+nvgjs__fringe(NVGcontext* ctx, NVGstate* state) {
+  return ctx->params.edgeAntiAlias && state->shapeAntiAlias ? ctx->fringeWidth : 0.0f;
+}
+
+void
+nvgjs_nvg_tess_params(NVGcontext* ctx, int stroke, NVGJSTessParams* p) {
+  NVGstate* state = nvg__getState(ctx);
+
+  nvgjs__tolerance_apply(ctx);
+  memset(p, 0, sizeof(*p));
+  memcpy(p->xform, state->xform, sizeof(p->xform));
+  p->fringe = nvgjs__fringe(ctx, state);
+  p->tessTol = ctx->tessTol;
+  p->distTol = ctx->distTol;
+
+  if(stroke) {
+    p->strokeWidth = nvgjs__stroke_width(ctx, state, NULL);
+    p->miterLimit = state->miterLimit;
+    p->lineCap = state->lineCap;
+    p->lineJoin = state->lineJoin;
+  }
+}
+
+int
+nvgjs_nvg_tessellate(NVGcontext* ctx, int stroke, const NVGpath** ppaths, const float** pbounds) {
+  NVGstate* state = nvg__getState(ctx);
+
+  nvg__flattenPaths(ctx);
+
+  if(stroke)
+    nvg__expandStroke(ctx,
+                      nvgjs__stroke_width(ctx, state, NULL) * 0.5f,
+                      nvgjs__fringe(ctx, state),
+                      state->lineCap,
+                      state->lineJoin,
+                      state->miterLimit);
+  else
+    nvg__expandFill(ctx, nvgjs__fringe(ctx, state), NVG_MITER, 2.4f);
+
+  *ppaths = ctx->cache->paths;
+  *pbounds = ctx->cache->bounds;
+  return ctx->cache->npaths;
+}
+
+void
+nvgjs_nvg_render(NVGcontext* ctx, int stroke, const NVGpath* paths, int npaths, const float* bounds) {
+  NVGstate* state = nvg__getState(ctx);
+  NVGpaint paint = stroke ? state->stroke : state->fill;
+  float width = stroke ? nvgjs__stroke_width(ctx, state, &paint) : 0.0f;
+
+  paint.innerColor.a *= state->alpha;
+  paint.outerColor.a *= state->alpha;
+
+  if(stroke) {
+    ctx->params.renderStroke(ctx->params.userPtr,
+                             &paint,
+                             state->compositeOperation,
+                             &state->scissor,
+                             ctx->fringeWidth,
+                             width,
+                             paths,
+                             npaths);
+
+    for(int i = 0; i < npaths; i++) {
+      ctx->strokeTriCount += paths[i].nstroke - 2;
+      ctx->drawCallCount++;
+    }
+  } else {
+    ctx->params.renderFill(ctx->params.userPtr,
+                           &paint,
+                           state->compositeOperation,
+                           &state->scissor,
+                           ctx->fringeWidth,
+                           bounds,
+                           paths,
+                           npaths);
+
+    for(int i = 0; i < npaths; i++) {
+      ctx->fillTriCount += paths[i].nfill - 2;
+      ctx->fillTriCount += paths[i].nstroke - 2;
+      ctx->drawCallCount += 2;
+    }
+  }
+}
+
+/* Non-zero winding number of the flattened paths around (x, y), with the
+   closing edge of each */
+static int
+nvgjs__winding(NVGpathCache* cache, float x, float y) {
+  int winding = 0;
+
+  for(int i = 0; i < cache->npaths; i++) {
+    const NVGpath* path = &cache->paths[i];
+    const NVGpoint* pts = &cache->points[path->first];
+
+    if(path->count < 3)
+      continue;
+
+    for(int j = 0; j < path->count; j++) {
+      const NVGpoint *a = &pts[j ? j - 1 : path->count - 1], *b = &pts[j];
+      float cross = (b->x - a->x) * (y - a->y) - (x - a->x) * (b->y - a->y);
+
+      if(a->y <= y) {
+        if(b->y > y && cross > 0)
+          winding++;
+      } else if(b->y <= y && cross < 0) {
+        winding--;
+      }
+    }
+  }
+
+  return winding;
+}
+
+/* Whether (x, y) lies in one of the triangles of the stroke strips */
+static int
+nvgjs__in_stroke(NVGpathCache* cache, float x, float y) {
+  for(int i = 0; i < cache->npaths; i++) {
+    const NVGvertex* v = cache->paths[i].stroke;
+
+    for(int j = 2; j < cache->paths[i].nstroke; j++) {
+      const NVGvertex *a = &v[j - 2], *b = &v[j - 1], *c = &v[j];
+      float area = (b->x - a->x) * (c->y - a->y) - (c->x - a->x) * (b->y - a->y);
+      float d0 = (b->x - a->x) * (y - a->y) - (x - a->x) * (b->y - a->y);
+      float d1 = (c->x - b->x) * (y - b->y) - (x - b->x) * (c->y - b->y);
+      float d2 = (a->x - c->x) * (y - c->y) - (x - c->x) * (a->y - c->y);
+
+      /* strips have degenerate triangles, which would match collinear points */
+      if(area == 0.0f)
+        continue;
+
+      if(area > 0 ? d0 >= 0 && d1 >= 0 && d2 >= 0 : d0 <= 0 && d1 <= 0 && d2 <= 0)
+        return 1;
+    }
+  }
+
+  return 0;
+}
+
+size_t
+nvgjs_nvg_hit_test(NVGcontext* ctx, int stroke, const float* pts, size_t count, unsigned char* out) {
+  NVGstate* state = nvg__getState(ctx);
+  NVGpathCache* cache = ctx->cache;
+  float bounds[4];
+  size_t inside = 0;
+
+  nvgjs__tolerance_apply(ctx);
+  nvg__flattenPaths(ctx);
+  memcpy(bounds, cache->bounds, sizeof(bounds));
+
+  if(stroke) {
+    /* no fringe: with one the outline grows by half of it */
+    nvg__expandStroke(ctx,
+                      nvgjs__stroke_width(ctx, state, NULL) * 0.5f,
+                      0.0f,
+                      state->lineCap,
+                      state->lineJoin,
+                      state->miterLimit);
+
+    /* joins and caps reach past the points */
+    bounds[0] = bounds[1] = 1e6f;
+    bounds[2] = bounds[3] = -1e6f;
+
+    for(int i = 0; i < cache->npaths; i++)
+      for(int j = 0; j < cache->paths[i].nstroke; j++) {
+        const NVGvertex* v = &cache->paths[i].stroke[j];
+
+        bounds[0] = nvg__minf(bounds[0], v->x);
+        bounds[1] = nvg__minf(bounds[1], v->y);
+        bounds[2] = nvg__maxf(bounds[2], v->x);
+        bounds[3] = nvg__maxf(bounds[3], v->y);
+      }
+  }
+
+  for(size_t i = 0; i < count; i++) {
+    float x = pts[i * 2], y = pts[i * 2 + 1];
+    int hit = 0;
+
+    if(x >= bounds[0] && x <= bounds[2] && y >= bounds[1] && y <= bounds[3])
+      hit = stroke ? nvgjs__in_stroke(cache, x, y) : nvgjs__winding(cache, x, y) != 0;
+
+    if(out)
+      out[i] = hit;
+
+    inside += hit;
+  }
+
+  return inside;
+}
@@ -0,0 +1,135 @@
+/**
+ * @file nvgjs-nanovg.h
+ */
+#ifndef NVGJS_NANOVG_H
+#define NVGJS_NANOVG_H
+
+#include <stddef.h>
+
+#include "nanovg.h"
+
+struct NVGJSStats;
+struct NVGJSTessCache;
+struct NVGJSHeadlessHandle;
+
+/**
+ * @brief What the binding keeps per NanoVG context, besides its JS object.
+ *
+ * Each part is owned by the module named and left NULL (0) until that
+ * module sets it up. The parts are only used by the thread drawing with the
+ * context. The record takes the renderer's place as the context's userPtr,
+ * with callbacks forwarding to the renderer's, so the callbacks get it as
+ * their first argument and nvgjs_nvg_data() reads it off the context; the
+ * Context object holds it as its opaque.
+ */
+typedef struct NVGJSContextData {
+  NVGparams params; /* the renderer's callbacks and userPtr */
+  struct NVGcontext* nvg;
+  struct NVGJSStats* stats;         /* nvgjs-stats.c */
+  struct NVGJSTessCache* tesscache; /* nvgjs-tesscache.c */
+  float tess, dist;                 /* tolerances in device pixels, 0 for NanoVG's */
+  int lod;
+  struct NVGJSHeadlessHandle* headless; /* nvgjs-module.c: tears the context down */
+} NVGJSContextData;
+
+/**
+ * @brief Create the record of a context, before any of its parts is used.
+ *
+ * @return The record, or NULL on allocation failure.
+ */
+NVGJSContextData* nvgjs_nvg_data_new(struct NVGcontext* nvg);
+
+/**
+ * @brief Free the record of a context and give the renderer its userPtr
+ * back; its parts must have been released. Must be called before the
+ * context is deleted.
+ */
+void nvgjs_nvg_data_free(struct NVGcontext* nvg);
+
+/**
+ * @brief The record of a context, or NULL.
+ */
+NVGJSContextData* nvgjs_nvg_data(struct NVGcontext* nvg);
+
+/**
+ * @brief Hand the context back to its renderer (@p saved receives what is
+ * installed) for calls into the renderer that read its userPtr themselves,
+ * e.g. nvglImageHandleGL3() or nvgluCreateFramebuffer(); undo with
+ * nvgjs_nvg_resume(). Nothing is counted in between.
+ */
+void nvgjs_nvg_suspend(NVGJSContextData* d, NVGparams* saved);
+
+/**
+ * @brief Reinstall what nvgjs_nvg_suspend() saved.
+ */
+void nvgjs_nvg_resume(NVGJSContextData* d, const NVGparams* saved);
+
+/**
+ * @brief Everything besides the path commands that the vertices produced
+ * by nvgFill() or nvgStroke() depend on, in a fixed layout that can be
+ * compared with memcmp().
+ */
+typedef struct {
+  float xform[6];    /* current transform */
+  float fringe;      /* fringe width, 0 without antialiasing */
+  float tessTol, distTol;
+  float strokeWidth; /* after scaling and clamping, as expanded; 0 for fills */
+  float miterLimit;
+  int lineCap, lineJoin;
+} NVGJSTessParams;
+
+/**
+ * @brief Set the curve flattening (@p tess) and point merging (@p dist)
+ * tolerances of a context in device pixels, kept across frames. NanoVG's
+ * defaults are 0.25 and 0.01.
+ *
+ * With @p lod, paths drawn at a scale below 1 merge points up to @p tess
+ * apart, in proportion to the zoom-out.
+ *
+ * @param tess  0 to go back to the defaults.
+ * @return 0 on success, -1 if the context has no record.
+ */
+int nvgjs_nvg_set_tolerance(struct NVGcontext* nvg, float tess, float dist, int lod);
+
+/**
+ * @brief The parameters a fill (@p stroke == 0) or stroke of the current
+ * path would be tessellated with. Fields that do not apply are zeroed.
+ */
+void nvgjs_nvg_tess_params(struct NVGcontext* nvg, int stroke, NVGJSTessParams* p);
+
+/**
+ * @brief Flatten and expand the current path exactly as nvgFill() or
+ * nvgStroke() would, without drawing it.
+ *
+ * The results live in NanoVG's path cache and stay valid until the next
+ * path operation on the context.
+ *
+ * @param[out] ppaths   Receives the paths.
+ * @param[out] pbounds  Receives the 4 bounds (minx, miny, maxx, maxy).
+ * @return Number of paths.
+ */
+int nvgjs_nvg_tessellate(struct NVGcontext* nvg, int stroke, const struct NVGpath** ppaths, const float** pbounds);
+
+/**
+ * @brief Hand tessellated paths to the renderer with the current paint,
+ * alpha, composite operation and scissor: the second half of nvgFill() or
+ * nvgStroke(), including the triangle and draw call counters.
+ */
+void nvgjs_nvg_render(struct NVGcontext* nvg, int stroke, const struct NVGpath* paths, int npaths, const float* bounds);
+
+/**
+ * @brief Test points against the area nvgFill() (@p stroke == 0) or
+ * nvgStroke() would cover with the current path and state.
+ *
+ * Fills use the flattened path and the non-zero rule, so holes made with
+ * nvgPathWinding() are outside. Strokes use the expanded outline, with its
+ * width, joins and caps. Points are in the coordinates the path was
+ * transformed to as it was built: those of nvgBeginFrame().
+ *
+ * @param pts    2 floats (x, y) per point.
+ * @param[out] out  1 per point inside, 0 otherwise, or NULL.
+ * @return Number of points inside.
+ */
+size_t nvgjs_nvg_hit_test(struct NVGcontext* nvg, int stroke, const float* pts, size_t count, unsigned char* out);
+
+#endif /* defined(NVGJS_NANOVG_H) */
@@ -0,0 +1,33 @@
+#include "nvgjs-profile.h"
+
+#include <stdlib.h>
+
+__thread int64_t* nvgjs_profile_slot __attribute__((tls_model("initial-exec")));
+
+/* qsort() has no context argument */
+static __thread const NVGJSProfileEntry* profile_entries;
+
+static int
+profile_compare(const void* a, const void* b) {
+  int64_t ta = profile_entries[*(const int*)a].total_ns, tb = profile_entries[*(const int*)b].total_ns;
+
+  /* ties keep table order */
+  if(ta == tb)
+    return *(const int*)a - *(const int*)b;
+
+  return ta < tb ? 1 : -1;
+}
+
+int
+nvgjs_profile_order(const NVGJSProfileEntry* entries, int n, int* order) {
+  int count = 0;
+
+  for(int i = 0; i < n; i++)
+    if(entries[i].calls)
+      order[count++] = i;
+
+  profile_entries = entries;
+  qsort(order, count, sizeof(int), profile_compare);
+  profile_entries = 0;
+  return count;
+}
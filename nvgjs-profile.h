@@ -0,0 +1,46 @@
+/**
+ * @file nvgjs-profile.h
+ */
+#ifndef NVGJS_PROFILE_H
+#define NVGJS_PROFILE_H
+
+#include <stdint.h>
+
+#include "nvgjs-trace.h"
+
+/**
+ * @brief Counters of one Context method (ProfileStart()).
+ */
+typedef struct {
+  uint64_t calls, exceptions;
+  int64_t total_ns;    /* the whole call */
+  int64_t convert_ns;  /* up to NVGJS_PROFILE_MARK(): context lookup, argument conversion */
+  int64_t nanovg_ns;   /* from NVGJS_PROFILE_MARK() to the return */
+} NVGJSProfileEntry;
+
+/**
+ * @brief Where the method being profiled on this thread wants the time of
+ * its NVGJS_PROFILE_MARK(), NULL outside of profiled calls.
+ */
+extern __thread int64_t* nvgjs_profile_slot __attribute__((tls_model("initial-exec")));
+
+/**
+ * @brief Mark the end of argument conversion in a method, just before its
+ * NanoVG call. A test of nvgjs_profile_slot unless the call is profiled.
+ */
+#define NVGJS_PROFILE_MARK() \
+  do { \
+    if(__builtin_expect(nvgjs_profile_slot != 0, 0)) \
+      *nvgjs_profile_slot = nvgjs_trace_now(); \
+  } while(0)
+
+/**
+ * @brief Order entries by total time, most expensive first, leaving out
+ * those never called.
+ *
+ * @param[out] order  Receives indices into @p entries.
+ * @return Number of indices written.
+ */
+int nvgjs_profile_order(const NVGJSProfileEntry* entries, int n, int* order);
+
+#endif /* defined(NVGJS_PROFILE_H) */
@@ -0,0 +1,112 @@
+#include <GL/glew.h>
+
+#include "nvgjs-readback.h"
+
+#include <string.h>
+
+int
+nvgjs_readback_start(NVGJSReadbackRing* ring, int x, int y, int w, int h) {
+  size_t size = (size_t)w * h * 4;
+  NVGJSReadback* rb = 0;
+  int i;
+
+  for(i = 0; i < NVGJS_READBACK_SLOTS; i++)
+    if(!ring->slot[i].fence) {
+      rb = &ring->slot[i];
+      break;
+    }
+
+  if(!rb)
+    return -1;
+
+  if(!rb->pbo)
+    glGenBuffers(1, &rb->pbo);
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->pbo);
+
+  /* grow only; a smaller read reuses the existing storage */
+  if(rb->capacity < size) {
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, 0, GL_STREAM_READ);
+    rb->capacity = size;
+  }
+
+  glReadPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  if(!(rb->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)))
+    return -1;
+
+  /* make sure the fence reaches the GPU even if the caller stops drawing */
+  glFlush();
+
+  rb->size = size;
+  rb->seq = ring->seq++;
+  return i;
+}
+
+int
+nvgjs_readback_oldest(const NVGJSReadbackRing* ring) {
+  int oldest = -1;
+
+  for(int i = 0; i < NVGJS_READBACK_SLOTS; i++)
+    if(ring->slot[i].fence && (oldest == -1 || ring->slot[i].seq < ring->slot[oldest].seq))
+      oldest = i;
+
+  return oldest;
+}
+
+int
+nvgjs_readback_wait(NVGJSReadbackRing* ring, int slot, uint64_t timeout_ns) {
+  NVGJSReadback* rb = &ring->slot[slot];
+
+  if(!rb->fence)
+    return -1;
+
+  switch(glClientWaitSync(rb->fence, timeout_ns ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, timeout_ns)) {
+    case GL_ALREADY_SIGNALED:
+    case GL_CONDITION_SATISFIED: return 1;
+    case GL_TIMEOUT_EXPIRED: return 0;
+    default: return -1;
+  }
+}
+
+int
+nvgjs_readback_finish(NVGJSReadbackRing* ring, int slot, void* dst) {
+  NVGJSReadback* rb = &ring->slot[slot];
+  int ret = 0;
+
+  if(dst) {
+    void* src;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->pbo);
+
+    if((src = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, rb->size, GL_MAP_READ_BIT))) {
+      memcpy(dst, src, rb->size);
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+      ret = -1;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  }
+
+  glDeleteSync(rb->fence);
+  rb->fence = 0;
+  rb->size = 0;
+  return ret;
+}
+
+void
+nvgjs_readback_free(NVGJSReadbackRing* ring) {
+  for(int i = 0; i < NVGJS_READBACK_SLOTS; i++) {
+    NVGJSReadback* rb = &ring->slot[i];
+
+    if(rb->fence)
+      glDeleteSync(rb->fence);
+
+    if(rb->pbo)
+      glDeleteBuffers(1, &rb->pbo);
+  }
+
+  memset(ring, 0, sizeof(*ring));
+}
@@ -0,0 +1,80 @@
+/**
+ * @file nvgjs-readback.h
+ */
+#ifndef NVGJS_READBACK_H
+#define NVGJS_READBACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Number of pixel buffer objects in a readback ring.
+ *
+ * Three slots let a capture issued every frame complete two frames later
+ * without the driver having to stall on a buffer that is still being written.
+ */
+#define NVGJS_READBACK_SLOTS 3
+
+/**
+ * @brief One in-flight asynchronous glReadPixels.
+ */
+typedef struct NVGJSReadback {
+  unsigned int pbo;  /* GL_PIXEL_PACK_BUFFER name, 0 until first use */
+  void* fence;       /* GLsync, NULL while the slot is free */
+  size_t capacity;   /* allocated size of pbo */
+  size_t size;       /* bytes of the pending read (w * h * 4) */
+  uint64_t seq;      /* submission order */
+} NVGJSReadback;
+
+/**
+ * @brief Ring of pixel buffer objects used by nvgjs_readback_start().
+ *
+ * Zero-initialize before use. All functions must be called with the GL
+ * context that owns the buffers current.
+ */
+typedef struct NVGJSReadbackRing {
+  NVGJSReadback slot[NVGJS_READBACK_SLOTS];
+  uint64_t seq;
+} NVGJSReadbackRing;
+
+/**
+ * @brief Start reading an RGBA8 rectangle of the read framebuffer into a free slot.
+ *
+ * Issues glReadPixels into the slot's pixel buffer object followed by a
+ * fence, so the call returns without waiting for the GPU.
+ *
+ * @return Slot index, or -1 if every slot is busy or GL failed.
+ */
+int nvgjs_readback_start(NVGJSReadbackRing*, int x, int y, int w, int h);
+
+/**
+ * @brief Index of the oldest busy slot.
+ *
+ * @return Slot index, or -1 if nothing is pending.
+ */
+int nvgjs_readback_oldest(const NVGJSReadbackRing*);
+
+/**
+ * @brief Wait for a slot's fence.
+ *
+ * @param timeout_ns  0 to only poll.
+ * @return 1 if the pixels are ready, 0 if still pending, -1 if the wait failed.
+ */
+int nvgjs_readback_wait(NVGJSReadbackRing*, int slot, uint64_t timeout_ns);
+
+/**
+ * @brief Copy a finished slot's pixels out and release the slot.
+ *
+ * @param dst  Destination of at least NVGJSReadback.size bytes, or NULL to
+ *             just release the slot.
+ * @return 0 on success, -1 if the buffer could not be mapped (the slot is
+ *         released anyway).
+ */
+int nvgjs_readback_finish(NVGJSReadbackRing*, int slot, void* dst);
+
+/**
+ * @brief Delete the fences and pixel buffer objects of all slots.
+ */
+void nvgjs_readback_free(NVGJSReadbackRing*);
+
+#endif /* defined(NVGJS_READBACK_H) */
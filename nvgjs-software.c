@@ -0,0 +1,858 @@
+#include "nanovg.h"
+#include "nvgjs-software.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+typedef struct {
+  int id, type, width, height, flags;
+  uint8_t* data; /* 1 (NVG_TEXTURE_ALPHA) or 4 bytes per texel */
+} NVGJSSWTexture;
+
+typedef struct {
+  uint8_t* pixels;
+  int width, height, antialias;
+  float scale[2];  /* framebuffer pixels per view unit */
+  float* acc;      /* (width + 2) * height coverage accumulator, kept zeroed */
+  uint8_t* cov;    /* one row of 8-bit coverage */
+  NVGJSSWTexture* textures;
+  int ntextures, ctextures, texture_id;
+} NVGJSSoftware;
+
+enum {
+  SW_SOLID,     /* constant color */
+  SW_GRADIENT,  /* linear/box/radial gradient (NanoVG's rounded-rect distance) */
+  SW_IMAGE,     /* image pattern */
+  SW_TEXCOORD,  /* renderTriangles: texture at interpolated vertex uv */
+};
+
+/* Everything the per-pixel shader needs; mirrors the uniforms of NanoVG's GL
+   fragment shader (see glnvg__convertPaint) */
+typedef struct {
+  int kind, tex_type; /* tex_type: 0 premultiplied RGBA, 1 straight RGBA, 2 alpha */
+  int scissor;        /* non-zero if a scissor applies */
+  float paint_mat[6], scissor_mat[6];
+  float scissor_ext[2], scissor_scale[2];
+  float extent[2], radius, feather;
+  float inner[4], outer[4]; /* premultiplied */
+  uint8_t solid[4];         /* premultiplied RGBA8 of inner, for SW_SOLID */
+  const NVGJSSWTexture* tex;
+  float uv[6]; /* SW_TEXCOORD: u = uv[0]x + uv[1]y + uv[2], v = uv[3]x + uv[4]y + uv[5] */
+} NVGJSSWPaint;
+
+static inline float
+sw_clampf(float a, float lo, float hi) {
+  return a < lo ? lo : a > hi ? hi : a;
+}
+
+static inline unsigned
+sw_div255(unsigned x) {
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+static NVGJSSWTexture*
+sw_texture(NVGJSSoftware* sw, int id) {
+  for(int i = 0; i < sw->ntextures; i++)
+    if(sw->textures[i].id == id)
+      return &sw->textures[i];
+
+  return 0;
+}
+
+static int
+sw_render_create(void* uptr) {
+  (void)uptr;
+  return 1;
+}
+
+static int
+sw_create_texture(void* uptr, int type, int w, int h, int flags, const unsigned char* data) {
+  NVGJSSoftware* sw = uptr;
+  NVGJSSWTexture* tex = 0;
+  size_t size = (size_t)w * h * (type == NVG_TEXTURE_RGBA ? 4 : 1);
+
+  for(int i = 0; i < sw->ntextures; i++)
+    if(sw->textures[i].id == 0) {
+      tex = &sw->textures[i];
+      break;
+    }
+
+  if(!tex) {
+    if(sw->ntextures + 1 > sw->ctextures) {
+      int n = sw->ctextures ? sw->ctextures * 2 : 4;
+      NVGJSSWTexture* textures;
+
+      if(!(textures = realloc(sw->textures, sizeof(NVGJSSWTexture) * n)))
+        return 0;
+
+      sw->textures = textures;
+      sw->ctextures = n;
+    }
+
+    tex = &sw->textures[sw->ntextures++];
+  }
+
+  if(!(tex->data = data ? malloc(size) : calloc(1, size))) {
+    tex->id = 0;
+    return 0;
+  }
+
+  if(data)
+    memcpy(tex->data, data, size);
+
+  tex->id = ++sw->texture_id;
+  tex->type = type;
+  tex->width = w;
+  tex->height = h;
+  tex->flags = flags;
+  return tex->id;
+}
+
+static int
+sw_delete_texture(void* uptr, int image) {
+  NVGJSSWTexture* tex;
+
+  if(!(tex = sw_texture(uptr, image)))
+    return 0;
+
+  free(tex->data);
+  memset(tex, 0, sizeof(*tex));
+  return 1;
+}
+
+/* data is the whole image (row length = texture width), as with GL_UNPACK_ROW_LENGTH */
+static int
+sw_update_texture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data) {
+  NVGJSSWTexture* tex;
+  int bpp;
+
+  if(!(tex = sw_texture(uptr, image)))
+    return 0;
+
+  bpp = tex->type == NVG_TEXTURE_RGBA ? 4 : 1;
+
+  for(int row = y; row < y + h; row++)
+    memcpy(tex->data + ((size_t)row * tex->width + x) * bpp,
+           data + ((size_t)row * tex->width + x) * bpp,
+           (size_t)w * bpp);
+
+  return 1;
+}
+
+static int
+sw_texture_size(void* uptr, int image, int* w, int* h) {
+  NVGJSSWTexture* tex;
+
+  if(!(tex = sw_texture(uptr, image)))
+    return 0;
+
+  *w = tex->width;
+  *h = tex->height;
+  return 1;
+}
+
+static void
+sw_viewport(void* uptr, float width, float height, float ratio) {
+  NVGJSSoftware* sw = uptr;
+
+  (void)ratio;
+  sw->scale[0] = width > 0 ? sw->width / width : 1;
+  sw->scale[1] = height > 0 ? sw->height / height : 1;
+}
+
+static void
+sw_cancel(void* uptr) {
+  (void)uptr;
+}
+
+static void
+sw_flush(void* uptr) {
+  (void)uptr;
+}
+
+static void
+sw_premultiply(float out[4], NVGcolor c) {
+  out[0] = c.r * c.a;
+  out[1] = c.g * c.a;
+  out[2] = c.b * c.a;
+  out[3] = c.a;
+}
+
+/* Port of glnvg__convertPaint() */
+static void
+sw_paint(NVGJSSoftware* sw, NVGJSSWPaint* p, NVGpaint* paint, NVGscissor* scissor, float fringe) {
+  float invxform[6];
+
+  memset(p, 0, sizeof(*p));
+  sw_premultiply(p->inner, paint->innerColor);
+  sw_premultiply(p->outer, paint->outerColor);
+
+  if(scissor->extent[0] >= -0.5f && scissor->extent[1] >= -0.5f) {
+    p->scissor = 1;
+    nvgTransformInverse(p->scissor_mat, scissor->xform);
+    p->scissor_ext[0] = scissor->extent[0];
+    p->scissor_ext[1] = scissor->extent[1];
+    p->scissor_scale[0] =
+     sqrtf(scissor->xform[0] * scissor->xform[0] + scissor->xform[2] * scissor->xform[2]) / fringe;
+    p->scissor_scale[1] =
+     sqrtf(scissor->xform[1] * scissor->xform[1] + scissor->xform[3] * scissor->xform[3]) / fringe;
+  }
+
+  p->extent[0] = paint->extent[0];
+  p->extent[1] = paint->extent[1];
+
+  if(paint->image && (p->tex = sw_texture(sw, paint->image))) {
+    if(p->tex->flags & NVG_IMAGE_FLIPY) {
+      float m1[6], m2[6];
+
+      nvgTransformTranslate(m1, 0.0f, p->extent[1] * 0.5f);
+      nvgTransformMultiply(m1, paint->xform);
+      nvgTransformScale(m2, 1.0f, -1.0f);
+      nvgTransformMultiply(m2, m1);
+      nvgTransformTranslate(m1, 0.0f, -p->extent[1] * 0.5f);
+      nvgTransformMultiply(m1, m2);
+      nvgTransformInverse(invxform, m1);
+    } else {
+      nvgTransformInverse(invxform, paint->xform);
+    }
+
+    p->kind = SW_IMAGE;
+    p->tex_type = p->tex->type == NVG_TEXTURE_RGBA ? (p->tex->flags & NVG_IMAGE_PREMULTIPLIED ? 0 : 1) : 2;
+  } else {
+    p->kind = memcmp(p->inner, p->outer, sizeof(p->inner)) ? SW_GRADIENT : SW_SOLID;
+    p->radius = paint->radius;
+    p->feather = paint->feather;
+    nvgTransformInverse(invxform, paint->xform);
+  }
+
+  memcpy(p->paint_mat, invxform, sizeof(invxform));
+
+  for(int i = 0; i < 4; i++)
+    p->solid[i] = (uint8_t)(sw_clampf(p->inner[i], 0, 1) * 255.0f + 0.5f);
+}
+
+static inline float
+sw_sdroundrect(float px, float py, const float ext[2], float rad) {
+  float dx = fabsf(px) - (ext[0] - rad), dy = fabsf(py) - (ext[1] - rad);
+  float mx = dx > 0 ? dx : 0, my = dy > 0 ? dy : 0;
+
+  return fminf(fmaxf(dx, dy), 0.0f) + sqrtf(mx * mx + my * my) - rad;
+}
+
+static inline float
+sw_wrap(float t, int size, int repeat) {
+  if(repeat)
+    return t - floorf(t / size) * size;
+
+  return sw_clampf(t, 0, size - 1);
+}
+
+/* Texel fetch with bilinear filtering (GL_LINEAR) unless NVG_IMAGE_NEAREST;
+   (u, v) in 0..1 */
+static void
+sw_sample(const NVGJSSWTexture* tex, float u, float v, float out[4]) {
+  int rx = tex->flags & NVG_IMAGE_REPEATX, ry = tex->flags & NVG_IMAGE_REPEATY;
+  int bpp = tex->type == NVG_TEXTURE_RGBA ? 4 : 1, n = tex->flags & NVG_IMAGE_NEAREST ? 1 : 2;
+  float x = u * tex->width - 0.5f, y = v * tex->height - 0.5f;
+  float fx = x - floorf(x), fy = y - floorf(y);
+  int x0 = (int)floorf(x), y0 = (int)floorf(y);
+
+  if(n == 1) {
+    x0 = (int)floorf(x + 0.5f);
+    y0 = (int)floorf(y + 0.5f);
+    fx = fy = 0;
+  }
+
+  out[0] = out[1] = out[2] = out[3] = 0;
+
+  for(int j = 0; j < n; j++)
+    for(int i = 0; i < n; i++) {
+      float w = (i ? fx : 1 - fx) * (j ? fy : 1 - fy);
+      int tx = (int)sw_wrap(x0 + i, tex->width, rx), ty = (int)sw_wrap(y0 + j, tex->height, ry);
+      const uint8_t* t = tex->data + ((size_t)ty * tex->width + tx) * bpp;
+
+      for(int c = 0; c < 4; c++)
+        out[c] += w * t[bpp == 4 ? c : 0];
+    }
+
+  for(int c = 0; c < 4; c++)
+    out[c] *= 1.0f / 255.0f;
+}
+
+static void
+sw_texel(const NVGJSSWPaint* p, float u, float v, float out[4]) {
+  sw_sample(p->tex, u, v, out);
+
+  if(p->tex_type == 1) {
+    out[0] *= out[3];
+    out[1] *= out[3];
+    out[2] *= out[3];
+  } else if(p->tex_type == 2) {
+    out[1] = out[2] = out[3] = out[0];
+  }
+}
+
+/* Shade one pixel; (x, y) in view units. Result is premultiplied. */
+static void
+sw_shade(const NVGJSSWPaint* p, float x, float y, float fx, float fy, float out[4]) {
+  const float* m = p->paint_mat;
+  float px = m[0] * x + m[2] * y + m[4], py = m[1] * x + m[3] * y + m[5];
+
+  switch(p->kind) {
+    case SW_GRADIENT: {
+      float d = sw_clampf((sw_sdroundrect(px, py, p->extent, p->radius) + p->feather * 0.5f) / p->feather, 0, 1);
+
+      for(int c = 0; c < 4; c++)
+        out[c] = p->inner[c] + (p->outer[c] - p->inner[c]) * d;
+
+      return;
+    }
+
+    case SW_IMAGE:
+      sw_texel(p, px / p->extent[0], py / p->extent[1], out);
+      break;
+
+    case SW_TEXCOORD:
+      if(p->tex) {
+        sw_texel(p, p->uv[0] * fx + p->uv[1] * fy + p->uv[2], p->uv[3] * fx + p->uv[4] * fy + p->uv[5], out);
+        break;
+      }
+      /* fall through */
+
+    default: memcpy(out, p->inner, sizeof(p->inner)); return;
+  }
+
+  for(int c = 0; c < 4; c++)
+    out[c] *= p->inner[c];
+}
+
+static float
+sw_scissor_mask(const NVGJSSWPaint* p, float x, float y) {
+  const float* m = p->scissor_mat;
+  float sx = fabsf(m[0] * x + m[2] * y + m[4]) - p->scissor_ext[0];
+  float sy = fabsf(m[1] * x + m[3] * y + m[5]) - p->scissor_ext[1];
+
+  return sw_clampf(0.5f - sx * p->scissor_scale[0], 0, 1) * sw_clampf(0.5f - sy * p->scissor_scale[1], 0, 1);
+}
+
+static float
+sw_factor(int f, const float s[4], const float d[4], int c) {
+  switch(f) {
+    case NVG_ZERO: return 0;
+    case NVG_ONE: return 1;
+    case NVG_SRC_COLOR: return s[c];
+    case NVG_ONE_MINUS_SRC_COLOR: return 1 - s[c];
+    case NVG_DST_COLOR: return d[c];
+    case NVG_ONE_MINUS_DST_COLOR: return 1 - d[c];
+    case NVG_SRC_ALPHA: return s[3];
+    case NVG_ONE_MINUS_SRC_ALPHA: return 1 - s[3];
+    case NVG_DST_ALPHA: return d[3];
+    case NVG_ONE_MINUS_DST_ALPHA: return 1 - d[3];
+    case NVG_SRC_ALPHA_SATURATE: return c == 3 ? 1 : fminf(s[3], 1 - d[3]);
+  }
+
+  return 0;
+}
+
+static inline int
+sw_srcover(const NVGcompositeOperationState* op) {
+  return op->srcRGB == NVG_ONE && op->srcAlpha == NVG_ONE && op->dstRGB == NVG_ONE_MINUS_SRC_ALPHA &&
+         op->dstAlpha == NVG_ONE_MINUS_SRC_ALPHA;
+}
+
+/* src-over of one premultiplied color over n pixels at full coverage */
+static void
+sw_fill_solid(uint8_t* dst, const uint8_t src[4], int n) {
+  unsigned inv = 255 - src[3];
+  int i = 0;
+
+  if(src[3] == 255) {
+    uint32_t v;
+
+    memcpy(&v, src, 4);
+
+    for(; i < n; i++)
+      memcpy(dst + i * 4, &v, 4);
+
+    return;
+  }
+
+#ifdef __SSE2__
+  {
+    uint32_t v;
+
+    memcpy(&v, src, 4);
+
+    __m128i s = _mm_set1_epi32(v), k = _mm_set1_epi16(inv), r = _mm_set1_epi16(128), z = _mm_setzero_si128();
+
+    for(; i + 4 <= n; i += 4) {
+      __m128i d = _mm_loadu_si128((const __m128i*)(dst + i * 4));
+      __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, z), k), r);
+      __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, z), k), r);
+
+      /* (x + 128 + ((x + 128) >> 8)) >> 8 == x / 255 rounded */
+      lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+      hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+      _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_adds_epu8(_mm_packus_epi16(lo, hi), s));
+    }
+  }
+#endif
+
+  for(; i < n; i++)
+    for(int c = 0; c < 4; c++)
+      dst[i * 4 + c] = src[c] + sw_div255(dst[i * 4 + c] * inv);
+}
+
+/* Composite one row of coverage; x0/y are framebuffer pixel coordinates */
+static void
+sw_span(NVGJSSoftware* sw,
+        const NVGJSSWPaint* p,
+        const NVGcompositeOperationState* op,
+        int x0,
+        int y,
+        uint8_t* cov,
+        int n) {
+  uint8_t* dst = sw->pixels + ((size_t)y * sw->width + x0) * 4;
+  float iy = (y + 0.5f) / sw->scale[1];
+  int x = 0;
+
+  if(p->scissor)
+    for(int i = 0; i < n; i++)
+      if(cov[i])
+        cov[i] = (uint8_t)(cov[i] * sw_scissor_mask(p, (x0 + i + 0.5f) / sw->scale[0], iy) + 0.5f);
+
+  if(p->kind == SW_SOLID && sw_srcover(op)) {
+    while(x < n) {
+      int end;
+
+      if(!cov[x]) {
+        x++;
+        continue;
+      }
+
+      if(cov[x] == 255) {
+        for(end = x + 1; end < n && cov[end] == 255; end++)
+          ;
+
+        sw_fill_solid(dst + x * 4, p->solid, end - x);
+        x = end;
+        continue;
+      }
+
+      {
+        unsigned c = cov[x], a = sw_div255(p->solid[3] * c), inv = 255 - a;
+
+        for(int i = 0; i < 4; i++)
+          dst[x * 4 + i] = sw_div255(p->solid[i] * c) + sw_div255(dst[x * 4 + i] * inv);
+      }
+
+      x++;
+    }
+
+    return;
+  }
+
+  for(; x < n; x++) {
+    float s[4], d[4], r[4], c;
+
+    if(!cov[x])
+      continue;
+
+    c = cov[x] * (1.0f / 255.0f);
+    sw_shade(p, (x0 + x + 0.5f) / sw->scale[0], iy, x0 + x + 0.5f, y + 0.5f, s);
+
+    for(int i = 0; i < 4; i++) {
+      s[i] *= c;
+      d[i] = dst[x * 4 + i] * (1.0f / 255.0f);
+    }
+
+    if(sw_srcover(op)) {
+      for(int i = 0; i < 4; i++)
+        r[i] = s[i] + d[i] * (1 - s[3]);
+    } else {
+      for(int i = 0; i < 3; i++)
+        r[i] = s[i] * sw_factor(op->srcRGB, s, d, i) + d[i] * sw_factor(op->dstRGB, s, d, i);
+
+      r[3] = s[3] * sw_factor(op->srcAlpha, s, d, 3) + d[3] * sw_factor(op->dstAlpha, s, d, 3);
+    }
+
+    for(int i = 0; i < 4; i++)
+      dst[x * 4 + i] = (uint8_t)(sw_clampf(r[i], 0, 1) * 255.0f + 0.5f);
+  }
+}
+
+/* Draw area into the accumulator for the edge (x0,y0)-(x1,y1), in pixels
+   relative to the bounding box. Each cell gets the signed area the edge
+   covers to its right on that scanline, so a prefix sum along the row yields
+   the winding-weighted coverage (the "font-rs" scheme). x is clamped to
+   [0, w]: whatever lies left of the box still counts towards the winding. */
+static void
+sw_line(float* acc, int stride, int w, int h, float x0, float y0, float x1, float y1) {
+  float dir = 1, dxdy, x;
+  int ystart, yend;
+
+  if(y0 == y1)
+    return;
+
+  if(y0 > y1) {
+    float t;
+
+    dir = -1;
+    t = x0, x0 = x1, x1 = t;
+    t = y0, y0 = y1, y1 = t;
+  }
+
+  dxdy = (x1 - x0) / (y1 - y0);
+  x = x0;
+
+  if(y0 < 0)
+    x -= y0 * dxdy;
+
+  ystart = y0 < 0 ? 0 : (int)y0;
+  yend = y1 < h ? (int)ceilf(y1) : h;
+
+  for(int y = ystart; y < yend; y++) {
+    float* row = acc + (size_t)y * stride;
+    float dy = fminf((float)(y + 1), y1) - fmaxf((float)y, y0);
+    float xnext = x + dxdy * dy, d = dy * dir;
+    float xa = sw_clampf(x, 0, w), xb = sw_clampf(xnext, 0, w);
+    float xl = fminf(xa, xb), xr = fmaxf(xa, xb);
+    float xlf = floorf(xl), xrc = ceilf(xr);
+    int xli = (int)xlf, xri = (int)xrc;
+
+    if(xri <= xli + 1) {
+      float xmf = 0.5f * (xa + xb) - xlf;
+
+      row[xli] += d - d * xmf;
+      row[xli + 1] += d * xmf;
+    } else {
+      float s = 1.0f / (xr - xl), x0f = xl - xlf, a0 = 0.5f * s * (1 - x0f) * (1 - x0f);
+      float x1f = xr - xrc + 1, am = 0.5f * s * x1f * x1f;
+
+      row[xli] += d * a0;
+
+      if(xri == xli + 2) {
+        row[xli + 1] += d * (1 - a0 - am);
+      } else {
+        float a1 = s * (1.5f - x0f), a2 = a1 + (xri - xli - 3) * s;
+
+        row[xli + 1] += d * (a1 - a0);
+
+        for(int xi = xli + 2; xi < xri - 1; xi++)
+          row[xi] += d * s;
+
+        row[xri - 1] += d * (1 - a2 - am);
+      }
+
+      row[xri] += d * am;
+    }
+
+    x = xnext;
+  }
+}
+
+/* Pixel bounding box of an item, clipped to the framebuffer and to an
+   axis-aligned scissor. Returns 0 if empty. */
+static int
+sw_box(NVGJSSoftware* sw, const NVGJSSWPaint* p, NVGscissor* scissor, const float b[4], int box[4]) {
+  float x0 = b[0] * sw->scale[0], y0 = b[1] * sw->scale[1], x1 = b[2] * sw->scale[0], y1 = b[3] * sw->scale[1];
+
+  if(p->scissor && scissor->xform[1] == 0 && scissor->xform[2] == 0) {
+    float ex = scissor->extent[0] * fabsf(scissor->xform[0]), ey = scissor->extent[1] * fabsf(scissor->xform[3]);
+
+    x0 = fmaxf(x0, (scissor->xform[4] - ex) * sw->scale[0] - 1);
+    y0 = fmaxf(y0, (scissor->xform[5] - ey) * sw->scale[1] - 1);
+    x1 = fminf(x1, (scissor->xform[4] + ex) * sw->scale[0] + 1);
+    y1 = fminf(y1, (scissor->xform[5] + ey) * sw->scale[1] + 1);
+  }
+
+  box[0] = x0 > 0 ? (int)floorf(x0) : 0;
+  box[1] = y0 > 0 ? (int)floorf(y0) : 0;
+  box[2] = x1 < sw->width ? (int)ceilf(x1) : sw->width;
+  box[3] = y1 < sw->height ? (int)ceilf(y1) : sw->height;
+
+  return box[0] < box[2] && box[1] < box[3];
+}
+
+/* Turn the accumulated rows of box into coverage and composite them,
+   leaving the accumulator zeroed */
+static void
+sw_resolve(NVGJSSoftware* sw, const NVGJSSWPaint* p, const NVGcompositeOperationState* op, const int box[4]) {
+  int w = box[2] - box[0], stride = w + 2;
+
+  for(int y = box[1]; y < box[3]; y++) {
+    float* row = sw->acc + (size_t)(y - box[1]) * stride;
+    float sum = 0;
+    int any = 0;
+
+    for(int x = 0; x < w; x++) {
+      float c;
+
+      sum += row[x];
+      c = fabsf(sum);
+
+      if(sw->antialias)
+        sw->cov[x] = c >= 1 ? 255 : (uint8_t)(c * 255.0f + 0.5f);
+      else
+        sw->cov[x] = c >= 0.5f ? 255 : 0;
+
+      any |= sw->cov[x];
+    }
+
+    memset(row, 0, sizeof(float) * stride);
+
+    if(any)
+      sw_span(sw, p, op, box[0], y, sw->cov, w);
+  }
+}
+
+static inline void
+sw_edge(NVGJSSoftware* sw, const int box[4], const NVGvertex* a, const NVGvertex* b) {
+  sw_line(sw->acc,
+          box[2] - box[0] + 2,
+          box[2] - box[0],
+          box[3] - box[1],
+          a->x * sw->scale[0] - box[0],
+          a->y * sw->scale[1] - box[1],
+          b->x * sw->scale[0] - box[0],
+          b->y * sw->scale[1] - box[1]);
+}
+
+/* Add a triangle with positive orientation, so overlapping triangles of a
+   strip add up instead of cancelling out */
+static void
+sw_triangle(NVGJSSoftware* sw, const int box[4], const NVGvertex* a, const NVGvertex* b, const NVGvertex* c) {
+  float area = (b->x - a->x) * (c->y - a->y) - (c->x - a->x) * (b->y - a->y);
+
+  if(area == 0)
+    return;
+
+  if(area < 0) {
+    const NVGvertex* t = b;
+
+    b = c;
+    c = t;
+  }
+
+  sw_edge(sw, box, a, b);
+  sw_edge(sw, box, b, c);
+  sw_edge(sw, box, c, a);
+}
+
+static void
+sw_bounds(float b[4], const NVGvertex* v, int n) {
+  for(int i = 0; i < n; i++) {
+    b[0] = fminf(b[0], v[i].x);
+    b[1] = fminf(b[1], v[i].y);
+    b[2] = fmaxf(b[2], v[i].x);
+    b[3] = fmaxf(b[3], v[i].y);
+  }
+}
+
+static void
+sw_fill(void* uptr,
+        NVGpaint* paint,
+        NVGcompositeOperationState op,
+        NVGscissor* scissor,
+        float fringe,
+        const float* bounds,
+        const NVGpath* paths,
+        int npaths) {
+  NVGJSSoftware* sw = uptr;
+  NVGJSSWPaint p;
+  int box[4];
+
+  sw_paint(sw, &p, paint, scissor, fringe);
+
+  if(!sw_box(sw, &p, scissor, bounds, box))
+    return;
+
+  for(int i = 0; i < npaths; i++) {
+    const NVGvertex* v = paths[i].fill;
+    int n = paths[i].nfill;
+
+    for(int j = 0; j < n; j++)
+      sw_edge(sw, box, &v[j], &v[j + 1 < n ? j + 1 : 0]);
+  }
+
+  sw_resolve(sw, &p, &op, box);
+}
+
+static void
+sw_stroke(void* uptr,
+          NVGpaint* paint,
+          NVGcompositeOperationState op,
+          NVGscissor* scissor,
+          float fringe,
+          float strokeWidth,
+          const NVGpath* paths,
+          int npaths) {
+  NVGJSSoftware* sw = uptr;
+  NVGJSSWPaint p;
+  float b[4] = {INFINITY, INFINITY, -INFINITY, -INFINITY};
+  int box[4];
+
+  (void)strokeWidth;
+
+  for(int i = 0; i < npaths; i++)
+    sw_bounds(b, paths[i].stroke, paths[i].nstroke);
+
+  sw_paint(sw, &p, paint, scissor, fringe);
+
+  if(!sw_box(sw, &p, scissor, b, box))
+    return;
+
+  /* each path's stroke is a triangle strip */
+  for(int i = 0; i < npaths; i++) {
+    const NVGvertex* v = paths[i].stroke;
+
+    for(int j = 0; j + 2 < paths[i].nstroke; j++)
+      sw_triangle(sw, box, &v[j], &v[j + 1], &v[j + 2]);
+  }
+
+  sw_resolve(sw, &p, &op, box);
+}
+
+/* Affine map from framebuffer pixel to texture coordinates through the
+   triangle a, b, c; returns 0 for a degenerate triangle */
+static int
+sw_uvmap(NVGJSSoftware* sw, float m[6], const NVGvertex* a, const NVGvertex* b, const NVGvertex* c) {
+  float ax = a->x * sw->scale[0], ay = a->y * sw->scale[1];
+  float bx = b->x * sw->scale[0] - ax, by = b->y * sw->scale[1] - ay;
+  float cx = c->x * sw->scale[0] - ax, cy = c->y * sw->scale[1] - ay;
+  float det = bx * cy - cx * by;
+
+  if(det == 0)
+    return 0;
+
+  m[0] = ((b->u - a->u) * cy - (c->u - a->u) * by) / det;
+  m[1] = ((c->u - a->u) * bx - (b->u - a->u) * cx) / det;
+  m[2] = a->u - m[0] * ax - m[1] * ay;
+  m[3] = ((b->v - a->v) * cy - (c->v - a->v) * by) / det;
+  m[4] = ((c->v - a->v) * bx - (b->v - a->v) * cx) / det;
+  m[5] = a->v - m[3] * ax - m[4] * ay;
+  return 1;
+}
+
+static int
+sw_uvmatch(NVGJSSoftware* sw, const float m[6], const NVGvertex* v) {
+  float x = v->x * sw->scale[0], y = v->y * sw->scale[1];
+
+  return fabsf(m[0] * x + m[1] * y + m[2] - v->u) < 1e-4f && fabsf(m[3] * x + m[4] * y + m[5] - v->v) < 1e-4f;
+}
+
+static void
+sw_triangles(void* uptr,
+             NVGpaint* paint,
+             NVGcompositeOperationState op,
+             NVGscissor* scissor,
+             const NVGvertex* verts,
+             int nverts,
+             float fringe) {
+  NVGJSSoftware* sw = uptr;
+  NVGJSSWPaint p;
+
+  sw_paint(sw, &p, paint, scissor, fringe);
+  p.kind = SW_TEXCOORD;
+
+  /* Text arrives as two triangles per glyph quad. Triangles that share one
+     texture mapping are resolved together, so the quad's diagonal is not
+     blended twice. */
+  for(int i = 0; i + 2 < nverts;) {
+    float b[4] = {INFINITY, INFINITY, -INFINITY, -INFINITY};
+    int n = 3, box[4];
+
+    if(!sw_uvmap(sw, p.uv, &verts[i], &verts[i + 1], &verts[i + 2])) {
+      i += 3;
+      continue;
+    }
+
+    while(i + n + 2 < nverts && sw_uvmatch(sw, p.uv, &verts[i + n]) && sw_uvmatch(sw, p.uv, &verts[i + n + 1]) &&
+          sw_uvmatch(sw, p.uv, &verts[i + n + 2]))
+      n += 3;
+
+    sw_bounds(b, &verts[i], n);
+
+    if(sw_box(sw, &p, scissor, b, box)) {
+      for(int j = 0; j < n; j += 3)
+        sw_triangle(sw, box, &verts[i + j], &verts[i + j + 1], &verts[i + j + 2]);
+
+      sw_resolve(sw, &p, &op, box);
+    }
+
+    i += n;
+  }
+}
+
+static void
+sw_delete(void* uptr) {
+  NVGJSSoftware* sw = uptr;
+
+  if(!sw)
+    return;
+
+  for(int i = 0; i < sw->ntextures; i++)
+    free(sw->textures[i].data);
+
+  free(sw->textures);
+  free(sw->acc);
+  free(sw->cov);
+  free(sw);
+}
+
+NVGcontext*
+nvgjs_software_create(uint8_t* pixels, int width, int height, int flags) {
+  NVGparams params;
+  NVGJSSoftware* sw;
+
+  if(!(sw = calloc(1, sizeof(NVGJSSoftware))))
+    return 0;
+
+  sw->pixels = pixels;
+  sw->width = width;
+  sw->height = height;
+  /* NVG_ANTIALIAS, from nanovg_gl.h's NVGcreateFlags */
+  sw->antialias = !!(flags & (1 << 0));
+  sw->scale[0] = sw->scale[1] = 1;
+
+  if(!(sw->acc = calloc((size_t)(width + 2) * height, sizeof(float))) || !(sw->cov = malloc(width))) {
+    sw_delete(sw);
+    return 0;
+  }
+
+  memset(&params, 0, sizeof(params));
+  params.userPtr = sw;
+  /* coverage is computed exactly here, no fringe geometry needed */
+  params.edgeAntiAlias = 0;
+  params.renderCreate = sw_render_create;
+  params.renderCreateTexture = sw_create_texture;
+  params.renderDeleteTexture = sw_delete_texture;
+  params.renderUpdateTexture = sw_update_texture;
+  params.renderGetTextureSize = sw_texture_size;
+  params.renderViewport = sw_viewport;
+  params.renderCancel = sw_cancel;
+  params.renderFlush = sw_flush;
+  params.renderFill = sw_fill;
+  params.renderStroke = sw_stroke;
+  params.renderTriangles = sw_triangles;
+  params.renderDelete = sw_delete;
+
+  /* nvgCreateInternal() calls renderDelete (freeing sw) if it fails */
+  return nvgCreateInternal(&params);
+}
+
+int
+nvgjs_software_is(NVGcontext* nvg) {
+  return nvgInternalParams(nvg)->renderDelete == sw_delete;
+}
+
+void
+nvgjs_software_delete(NVGcontext* nvg) {
+  nvgDeleteInternal(nvg);
+}
@@ -0,0 +1,43 @@
+/**
+ * @file nvgjs-software.h
+ */
+#ifndef NVGJS_SOFTWARE_H
+#define NVGJS_SOFTWARE_H
+
+#include <stdint.h>
+
+struct NVGcontext;
+
+/**
+ * @brief Create a NanoVG context that renders on the CPU into @p pixels.
+ *
+ * The renderer implements NVGparams directly: fills and strokes are
+ * rasterized with exact area coverage (signed-area accumulation, nonzero
+ * winding) instead of NanoVG's anti-aliasing fringes, so the context is
+ * created with edgeAntiAlias off and the coverage is computed here.
+ * Solid-color spans are blended with SSE2 where available.
+ *
+ * Drawing happens immediately in renderFill/renderStroke/renderTriangles;
+ * nvgCancelFrame() cannot undo it.
+ *
+ * @param pixels  @p width * @p height * 4 bytes, premultiplied RGBA8, top row
+ *                first. Owned by the caller and must outlive the context.
+ * @param width   Width in pixels.
+ * @param height  Height in pixels.
+ * @param flags   NVG_ANTIALIAS for coverage anti-aliasing (otherwise pixels
+ *                are either covered or not).
+ * @return The context, or NULL on allocation failure.
+ */
+struct NVGcontext* nvgjs_software_create(uint8_t* pixels, int width, int height, int flags);
+
+/**
+ * @brief Test whether a context was created by nvgjs_software_create().
+ */
+int nvgjs_software_is(struct NVGcontext*);
+
+/**
+ * @brief Delete a software context (the pixel memory is left alone).
+ */
+void nvgjs_software_delete(struct NVGcontext*);
+
+#endif /* defined(NVGJS_SOFTWARE_H) */
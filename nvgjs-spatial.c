@@ -0,0 +1,435 @@
+#include "nvgjs-spatial.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Entries overlapping more cells than this go to the big list */
+#define SPATIAL_MAX_CELLS 16
+
+/* Cell coordinates are clamped to this, so far-off entries share edge cells */
+#define SPATIAL_MAX_COORD (1 << 30)
+
+typedef struct {
+  int32_t id, next;
+} NVGJSSpatialNode;
+
+struct NVGJSSpatial {
+  float cell, inv;
+  float (*boxes)[4]; /* minx, miny, maxx, maxy; minx NaN when left out */
+  uint32_t* stamps;  /* query that last saw each entry */
+  uint32_t stamp;
+  size_t count, size;
+  int32_t* buckets; /* first node, -1 for none */
+  size_t nbuckets;  /* power of 2 */
+  NVGJSSpatialNode* nodes;
+  size_t nnodes, cnodes;
+  int32_t free_node;
+  int32_t* big;
+  size_t nbig, cbig;
+};
+
+static inline int
+spatial_valid(const float b[4]) {
+  return !isnan(b[0]) && !isnan(b[1]) && !isnan(b[2]) && !isnan(b[3]);
+}
+
+static inline int32_t
+spatial_coord(double v) {
+  v = floor(v);
+
+  if(!(v > -SPATIAL_MAX_COORD))
+    return -SPATIAL_MAX_COORD;
+
+  return v < SPATIAL_MAX_COORD ? (int32_t)v : SPATIAL_MAX_COORD;
+}
+
+/* Cells overlapped by @p b grown by @p pad, and how many */
+static uint64_t
+spatial_range(const NVGJSSpatial* s, const float b[4], float pad, int32_t r[4]) {
+  r[0] = spatial_coord(((double)b[0] - pad) * s->inv);
+  r[1] = spatial_coord(((double)b[1] - pad) * s->inv);
+  r[2] = spatial_coord(((double)b[2] + pad) * s->inv);
+  r[3] = spatial_coord(((double)b[3] + pad) * s->inv);
+
+  return (uint64_t)(r[2] - r[0] + 1) * (uint64_t)(r[3] - r[1] + 1);
+}
+
+static inline size_t
+spatial_bucket(const NVGJSSpatial* s, int32_t cx, int32_t cy) {
+  uint32_t h = (uint32_t)cx * 0x9e3779b1u ^ (uint32_t)cy * 0x85ebca77u;
+
+  h ^= h >> 15;
+  return h & (s->nbuckets - 1);
+}
+
+static int
+spatial_link(NVGJSSpatial* s, size_t bucket, int32_t id) {
+  int32_t n;
+
+  if((n = s->free_node) >= 0) {
+    s->free_node = s->nodes[n].next;
+  } else {
+    if(s->nnodes == s->cnodes) {
+      size_t size = s->cnodes ? s->cnodes * 2 : 256;
+      NVGJSSpatialNode* nodes;
+
+      if(!(nodes = realloc(s->nodes, size * sizeof(NVGJSSpatialNode))))
+        return -1;
+
+      s->nodes = nodes;
+      s->cnodes = size;
+    }
+
+    n = s->nnodes++;
+  }
+
+  s->nodes[n].id = id;
+  s->nodes[n].next = s->buckets[bucket];
+  s->buckets[bucket] = n;
+  return 0;
+}
+
+static void
+spatial_unlink(NVGJSSpatial* s, size_t bucket, int32_t id) {
+  int32_t n, *p;
+
+  for(p = &s->buckets[bucket]; (n = *p) >= 0; p = &s->nodes[n].next)
+    if(s->nodes[n].id == id) {
+      *p = s->nodes[n].next;
+      s->nodes[n].next = s->free_node;
+      s->free_node = n;
+      break;
+    }
+}
+
+static int
+spatial_insert(NVGJSSpatial* s, int32_t id) {
+  const float* b = s->boxes[id];
+  int32_t r[4];
+
+  if(spatial_range(s, b, 0, r) > SPATIAL_MAX_CELLS) {
+    if(s->nbig == s->cbig) {
+      size_t size = s->cbig ? s->cbig * 2 : 16;
+      int32_t* big;
+
+      if(!(big = realloc(s->big, size * sizeof(int32_t))))
+        return -1;
+
+      s->big = big;
+      s->cbig = size;
+    }
+
+    s->big[s->nbig++] = id;
+    return 0;
+  }
+
+  for(int32_t cy = r[1]; cy <= r[3]; cy++)
+    for(int32_t cx = r[0]; cx <= r[2]; cx++)
+      if(spatial_link(s, spatial_bucket(s, cx, cy), id)) {
+        /* leave the index as if the entry had not been inserted */
+        for(int32_t y = r[1]; y <= cy; y++)
+          for(int32_t x = r[0]; x <= (y < cy ? r[2] : cx - 1); x++)
+            spatial_unlink(s, spatial_bucket(s, x, y), id);
+
+        return -1;
+      }
+
+  return 0;
+}
+
+static void
+spatial_remove(NVGJSSpatial* s, int32_t id) {
+  const float* b = s->boxes[id];
+  int32_t r[4];
+
+  if(spatial_range(s, b, 0, r) > SPATIAL_MAX_CELLS) {
+    for(size_t i = 0; i < s->nbig; i++)
+      if(s->big[i] == id) {
+        s->big[i] = s->big[--s->nbig];
+        break;
+      }
+
+    return;
+  }
+
+  for(int32_t cy = r[1]; cy <= r[3]; cy++)
+    for(int32_t cx = r[0]; cx <= r[2]; cx++)
+      spatial_unlink(s, spatial_bucket(s, cx, cy), id);
+}
+
+/* (Re)build the grid with at least as many buckets as ids */
+static int
+spatial_rehash(NVGJSSpatial* s, size_t count) {
+  size_t nbuckets = 64;
+  int32_t* buckets;
+
+  while(nbuckets < count)
+    nbuckets *= 2;
+
+  if(!(buckets = malloc(nbuckets * sizeof(int32_t))))
+    return -1;
+
+  free(s->buckets);
+  memset(buckets, 0xff, nbuckets * sizeof(int32_t));
+  s->buckets = buckets;
+  s->nbuckets = nbuckets;
+  s->nnodes = 0;
+  s->free_node = -1;
+  s->nbig = 0;
+
+  for(size_t i = 0; i < s->count; i++)
+    if(spatial_valid(s->boxes[i]) && spatial_insert(s, i)) {
+      /* keep the index consistent: leave out what no longer fits */
+      for(; i < s->count; i++)
+        s->boxes[i][0] = NAN;
+
+      return -1;
+    }
+
+  return 0;
+}
+
+static int
+spatial_reserve(NVGJSSpatial* s, size_t count) {
+  float(*boxes)[4];
+  uint32_t* stamps;
+  size_t size = s->size ? s->size : 64;
+
+  if(count <= s->size)
+    return 0;
+
+  while(size < count)
+    size *= 2;
+
+  if(!(boxes = realloc(s->boxes, size * sizeof(*boxes))))
+    return -1;
+
+  s->boxes = boxes;
+
+  if(!(stamps = realloc(s->stamps, size * sizeof(uint32_t))))
+    return -1;
+
+  memset(stamps + s->size, 0, (size - s->size) * sizeof(uint32_t));
+  s->stamps = stamps;
+  s->size = size;
+  return 0;
+}
+
+/* About four entries per cell, but no smaller than the average entry */
+static float
+spatial_auto_cell(const NVGJSSpatial* s) {
+  double minx = INFINITY, miny = INFINITY, maxx = -INFINITY, maxy = -INFINITY, sides = 0, w, h, cell;
+  size_t n = 0;
+
+  for(size_t i = 0; i < s->count; i++) {
+    const float* b = s->boxes[i];
+
+    if(!spatial_valid(b))
+      continue;
+
+    minx = fmin(minx, b[0]);
+    miny = fmin(miny, b[1]);
+    maxx = fmax(maxx, b[2]);
+    maxy = fmax(maxy, b[3]);
+    sides += fmax(b[2] - b[0], b[3] - b[1]);
+    n++;
+  }
+
+  if(!n)
+    return 16.0f;
+
+  w = maxx - minx;
+  h = maxy - miny;
+  cell = w > 0 && h > 0 ? sqrt(4 * w * h / n) : 4 * fmax(w, h) / n;
+  cell = fmax(cell, sides / n);
+
+  /* all entries on one spot, or infinite ones */
+  if(!(cell > 0 && cell < 1e30))
+    return 16.0f;
+
+  return cell;
+}
+
+static inline void
+spatial_box(float out[4], const float b[4]) {
+  out[0] = fminf(b[0], b[2]);
+  out[1] = fminf(b[1], b[3]);
+  out[2] = fmaxf(b[0], b[2]);
+  out[3] = fmaxf(b[1], b[3]);
+
+  if(!spatial_valid(b))
+    out[0] = NAN;
+}
+
+NVGJSSpatial*
+nvgjs_spatial_new(const float* coords, size_t count, int stride, float cell) {
+  NVGJSSpatial* s;
+
+  if(!(s = calloc(1, sizeof(NVGJSSpatial))))
+    return 0;
+
+  if(!coords)
+    count = 0;
+
+  if(spatial_reserve(s, count))
+    goto fail;
+
+  for(size_t i = 0; i < count; i++) {
+    const float* c = &coords[i * stride];
+    float b[4] = {c[0], c[1], c[stride > 2 ? 2 : 0], c[stride > 2 ? 3 : 1]};
+
+    spatial_box(s->boxes[i], b);
+  }
+
+  s->count = count;
+  s->cell = cell > 0 ? cell : spatial_auto_cell(s);
+  s->inv = 1.0f / s->cell;
+
+  if(spatial_rehash(s, count))
+    goto fail;
+
+  return s;
+
+fail:
+  nvgjs_spatial_free(s);
+  return 0;
+}
+
+void
+nvgjs_spatial_free(NVGJSSpatial* s) {
+  if(!s)
+    return;
+
+  free(s->boxes);
+  free(s->stamps);
+  free(s->buckets);
+  free(s->nodes);
+  free(s->big);
+  free(s);
+}
+
+size_t
+nvgjs_spatial_count(const NVGJSSpatial* s) {
+  return s->count;
+}
+
+float
+nvgjs_spatial_cell(const NVGJSSpatial* s) {
+  return s->cell;
+}
+
+int
+nvgjs_spatial_set(NVGJSSpatial* s, size_t id, const float box[4]) {
+  if(id > s->count || id >= INT32_MAX)
+    return -1;
+
+  if(id == s->count) {
+    if(spatial_reserve(s, id + 1))
+      return -1;
+
+    s->boxes[id][0] = NAN;
+    s->count++;
+
+    if(s->count > s->nbuckets && spatial_rehash(s, s->count * 2)) {
+      s->count--;
+      return -1;
+    }
+  }
+
+  if(spatial_valid(s->boxes[id]))
+    spatial_remove(s, id);
+
+  spatial_box(s->boxes[id], box);
+
+  if(spatial_valid(s->boxes[id]) && spatial_insert(s, id)) {
+    s->boxes[id][0] = NAN;
+    return -1;
+  }
+
+  return 0;
+}
+
+/* Squared distance between two boxes, 0 if they touch */
+static inline float
+spatial_distance2(const float a[4], const float b[4]) {
+  float dx = fmaxf(fmaxf(a[0] - b[2], b[0] - a[2]), 0.0f);
+  float dy = fmaxf(fmaxf(a[1] - b[3], b[1] - a[3]), 0.0f);
+
+  return dx * dx + dy * dy;
+}
+
+static uint32_t
+spatial_next_stamp(NVGJSSpatial* s) {
+  if(++s->stamp == 0) {
+    memset(s->stamps, 0, s->size * sizeof(uint32_t));
+    s->stamp = 1;
+  }
+
+  return s->stamp;
+}
+
+/* Call @p visit for every entry that may lie within @p radius of @p rect:
+   the big list and the grid cells around it, each entry once, or everything
+   when that would be more cells than buckets */
+#define SPATIAL_FOREACH(s, rect, radius, id, visit) \
+  do { \
+    int32_t r_[4]; \
+    uint32_t stamp_; \
+    if(spatial_range(s, rect, radius, r_) > s->nbuckets) { \
+      for(size_t i_ = 0; i_ < s->count; i_++) \
+        if(spatial_valid(s->boxes[i_])) { \
+          id = i_; \
+          visit; \
+        } \
+      break; \
+    } \
+    for(size_t i_ = 0; i_ < s->nbig; i_++) { \
+      id = s->big[i_]; \
+      visit; \
+    } \
+    stamp_ = spatial_next_stamp(s); \
+    for(int32_t cy_ = r_[1]; cy_ <= r_[3]; cy_++) \
+      for(int32_t cx_ = r_[0]; cx_ <= r_[2]; cx_++) \
+        for(int32_t n_ = s->buckets[spatial_bucket(s, cx_, cy_)]; n_ >= 0; n_ = s->nodes[n_].next) { \
+          id = s->nodes[n_].id; \
+          if(s->stamps[id] == stamp_) \
+            continue; \
+          s->stamps[id] = stamp_; \
+          visit; \
+        } \
+  } while(0)
+
+size_t
+nvgjs_spatial_query(NVGJSSpatial* s, const float rect[4], float radius, int32_t* out, size_t max) {
+  float r2 = radius * radius;
+  size_t found = 0;
+  int32_t id;
+
+  SPATIAL_FOREACH(s, rect, radius, id, {
+    if(spatial_distance2(s->boxes[id], rect) <= r2) {
+      if(found < max)
+        out[found] = id;
+
+      found++;
+    }
+  });
+
+  return found;
+}
+
+int32_t
+nvgjs_spatial_nearest(NVGJSSpatial* s, float x, float y, float radius) {
+  const float pt[4] = {x, y, x, y};
+  float best2 = radius * radius, d2;
+  int32_t best = -1, id;
+
+  SPATIAL_FOREACH(s, pt, radius, id, {
+    if((d2 = spatial_distance2(s->boxes[id], pt)) < best2 || (d2 == best2 && id > best)) {
+      best2 = d2;
+      best = id;
+    }
+  });
+
+  return best;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file nvgjs-spatial.h
+ */
+#ifndef NVGJS_SPATIAL_H
+#define NVGJS_SPATIAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Hashed uniform grid over axis-aligned boxes (points are boxes of
+ * size 0), addressed by id 0 .. count - 1.
+ *
+ * Every grid cell an entry overlaps hashes to a bucket listing it, so
+ * coordinates are unbounded and entries move without a rebuild. Entries
+ * covering more than a few cells are kept in a separate list that every
+ * query scans.
+ */
+typedef struct NVGJSSpatial NVGJSSpatial;
+
+/**
+ * @brief Build an index over @p count entries.
+ *
+ * @param coords  2 floats (x, y) or 4 floats (minx, miny, maxx, maxy) per
+ *                entry, by @p stride; NULL for an empty index. Entries with a
+ *                NaN coordinate are left out until set.
+ * @param cell    Grid cell size, or 0 to derive it from the entries' extent
+ *                and sizes.
+ * @return The index, or NULL on allocation failure.
+ */
+NVGJSSpatial* nvgjs_spatial_new(const float* coords, size_t count, int stride, float cell);
+
+void nvgjs_spatial_free(NVGJSSpatial*);
+
+/**
+ * @brief Number of ids, including those left out.
+ */
+size_t nvgjs_spatial_count(const NVGJSSpatial*);
+
+/**
+ * @brief Grid cell size in use.
+ */
+float nvgjs_spatial_cell(const NVGJSSpatial*);
+
+/**
+ * @brief Move entry @p id to @p box (minx, miny, maxx, maxy, in any order),
+ * or leave it out with a NaN coordinate.
+ *
+ * @param id  An existing id, or nvgjs_spatial_count() to append one.
+ * @return 0 on success, -1 if @p id is out of range or on allocation
+ *         failure.
+ */
+int nvgjs_spatial_set(NVGJSSpatial*, size_t id, const float box[4]);
+
+/**
+ * @brief Find the entries within @p radius of @p rect (minx, miny, maxx,
+ * maxy; a point when both corners are equal), boxes touching it included.
+ *
+ * @param out  Receives the first @p max ids found, in no particular order.
+ * @return Number of entries found, which may exceed @p max.
+ */
+size_t nvgjs_spatial_query(NVGJSSpatial*, const float rect[4], float radius, int32_t* out, size_t max);
+
+/**
+ * @brief The entry closest to (@p x, @p y) and no further than @p radius,
+ * measured to the edge of its box (0 inside). Ties go to the highest id, the
+ * one drawn last.
+ *
+ * @return Its id, or -1.
+ */
+int32_t nvgjs_spatial_nearest(NVGJSSpatial*, float x, float y, float radius);
+
+#endif /* defined(NVGJS_SPATIAL_H) */
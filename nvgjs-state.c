@@ -0,0 +1,114 @@
+#include "nvgjs-state.h"
+#include "nvgjs-utils.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+/* Serialises JS_NewClassID() */
+static pthread_mutex_t state_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Holds the state; installed as the prototype of this class in each context,
+   which is the only reference, so it is finalized by JS_FreeContext() */
+static JSClassID nvgjs_state_class_id;
+
+static void
+nvgjs_state_finalizer(JSRuntime* rt, JSValue val) {
+  NVGJSState* st;
+
+  if(!(st = JS_GetOpaque(val, nvgjs_state_class_id)))
+    return;
+
+  if(st->finalize)
+    st->finalize(rt, st);
+
+  JS_FreeAtomRT(rt, st->atom_length);
+  JS_FreeAtomRT(rt, st->atom_next);
+  JS_FreeAtomRT(rt, st->atom_done);
+  JS_FreeAtomRT(rt, st->atom_value);
+  JS_FreeAtomRT(rt, st->atom_iterator);
+  JS_FreeValueRT(rt, st->float32array_ctor);
+  JS_FreeValueRT(rt, st->typedarray_ctor);
+
+  for(size_t i = 0; i < countof(st->color_keys); i++)
+    JS_FreeAtomRT(rt, st->color_keys[i]);
+  for(size_t i = 0; i < countof(st->transform_keys); i++)
+    JS_FreeAtomRT(rt, st->transform_keys[i]);
+  for(size_t i = 0; i < countof(st->vector_keys); i++)
+    JS_FreeAtomRT(rt, st->vector_keys[i]);
+  for(size_t i = 0; i < countof(st->bounds_keys); i++)
+    JS_FreeAtomRT(rt, st->bounds_keys[i]);
+  for(size_t i = 0; i < countof(st->size_keys); i++)
+    JS_FreeAtomRT(rt, st->size_keys[i]);
+
+  JS_FreeValueRT(rt, st->transform_ctor);
+  js_free_rt(rt, st->profile);
+  js_free_rt(rt, st);
+}
+
+static JSClassDef nvgjs_state_class = {
+ .class_name = "NVGstate",
+ .finalizer = nvgjs_state_finalizer,
+};
+
+void
+nvgjs_state_register(JSContext* ctx, JSClassID* pclass_id, const JSClassDef* class_def) {
+  JSRuntime* rt = JS_GetRuntime(ctx);
+
+  pthread_mutex_lock(&state_lock);
+  JS_NewClassID(pclass_id);
+  pthread_mutex_unlock(&state_lock);
+
+  if(!JS_IsRegisteredClass(rt, *pclass_id))
+    JS_NewClass(rt, *pclass_id, class_def);
+}
+
+/* The prototype is JS_NULL in contexts of the runtime without a state */
+NVGJSState*
+nvgjs_state(JSContext* ctx) {
+  NVGJSState* st;
+  JSValue obj;
+
+  if(!JS_IsRegisteredClass(JS_GetRuntime(ctx), nvgjs_state_class_id))
+    return 0;
+
+  obj = JS_GetClassProto(ctx, nvgjs_state_class_id);
+  st = JS_GetOpaque(obj, nvgjs_state_class_id);
+  JS_FreeValue(ctx, obj);
+  return st;
+}
+
+NVGJSState*
+nvgjs_state_new(JSContext* ctx) {
+  NVGJSState* st;
+  JSValue obj;
+
+  if((st = nvgjs_state(ctx)))
+    return st;
+
+  nvgjs_state_register(ctx, &nvgjs_state_class_id, &nvgjs_state_class);
+
+  if(!(st = js_mallocz(ctx, sizeof(NVGJSState))))
+    return 0;
+
+  if(JS_IsException((obj = JS_NewObjectClass(ctx, nvgjs_state_class_id)))) {
+    js_free(ctx, st);
+    return 0;
+  }
+
+  st->ctx = ctx;
+  st->float32array_ctor = JS_UNDEFINED;
+  st->typedarray_ctor = JS_UNDEFINED;
+  st->transform_ctor = JS_UNDEFINED;
+
+  for(int i = 0; i < NVGJS_READBACK_SLOTS; i++) {
+    st->readback_promise[i].resolve = JS_UNDEFINED;
+    st->readback_promise[i].reject = JS_UNDEFINED;
+    st->readback_promise[i].target = JS_UNDEFINED;
+  }
+
+  nvgjs_worker_init(&st->worker);
+  JS_SetOpaque(obj, st);
+
+  JS_SetClassProto(ctx, nvgjs_state_class_id, obj);
+  return st;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file nvgjs-state.h
+ */
+#ifndef NVGJS_STATE_H
+#define NVGJS_STATE_H
+
+#include <quickjs.h>
+
+#include "nvgjs-profile.h"
+#include "nvgjs-readback.h"
+#include "nvgjs-worker.h"
+
+/**
+ * @brief Module state of one JSContext.
+ *
+ * Everything that holds atoms, JS values or pending work lives here instead
+ * of in statics, so runtimes on different threads never share any of it.
+ * Created by nvgjs_state_new() from module init and freed together with the
+ * context.
+ */
+typedef struct NVGJSState {
+  JSContext* ctx;
+
+  /* nvgjs-utils.c: atoms used by the readers and, without
+     JS_GetTypedArrayType(), the constructors for JS_IsInstanceOf() */
+  JSAtom atom_length, atom_next, atom_done, atom_value, atom_iterator;
+  JSValue float32array_ctor, typedarray_ctor;
+
+  /* nvgjs-module.c: property-map keys */
+  JSAtom color_keys[4], transform_keys[6], vector_keys[2], bounds_keys[4], size_keys[2];
+  JSValue transform_ctor;
+
+  /* ReadPixelsAsync() */
+  NVGJSReadbackRing readback;
+  struct {
+    JSValue resolve, reject, target;
+  } readback_promise[NVGJS_READBACK_SLOTS];
+
+  /* EncodeImage(), SaveImage() */
+  NVGJSWorker worker;
+
+  /* TraceStart(), ProfileStart(): Context methods replaced by wrappers
+     while either is on; profile has an entry per nvgjs_context_methods */
+  BOOL trace_methods, profile_methods, wrapped_methods;
+  NVGJSProfileEntry* profile;
+
+  /** Called when the context is freed, before the fields above are released */
+  void (*finalize)(JSRuntime*, struct NVGJSState*);
+} NVGJSState;
+
+/**
+ * @brief Get the state of @p ctx, creating it on first use.
+ *
+ * The state is kept alive by the context itself (as the prototype of a
+ * private class), so it is freed when the context is.
+ *
+ * @return The state, or NULL with a pending exception.
+ */
+NVGJSState* nvgjs_state_new(JSContext*);
+
+/**
+ * @brief Get the state of @p ctx.
+ *
+ * Read from the context itself, without locking.
+ *
+ * @return The state, or NULL if nvgjs_state_new() was never called.
+ */
+NVGJSState* nvgjs_state(JSContext*);
+
+/**
+ * @brief Register a class in the runtime of @p ctx.
+ *
+ * Class ids are process-wide while class definitions are per runtime;
+ * JS_NewClassID() is serialised so module init may run on several threads
+ * at once, and a runtime that already has the class is left alone.
+ */
+void nvgjs_state_register(JSContext*, JSClassID*, const JSClassDef*);
+
+#endif /* defined(NVGJS_STATE_H) */
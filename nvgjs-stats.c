@@ -0,0 +1,265 @@
+#include "nanovg.h"
+#include "nvgjs-nanovg.h"
+#include "nvgjs-stats.h"
+#include "nvgjs-trace.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static inline NVGJSStats*
+stats_of(NVGcontext* nvg) {
+  NVGJSContextData* d = nvgjs_nvg_data(nvg);
+
+  return d ? d->stats : 0;
+}
+
+
+static void
+stats_paths(NVGJSStats* s, const NVGpath* paths, int npaths, int fill) {
+  s->frame[NVGJS_STAT_PATHS] += npaths;
+
+  for(int i = 0; i < npaths; i++) {
+    int nfill = fill ? paths[i].nfill : 0, nstroke = paths[i].nstroke;
+
+    /* fans and strips: n - 2 triangles each */
+    s->frame[NVGJS_STAT_TRIANGLES] += (nfill > 2 ? nfill - 2 : 0) + (nstroke > 2 ? nstroke - 2 : 0);
+    s->frame[NVGJS_STAT_VERTICES] += nfill + nstroke;
+  }
+}
+
+static void
+stats_fill(void* uptr,
+           NVGpaint* paint,
+           NVGcompositeOperationState op,
+           NVGscissor* scissor,
+           float fringe,
+           const float* bounds,
+           const NVGpath* paths,
+           int npaths) {
+  NVGJSContextData* d = uptr;
+  NVGJSStats* s = d->stats;
+
+  s->frame[NVGJS_STAT_FILLS]++;
+  stats_paths(s, paths, npaths, 1);
+  d->params.renderFill(d->params.userPtr, paint, op, scissor, fringe, bounds, paths, npaths);
+}
+
+static void
+stats_stroke(void* uptr,
+             NVGpaint* paint,
+             NVGcompositeOperationState op,
+             NVGscissor* scissor,
+             float fringe,
+             float strokeWidth,
+             const NVGpath* paths,
+             int npaths) {
+  NVGJSContextData* d = uptr;
+  NVGJSStats* s = d->stats;
+
+  s->frame[NVGJS_STAT_STROKES]++;
+  stats_paths(s, paths, npaths, 0);
+  d->params.renderStroke(d->params.userPtr, paint, op, scissor, fringe, strokeWidth, paths, npaths);
+}
+
+static void
+stats_triangles(void* uptr,
+                NVGpaint* paint,
+                NVGcompositeOperationState op,
+                NVGscissor* scissor,
+                const NVGvertex* verts,
+                int nverts,
+                float fringe) {
+  NVGJSContextData* d = uptr;
+  NVGJSStats* s = d->stats;
+
+  s->frame[NVGJS_STAT_TRIANGLES] += nverts / 3;
+  s->frame[NVGJS_STAT_VERTICES] += nverts;
+  d->params.renderTriangles(d->params.userPtr, paint, op, scissor, verts, nverts, fringe);
+}
+
+static int
+stats_create_texture(void* uptr, int type, int w, int h, int flags, const unsigned char* data) {
+  NVGJSContextData* d = uptr;
+  NVGJSStats* s = d->stats;
+  NVGJS_TRACE_BEGIN(t0);
+  int id = d->params.renderCreateTexture(d->params.userPtr, type, w, h, flags, data);
+
+  NVGJS_TRACE_END(t0, "CreateTexture", "image", data ? (int64_t)w * h * (type == NVG_TEXTURE_RGBA ? 4 : 1) : -1);
+
+  if(id && type == NVG_TEXTURE_RGBA) {
+    if(s->nimages == s->cimages) {
+      int n = s->cimages ? s->cimages * 2 : 8, *images;
+
+      if((images = realloc(s->images, sizeof(int) * n))) {
+        s->images = images;
+        s->cimages = n;
+      }
+    }
+
+    if(s->nimages < s->cimages)
+      s->images[s->nimages++] = id;
+  }
+
+  if(data) {
+    s->frame[NVGJS_STAT_TEXTURE_UPLOADS]++;
+    s->frame[NVGJS_STAT_TEXTURE_BYTES] += (double)w * h * (type == NVG_TEXTURE_RGBA ? 4 : 1);
+  }
+
+  /* a new (larger) font atlas */
+  if(type != NVG_TEXTURE_RGBA)
+    s->frame[NVGJS_STAT_FONT_UPDATES]++;
+
+  return id;
+}
+
+static int
+stats_delete_texture(void* uptr, int image) {
+  NVGJSContextData* d = uptr;
+  NVGJSStats* s = d->stats;
+
+  for(int i = 0; i < s->nimages; i++)
+    if(s->images[i] == image) {
+      s->images[i] = s->images[--s->nimages];
+      break;
+    }
+
+  return d->params.renderDeleteTexture(d->params.userPtr, image);
+}
+
+static int
+stats_update_texture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data) {
+  NVGJSContextData* d = uptr;
+  NVGJSStats* s = d->stats;
+  int rgba = 0;
+
+  for(int i = 0; i < s->nimages; i++)
+    if(s->images[i] == image) {
+      rgba = 1;
+      break;
+    }
+
+  s->frame[NVGJS_STAT_TEXTURE_UPLOADS]++;
+  s->frame[NVGJS_STAT_TEXTURE_BYTES] += (double)w * h * (rgba ? 4 : 1);
+
+  if(!rgba)
+    s->frame[NVGJS_STAT_FONT_UPDATES]++;
+
+  NVGJS_TRACE_BEGIN(t0);
+  int ret = d->params.renderUpdateTexture(d->params.userPtr, image, x, y, w, h, data);
+
+  NVGJS_TRACE_END(t0, "UpdateTexture", "image", (int64_t)w * h * (rgba ? 4 : 1));
+  return ret;
+}
+
+int
+nvgjs_stats_attach(NVGcontext* nvg, double* out, double* gpu) {
+  NVGparams* params = nvgInternalParams(nvg);
+  NVGJSContextData* d;
+  NVGJSStats* s;
+
+  if(!(d = nvgjs_nvg_data(nvg)) || d->stats)
+    return -1;
+
+  if(!(s = calloc(1, sizeof(NVGJSStats))))
+    return -1;
+
+  s->orig = *params;
+  s->out = out;
+  s->gpu = gpu;
+  d->stats = s;
+
+  params->renderFill = stats_fill;
+  params->renderStroke = stats_stroke;
+  params->renderTriangles = stats_triangles;
+  params->renderCreateTexture = stats_create_texture;
+  params->renderDeleteTexture = stats_delete_texture;
+  params->renderUpdateTexture = stats_update_texture;
+  return 0;
+}
+
+void
+nvgjs_stats_detach(NVGcontext* nvg) {
+  NVGJSContextData* d;
+  NVGJSStats* s;
+  NVGparams* params;
+
+  if(!(d = nvgjs_nvg_data(nvg)) || !(s = d->stats))
+    return;
+
+  d->stats = 0;
+  params = nvgInternalParams(nvg);
+  params->renderFill = s->orig.renderFill;
+  params->renderStroke = s->orig.renderStroke;
+  params->renderTriangles = s->orig.renderTriangles;
+  params->renderCreateTexture = s->orig.renderCreateTexture;
+  params->renderDeleteTexture = s->orig.renderDeleteTexture;
+  params->renderUpdateTexture = s->orig.renderUpdateTexture;
+
+  free(s->images);
+  free(s);
+}
+
+NVGJSGpuTimer*
+nvgjs_stats_gputimer(NVGcontext* nvg) {
+  NVGJSStats* s = stats_of(nvg);
+
+  return s && s->gpu ? &s->timer : 0;
+}
+
+void
+nvgjs_stats_gpu(NVGcontext* nvg, const double* ms, int n) {
+  NVGJSStats* s = stats_of(nvg);
+
+  if(!s || !s->gpu || n <= 0)
+    return;
+
+  if(n > NVGJS_STATS_GPU_HISTORY) {
+    ms += n - NVGJS_STATS_GPU_HISTORY;
+    n = NVGJS_STATS_GPU_HISTORY;
+  }
+
+  memmove(s->gpu + n, s->gpu, sizeof(double) * (NVGJS_STATS_GPU_HISTORY - n));
+
+  /* newest first */
+  for(int i = 0; i < n; i++)
+    s->gpu[i] = ms[n - 1 - i];
+}
+
+double*
+nvgjs_stats(NVGcontext* nvg) {
+  NVGJSStats* s = stats_of(nvg);
+
+  return s ? s->frame : 0;
+}
+
+void
+nvgjs_stats_begin(NVGcontext* nvg) {
+  NVGJSStats* s = stats_of(nvg);
+
+  if(s)
+    s->begin_ns = nvgjs_trace_now();
+}
+
+void
+nvgjs_stats_flush(NVGcontext* nvg) {
+  NVGJSStats* s = stats_of(nvg);
+
+  if(s)
+    s->flush_ns = nvgjs_trace_now();
+}
+
+void
+nvgjs_stats_end(NVGcontext* nvg) {
+  NVGJSStats* s = stats_of(nvg);
+  int64_t now;
+
+  if(!s)
+    return;
+
+  now = nvgjs_trace_now();
+  s->frame[NVGJS_STAT_FRAME_MS] = s->begin_ns ? (now - s->begin_ns) / 1e6 : 0;
+  s->frame[NVGJS_STAT_FLUSH_MS] = s->flush_ns ? (now - s->flush_ns) / 1e6 : 0;
+  memcpy(s->out, s->frame, sizeof(s->frame));
+  memset(s->frame, 0, sizeof(s->frame));
+  s->begin_ns = s->flush_ns = 0;
+}
@@ -0,0 +1,110 @@
+/**
+ * @file nvgjs-stats.h
+ */
+#ifndef NVGJS_STATS_H
+#define NVGJS_STATS_H
+
+#include <stdint.h>
+
+#include "nanovg.h"
+#include "nvgjs-gputimer.h"
+
+/**
+ * @brief Length of the GPU time history (Context.gpuTimeMs), in frames.
+ */
+#define NVGJS_STATS_GPU_HISTORY 60
+
+/**
+ * @brief Indices into the per-frame statistics (Context.stats).
+ */
+enum {
+  NVGJS_STAT_CALLS,            /* binding calls on the context */
+  NVGJS_STAT_PATHS,            /* paths handed to the renderer by fills and strokes */
+  NVGJS_STAT_FILLS,            /* renderFill calls */
+  NVGJS_STAT_STROKES,          /* renderStroke calls */
+  NVGJS_STAT_TRIANGLES,        /* triangles in fills, strokes and text */
+  NVGJS_STAT_VERTICES,         /* vertices of the same */
+  NVGJS_STAT_DRAWS,            /* GL draw calls issued by the flush */
+  NVGJS_STAT_TEXTURE_UPLOADS,  /* texture creations with data and updates */
+  NVGJS_STAT_TEXTURE_BYTES,    /* bytes of the same */
+  NVGJS_STAT_FONT_UPDATES,     /* font atlas uploads (part of the above) */
+  NVGJS_STAT_FRAME_MS,         /* BeginFrame to the end of EndFrame */
+  NVGJS_STAT_FLUSH_MS,         /* nvgEndFrame() alone */
+  NVGJS_STAT_COUNT,
+};
+
+/**
+ * @brief Counters of a context, reached through its record (see
+ * nvgjs-nanovg.h).
+ */
+typedef struct NVGJSStats {
+  NVGparams orig; /* the record's callbacks, restored by detach */
+  double frame[NVGJS_STAT_COUNT];
+  double *out, *gpu;
+  NVGJSGpuTimer timer;
+  int64_t begin_ns, flush_ns;
+  /* RGBA textures; updates of any other are the font atlas */
+  int *images, nimages, cimages;
+} NVGJSStats;
+
+/**
+ * @brief Start counting for a context.
+ *
+ * Interposes counting wrappers on the renderer callbacks in the context's
+ * NVGparams. Their userPtr is the context's record (see nvgjs-nanovg.h),
+ * which holds the counters and the renderer's own callbacks.
+ *
+ * @param nvg  Context.
+ * @param out  NVGJS_STAT_COUNT doubles receiving each completed frame (see
+ *             nvgjs_stats_end()); must stay valid until nvgjs_stats_detach().
+ * @param gpu  NVGJS_STATS_GPU_HISTORY doubles for the GPU times collected by
+ *             nvgjs_stats_gpu(), or NULL for contexts without GL.
+ * @return 0 on success, -1 on allocation failure, if the context has no
+ *         record (see nvgjs_nvg_data_new()) or is attached already.
+ */
+int nvgjs_stats_attach(struct NVGcontext* nvg, double* out, double* gpu);
+
+/**
+ * @brief Stop counting and restore the callbacks. Must be called before
+ * the context is deleted; no-op if it was not attached. Timer queries are
+ * not deleted here: do that first with nvgjs_gputimer_free() if GL is
+ * still current.
+ */
+void nvgjs_stats_detach(struct NVGcontext* nvg);
+
+/**
+ * @brief The context's timer query ring, NULL unless attached with a GPU
+ * history. The caller owns the GL side (see nvgjs-gputimer.h).
+ */
+NVGJSGpuTimer* nvgjs_stats_gputimer(struct NVGcontext* nvg);
+
+/**
+ * @brief Add GPU times (oldest first) to the front of the history, moving
+ * older entries back.
+ */
+void nvgjs_stats_gpu(struct NVGcontext* nvg, const double* ms, int n);
+
+/**
+ * @brief Counters of the frame in progress, NULL if not attached.
+ */
+double* nvgjs_stats(struct NVGcontext* nvg);
+
+/**
+ * @brief Note the start of a frame (nvgBeginFrame()).
+ */
+void nvgjs_stats_begin(struct NVGcontext* nvg);
+
+/**
+ * @brief Note the start of the flush, just before nvgEndFrame().
+ */
+void nvgjs_stats_flush(struct NVGcontext* nvg);
+
+/**
+ * @brief Publish the frame to @p out and reset the counters.
+ *
+ * Counting runs from one nvgjs_stats_end() to the next, so work between
+ * frames (image uploads, font loading) is charged to the frame after it.
+ */
+void nvgjs_stats_end(struct NVGcontext* nvg);
+
+#endif /* defined(NVGJS_STATS_H) */
@@ -0,0 +1,950 @@
+#include "nanovg.h"
+#include "nvgjs-svg.h"
+#include "nvgjs-image.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Output is flushed to the file descriptor in chunks of this size */
+#define SVG_CHUNK 65536
+
+typedef struct {
+  int id, type, width, height, flags;
+  int version;    /* bumped by every update */
+  int emitted;    /* version last written as an <image> def, 0 if none */
+  uint8_t* data;  /* 1 (NVG_TEXTURE_ALPHA) or 4 bytes per texel */
+} NVGJSSVGTexture;
+
+typedef struct {
+  int fd, flags, error, finished;
+  int64_t size;         /* bytes written to fd so far */
+  char* buf;            /* pending output; the whole document in memory mode */
+  size_t len, cap;
+  NVGJSSVGTexture* textures;
+  int ntextures, ctextures, texture_id;
+  int next_id;          /* for the ids of defs */
+  /* last scissor written as a <clipPath> */
+  float scissor_xform[6], scissor_extent[2];
+  int scissor_id;
+  /* tint filters for alpha textures, by color */
+  struct {
+    uint32_t rgba;
+    int id;
+  } * tints;
+  int ntints;
+} NVGJSSVG;
+
+/* Hand the buffer to the file descriptor (no-op in memory mode) */
+static void
+svg_flush(NVGJSSVG* svg) {
+  size_t pos = 0;
+
+  if(svg->fd < 0)
+    return;
+
+  while(pos < svg->len && !svg->error) {
+    ssize_t r = write(svg->fd, svg->buf + pos, svg->len - pos);
+
+    if(r < 0 && errno != EINTR)
+      svg->error = errno;
+    else if(r > 0)
+      pos += r;
+  }
+
+  svg->size += pos;
+  svg->len = 0;
+}
+
+/* Make room for n more bytes; returns the write position or NULL */
+static char*
+svg_reserve(NVGJSSVG* svg, size_t n) {
+  if(svg->len + n > svg->cap && svg->fd >= 0)
+    svg_flush(svg);
+
+  if(svg->len + n > svg->cap) {
+    size_t cap = svg->cap ? svg->cap : SVG_CHUNK;
+    char* buf;
+
+    while(cap < svg->len + n)
+      cap *= 2;
+
+    if(!(buf = realloc(svg->buf, cap))) {
+      svg->error = ENOMEM;
+      return 0;
+    }
+
+    svg->buf = buf;
+    svg->cap = cap;
+  }
+
+  return svg->buf + svg->len;
+}
+
+static void
+svg_write(NVGJSSVG* svg, const char* s, size_t n) {
+  char* p;
+
+  if((p = svg_reserve(svg, n))) {
+    memcpy(p, s, n);
+    svg->len += n;
+  }
+}
+
+static void
+svg_puts(NVGJSSVG* svg, const char* s) {
+  svg_write(svg, s, strlen(s));
+}
+
+static void
+svg_printf(NVGJSSVG* svg, const char* fmt, ...) {
+  va_list ap;
+  size_t room = 256;
+  char* p;
+  int n;
+
+  for(;;) {
+    if(!(p = svg_reserve(svg, room)))
+      return;
+
+    va_start(ap, fmt);
+    n = vsnprintf(p, room, fmt, ap);
+    va_end(ap);
+
+    if(n < 0)
+      return;
+
+    if((size_t)n < room)
+      break;
+
+    room = n + 1;
+  }
+
+  svg->len += n;
+}
+
+/* A coordinate with at most two decimals and no trailing zeros */
+static void
+svg_num(NVGJSSVG* svg, double f) {
+  char tmp[32], *e = tmp + sizeof(tmp), *p = e;
+  int64_t v;
+  int neg, frac;
+
+  if(!isfinite(f) || fabs(f) > 1e15)
+    f = 0;
+
+  v = llround(f * 100);
+
+  if((neg = v < 0))
+    v = -v;
+
+  frac = v % 100;
+  v /= 100;
+
+  if(frac) {
+    if(frac % 10)
+      *--p = '0' + frac % 10;
+
+    *--p = '0' + frac / 10;
+    *--p = '.';
+  }
+
+  do
+    *--p = '0' + v % 10;
+  while((v /= 10));
+
+  if(neg)
+    *--p = '-';
+
+  svg_write(svg, p, e - p);
+}
+
+static void
+svg_point(NVGJSSVG* svg, double x, double y) {
+  svg_num(svg, x);
+  svg_write(svg, " ", 1);
+  svg_num(svg, y);
+}
+
+/* matrix(a b c d e f) of a NanoVG transform */
+static void
+svg_matrix(NVGJSSVG* svg, const char* attr, const float m[6]) {
+  /* adding 0 turns -0 into 0 */
+  svg_printf(svg, " %s=\"matrix(%g %g %g %g ", attr, m[0] + 0.0, m[1] + 0.0, m[2] + 0.0, m[3] + 0.0);
+  svg_point(svg, m[4], m[5]);
+  svg_puts(svg, ")\"");
+}
+
+/* #rrggbb plus opacity="a" when translucent */
+static void
+svg_color(NVGJSSVG* svg, const char* attr, NVGcolor c) {
+  int r = (int)(fminf(fmaxf(c.r, 0), 1) * 255 + 0.5f);
+  int g = (int)(fminf(fmaxf(c.g, 0), 1) * 255 + 0.5f);
+  int b = (int)(fminf(fmaxf(c.b, 0), 1) * 255 + 0.5f);
+
+  svg_printf(svg, " %s=\"#%02x%02x%02x\"", attr, r, g, b);
+
+  if(c.a < 1)
+    svg_printf(svg, " %s-opacity=\"%.3g\"", attr, fmaxf(c.a, 0));
+}
+
+static void
+svg_base64(NVGJSSVG* svg, const uint8_t* data, size_t len) {
+  static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  char* p;
+  size_t i;
+
+  if(!(p = svg_reserve(svg, (len + 2) / 3 * 4)))
+    return;
+
+  for(i = 0; i + 2 < len; i += 3) {
+    uint32_t v = (uint32_t)data[i] << 16 | (uint32_t)data[i + 1] << 8 | data[i + 2];
+
+    *p++ = digits[v >> 18];
+    *p++ = digits[(v >> 12) & 63];
+    *p++ = digits[(v >> 6) & 63];
+    *p++ = digits[v & 63];
+  }
+
+  if(i < len) {
+    uint32_t v = (uint32_t)data[i] << 16 | (i + 1 < len ? (uint32_t)data[i + 1] << 8 : 0);
+
+    *p++ = digits[v >> 18];
+    *p++ = digits[(v >> 12) & 63];
+    *p++ = i + 1 < len ? digits[(v >> 6) & 63] : '=';
+    *p++ = '=';
+  }
+
+  svg->len = p - svg->buf;
+}
+
+static NVGJSSVGTexture*
+svg_texture(NVGJSSVG* svg, int id) {
+  if(id <= 0)
+    return 0;
+
+  for(int i = 0; i < svg->ntextures; i++)
+    if(svg->textures[i].id == id)
+      return &svg->textures[i];
+
+  return 0;
+}
+
+static int
+svg_render_create(void* uptr) {
+  (void)uptr;
+  return 1;
+}
+
+static int
+svg_create_texture(void* uptr, int type, int w, int h, int flags, const unsigned char* data) {
+  NVGJSSVG* svg = uptr;
+  NVGJSSVGTexture* tex = 0;
+  size_t size = (size_t)w * h * (type == NVG_TEXTURE_RGBA ? 4 : 1);
+
+  for(int i = 0; i < svg->ntextures; i++)
+    if(svg->textures[i].id == 0) {
+      tex = &svg->textures[i];
+      break;
+    }
+
+  if(!tex) {
+    if(svg->ntextures + 1 > svg->ctextures) {
+      int n = svg->ctextures ? svg->ctextures * 2 : 4;
+      NVGJSSVGTexture* textures;
+
+      if(!(textures = realloc(svg->textures, sizeof(NVGJSSVGTexture) * n)))
+        return 0;
+
+      svg->textures = textures;
+      svg->ctextures = n;
+    }
+
+    tex = &svg->textures[svg->ntextures++];
+  }
+
+  memset(tex, 0, sizeof(*tex));
+
+  if(!(tex->data = data ? malloc(size) : calloc(1, size)))
+    return 0;
+
+  if(data)
+    memcpy(tex->data, data, size);
+
+  tex->id = ++svg->texture_id;
+  tex->type = type;
+  tex->width = w;
+  tex->height = h;
+  tex->flags = flags;
+  tex->version = 1;
+  return tex->id;
+}
+
+static int
+svg_delete_texture(void* uptr, int image) {
+  NVGJSSVGTexture* tex;
+
+  if(!(tex = svg_texture(uptr, image)))
+    return 0;
+
+  free(tex->data);
+  memset(tex, 0, sizeof(*tex));
+  return 1;
+}
+
+/* data is the whole image (row length = texture width), as with GL_UNPACK_ROW_LENGTH */
+static int
+svg_update_texture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data) {
+  NVGJSSVGTexture* tex;
+  int bpp;
+
+  if(!(tex = svg_texture(uptr, image)))
+    return 0;
+
+  bpp = tex->type == NVG_TEXTURE_RGBA ? 4 : 1;
+
+  for(int row = y; row < y + h; row++)
+    memcpy(tex->data + ((size_t)row * tex->width + x) * bpp,
+           data + ((size_t)row * tex->width + x) * bpp,
+           (size_t)w * bpp);
+
+  tex->version++;
+  return 1;
+}
+
+static int
+svg_texture_size(void* uptr, int image, int* w, int* h) {
+  NVGJSSVGTexture* tex;
+
+  if(!(tex = svg_texture(uptr, image)))
+    return 0;
+
+  *w = tex->width;
+  *h = tex->height;
+  return 1;
+}
+
+static void
+svg_viewport(void* uptr, float width, float height, float ratio) {
+  (void)uptr;
+  (void)width;
+  (void)height;
+  (void)ratio;
+}
+
+static void
+svg_cancel(void* uptr) {
+  (void)uptr;
+}
+
+static void
+svg_flush_frame(void* uptr) {
+  (void)uptr;
+}
+
+/* Write the texture as a PNG <image> def unless its current contents
+   already are; alpha textures become white with that alpha, premultiplied
+   ones are converted back to straight alpha */
+static void
+svg_image(NVGJSSVG* svg, NVGJSSVGTexture* tex) {
+  size_t n = (size_t)tex->width * tex->height, len;
+  uint8_t *rgba, *png;
+
+  if(tex->emitted == tex->version)
+    return;
+
+  if(!(rgba = malloc(n * 4))) {
+    svg->error = ENOMEM;
+    return;
+  }
+
+  for(size_t i = 0; i < n; i++) {
+    uint8_t* d = rgba + i * 4;
+
+    if(tex->type != NVG_TEXTURE_RGBA) {
+      d[0] = d[1] = d[2] = 255;
+      d[3] = tex->data[i];
+    } else if((tex->flags & NVG_IMAGE_PREMULTIPLIED) && tex->data[i * 4 + 3]) {
+      const uint8_t* s = tex->data + i * 4;
+
+      for(int c = 0; c < 3; c++)
+        d[c] = s[c] >= s[3] ? 255 : (s[c] * 255 + s[3] / 2) / s[3];
+
+      d[3] = s[3];
+    } else {
+      memcpy(d, tex->data + i * 4, 4);
+    }
+  }
+
+  png = nvgjs_image_encode(NVGJS_IMAGE_PNG, rgba, tex->width, tex->height, NVGJS_IMAGE_ALPHA, &len);
+  free(rgba);
+
+  if(!png) {
+    svg->error = ENOMEM;
+    return;
+  }
+
+  svg_printf(svg,
+             "<defs><image id=\"t%d_%d\" width=\"%d\" height=\"%d\" preserveAspectRatio=\"none\"%s"
+             " xlink:href=\"data:image/png;base64,",
+             tex->id,
+             tex->version,
+             tex->width,
+             tex->height,
+             tex->flags & NVG_IMAGE_NEAREST ? " style=\"image-rendering:pixelated\"" : "");
+  svg_base64(svg, png, len);
+  svg_puts(svg, "\"/></defs>\n");
+  free(png);
+
+  tex->emitted = tex->version;
+}
+
+/* Filter that paints the alpha of its input in color c; written once per
+   color. Returns the filter id. */
+static int
+svg_tint(NVGJSSVG* svg, NVGcolor c) {
+  uint32_t rgba = 0;
+  void* tints;
+
+  for(int i = 0; i < 4; i++)
+    rgba = rgba << 8 | (uint32_t)(fminf(fmaxf(c.rgba[i], 0), 1) * 255 + 0.5f);
+
+  for(int i = 0; i < svg->ntints; i++)
+    if(svg->tints[i].rgba == rgba)
+      return svg->tints[i].id;
+
+  if(!(tints = realloc(svg->tints, sizeof(*svg->tints) * (svg->ntints + 1)))) {
+    svg->error = ENOMEM;
+    return 0;
+  }
+
+  svg->tints = tints;
+  svg->tints[svg->ntints].rgba = rgba;
+  svg->tints[svg->ntints].id = ++svg->next_id;
+
+  svg_printf(svg,
+             "<defs><filter id=\"f%d\" color-interpolation-filters=\"sRGB\"><feColorMatrix type=\"matrix\" "
+             "values=\"0 0 0 0 %.3g 0 0 0 0 %.3g 0 0 0 0 %.3g 0 0 0 %.3g 0\"/></filter></defs>\n",
+             svg->next_id,
+             (rgba >> 24) / 255.0,
+             ((rgba >> 16) & 255) / 255.0,
+             ((rgba >> 8) & 255) / 255.0,
+             (rgba & 255) / 255.0);
+
+  return svg->tints[svg->ntints++].id;
+}
+
+/* Write the scissor as a <clipPath> if it differs from the previous one.
+   Returns its id, 0 without a scissor. */
+static int
+svg_scissor(NVGJSSVG* svg, const NVGscissor* scissor) {
+  float ex = scissor->extent[0], ey = scissor->extent[1];
+
+  if(ex < -0.5f || ey < -0.5f)
+    return 0;
+
+  if(svg->scissor_id && !memcmp(svg->scissor_xform, scissor->xform, sizeof(svg->scissor_xform)) &&
+     !memcmp(svg->scissor_extent, scissor->extent, sizeof(svg->scissor_extent)))
+    return svg->scissor_id;
+
+  memcpy(svg->scissor_xform, scissor->xform, sizeof(svg->scissor_xform));
+  memcpy(svg->scissor_extent, scissor->extent, sizeof(svg->scissor_extent));
+  svg->scissor_id = ++svg->next_id;
+
+  svg_printf(svg, "<defs><clipPath id=\"c%d\"><rect x=\"", svg->scissor_id);
+  svg_num(svg, -ex);
+  svg_puts(svg, "\" y=\"");
+  svg_num(svg, -ey);
+  svg_puts(svg, "\" width=\"");
+  svg_num(svg, ex * 2);
+  svg_puts(svg, "\" height=\"");
+  svg_num(svg, ey * 2);
+  svg_puts(svg, "\"");
+  svg_matrix(svg, "transform", scissor->xform);
+  svg_puts(svg, "/></clipPath></defs>\n");
+  return svg->scissor_id;
+}
+
+static void
+svg_stop(NVGJSSVG* svg, double offset, NVGcolor c) {
+  svg_printf(svg, "<stop offset=\"%.4g\"", fmin(fmax(offset, 0), 1));
+  svg_color(svg, "stop-color", c);
+  svg_puts(svg, "/>");
+}
+
+enum {
+  SVG_SOLID,
+  SVG_LINEAR,
+  SVG_RADIAL,
+  SVG_BOX,
+  SVG_IMAGE,
+};
+
+/* Tell NanoVG's paint kinds apart; they share one representation (see
+   nvgLinearGradient() and friends) */
+static int
+svg_paint_kind(NVGJSSVG* svg, const NVGpaint* paint) {
+  if(paint->image && svg_texture(svg, paint->image))
+    return SVG_IMAGE;
+
+  if(!memcmp(&paint->innerColor, &paint->outerColor, sizeof(NVGcolor)))
+    return SVG_SOLID;
+
+  /* nvgLinearGradient() uses an extent of 1e5 */
+  if(paint->extent[0] >= 1e4f)
+    return SVG_LINEAR;
+
+  if(paint->extent[0] == paint->radius && paint->extent[1] == paint->radius)
+    return SVG_RADIAL;
+
+  return SVG_BOX;
+}
+
+/* Write the defs a paint needs and return the value of the fill attribute
+   in ref ("#rrggbb" or "url(#..)") */
+static void
+svg_paint(NVGJSSVG* svg, const NVGpaint* paint, int kind, char ref[32], int* tint) {
+  const float* m = paint->xform;
+  int id = ++svg->next_id;
+
+  *tint = 0;
+  snprintf(ref, 32, "url(#p%d)", id);
+
+  switch(kind) {
+    case SVG_LINEAR: {
+      /* t = 0 .. 1 across y = extent[1] -+ feather / 2 in paint space */
+      double y0 = paint->extent[1] - paint->feather * 0.5, y1 = paint->extent[1] + paint->feather * 0.5;
+
+      svg_printf(svg, "<defs><linearGradient id=\"p%d\" gradientUnits=\"userSpaceOnUse\" x1=\"", id);
+      svg_num(svg, m[2] * y0 + m[4]);
+      svg_puts(svg, "\" y1=\"");
+      svg_num(svg, m[3] * y0 + m[5]);
+      svg_puts(svg, "\" x2=\"");
+      svg_num(svg, m[2] * y1 + m[4]);
+      svg_puts(svg, "\" y2=\"");
+      svg_num(svg, m[3] * y1 + m[5]);
+      svg_puts(svg, "\">");
+      svg_stop(svg, 0, paint->innerColor);
+      svg_stop(svg, 1, paint->outerColor);
+      svg_puts(svg, "</linearGradient></defs>\n");
+      break;
+    }
+
+    case SVG_RADIAL: {
+      double inr = paint->radius - paint->feather * 0.5, outr = paint->radius + paint->feather * 0.5;
+
+      svg_printf(svg, "<defs><radialGradient id=\"p%d\" gradientUnits=\"userSpaceOnUse\" cx=\"0\" cy=\"0\" r=\"", id);
+      svg_num(svg, outr > 0 ? outr : 0.01);
+      svg_puts(svg, "\"");
+      svg_matrix(svg, "gradientTransform", m);
+      svg_puts(svg, ">");
+      svg_stop(svg, outr > 0 ? inr / outr : 0, paint->innerColor);
+      svg_stop(svg, 1, paint->outerColor);
+      svg_puts(svg, "</radialGradient></defs>\n");
+      break;
+    }
+
+    case SVG_IMAGE: {
+      NVGJSSVGTexture* tex = svg_texture(svg, paint->image);
+      double sx = paint->extent[0] / tex->width, sy = paint->extent[1] / tex->height;
+
+      svg_image(svg, tex);
+      svg_printf(svg, "<defs><pattern id=\"p%d\" patternUnits=\"userSpaceOnUse\" width=\"", id);
+      svg_num(svg, paint->extent[0]);
+      svg_puts(svg, "\" height=\"");
+      svg_num(svg, paint->extent[1]);
+      svg_puts(svg, "\"");
+      svg_matrix(svg, "patternTransform", m);
+      svg_printf(svg, "><use xlink:href=\"#t%d_%d\" transform=\"matrix(%g 0 0 %g 0 ", tex->id, tex->version, sx,
+                 tex->flags & NVG_IMAGE_FLIPY ? -sy : sy);
+      svg_num(svg, tex->flags & NVG_IMAGE_FLIPY ? paint->extent[1] : 0);
+      svg_puts(svg, ")\"/></pattern></defs>\n");
+
+      if(tex->type != NVG_TEXTURE_RGBA)
+        *tint = svg_tint(svg, paint->innerColor);
+
+      break;
+    }
+
+    default: {
+      NVGcolor c = paint->innerColor;
+      int r = (int)(fminf(fmaxf(c.r, 0), 1) * 255 + 0.5f);
+      int g = (int)(fminf(fmaxf(c.g, 0), 1) * 255 + 0.5f);
+      int b = (int)(fminf(fmaxf(c.b, 0), 1) * 255 + 0.5f);
+
+      svg->next_id--;
+      snprintf(ref, 32, "#%02x%02x%02x", r, g, b);
+      break;
+    }
+  }
+}
+
+/* Path data of the fill polygons, or of stroke strips turned into outlines:
+   one side forwards, the other backwards. With nonzero winding the pieces
+   of a strip add up, so self-overlapping strokes are covered once. */
+static void
+svg_d(NVGJSSVG* svg, const NVGpath* paths, int npaths, int stroke) {
+  svg_puts(svg, " d=\"");
+
+  for(int i = 0; i < npaths; i++) {
+    const NVGvertex* v = stroke ? paths[i].stroke : paths[i].fill;
+    int n = stroke ? paths[i].nstroke : paths[i].nfill;
+
+    if(n < 3)
+      continue;
+
+    svg_puts(svg, "M");
+
+    if(!stroke) {
+      for(int j = 0; j < n; j++) {
+        if(j)
+          svg_write(svg, " ", 1);
+
+        svg_point(svg, v[j].x, v[j].y);
+      }
+    } else {
+      for(int j = 0; j < n; j += 2) {
+        if(j)
+          svg_write(svg, " ", 1);
+
+        svg_point(svg, v[j].x, v[j].y);
+      }
+
+      for(int j = (n - 1) | 1; j >= 1; j -= 2)
+        if(j < n) {
+          svg_write(svg, " ", 1);
+          svg_point(svg, v[j].x, v[j].y);
+        }
+    }
+
+    svg_puts(svg, "Z");
+  }
+
+  svg_puts(svg, "\"");
+}
+
+/* Common to fills and strokes: one <path>, or for a box gradient the path
+   filled with the outer color under a blurred rounded rectangle of the inner
+   color, clipped to the path */
+static void
+svg_shape(NVGJSSVG* svg, NVGpaint* paint, NVGscissor* scissor, const NVGpath* paths, int npaths, int stroke) {
+  int kind = svg_paint_kind(svg, paint), clip, tint;
+  char ref[32];
+
+  if(svg->finished)
+    return;
+
+  clip = svg_scissor(svg, scissor);
+
+  if(kind == SVG_BOX) {
+    int id = ++svg->next_id;
+    float f = fmaxf(paint->feather, 0.01f);
+
+    svg_printf(svg, "<defs><clipPath id=\"c%d\"", id);
+
+    if(clip)
+      svg_printf(svg, " clip-path=\"url(#c%d)\"", clip);
+
+    svg_puts(svg, "><path");
+    svg_d(svg, paths, npaths, stroke);
+    svg_printf(svg, "/></clipPath><filter id=\"f%d\" x=\"-50%%\" y=\"-50%%\" width=\"200%%\" height=\"200%%\">", id);
+    /* matches the slope of NanoVG's linear ramp of width feather */
+    svg_printf(svg, "<feGaussianBlur stdDeviation=\"%.3g\"/></filter></defs>\n", f * 0.4f);
+    svg_printf(svg, "<g clip-path=\"url(#c%d)\"><path", id);
+    svg_d(svg, paths, npaths, stroke);
+    svg_color(svg, "fill", paint->outerColor);
+    svg_puts(svg, "/><rect x=\"");
+    svg_num(svg, -paint->extent[0]);
+    svg_puts(svg, "\" y=\"");
+    svg_num(svg, -paint->extent[1]);
+    svg_puts(svg, "\" width=\"");
+    svg_num(svg, paint->extent[0] * 2);
+    svg_puts(svg, "\" height=\"");
+    svg_num(svg, paint->extent[1] * 2);
+    svg_puts(svg, "\" rx=\"");
+    svg_num(svg, paint->radius);
+    svg_puts(svg, "\"");
+    svg_matrix(svg, "transform", paint->xform);
+    svg_color(svg, "fill", paint->innerColor);
+    svg_printf(svg, " filter=\"url(#f%d)\"/></g>\n", id);
+    return;
+  }
+
+  svg_paint(svg, paint, kind, ref, &tint);
+  svg_puts(svg, "<path");
+  svg_d(svg, paths, npaths, stroke);
+  svg_printf(svg, " fill=\"%s\"", ref);
+
+  if(kind == SVG_SOLID && paint->innerColor.a < 1)
+    svg_printf(svg, " fill-opacity=\"%.3g\"", fmaxf(paint->innerColor.a, 0));
+  else if(kind == SVG_IMAGE && !tint && paint->innerColor.a < 1)
+    svg_printf(svg, " opacity=\"%.3g\"", fmaxf(paint->innerColor.a, 0));
+
+  if(tint)
+    svg_printf(svg, " filter=\"url(#f%d)\"", tint);
+
+  if(clip)
+    svg_printf(svg, " clip-path=\"url(#c%d)\"", clip);
+
+  svg_puts(svg, "/>\n");
+}
+
+static void
+svg_fill(void* uptr,
+         NVGpaint* paint,
+         NVGcompositeOperationState op,
+         NVGscissor* scissor,
+         float fringe,
+         const float* bounds,
+         const NVGpath* paths,
+         int npaths) {
+  (void)op;
+  (void)fringe;
+  (void)bounds;
+  svg_shape(uptr, paint, scissor, paths, npaths, 0);
+}
+
+static void
+svg_stroke(void* uptr,
+           NVGpaint* paint,
+           NVGcompositeOperationState op,
+           NVGscissor* scissor,
+           float fringe,
+           float strokeWidth,
+           const NVGpath* paths,
+           int npaths) {
+  (void)op;
+  (void)fringe;
+  (void)strokeWidth;
+  svg_shape(uptr, paint, scissor, paths, npaths, 1);
+}
+
+/* Affine map from texel to view coordinates through the triangle a, b, c;
+   returns 0 for a degenerate triangle */
+static int
+svg_texmap(float m[6], const NVGJSSVGTexture* tex, const NVGvertex* a, const NVGvertex* b, const NVGvertex* c) {
+  float au = a->u * tex->width, av = a->v * tex->height;
+  float bu = b->u * tex->width - au, bv = b->v * tex->height - av;
+  float cu = c->u * tex->width - au, cv = c->v * tex->height - av;
+  float det = bu * cv - cu * bv;
+
+  if(det == 0)
+    return 0;
+
+  m[0] = ((b->x - a->x) * cv - (c->x - a->x) * bv) / det;
+  m[1] = ((b->y - a->y) * cv - (c->y - a->y) * bv) / det;
+  m[2] = ((c->x - a->x) * bu - (b->x - a->x) * cu) / det;
+  m[3] = ((c->y - a->y) * bu - (b->y - a->y) * cu) / det;
+  m[4] = a->x - m[0] * au - m[2] * av;
+  m[5] = a->y - m[1] * au - m[3] * av;
+  return 1;
+}
+
+static int
+svg_texmatch(const float m[6], const NVGJSSVGTexture* tex, const NVGvertex* v) {
+  float u = v->u * tex->width, t = v->v * tex->height;
+
+  return fabsf(m[0] * u + m[2] * t + m[4] - v->x) < 1e-3f && fabsf(m[1] * u + m[3] * t + m[5] - v->y) < 1e-3f;
+}
+
+/* Text: each run of triangles sharing one texture mapping (a glyph quad)
+   becomes a path filled with a pattern of the texture, tinted by a filter
+   for alpha textures such as the font atlas */
+static void
+svg_triangles(void* uptr,
+              NVGpaint* paint,
+              NVGcompositeOperationState op,
+              NVGscissor* scissor,
+              const NVGvertex* verts,
+              int nverts,
+              float fringe) {
+  NVGJSSVG* svg = uptr;
+  NVGJSSVGTexture* tex;
+  int clip, tint = 0;
+
+  (void)op;
+  (void)fringe;
+
+  if(svg->finished || !(tex = svg_texture(svg, paint->image)))
+    return;
+
+  clip = svg_scissor(svg, scissor);
+  svg_image(svg, tex);
+
+  if(tex->type != NVG_TEXTURE_RGBA)
+    tint = svg_tint(svg, paint->innerColor);
+
+  svg_puts(svg, "<g");
+
+  if(tint)
+    svg_printf(svg, " filter=\"url(#f%d)\"", tint);
+  else if(paint->innerColor.a < 1)
+    svg_printf(svg, " opacity=\"%.3g\"", fmaxf(paint->innerColor.a, 0));
+
+  if(clip)
+    svg_printf(svg, " clip-path=\"url(#c%d)\"", clip);
+
+  svg_puts(svg, ">\n");
+
+  for(int i = 0; i + 2 < nverts;) {
+    float m[6];
+    int n = 3, id;
+
+    if(!svg_texmap(m, tex, &verts[i], &verts[i + 1], &verts[i + 2])) {
+      i += 3;
+      continue;
+    }
+
+    while(i + n + 2 < nverts && svg_texmatch(m, tex, &verts[i + n]) && svg_texmatch(m, tex, &verts[i + n + 1]) &&
+          svg_texmatch(m, tex, &verts[i + n + 2]))
+      n += 3;
+
+    id = ++svg->next_id;
+    svg_printf(svg,
+               "<defs><pattern id=\"p%d\" patternUnits=\"userSpaceOnUse\" width=\"%d\" height=\"%d\"",
+               id,
+               tex->width,
+               tex->height);
+    svg_matrix(svg, "patternTransform", m);
+    svg_printf(svg, "><use xlink:href=\"#t%d_%d\"/></pattern></defs><path d=\"", tex->id, tex->version);
+
+    for(int j = 0; j < n; j += 3) {
+      svg_puts(svg, "M");
+      svg_point(svg, verts[i + j].x, verts[i + j].y);
+      svg_write(svg, " ", 1);
+      svg_point(svg, verts[i + j + 1].x, verts[i + j + 1].y);
+      svg_write(svg, " ", 1);
+      svg_point(svg, verts[i + j + 2].x, verts[i + j + 2].y);
+      svg_puts(svg, "Z");
+    }
+
+    svg_printf(svg, "\" fill=\"url(#p%d)\"/>\n", id);
+    i += n;
+  }
+
+  svg_puts(svg, "</g>\n");
+}
+
+static void
+svg_finish(NVGJSSVG* svg) {
+  if(svg->finished)
+    return;
+
+  svg_puts(svg, "</svg>\n");
+  svg_flush(svg);
+  svg->finished = 1;
+}
+
+static void
+svg_delete(void* uptr) {
+  NVGJSSVG* svg = uptr;
+
+  if(!svg)
+    return;
+
+  svg_finish(svg);
+
+  if(svg->fd >= 0 && (svg->flags & NVGJS_SVG_CLOSE))
+    close(svg->fd);
+
+  for(int i = 0; i < svg->ntextures; i++)
+    free(svg->textures[i].data);
+
+  free(svg->textures);
+  free(svg->tints);
+  free(svg->buf);
+  free(svg);
+}
+
+NVGcontext*
+nvgjs_svg_create(int width, int height, int fd, int flags) {
+  NVGparams params;
+  NVGJSSVG* svg;
+
+  if(!(svg = calloc(1, sizeof(NVGJSSVG)))) {
+    if(fd >= 0 && (flags & NVGJS_SVG_CLOSE))
+      close(fd);
+
+    return 0;
+  }
+
+  svg->fd = fd;
+  svg->flags = flags;
+
+  svg_printf(svg,
+             "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+             "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" "
+             "width=\"%d\" height=\"%d\" viewBox=\"0 0 %d %d\">\n",
+             width,
+             height,
+             width,
+             height);
+
+  if(svg->error) {
+    if(fd >= 0 && (flags & NVGJS_SVG_CLOSE))
+      close(fd);
+
+    free(svg->buf);
+    free(svg);
+    return 0;
+  }
+
+  memset(&params, 0, sizeof(params));
+  params.userPtr = svg;
+  /* anti-aliasing is up to the SVG renderer, no fringe geometry */
+  params.edgeAntiAlias = 0;
+  params.renderCreate = svg_render_create;
+  params.renderCreateTexture = svg_create_texture;
+  params.renderDeleteTexture = svg_delete_texture;
+  params.renderUpdateTexture = svg_update_texture;
+  params.renderGetTextureSize = svg_texture_size;
+  params.renderViewport = svg_viewport;
+  params.renderCancel = svg_cancel;
+  params.renderFlush = svg_flush_frame;
+  params.renderFill = svg_fill;
+  params.renderStroke = svg_stroke;
+  params.renderTriangles = svg_triangles;
+  params.renderDelete = svg_delete;
+
+  /* nvgCreateInternal() calls renderDelete (freeing svg) if it fails */
+  return nvgCreateInternal(&params);
+}
+
+int
+nvgjs_svg_is(NVGcontext* nvg) {
+  return nvgInternalParams(nvg)->renderDelete == svg_delete;
+}
+
+int64_t
+nvgjs_svg_finish(NVGcontext* nvg, uint8_t** pdata) {
+  NVGJSSVG* svg = nvgInternalParams(nvg)->userPtr;
+
+  svg_finish(svg);
+
+  if(svg->error) {
+    errno = svg->error;
+    return -1;
+  }
+
+  if(svg->fd >= 0)
+    return svg->size;
+
+  svg->size = svg->len;
+
+  if(pdata) {
+    *pdata = (uint8_t*)svg->buf;
+    svg->buf = 0;
+    svg->len = svg->cap = 0;
+  }
+
+  return svg->size;
+}
+
+void
+nvgjs_svg_delete(NVGcontext* nvg) {
+  nvgDeleteInternal(nvg);
+}
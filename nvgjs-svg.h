@@ -0,0 +1,65 @@
+/**
+ * @file nvgjs-svg.h
+ */
+#ifndef NVGJS_SVG_H
+#define NVGJS_SVG_H
+
+#include <stdint.h>
+
+struct NVGcontext;
+
+/**
+ * @brief Flags for nvgjs_svg_create().
+ */
+enum {
+  NVGJS_SVG_CLOSE = 1, /* close the file descriptor when the context is deleted or creation fails */
+};
+
+/**
+ * @brief Create a NanoVG context that writes SVG instead of rendering.
+ *
+ * The renderer implements NVGparams directly: every fill, stroke and
+ * triangle batch becomes a <path> element as soon as NanoVG hands it over.
+ * Gradients, image patterns, scissors and textures (including the font
+ * atlas used by text) become <defs> written just before their first use, so
+ * nothing has to be buffered and the document streams out.
+ *
+ * Box gradients are approximated with a blurred rounded rectangle and only
+ * the source-over composite operation is represented. Drawing cannot be
+ * undone, so nvgCancelFrame() has no effect.
+ *
+ * @param width   Document width (the viewBox is 0 0 width height).
+ * @param height  Document height.
+ * @param fd      File descriptor written through a 64 KiB buffer, or -1 to
+ *                collect the document in memory (see nvgjs_svg_finish()).
+ * @param flags   NVGJS_SVG_CLOSE.
+ * @return The context, or NULL on allocation failure. With NVGJS_SVG_CLOSE
+ *         @p fd has been closed then, too.
+ */
+struct NVGcontext* nvgjs_svg_create(int width, int height, int fd, int flags);
+
+/**
+ * @brief Test whether a context was created by nvgjs_svg_create().
+ */
+int nvgjs_svg_is(struct NVGcontext*);
+
+/**
+ * @brief Write the closing tag and flush the output.
+ *
+ * Later drawing is ignored. Calling it again returns the same size.
+ *
+ * @param      nvg    SVG context, with its renderer's own userPtr (see
+ *                    nvgjs_nvg_data_free()).
+ * @param[out] pdata  In memory mode receives the malloc()'d document (the
+ *                    caller frees it), once; may be NULL.
+ * @return Size of the document in bytes, or -1 with errno set if writing to
+ *         the file descriptor failed.
+ */
+int64_t nvgjs_svg_finish(struct NVGcontext* nvg, uint8_t** pdata);
+
+/**
+ * @brief Finish (if not done yet) and delete an SVG context.
+ */
+void nvgjs_svg_delete(struct NVGcontext*);
+
+#endif /* defined(NVGJS_SVG_H) */
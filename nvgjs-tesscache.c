@@ -0,0 +1,385 @@
+#include "nanovg.h"
+#include "nvgjs-command.h"
+#include "nvgjs-nanovg.h"
+#include "nvgjs-tesscache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  uint64_t hash;
+  size_t len;
+  int stroke;
+  NVGJSTessParams p; /* translation zeroed */
+} NVGJSTessKey;
+
+typedef struct NVGJSTessEntry {
+  struct NVGJSTessEntry *chain, *prev, *next;
+  uint64_t khash;
+  NVGJSTessKey key;
+  float e, f; /* translation the vertices were made with */
+  float bounds[4];
+  int npaths;
+  size_t nverts, bytes;
+  NVGpath* paths; /* followed by the vertices and the commands, in the same allocation */
+  float* cmds;    /* compared on a hit, key.hash may collide */
+} NVGJSTessEntry;
+
+typedef struct NVGJSTessCache {
+  NVGJSTessEntry** buckets;
+  size_t nbuckets;
+  NVGJSTessEntry *head, *tail; /* most recently used first */
+  size_t entries, bytes, max_bytes;
+  uint64_t hits, misses;
+  /* translated copy of the last hit */
+  NVGpath* paths;
+  NVGvertex* verts;
+  size_t cpaths, cverts;
+} NVGJSTessCache;
+
+/* The record lookup is cached per thread, so uncached draws stay cheap */
+static inline NVGJSTessCache*
+tess_of(NVGcontext* nvg) {
+  NVGJSContextData* d = nvgjs_nvg_data(nvg);
+
+  return d ? d->tesscache : 0;
+}
+
+static inline uint64_t
+tess_mix(uint64_t h, uint32_t w) {
+  h = (h ^ w) * 0x9e3779b97f4a7c15ull;
+  return h ^ (h >> 29);
+}
+
+static uint64_t
+tess_words(uint64_t h, const void* p, size_t n) {
+  const uint32_t* w = p;
+
+  for(size_t i = 0; i < n; i++)
+    h = tess_mix(h, w[i]);
+
+  return h;
+}
+
+uint64_t
+nvgjs_tesscache_hash(const float* cmds, size_t len) {
+  uint64_t h = tess_words(tess_mix(0xcbf29ce484222325ull, len), cmds, len);
+
+  return h ? h : 1;
+}
+
+static void
+tess_unlink(NVGJSTessCache* c, NVGJSTessEntry* e) {
+  if(e->prev)
+    e->prev->next = e->next;
+  else
+    c->head = e->next;
+
+  if(e->next)
+    e->next->prev = e->prev;
+  else
+    c->tail = e->prev;
+}
+
+static void
+tess_push(NVGJSTessCache* c, NVGJSTessEntry* e) {
+  e->prev = 0;
+  e->next = c->head;
+
+  if(c->head)
+    c->head->prev = e;
+  else
+    c->tail = e;
+
+  c->head = e;
+}
+
+static void
+tess_evict(NVGJSTessCache* c, NVGJSTessEntry* e) {
+  NVGJSTessEntry** p = &c->buckets[e->khash & (c->nbuckets - 1)];
+
+  while(*p != e)
+    p = &(*p)->chain;
+
+  *p = e->chain;
+  tess_unlink(c, e);
+  c->entries--;
+  c->bytes -= e->bytes;
+  free(e);
+}
+
+static void
+tess_trim(NVGJSTessCache* c, size_t max_bytes) {
+  while(c->tail && c->bytes > max_bytes)
+    tess_evict(c, c->tail);
+}
+
+/* Keep the load factor at or below 1 */
+static void
+tess_grow(NVGJSTessCache* c) {
+  size_t n = c->nbuckets ? c->nbuckets * 2 : 64;
+  NVGJSTessEntry **buckets, *e;
+
+  if(c->entries < c->nbuckets)
+    return;
+
+  if(!(buckets = calloc(n, sizeof(NVGJSTessEntry*))))
+    return;
+
+  for(e = c->head; e; e = e->next) {
+    e->chain = buckets[e->khash & (n - 1)];
+    buckets[e->khash & (n - 1)] = e;
+  }
+
+  free(c->buckets);
+  c->buckets = buckets;
+  c->nbuckets = n;
+}
+
+static NVGJSTessEntry*
+tess_lookup(NVGJSTessCache* c, const NVGJSTessKey* key, uint64_t khash, const float* cmds) {
+  NVGJSTessEntry* e;
+
+  for(e = c->buckets[khash & (c->nbuckets - 1)]; e; e = e->chain)
+    if(e->khash == khash && !memcmp(&e->key, key, sizeof(*key)) && !memcmp(e->cmds, cmds, sizeof(float) * key->len))
+      break;
+
+  return e;
+}
+
+static void
+tess_insert(NVGJSTessCache* c,
+            const NVGJSTessKey* key,
+            uint64_t khash,
+            const NVGJSTessParams* p,
+            const float* cmds,
+            const NVGpath* paths,
+            int npaths,
+            const float* bounds) {
+  NVGJSTessEntry* e;
+  NVGvertex* v;
+  size_t nverts = 0, bytes;
+
+  for(int i = 0; i < npaths; i++)
+    nverts += paths[i].nfill + paths[i].nstroke;
+
+  bytes = sizeof(NVGJSTessEntry) + sizeof(NVGpath) * npaths + sizeof(NVGvertex) * nverts + sizeof(float) * key->len;
+
+  if(bytes > c->max_bytes)
+    return;
+
+  tess_trim(c, c->max_bytes - bytes);
+
+  if(!(e = malloc(bytes)))
+    return;
+
+  e->khash = khash;
+  memcpy(&e->key, key, sizeof(*key)); /* with the padding, for memcmp() */
+  e->e = p->xform[4];
+  e->f = p->xform[5];
+  memcpy(e->bounds, bounds, sizeof(e->bounds));
+  e->npaths = npaths;
+  e->nverts = nverts;
+  e->bytes = bytes;
+  e->paths = (NVGpath*)(e + 1);
+  v = (NVGvertex*)(e->paths + npaths);
+
+  /* the fill and stroke vertices are slices of NanoVG's buffer; pack them */
+  for(int i = 0; i < npaths; i++) {
+    e->paths[i] = paths[i];
+    e->paths[i].fill = paths[i].nfill > 0 ? memcpy(v, paths[i].fill, sizeof(NVGvertex) * paths[i].nfill) : 0;
+    v += paths[i].nfill > 0 ? paths[i].nfill : 0;
+    e->paths[i].stroke = paths[i].nstroke > 0 ? memcpy(v, paths[i].stroke, sizeof(NVGvertex) * paths[i].nstroke) : 0;
+    v += paths[i].nstroke > 0 ? paths[i].nstroke : 0;
+  }
+
+  e->cmds = memcpy(v, cmds, sizeof(float) * key->len);
+
+  tess_grow(c);
+
+  if(!c->nbuckets) {
+    free(e);
+    return;
+  }
+
+  e->chain = c->buckets[khash & (c->nbuckets - 1)];
+  c->buckets[khash & (c->nbuckets - 1)] = e;
+  tess_push(c, e);
+  c->entries++;
+  c->bytes += bytes;
+}
+
+/* The entry's paths moved by (dx, dy), in the cache's scratch buffers */
+static const NVGpath*
+tess_translate(NVGJSTessCache* c, const NVGJSTessEntry* e, float dx, float dy) {
+  const NVGvertex* src = (const NVGvertex*)(e->paths + e->npaths);
+
+  if(c->cpaths < (size_t)e->npaths) {
+    NVGpath* paths;
+
+    if(!(paths = realloc(c->paths, sizeof(NVGpath) * e->npaths)))
+      return 0;
+
+    c->paths = paths;
+    c->cpaths = e->npaths;
+  }
+
+  if(c->cverts < e->nverts) {
+    NVGvertex* verts;
+
+    if(!(verts = realloc(c->verts, sizeof(NVGvertex) * e->nverts)))
+      return 0;
+
+    c->verts = verts;
+    c->cverts = e->nverts;
+  }
+
+  for(size_t i = 0; i < e->nverts; i++) {
+    c->verts[i].x = src[i].x + dx;
+    c->verts[i].y = src[i].y + dy;
+    c->verts[i].u = src[i].u;
+    c->verts[i].v = src[i].v;
+  }
+
+  for(int i = 0; i < e->npaths; i++) {
+    c->paths[i] = e->paths[i];
+
+    if(e->paths[i].fill)
+      c->paths[i].fill = c->verts + (e->paths[i].fill - src);
+
+    if(e->paths[i].stroke)
+      c->paths[i].stroke = c->verts + (e->paths[i].stroke - src);
+  }
+
+  return c->paths;
+}
+
+int
+nvgjs_tesscache_set(NVGcontext* nvg, size_t max_bytes) {
+  NVGJSContextData* d;
+  NVGJSTessCache* c;
+
+  if(!max_bytes) {
+    nvgjs_tesscache_free(nvg);
+    return 0;
+  }
+
+  if(!(d = nvgjs_nvg_data(nvg)))
+    return -1;
+
+  if((c = d->tesscache)) {
+    c->max_bytes = max_bytes;
+    tess_trim(c, max_bytes);
+    return 0;
+  }
+
+  if(!(c = calloc(1, sizeof(NVGJSTessCache))))
+    return -1;
+
+  c->max_bytes = max_bytes;
+  d->tesscache = c;
+  return 0;
+}
+
+void
+nvgjs_tesscache_free(NVGcontext* nvg) {
+  NVGJSContextData* d;
+  NVGJSTessCache* c;
+
+  if(!(d = nvgjs_nvg_data(nvg)) || !(c = d->tesscache))
+    return;
+
+  d->tesscache = 0;
+  tess_trim(c, 0);
+  free(c->buckets);
+  free(c->paths);
+  free(c->verts);
+  free(c);
+}
+
+int
+nvgjs_tesscache_draw(NVGcontext* nvg, uint64_t hash, const float* cmds, size_t len, int stroke) {
+  NVGJSTessCache* c = tess_of(nvg);
+  NVGJSTessParams p;
+  NVGJSTessKey key;
+  NVGJSTessEntry* e;
+  const NVGpath* paths;
+  const float* bounds;
+  uint64_t khash;
+  int npaths, hit = 0;
+
+  nvgBeginPath(nvg);
+
+  if(!c) {
+    nvgjs_command_execute(nvg, cmds, len, NULL);
+
+    if(stroke)
+      nvgStroke(nvg);
+    else
+      nvgFill(nvg);
+
+    return 0;
+  }
+
+  /* the key depends on the state only, so a hit needs no replay */
+  nvgjs_nvg_tess_params(nvg, stroke, &p);
+
+  memset(&key, 0, sizeof(key));
+  key.hash = hash;
+  key.len = len;
+  key.stroke = stroke;
+  key.p = p;
+  key.p.xform[4] = key.p.xform[5] = 0;
+  khash = tess_words(hash, &key.p, sizeof(key.p) / sizeof(uint32_t));
+
+  if(c->nbuckets && (e = tess_lookup(c, &key, khash, cmds))) {
+    float dx = p.xform[4] - e->e, dy = p.xform[5] - e->f;
+
+    c->hits++;
+    tess_unlink(c, e);
+    tess_push(c, e);
+
+    if(dx == 0 && dy == 0) {
+      nvgjs_nvg_render(nvg, stroke, e->paths, e->npaths, e->bounds);
+      return 1;
+    }
+
+    if((paths = tess_translate(c, e, dx, dy))) {
+      float moved[4] = {e->bounds[0] + dx, e->bounds[1] + dy, e->bounds[2] + dx, e->bounds[3] + dy};
+
+      nvgjs_nvg_render(nvg, stroke, paths, e->npaths, moved);
+      return 1;
+    }
+
+    /* out of memory for the copy: tessellate, the entry stays */
+    hit = -1;
+  }
+
+  nvgjs_command_execute(nvg, cmds, len, NULL);
+  npaths = nvgjs_nvg_tessellate(nvg, stroke, &paths, &bounds);
+
+  if(!hit) {
+    c->misses++;
+    tess_insert(c, &key, khash, &p, cmds, paths, npaths, bounds);
+  }
+
+  nvgjs_nvg_render(nvg, stroke, paths, npaths, bounds);
+  /* leave the current path empty, as after a hit */
+  nvgBeginPath(nvg);
+  return 0;
+}
+
+int
+nvgjs_tesscache_stats(NVGcontext* nvg, NVGJSTessCacheStats* st) {
+  NVGJSTessCache* c;
+
+  if(!(c = tess_of(nvg)))
+    return -1;
+
+  st->hits = c->hits;
+  st->misses = c->misses;
+  st->entries = c->entries;
+  st->bytes = c->bytes;
+  st->max_bytes = c->max_bytes;
+  return 0;
+}
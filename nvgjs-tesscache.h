@@ -0,0 +1,60 @@
+/**
+ * @file nvgjs-tesscache.h
+ */
+#ifndef NVGJS_TESSCACHE_H
+#define NVGJS_TESSCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct NVGcontext;
+
+typedef struct {
+  uint64_t hits, misses;
+  size_t entries, bytes, max_bytes;
+} NVGJSTessCacheStats;
+
+/**
+ * @brief Hash of an encoded path (see nvgjs-command.h), never 0.
+ */
+uint64_t nvgjs_tesscache_hash(const float* cmds, size_t len);
+
+/**
+ * @brief Enable, resize or (with @p max_bytes 0) disable and free the
+ * tessellation cache of a context. Entries over the new budget are evicted,
+ * least recently used first.
+ *
+ * @return 0 on success, -1 on allocation failure or if the context has no
+ *         record (see nvgjs_nvg_data_new()).
+ */
+int nvgjs_tesscache_set(struct NVGcontext* nvg, size_t max_bytes);
+
+/**
+ * @brief Free the context's cache, if any. Must be called before the
+ * context is deleted.
+ */
+void nvgjs_tesscache_free(struct NVGcontext* nvg);
+
+/**
+ * @brief Replace the current path with an encoded one and fill
+ * (@p stroke == 0) or stroke it.
+ *
+ * With a cache, the vertices are looked up by @p hash, the commands and
+ * everything in NVGJSTessParams but the translation; a hit skips replaying,
+ * flattening and expansion and moves the stored vertices by the difference in
+ * translation. The current path is then left empty. Without a cache it is the
+ * same as after nvgBeginPath(), the commands and nvgFill()/nvgStroke().
+ *
+ * @param hash  nvgjs_tesscache_hash() of the commands.
+ * @return 1 on a hit, 0 otherwise.
+ */
+int nvgjs_tesscache_draw(struct NVGcontext* nvg, uint64_t hash, const float* cmds, size_t len, int stroke);
+
+/**
+ * @brief Counters of the context's cache.
+ *
+ * @return 0, or -1 if it has none.
+ */
+int nvgjs_tesscache_stats(struct NVGcontext* nvg, NVGJSTessCacheStats* st);
+
+#endif /* defined(NVGJS_TESSCACHE_H) */
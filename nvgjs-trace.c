@@ -0,0 +1,170 @@
+#include "nvgjs-trace.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct {
+  uint64_t seq;  /* index + 1 once written, 0 while being written */
+  int64_t ts, dur, bytes;
+  const char *name, *cat;
+  uint32_t tid;
+} NVGJSTraceEvent;
+
+int nvgjs_trace_enabled;
+
+/* Guards allocation and clearing of the ring, not recording */
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static NVGJSTraceEvent* trace_ring;
+static uint64_t trace_mask, trace_head;
+static uint32_t trace_period = 1, trace_threads;
+
+static __thread struct {
+  uint32_t tid, tick;
+} trace_thread __attribute__((tls_model("initial-exec")));
+
+int
+nvgjs_trace_start(uint32_t capacity, uint32_t sample) {
+  int ret = 0;
+
+  pthread_mutex_lock(&trace_lock);
+
+  if(!trace_ring) {
+    uint64_t n = 1024;
+
+    while(n < capacity)
+      n <<= 1;
+
+    if((trace_ring = calloc(n, sizeof(NVGJSTraceEvent))))
+      trace_mask = n - 1;
+    else
+      ret = -1;
+  } else if(!nvgjs_trace_enabled) {
+    memset(trace_ring, 0, sizeof(NVGJSTraceEvent) * (trace_mask + 1));
+    __atomic_store_n(&trace_head, 0, __ATOMIC_RELAXED);
+  }
+
+  if(!ret) {
+    __atomic_store_n(&trace_period, sample ? sample : 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&nvgjs_trace_enabled, 1, __ATOMIC_RELEASE);
+  }
+
+  pthread_mutex_unlock(&trace_lock);
+  return ret;
+}
+
+void
+nvgjs_trace_stop(void) {
+  __atomic_store_n(&nvgjs_trace_enabled, 0, __ATOMIC_RELEASE);
+}
+
+int64_t
+nvgjs_trace_now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+int
+nvgjs_trace_sample(void) {
+  if(!NVGJS_TRACING())
+    return 0;
+
+  if(++trace_thread.tick < __atomic_load_n(&trace_period, __ATOMIC_RELAXED))
+    return 0;
+
+  trace_thread.tick = 0;
+  return 1;
+}
+
+void
+nvgjs_trace_complete(const char* name, const char* cat, int64_t t0, int64_t bytes) {
+  uint64_t i = __atomic_fetch_add(&trace_head, 1, __ATOMIC_RELAXED);
+  NVGJSTraceEvent* e = &trace_ring[i & trace_mask];
+
+  if(!trace_thread.tid)
+    trace_thread.tid = __atomic_add_fetch(&trace_threads, 1, __ATOMIC_RELAXED);
+
+  /* a slot being rewritten reads as empty until it is published again */
+  __atomic_store_n(&e->seq, 0, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  /* relaxed stores: a dump may read the slot concurrently */
+  __atomic_store_n(&e->ts, t0, __ATOMIC_RELAXED);
+  __atomic_store_n(&e->dur, nvgjs_trace_now() - t0, __ATOMIC_RELAXED);
+  __atomic_store_n(&e->bytes, bytes, __ATOMIC_RELAXED);
+  __atomic_store_n(&e->name, name, __ATOMIC_RELAXED);
+  __atomic_store_n(&e->cat, cat, __ATOMIC_RELAXED);
+  __atomic_store_n(&e->tid, trace_thread.tid, __ATOMIC_RELAXED);
+
+  __atomic_store_n(&e->seq, i + 1, __ATOMIC_RELEASE);
+}
+
+int64_t
+nvgjs_trace_dump(FILE* f) {
+  uint64_t head, i;
+  int64_t n = 0;
+  int pid = getpid();
+
+  fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+  fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"qjs-nanovg\"}}", pid);
+
+  pthread_mutex_lock(&trace_lock);
+
+  if(trace_ring) {
+    head = __atomic_load_n(&trace_head, __ATOMIC_ACQUIRE);
+
+    for(i = head > trace_mask ? head - trace_mask - 1 : 0; i < head; i++) {
+      NVGJSTraceEvent* slot = &trace_ring[i & trace_mask];
+      NVGJSTraceEvent e;
+      uint64_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+
+      /* unpublished, or overwritten by a later lap */
+      if(seq != i + 1)
+        continue;
+
+      e.ts = __atomic_load_n(&slot->ts, __ATOMIC_RELAXED);
+      e.dur = __atomic_load_n(&slot->dur, __ATOMIC_RELAXED);
+      e.bytes = __atomic_load_n(&slot->bytes, __ATOMIC_RELAXED);
+      e.name = __atomic_load_n(&slot->name, __ATOMIC_RELAXED);
+      e.cat = __atomic_load_n(&slot->cat, __ATOMIC_RELAXED);
+      e.tid = __atomic_load_n(&slot->tid, __ATOMIC_RELAXED);
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+      if(__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq)
+        continue;
+
+      fprintf(f,
+              ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u",
+              e.name,
+              e.cat,
+              e.ts / 1e3,
+              e.dur / 1e3,
+              pid,
+              e.tid);
+
+      if(e.bytes >= 0)
+        fprintf(f, ",\"args\":{\"bytes\":%lld}", (long long)e.bytes);
+
+      fputc('}', f);
+      n++;
+    }
+  }
+
+  pthread_mutex_unlock(&trace_lock);
+
+  fputs("\n]}\n", f);
+
+  if(fflush(f) || ferror(f)) {
+    if(!errno)
+      errno = EIO;
+    return -1;
+  }
+
+  return n;
+}
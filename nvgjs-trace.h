@@ -0,0 +1,85 @@
+/**
+ * @file nvgjs-trace.h
+ */
+#ifndef NVGJS_TRACE_H
+#define NVGJS_TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief Nonzero between nvgjs_trace_start() and nvgjs_trace_stop().
+ *
+ * Only read through NVGJS_TRACING().
+ */
+extern int nvgjs_trace_enabled;
+
+#define NVGJS_TRACING() __builtin_expect(__atomic_load_n(&nvgjs_trace_enabled, __ATOMIC_ACQUIRE), 0)
+
+/**
+ * @brief Open a span: reads the clock while tracing, otherwise the flag test
+ * is all it costs and @p t0 is 0.
+ */
+#define NVGJS_TRACE_BEGIN(t0) int64_t t0 = NVGJS_TRACING() ? nvgjs_trace_now() : 0
+
+/**
+ * @brief Close a span opened with NVGJS_TRACE_BEGIN().
+ *
+ * @p name and @p cat must be string literals (only the pointers are
+ * recorded); @p bytes is reported as args.bytes unless negative.
+ */
+#define NVGJS_TRACE_END(t0, name, cat, bytes) \
+  do { \
+    if(t0) \
+      nvgjs_trace_complete(name, cat, t0, bytes); \
+  } while(0)
+
+/**
+ * @brief Enable tracing.
+ *
+ * The event ring is allocated by the first call and kept for the life of the
+ * process, so threads still finishing a span never write to freed memory;
+ * later calls only clear it.
+ *
+ * @param capacity  Number of events kept (rounded up to a power of two, at
+ *                  least 1024); the oldest are overwritten. Only the first
+ *                  call's value is used.
+ * @param sample    Record one in @p sample sampled calls per thread (see
+ *                  nvgjs_trace_sample()), 1 for all of them.
+ * @return 0 on success, -1 on allocation failure.
+ */
+int nvgjs_trace_start(uint32_t capacity, uint32_t sample);
+
+/**
+ * @brief Disable tracing. Recorded events stay in the ring.
+ */
+void nvgjs_trace_stop(void);
+
+/**
+ * @brief Monotonic clock in nanoseconds, also used for the frame statistics.
+ */
+int64_t nvgjs_trace_now(void);
+
+/**
+ * @brief Decide whether this call of a sampled kind (binding calls) is
+ * recorded: true for every n-th call on the calling thread while tracing.
+ */
+int nvgjs_trace_sample(void);
+
+/**
+ * @brief Record a complete span from @p t0 to now.
+ *
+ * Lock-free: writers claim a slot with an atomic increment and publish it
+ * with a sequence number, so any thread may record while another dumps.
+ */
+void nvgjs_trace_complete(const char* name, const char* cat, int64_t t0, int64_t bytes);
+
+/**
+ * @brief Write the events in the ring as Chrome trace-event JSON (loadable
+ * in Perfetto and chrome://tracing).
+ *
+ * @return Number of events written, or -1 with errno set on write errors.
+ */
+int64_t nvgjs_trace_dump(FILE* f);
+
+#endif /* defined(NVGJS_TRACE_H) */
@@ -1,11 +1,90 @@
 #include "nvgjs-utils.h"
+#include "nvgjs-state.h"
 #include <assert.h>
 #include <string.h>
 
+void
+nvgjs_utils_init(JSContext* ctx, NVGJSState* st) {
+  JSValue global, symbol, iterator;
+
+  global = JS_GetGlobalObject(ctx);
+  symbol = JS_GetPropertyStr(ctx, global, "Symbol");
+  iterator = JS_GetPropertyStr(ctx, symbol, "iterator");
+
+  st->atom_iterator = JS_ValueToAtom(ctx, iterator);
+  st->atom_length = JS_NewAtom(ctx, "length");
+  st->atom_next = JS_NewAtom(ctx, "next");
+  st->atom_done = JS_NewAtom(ctx, "done");
+  st->atom_value = JS_NewAtom(ctx, "value");
+
+#ifndef HAVE_JS_GETTYPEDARRAYTYPE
+  st->float32array_ctor = JS_GetPropertyStr(ctx, global, "Float32Array");
+  st->typedarray_ctor = JS_GetPropertyStr(ctx, st->float32array_ctor, "__proto__");
+#endif
+
+  JS_FreeValue(ctx, iterator);
+  JS_FreeValue(ctx, symbol);
+  JS_FreeValue(ctx, global);
+}
+
+void
+nvgjs_atoms(JSContext* ctx, JSAtom atoms[], const char* const names[], int len) {
+  for(int i = 0; i < len; i++)
+    atoms[i] = JS_NewAtom(ctx, names[i]);
+}
+
+BOOL
+nvgjs_isfloat32array(JSContext* ctx, JSValueConst value) {
+#ifdef HAVE_JS_GETTYPEDARRAYTYPE
+  (void)ctx;
+  return JS_GetTypedArrayType(value) == JS_TYPED_ARRAY_FLOAT32;
+#else
+  NVGJSState* st;
+
+  return JS_IsObject(value) && (st = nvgjs_state(ctx)) &&
+         JS_IsInstanceOf(ctx, value, st->float32array_ctor) > 0;
+#endif
+}
+
+static BOOL
+nvgjs_istypedarray(JSContext* ctx, JSValueConst value) {
+#ifdef HAVE_JS_GETTYPEDARRAYTYPE
+  (void)ctx;
+  return JS_GetTypedArrayType(value) >= 0;
+#else
+  NVGJSState* st;
+
+  return JS_IsObject(value) && (st = nvgjs_state(ctx)) && JS_IsInstanceOf(ctx, value, st->typedarray_ctor) > 0;
+#endif
+}
+
+uint8_t*
+nvgjs_bytes(JSContext* ctx, size_t* plen, JSValueConst value) {
+  size_t offset, byte_length, bytes_per_element, len;
+  uint8_t* ptr;
+  JSValue buf;
+
+  if(!nvgjs_istypedarray(ctx, value))
+    return JS_GetArrayBuffer(ctx, plen, value);
+
+  buf = JS_GetTypedArrayBuffer(ctx, value, &offset, &byte_length, &bytes_per_element);
+
+  if(JS_IsException(buf))
+    return 0;
+
+  if((ptr = JS_GetArrayBuffer(ctx, &len, buf))) {
+    ptr += offset;
+    *plen = byte_length;
+  }
+
+  JS_FreeValue(ctx, buf);
+  return ptr;
+}
+
 static int
 nvgjs_arraylen(JSContext* ctx, JSValueConst vector) {
   int32_t len = -1;
-  JSValue val = JS_GetPropertyStr(ctx, vector, "length");
+  JSValue val = JS_GetProperty(ctx, vector, nvgjs_state(ctx)->atom_length);
   JS_ToInt32(ctx, &len, val);
   JS_FreeValue(ctx, val);
   return len;
@@ -28,34 +107,19 @@ nvgjs_typedarray(JSContext* ctx, JSValueConst obj, int* plength, int* pbytes_per
 
     JS_FreeValue(ctx, buf);
   } else {
-    /* JS_GetTypedArrayBuffer threw; discard the exception so the caller can
-     * treat this as a silent "not a typed array" probe. */
+    /* Only reached for objects that passed nvgjs_isfloat32array() without
+     * being typed arrays (e.g. Object.create(Float32Array.prototype) with the
+     * instanceof fallback); report them as "not a typed array". */
     JS_FreeValue(ctx, JS_GetException(ctx));
   }
 
   return ptr;
 }
 
-static JSAtom
-nvgjs_iterator(JSContext* ctx) {
-  static JSAtom iterator;
-
-  if(!iterator) {
-    JSValue global = JS_GetGlobalObject(ctx);
-    JSValue ctor = JS_GetPropertyStr(ctx, global, "Symbol");
-    JS_FreeValue(ctx, global);
-    JSValue sym = JS_GetPropertyStr(ctx, ctor, "iterator");
-    JS_FreeValue(ctx, ctor);
-    iterator = JS_ValueToAtom(ctx, sym);
-    JS_FreeValue(ctx, sym);
-  }
-
-  return iterator;
-}
-
 static JSValue
 nvgjs_next(JSContext* ctx, JSValueConst obj, BOOL* done_p) {
-  JSValue fn = JS_GetPropertyStr(ctx, obj, "next");
+  NVGJSState* st = nvgjs_state(ctx);
+  JSValue fn = JS_GetProperty(ctx, obj, st->atom_next);
   if(JS_IsException(fn)) {
     *done_p = TRUE;
     return JS_EXCEPTION;
@@ -69,8 +133,8 @@ nvgjs_next(JSContext* ctx, JSValueConst obj, BOOL* done_p) {
     return JS_EXCEPTION;
   }
 
-  JSValue done = JS_GetPropertyStr(ctx, result, "done");
-  JSValue value = JS_GetPropertyStr(ctx, result, "value");
+  JSValue done = JS_GetProperty(ctx, result, st->atom_done);
+  JSValue value = JS_GetProperty(ctx, result, st->atom_value);
   JS_FreeValue(ctx, result);
 
   *done_p = JS_ToBool(ctx, done);
@@ -78,70 +142,84 @@ nvgjs_next(JSContext* ctx, JSValueConst obj, BOOL* done_p) {
   return value;
 }
 
-float*
-nvgjs_outputarray(JSContext* ctx, int* plength, JSValueConst value) {
-  int bytes_per_element = 0;
-  float* ptr;
-
-  if((ptr = nvgjs_typedarray(ctx, value, plength, &bytes_per_element)))
-    if(bytes_per_element == sizeof(float))
-      return ptr;
+/* Exact test for one form; the order of enum nvgjs_form is the order in which
+ * nvgjs_form() tries them */
+static BOOL
+nvgjs_isform(JSContext* ctx, JSValueConst value, int form, const JSAtom prop_map[]) {
+  switch(form) {
+    case NVGJS_FORM_FLOAT32ARRAY: return nvgjs_isfloat32array(ctx, value);
+    case NVGJS_FORM_ARRAY: return JS_IsArray(ctx, value) > 0;
+    case NVGJS_FORM_OBJECT: return prop_map && JS_HasProperty(ctx, value, prop_map[0]) > 0;
+    case NVGJS_FORM_ITERABLE: return JS_HasProperty(ctx, value, nvgjs_state(ctx)->atom_iterator) > 0;
+    case NVGJS_FORM_ARRAYLIKE: return TRUE;
+  }
 
-  JS_ThrowTypeError(ctx, "expecting a Float32Array");
-  return 0;
+  return FALSE;
 }
 
-float*
-nvgjs_output(JSContext* ctx, int min_length, JSValueConst value) {
-  int len;
-  float* ptr;
+int
+nvgjs_form(JSContext* ctx, JSValueConst value, const JSAtom prop_map[], NVGJSHint* hint) {
+  int form, last;
 
-  if((ptr = nvgjs_outputarray(ctx, &len, value)))
-    if(len >= min_length)
-      return ptr;
+  if(!JS_IsObject(value))
+    return NVGJS_FORM_NONE;
 
-  return 0;
+  /* Hints are shared by all threads; relaxed accesses keep that race-free
+     and a stale value only costs an extra test */
+  last = hint ? __atomic_load_n(hint, __ATOMIC_RELAXED) : NVGJS_FORM_NONE;
+
+  /* Re-check the form this slot saw last. Only forms with an exact test
+     qualify: every Float32Array is iterable and anything is array-like. */
+  if(last != NVGJS_FORM_NONE && last < NVGJS_FORM_ITERABLE)
+    if(nvgjs_isform(ctx, value, last, prop_map))
+      return last;
+
+  for(form = NVGJS_FORM_FLOAT32ARRAY; form < NVGJS_FORM_ARRAYLIKE; form++)
+    if(form != last && nvgjs_isform(ctx, value, form, prop_map))
+      break;
+
+  if(hint && form != last)
+    __atomic_store_n(hint, form, __ATOMIC_RELAXED);
+
+  return form;
 }
 
-float*
-nvgjs_inputoutputarray(JSContext* ctx, float vec[], int min_length, JSValueConst vector) {
+static int
+nvgjs_readtyped(JSContext* ctx, float vec[], int min_length, int max_length, JSValueConst vector) {
+  int length, bytes_per_element;
   float* ptr;
-  int len;
 
-  if((ptr = nvgjs_outputarray(ctx, &len, vector))) {
-    if(len < min_length) {
-      JS_ThrowRangeError(ctx, "TypedArray vector must have at least %i elements (has %i)", min_length, len);
-      return 0;
-    }
+  if(!(ptr = nvgjs_typedarray(ctx, vector, &length, &bytes_per_element))) {
+    JS_ThrowTypeError(ctx, "detached Float32Array");
+    return -1;
+  }
 
-    return ptr;
+  if(length < min_length) {
+    JS_ThrowRangeError(ctx, "TypedArray vector must have at least %i elements (has %i)", min_length, length);
+    return -1;
   }
 
-  /* Not a Float32Array — clear the probe TypeError before trying fallbacks. */
-  JS_FreeValue(ctx, JS_GetException(ctx));
+  if(length > max_length)
+    length = max_length;
 
-  if(!nvgjs_inputarray(ctx, vec, min_length, vector))
-    return vec;
+  memcpy(vec, ptr, length * sizeof(float));
+  return length;
+}
 
-  JS_FreeValue(ctx, JS_GetException(ctx));
+static int
+nvgjs_readarray(JSContext* ctx, float vec[], int min_length, int max_length, JSValueConst vector) {
+  int length = nvgjs_arraylen(ctx, vector);
 
-  if(JS_HasProperty(ctx, vector, nvgjs_iterator(ctx)))
-    if(!nvgjs_inputiterator(ctx, vec, min_length, vector))
-      return vec;
+  if(length < min_length) {
+    JS_ThrowRangeError(ctx, "input Array must have at least %i elements", min_length);
+    return -1;
+  }
 
-  JS_FreeValue(ctx, JS_GetException(ctx));
+  if(length > max_length)
+    length = max_length;
 
-  const char* s = JS_ToCString(ctx, vector);
-  JS_ThrowTypeError(ctx, "expecting a Float32Array, Array or Iterable (%s)", s ? s : "");
-  if(s)
-    JS_FreeCString(ctx, s);
-  return 0;
-}
-
-int
-nvgjs_inputobject(JSContext* ctx, float vec[], int len, const char* const prop_map[], JSValueConst vector) {
-  for(int i = 0; i < len; i++) {
-    JSValue value = JS_GetPropertyStr(ctx, vector, prop_map[i]);
+  for(int i = 0; i < length; i++) {
+    JSValue value = JS_GetPropertyUint32(ctx, vector, i);
     int ret = nvgjs_tofloat32(ctx, &vec[i], value);
     JS_FreeValue(ctx, value);
 
@@ -149,36 +227,19 @@ nvgjs_inputobject(JSContext* ctx, float vec[], int len, const char* const prop_m
       return -1;
   }
 
-  return 0;
+  return length;
 }
 
-int
-nvgjs_inputarray(JSContext* ctx, float vec[], int min_length, JSValueConst vector) {
-  float* ptr;
-  int length;
-
-  if((ptr = nvgjs_outputarray(ctx, &length, vector))) {
-    if(length < min_length) {
-      JS_ThrowRangeError(ctx, "TypedArray vector must have at least %i elements (has %i)", min_length, length);
-      return -1;
-    }
-
-    memcpy(vec, ptr, min_length * sizeof(float));
-    return 0;
-  }
-
-  /* nvgjs_outputarray threw a TypeError (its probe failed). Clear it before
-     the Array fallback so a *successful* fallback doesn't leave a spurious
-     pending exception for the caller. */
-  JS_FreeValue(ctx, JS_GetException(ctx));
+static int
+nvgjs_readobject(
+ JSContext* ctx, float vec[], int min_length, int max_length, const JSAtom prop_map[], JSValueConst vector) {
+  int i;
 
-  if(nvgjs_arraylen(ctx, vector) < min_length) {
-    JS_ThrowRangeError(ctx, "input Array must have at least %i elements", min_length);
-    return -1;
-  }
+  for(i = 0; i < max_length; i++) {
+    if(i >= min_length && JS_HasProperty(ctx, vector, prop_map[i]) <= 0)
+      break;
 
-  for(int i = 0; i < min_length; i++) {
-    JSValue value = JS_GetPropertyUint32(ctx, vector, i);
+    JSValue value = JS_GetProperty(ctx, vector, prop_map[i]);
     int ret = nvgjs_tofloat32(ctx, &vec[i], value);
     JS_FreeValue(ctx, value);
 
@@ -186,19 +247,20 @@ nvgjs_inputarray(JSContext* ctx, float vec[], int min_length, JSValueConst vecto
       return -1;
   }
 
-  return 0;
+  return i;
 }
 
-int
-nvgjs_inputiterator(JSContext* ctx, float vec[], int min_length, JSValueConst vector) {
-  JSValue iter = JS_Invoke(ctx, vector, nvgjs_iterator(ctx), 0, 0);
+static int
+nvgjs_readiterator(JSContext* ctx, float vec[], int min_length, int max_length, JSValueConst vector) {
+  JSValue iter = JS_Invoke(ctx, vector, nvgjs_state(ctx)->atom_iterator, 0, 0);
+  int i;
 
   if(JS_IsException(iter)) {
     JS_ThrowTypeError(ctx, "object must be iterable");
     return -1;
   }
 
-  for(int i = 0; i < min_length; i++) {
+  for(i = 0; i < max_length; i++) {
     BOOL done = FALSE;
     JSValue val = nvgjs_next(ctx, iter, &done);
     int ret = 0;
@@ -213,50 +275,170 @@ nvgjs_inputiterator(JSContext* ctx, float vec[], int min_length, JSValueConst ve
       return -1;
     }
 
-    if(done) {
-      JS_FreeValue(ctx, iter);
-      JS_ThrowRangeError(ctx, "iterable must have at least %i elements (has %i)", min_length, i);
-      return -1;
-    }
+    if(done)
+      break;
   }
 
   JS_FreeValue(ctx, iter);
-  return 0;
+
+  if(i < min_length) {
+    JS_ThrowRangeError(ctx, "iterable must have at least %i elements (has %i)", min_length, i);
+    return -1;
+  }
+
+  return i;
 }
 
 int
-nvgjs_input(JSContext* ctx, float vec[], int len, const char* const prop_map[], JSValueConst vector) {
-  if(!JS_IsObject(vector)) {
-    JS_ThrowTypeError(ctx, "vector must be an object");
-    return -1;
+nvgjs_inputform(JSContext* ctx,
+                float vec[],
+                int min_length,
+                int max_length,
+                const JSAtom prop_map[],
+                JSValueConst vector,
+                int form) {
+  switch(form) {
+    case NVGJS_FORM_FLOAT32ARRAY: return nvgjs_readtyped(ctx, vec, min_length, max_length, vector);
+    case NVGJS_FORM_OBJECT: return nvgjs_readobject(ctx, vec, min_length, max_length, prop_map, vector);
+    case NVGJS_FORM_ITERABLE: return nvgjs_readiterator(ctx, vec, min_length, max_length, vector);
+    case NVGJS_FORM_ARRAY:
+    case NVGJS_FORM_ARRAYLIKE: return nvgjs_readarray(ctx, vec, min_length, max_length, vector);
   }
 
-  if(!nvgjs_inputarray(ctx, vec, len, vector))
+  JS_ThrowTypeError(ctx, "vector must be an object");
+  return -1;
+}
+
+float*
+nvgjs_outputarray(JSContext* ctx, int* plength, JSValueConst value) {
+  int bytes_per_element = 0;
+  float* ptr;
+
+  if(nvgjs_isfloat32array(ctx, value))
+    if((ptr = nvgjs_typedarray(ctx, value, plength, &bytes_per_element)))
+      return ptr;
+
+  JS_ThrowTypeError(ctx, "expecting a Float32Array");
+  return 0;
+}
+
+const float*
+nvgjs_inputfloats(JSContext* ctx, int* plength, JSValueConst value, float** pcopy) {
+  int length, bytes_per_element;
+  const float* ptr;
+
+  *pcopy = 0;
+
+  if(nvgjs_isfloat32array(ctx, value)) {
+    if(!(ptr = nvgjs_typedarray(ctx, value, plength, &bytes_per_element)))
+      JS_ThrowTypeError(ctx, "detached Float32Array");
+
+    return ptr;
+  }
+
+  if(JS_IsArray(ctx, value) <= 0) {
+    JS_ThrowTypeError(ctx, "expecting a Float32Array or Array");
     return 0;
+  }
 
-  JS_FreeValue(ctx, JS_GetException(ctx));
+  if((length = nvgjs_arraylen(ctx, value)) < 0 || !(*pcopy = js_malloc(ctx, (length + 1) * sizeof(float))))
+    return 0;
 
-  if(JS_HasProperty(ctx, vector, nvgjs_iterator(ctx)))
-    if(!nvgjs_inputiterator(ctx, vec, len, vector))
-      return 0;
+  if(nvgjs_readarray(ctx, *pcopy, length, length, value) < 0) {
+    js_free(ctx, *pcopy);
+    *pcopy = 0;
+    return 0;
+  }
+
+  *plength = length;
+  return *pcopy;
+}
 
-  JS_FreeValue(ctx, JS_GetException(ctx));
+float*
+nvgjs_output(JSContext* ctx, int min_length, JSValueConst value) {
+  int len;
+  float* ptr;
 
-  if(prop_map)
-    if(!nvgjs_inputobject(ctx, vec, len, prop_map, vector))
+  if((ptr = nvgjs_outputarray(ctx, &len, value)))
+    if(len >= min_length)
+      return ptr;
+
+  return 0;
+}
+
+float*
+nvgjs_inputoutputarray(JSContext* ctx, float vec[], int min_length, JSValueConst vector, NVGJSHint* hint) {
+  int form = nvgjs_form(ctx, vector, 0, hint);
+
+  if(form == NVGJS_FORM_FLOAT32ARRAY) {
+    float* ptr;
+    int len;
+
+    if(!(ptr = nvgjs_outputarray(ctx, &len, vector)))
       return 0;
 
-  JS_FreeValue(ctx, JS_GetException(ctx));
+    if(len < min_length) {
+      JS_ThrowRangeError(ctx, "TypedArray vector must have at least %i elements (has %i)", min_length, len);
+      return 0;
+    }
 
-  JS_ThrowTypeError(ctx, "object must be iterable or a property Map must be supplied");
-  return -1;
+    return ptr;
+  }
+
+  if(form == NVGJS_FORM_NONE) {
+    const char* s = JS_ToCString(ctx, vector);
+    JS_ThrowTypeError(ctx, "expecting a Float32Array, Array or Iterable (%s)", s ? s : "");
+    if(s)
+      JS_FreeCString(ctx, s);
+    return 0;
+  }
+
+  return nvgjs_inputform(ctx, vec, min_length, min_length, 0, vector, form) < 0 ? 0 : vec;
+}
+
+int
+nvgjs_inputobject(JSContext* ctx, float vec[], int len, const JSAtom prop_map[], JSValueConst vector) {
+  return nvgjs_readobject(ctx, vec, len, len, prop_map, vector) < 0 ? -1 : 0;
+}
+
+int
+nvgjs_inputarray(JSContext* ctx, float vec[], int min_length, JSValueConst vector) {
+  int form = nvgjs_isfloat32array(ctx, vector) ? NVGJS_FORM_FLOAT32ARRAY : NVGJS_FORM_ARRAYLIKE;
+
+  return nvgjs_inputform(ctx, vec, min_length, min_length, 0, vector, form) < 0 ? -1 : 0;
+}
+
+int
+nvgjs_inputiterator(JSContext* ctx, float vec[], int min_length, JSValueConst vector) {
+  return nvgjs_readiterator(ctx, vec, min_length, min_length, vector) < 0 ? -1 : 0;
+}
+
+int
+nvgjs_input(JSContext* ctx, float vec[], int len, const JSAtom prop_map[], JSValueConst vector, NVGJSHint* hint) {
+  int form = nvgjs_form(ctx, vector, prop_map, hint);
+
+  return nvgjs_inputform(ctx, vec, len, len, prop_map, vector, form) < 0 ? -1 : 0;
 }
 
 void
-nvgjs_copyobject(JSContext* ctx, JSValueConst value, const char* const prop_map[], const float vec[], int len) {
+nvgjs_copyobject(JSContext* ctx, JSValueConst value, const JSAtom prop_map[], const float vec[], int len) {
+  for(int i = 0; i < len; i++)
+    JS_SetProperty(ctx, value, prop_map[i], JS_NewFloat64(ctx, vec[i]));
+}
+
+JSValue
+nvgjs_newobject(JSContext* ctx, const JSAtom prop_map[], const float vec[], int len) {
+  JSValue obj = JS_NewObject(ctx);
 
+  if(JS_IsException(obj))
+    return obj;
+
+  /* Defining the same keys in the same order on a fresh object walks the
+     shape cache instead of looking properties up or creating new shapes */
   for(int i = 0; i < len; i++)
-    JS_SetPropertyStr(ctx, value, prop_map[i], JS_NewFloat64(ctx, vec[i]));
+    JS_DefinePropertyValue(ctx, obj, prop_map[i], JS_NewFloat64(ctx, vec[i]), JS_PROP_C_W_E);
+
+  return obj;
 }
 
 void
@@ -266,9 +448,15 @@ nvgjs_copyarray(JSContext* ctx, JSValueConst value, const float vec[], int len)
 }
 
 int
-nvgjs_arguments(JSContext* ctx, float vec[2], int vlen, int argc, JSValueConst argv[]) {
-  if(argc >= 1 && JS_IsObject(argv[0]) && !nvgjs_inputarray(ctx, vec, vlen, argv[0]))
-    return 1;
+nvgjs_arguments(JSContext* ctx,
+                float vec[],
+                int vlen,
+                const JSAtom prop_map[],
+                NVGJSHint* hint,
+                int argc,
+                JSValueConst argv[]) {
+  if(argc >= 1 && JS_IsObject(argv[0]))
+    return nvgjs_input(ctx, vec, vlen, prop_map, argv[0], hint) ? 0 : 1;
 
   if(argc >= vlen) {
     for(int i = 0; i < vlen; i++)
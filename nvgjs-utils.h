@@ -7,6 +7,116 @@
 #include <quickjs.h>
 #include <cutils.h>
 
+/**
+ * @brief Forms a vector argument can take, as classified by nvgjs_form().
+ *
+ * Listed in the order nvgjs_form() tests them.
+ */
+enum nvgjs_form {
+  NVGJS_FORM_NONE = 0,      /**< not an object */
+  NVGJS_FORM_FLOAT32ARRAY,  /**< Float32Array (read with memcpy) */
+  NVGJS_FORM_ARRAY,         /**< plain Array */
+  NVGJS_FORM_OBJECT,        /**< object with the first key of the property map */
+  NVGJS_FORM_ITERABLE,      /**< has Symbol.iterator */
+  NVGJS_FORM_ARRAYLIKE,     /**< anything else: read length and indices */
+};
+
+/**
+ * @brief Per-argument-slot cache of the enum nvgjs_form last seen there.
+ *
+ * Declare one zero-initialised static per call site and argument. It only
+ * changes the order of the type tests, never the outcome, so sharing it
+ * between runtimes and threads is harmless (it is read and written with
+ * relaxed atomics).
+ */
+typedef unsigned char NVGJSHint;
+
+struct NVGJSState;
+
+/**
+ * @brief Per-context setup (call from module init).
+ *
+ * Interns the atoms used by the readers (length, next, done, value,
+ * Symbol.iterator) into @p st and, without JS_GetTypedArrayType(), fetches
+ * the Float32Array constructor for the JS_IsInstanceOf() fallback.
+ *
+ * @param ctx  QuickJS context.
+ * @param st   Its module state, from nvgjs_state_new().
+ */
+void nvgjs_utils_init(JSContext*, struct NVGJSState*);
+
+/**
+ * @brief Intern a table of property names.
+ *
+ * The property-map parameters below take atoms, so key tables are interned
+ * once at module init instead of on every JS_GetPropertyStr().
+ *
+ * @param      ctx    QuickJS context.
+ * @param[out] atoms  Receives @p len atoms.
+ * @param      names  @p len property names.
+ * @param      len    Number of names.
+ */
+void nvgjs_atoms(JSContext*, JSAtom atoms[], const char* const names[], int len);
+
+/**
+ * @brief Test for a Float32Array without throwing.
+ *
+ * Uses JS_GetTypedArrayType() when QuickJS provides it
+ * (HAVE_JS_GETTYPEDARRAYTYPE), JS_IsInstanceOf() otherwise.
+ *
+ * @param ctx    QuickJS context.
+ * @param value  Any JS value.
+ * @return TRUE if @p value is a Float32Array.
+ */
+BOOL nvgjs_isfloat32array(JSContext*, JSValueConst);
+
+/**
+ * @brief Get the bytes behind an ArrayBuffer or any TypedArray view.
+ *
+ * For a TypedArray only the viewed range is returned, i.e. the pointer
+ * already includes the view's byte offset.
+ *
+ * @param ctx    QuickJS context.
+ * @param plen   Receives the size in bytes.
+ * @param value  ArrayBuffer or TypedArray.
+ * @return Pointer to the first byte, or NULL with a pending exception (not a
+ *         buffer, or detached).
+ */
+uint8_t* nvgjs_bytes(JSContext*, size_t* plen, JSValueConst);
+
+/**
+ * @brief Classify a vector argument without throwing.
+ *
+ * With a @p hint, the form recorded there is re-validated first, so a slot
+ * that keeps receiving the same kind of value costs a single test.
+ *
+ * @param         ctx       QuickJS context.
+ * @param         value     The JS value to classify.
+ * @param         prop_map  Property atoms for NVGJS_FORM_OBJECT, or NULL.
+ * @param[in,out] hint      Argument slot cache, or NULL.
+ * @return An enum nvgjs_form value.
+ */
+int nvgjs_form(JSContext*, JSValueConst, const JSAtom prop_map[], NVGJSHint* hint);
+
+/**
+ * @brief Read between @p min_length and @p max_length floats from a value of
+ * a known form.
+ *
+ * For NVGJS_FORM_OBJECT, keys past @p min_length are optional and reading
+ * stops at the first one that is missing.
+ *
+ * @param      ctx         QuickJS context (for exceptions).
+ * @param[out] vec         Destination buffer of at least @p max_length floats.
+ * @param      min_length  Elements required.
+ * @param      max_length  Elements read at most.
+ * @param      prop_map    Property atoms for NVGJS_FORM_OBJECT, or NULL.
+ * @param      vector      The source JS value.
+ * @param      form        Its form, as returned by nvgjs_form().
+ * @return Number of elements read, or -1 on error.
+ */
+int nvgjs_inputform(
+ JSContext*, float[], int min_length, int max_length, const JSAtom prop_map[], JSValueConst, int form);
+
 /**
  * @brief Get a writable pointer into a Float32Array's backing store
  * (zero-copy).
@@ -22,6 +132,22 @@
  */
 float* nvgjs_outputarray(JSContext*, int* plength, JSValueConst);
 
+/**
+ * @brief Get read-only floats of any length from a Float32Array (zero-copy)
+ * or a plain Array (copied).
+ *
+ * Used for bulk inputs such as point lists. Throws a TypeError for any other
+ * value.
+ *
+ * @param      ctx      QuickJS context (for exceptions).
+ * @param[out] plength  Receives the number of floats.
+ * @param      value    The JS value: Float32Array or Array.
+ * @param[out] pcopy    Receives the copy made of an Array, to be released with
+ *                      js_free(); NULL for a Float32Array.
+ * @return Pointer to the floats, or NULL on error.
+ */
+const float* nvgjs_inputfloats(JSContext*, int* plength, JSValueConst, float** pcopy);
+
 /**
  * @brief Like nvgjs_outputarray(), but require a minimum capacity.
  *
@@ -50,10 +176,11 @@ float* nvgjs_output(JSContext*, int min_length, JSValueConst);
  * inputs).
  * @param      min_length  Minimum number of elements required.
  * @param      vector      The JS value: Float32Array, Array, or iterable.
+ * @param[in,out] hint     Argument slot cache, or NULL.
  * @return Pointer to usable float data (either @p vector's buffer or @p vec),
  * or NULL on error.
  */
-float* nvgjs_inputoutputarray(JSContext*, float[], int min_length, JSValueConst);
+float* nvgjs_inputoutputarray(JSContext*, float[], int min_length, JSValueConst, NVGJSHint* hint);
 
 /**
  * @brief Read floats from named properties of a JS object into a C array.
@@ -65,11 +192,11 @@ float* nvgjs_inputoutputarray(JSContext*, float[], int min_length, JSValueConst)
  * @param      ctx       QuickJS context (for exceptions).
  * @param[out] vec       Destination buffer of at least @p len floats.
  * @param      len       Number of properties/floats to read.
- * @param      prop_map  Array of @p len property-name strings to read from.
+ * @param      prop_map  Array of @p len property atoms to read from.
  * @param      vector    The source JS object.
  * @return 0 on success, -1 on conversion error.
  */
-int nvgjs_inputobject(JSContext*, float[], int len, const char* const prop_map[], JSValueConst);
+int nvgjs_inputobject(JSContext*, float[], int len, const JSAtom prop_map[], JSValueConst);
 
 /**
  * @brief Read floats from a Float32Array or plain Array into a C array.
@@ -102,18 +229,21 @@ int nvgjs_inputiterator(JSContext*, float[], int min_length, JSValueConst);
 /**
  * @brief General-purpose vector argument reader.
  *
- * Tries, in order: Array/Float32Array, then iterable, then (if @p prop_map is
- * given) named object properties. This is the catch-all entry point for
- * accepting a vector argument in whatever JS form the caller provides.
+ * Classifies @p vector with nvgjs_form() (Float32Array, Array, object with
+ * @p prop_map keys, iterable, array-like) and reads it accordingly; no
+ * exceptions are thrown to tell the forms apart. This is the catch-all entry
+ * point for accepting a vector argument in whatever JS form the caller
+ * provides.
  *
- * @param      ctx       QuickJS context (for exceptions).
- * @param[out] vec       Destination buffer of at least @p len floats.
- * @param      len       Number of elements to read.
- * @param      prop_map  Property-name strings for the object fallback, or NULL.
- * @param      vector    The source JS value (must be an object).
- * @return 0 on success, -1 if @p vector is not an object or no form matched.
+ * @param         ctx       QuickJS context (for exceptions).
+ * @param[out]    vec       Destination buffer of at least @p len floats.
+ * @param         len       Number of elements to read.
+ * @param         prop_map  Property atoms for the object form, or NULL.
+ * @param         vector    The source JS value (must be an object).
+ * @param[in,out] hint      Argument slot cache, or NULL.
+ * @return 0 on success, -1 if @p vector is not an object or could not be read.
  */
-int nvgjs_input(JSContext*, float[], int len, const char* const prop_map[], JSValueConst);
+int nvgjs_input(JSContext*, float[], int len, const JSAtom prop_map[], JSValueConst, NVGJSHint* hint);
 
 /**
  * @brief Write a C float array back into named properties of a JS object.
@@ -123,11 +253,26 @@ int nvgjs_input(JSContext*, float[], int len, const char* const prop_map[], JSVa
  *
  * @param ctx       QuickJS context.
  * @param value     Destination JS object.
- * @param prop_map  Array of @p len property-name strings to assign.
+ * @param prop_map  Array of @p len property atoms to assign.
  * @param vec       Source float values.
  * @param len       Number of values to write.
  */
-void nvgjs_copyobject(JSContext*, JSValueConst, const char* const prop_map[], const float[], int len);
+void nvgjs_copyobject(JSContext*, JSValueConst, const JSAtom prop_map[], const float[], int len);
+
+/**
+ * @brief Create a plain object holding @p vec under the keys of @p prop_map.
+ *
+ * For result objects the module creates itself: the properties are defined
+ * in a fixed order on a fresh object, so every result shares one QuickJS
+ * shape and no lookups happen.
+ *
+ * @param ctx       QuickJS context.
+ * @param prop_map  Array of @p len property atoms.
+ * @param vec       Source float values.
+ * @param len       Number of values.
+ * @return The new object, or JS_EXCEPTION.
+ */
+JSValue nvgjs_newobject(JSContext*, const JSAtom prop_map[], const float[], int len);
 
 /**
  * @brief Write a C float array into the indexed elements of a JS array/object.
@@ -146,17 +291,20 @@ void nvgjs_copyarray(JSContext*, JSValueConst, const float[], int len);
  * @brief Accept a vector either as one object argument or as separate scalars.
  *
  * If the first argument is an object it is read as a vector (via
- * nvgjs_inputarray); otherwise @p vlen scalar arguments are converted. Handles
- * the common overload "fn(x, y)" vs "fn([x, y])".
+ * nvgjs_input); otherwise @p vlen scalar arguments are converted. Handles
+ * the common overload "fn(x, y)" vs "fn([x, y])" vs "fn({x, y})".
  *
- * @param      ctx   QuickJS context (for exceptions).
- * @param[out] vec   Destination buffer (sized for the vector, e.g. 2 floats).
- * @param      vlen  Number of floats the vector holds.
- * @param      argc  Argument count as passed to the JS function.
- * @param      argv  Argument values as passed to the JS function.
- * @return Number of elements filled (the vector length), or 0 if none matched.
+ * @param         ctx       QuickJS context (for exceptions).
+ * @param[out]    vec       Destination buffer (sized for the vector, e.g. 2 floats).
+ * @param         vlen      Number of floats the vector holds.
+ * @param         prop_map  Property atoms accepted for an object argument, or NULL.
+ * @param[in,out] hint      Argument slot cache, or NULL.
+ * @param         argc      Argument count as passed to the JS function.
+ * @param         argv      Argument values as passed to the JS function.
+ * @return Number of arguments consumed (1 for a vector object, @p vlen for
+ * scalars), or 0 if none matched.
  */
-int nvgjs_arguments(JSContext*, float[], int, int, JSValueConst[]);
+int nvgjs_arguments(JSContext*, float[], int, const JSAtom prop_map[], NVGJSHint* hint, int, JSValueConst[]);
 
 /**
  * @brief Convert a JS value to a 32-bit float.
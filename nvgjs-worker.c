@@ -0,0 +1,147 @@
+#include "nvgjs-worker.h"
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+static void*
+nvgjs_worker_main(void* arg) {
+  NVGJSWorker* w = arg;
+
+  pthread_mutex_lock(&w->lock);
+
+  for(;;) {
+    NVGJSJob* job;
+
+    while(!w->queue_head && !w->stopping)
+      pthread_cond_wait(&w->wake, &w->lock);
+
+    if(!(job = w->queue_head))
+      break;
+
+    if(!(w->queue_head = job->next))
+      w->queue_tail = 0;
+
+    pthread_mutex_unlock(&w->lock);
+    job->run(job);
+    pthread_mutex_lock(&w->lock);
+
+    job->next = 0;
+
+    if(w->done_tail)
+      w->done_tail->next = job;
+    else
+      w->done_head = job;
+
+    w->done_tail = job;
+    pthread_cond_broadcast(&w->done);
+  }
+
+  pthread_mutex_unlock(&w->lock);
+  return 0;
+}
+
+void
+nvgjs_worker_init(NVGJSWorker* w) {
+  memset(w, 0, sizeof(*w));
+  pthread_mutex_init(&w->lock, 0);
+  pthread_cond_init(&w->wake, 0);
+  pthread_cond_init(&w->done, 0);
+}
+
+int
+nvgjs_worker_submit(NVGJSWorker* w, NVGJSJob* job) {
+  pthread_mutex_lock(&w->lock);
+
+  if(!w->started) {
+    if(pthread_create(&w->thread, 0, nvgjs_worker_main, w)) {
+      pthread_mutex_unlock(&w->lock);
+      return -1;
+    }
+
+    w->started = 1;
+  }
+
+  job->next = 0;
+
+  if(w->queue_tail)
+    w->queue_tail->next = job;
+  else
+    w->queue_head = job;
+
+  w->queue_tail = job;
+  w->pending++;
+
+  pthread_cond_signal(&w->wake);
+  pthread_mutex_unlock(&w->lock);
+  return 0;
+}
+
+NVGJSJob*
+nvgjs_worker_take(NVGJSWorker* w, uint64_t timeout_ns) {
+  NVGJSJob* list;
+
+  pthread_mutex_lock(&w->lock);
+
+  if(!w->done_head && w->pending && timeout_ns) {
+    if(timeout_ns == UINT64_MAX) {
+      while(!w->done_head)
+        pthread_cond_wait(&w->done, &w->lock);
+    } else {
+      struct timespec ts;
+
+      clock_gettime(CLOCK_REALTIME, &ts);
+      ts.tv_sec += timeout_ns / 1000000000u;
+      ts.tv_nsec += timeout_ns % 1000000000u;
+
+      if(ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+      }
+
+      while(!w->done_head)
+        if(pthread_cond_timedwait(&w->done, &w->lock, &ts) == ETIMEDOUT)
+          break;
+    }
+  }
+
+  for(NVGJSJob* job = list = w->done_head; job; job = job->next)
+    w->pending--;
+
+  w->done_head = w->done_tail = 0;
+  pthread_mutex_unlock(&w->lock);
+  return list;
+}
+
+int
+nvgjs_worker_pending(NVGJSWorker* w) {
+  int n;
+
+  pthread_mutex_lock(&w->lock);
+  n = w->pending;
+  pthread_mutex_unlock(&w->lock);
+  return n;
+}
+
+NVGJSJob*
+nvgjs_worker_stop(NVGJSWorker* w) {
+  NVGJSJob* list;
+
+  pthread_mutex_lock(&w->lock);
+  w->stopping = 1;
+  pthread_cond_signal(&w->wake);
+  pthread_mutex_unlock(&w->lock);
+
+  if(w->started)
+    pthread_join(w->thread, 0);
+
+  w->started = 0;
+  list = w->done_head;
+  w->done_head = w->done_tail = 0;
+  w->pending = 0;
+
+  pthread_mutex_destroy(&w->lock);
+  pthread_cond_destroy(&w->wake);
+  pthread_cond_destroy(&w->done);
+  return list;
+}
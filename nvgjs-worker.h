@@ -0,0 +1,71 @@
+/**
+ * @file nvgjs-worker.h
+ */
+#ifndef NVGJS_WORKER_H
+#define NVGJS_WORKER_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+/**
+ * @brief A unit of work for the background thread.
+ *
+ * Embed as the first member of a larger struct holding the job's inputs and
+ * results. run() executes on the worker thread and must not touch JS values.
+ */
+typedef struct NVGJSJob {
+  void (*run)(struct NVGJSJob*);
+  struct NVGJSJob* next;
+} NVGJSJob;
+
+/**
+ * @brief A background thread with its queue of jobs.
+ *
+ * One per module state, so finished jobs always return to the runtime that
+ * submitted them. Zero-initialise with nvgjs_worker_init(); the thread is
+ * started by the first nvgjs_worker_submit().
+ */
+typedef struct {
+  pthread_mutex_t lock;
+  pthread_cond_t wake, done;
+  pthread_t thread;
+  /* FIFO of queued jobs and of finished ones, both guarded by lock */
+  NVGJSJob *queue_head, *queue_tail, *done_head, *done_tail;
+  int started, stopping, pending;
+} NVGJSWorker;
+
+/**
+ * @brief Initialise a worker (does not start the thread).
+ */
+void nvgjs_worker_init(NVGJSWorker*);
+
+/**
+ * @brief Queue a job, starting the worker thread on first use.
+ *
+ * @return 0 on success, -1 if the thread could not be started.
+ */
+int nvgjs_worker_submit(NVGJSWorker*, NVGJSJob*);
+
+/**
+ * @brief Take all finished jobs, in completion order.
+ *
+ * When none has finished yet but some are queued, waits up to @p timeout_ns
+ * for one (UINT64_MAX waits indefinitely).
+ *
+ * @return Linked list (through NVGJSJob.next) of finished jobs, or NULL.
+ */
+NVGJSJob* nvgjs_worker_take(NVGJSWorker*, uint64_t timeout_ns);
+
+/**
+ * @brief Number of submitted jobs not yet returned by nvgjs_worker_take().
+ */
+int nvgjs_worker_pending(NVGJSWorker*);
+
+/**
+ * @brief Run the remaining queued jobs, then join the thread.
+ *
+ * @return All jobs not yet taken, for the caller to free.
+ */
+NVGJSJob* nvgjs_worker_stop(NVGJSWorker*);
+
+#endif /* defined(NVGJS_WORKER_H) */
@@ -9,7 +9,7 @@
 
 import * as glfw from 'glfw';
 import * as std from 'std';
-import { ALIGN_CENTER, ALIGN_LEFT, ALIGN_MIDDLE, ALIGN_RIGHT, ANTIALIAS, CreateGL3, DeleteGL3, RGB, STENCIL_STROKES } from 'nanovg';
+import { ALIGN_CENTER, ALIGN_LEFT, ALIGN_MIDDLE, ALIGN_RIGHT, ANTIALIAS, CreateGL3, DeleteGL3, RGB, SpatialIndex, STENCIL_STROKES } from 'nanovg';
 
 // glfw.so does not export the mouse-button / action enums, so spell them out.
 // (GLFW_MOUSE_BUTTON_LEFT = 0, GLFW_MOUSE_BUTTON_RIGHT = 1; GLFW_PRESS = 1.)
@@ -73,30 +73,35 @@ function main() {
   const saveBtn = { x: width - 116, y: 16, w: 100, h: 34 };
 
   let mouse = { x: width / 2, y: height / 2 };
-  let drag = null; // { pl, pt } currently being dragged
+  let drag = null; // { pl, pt, id } currently being dragged
   let active = 0; // polyline that left-clicks append to
   let savedAt = 0; // timestamp of last save, for on-screen feedback
   let running = true;
 
   const inRect = (p, r) => p.x >= r.x && p.x <= r.x + r.w && p.y >= r.y && p.y <= r.y + r.h;
 
-  // Nearest handle within HIT_R of (mx, my), or null.
-  function hitHandle(mx, my) {
-    let best = null;
-    let bestD2 = HIT_R * HIT_R;
+  // Every handle in a native spatial index; handles[id] is { pl, pt, id }.
+  let handles;
+  let index;
+
+  // Rebuild after points were inserted or removed (ids shift).
+  function reindex() {
+    const xy = [];
+    handles = [];
     for(let pl = 0; pl < polylines.length; pl++) {
-      const pts = polylines[pl];
-      for(let pt = 0; pt < pts.length; pt++) {
-        const dx = pts[pt].x - mx;
-        const dy = pts[pt].y - my;
-        const d2 = dx * dx + dy * dy;
-        if(d2 <= bestD2) {
-          bestD2 = d2;
-          best = { pl, pt };
-        }
+      for(let pt = 0; pt < polylines[pl].length; pt++) {
+        handles.push({ pl, pt, id: handles.length });
+        xy.push(polylines[pl][pt].x, polylines[pl][pt].y);
       }
     }
-    return best;
+    index = new SpatialIndex(new Float32Array(xy), 2, HIT_R);
+  }
+  reindex();
+
+  // Nearest handle within HIT_R of (mx, my), or null.
+  function hitHandle(mx, my) {
+    const id = index.Nearest(mx, my, HIT_R);
+    return id < 0 ? null : handles[id];
   }
 
   function save() {
@@ -119,7 +124,10 @@ function main() {
   Object.assign(window, {
     handleCursorPos(x, y) {
       mouse = { x, y };
-      if(drag) polylines[drag.pl][drag.pt] = { x, y };
+      if(drag) {
+        polylines[drag.pl][drag.pt] = { x, y };
+        index.Update(drag.id, x, y);
+      }
     },
     handleMouseButton(button, action) {
       if(action !== PRESS) {
@@ -136,11 +144,16 @@ function main() {
           drag = hit;
           active = hit.pl;
         } else {
-          polylines[active].push({ x: mouse.x, y: mouse.y });
+          const pts = polylines[active];
+          pts.push({ x: mouse.x, y: mouse.y });
+          handles.push({ pl: active, pt: pts.length - 1, id: index.Add(mouse.x, mouse.y) });
         }
       } else if(button === MB_RIGHT) {
         const hit = hitHandle(mouse.x, mouse.y);
-        if(hit && polylines[hit.pl].length > 2) polylines[hit.pl].splice(hit.pt, 1);
+        if(hit && polylines[hit.pl].length > 2) {
+          polylines[hit.pl].splice(hit.pt, 1);
+          reindex();
+        }
       }
     },
     handleKey(keyCode, scancode, action) {
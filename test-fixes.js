@@ -1,4 +1,6 @@
-import { DegToRad, HSL, HSLA, LerpRGBA, RadToDeg, RGB, RGBA, RGBAf, RGBf, Transform, TransformPoint, TransRGBA, TransRGBAf, } from 'nanovg';
+import { ANTIALIAS, BUTT, Color, CreateHeadless, CreateSoftware, CreateSVG, DeleteGL3, DeleteHeadless, DeleteSoftware, DeleteSVG, DegToRad, EncodeImage, HOLE, HSL, HSLA, LerpRGBA, OP_ARC, OP_BEGIN_PATH, OP_FILL, OP_FILL_COLOR, OP_LINE_CAP, OP_LINE_JOIN, OP_NOP, OP_PATH_WINDING, OP_RECT, Path, Poll, ProfileResults, ProfileStart, ProfileStop, RadToDeg, ReadPixels, RGB, RGBA, RGBAf, RGBf, ROUND, SpatialIndex, STAT_CALLS, STAT_DRAWS, STAT_FILLS, STAT_FRAME_MS, STAT_PATHS, STAT_STROKES, STAT_TRIANGLES, STAT_VERTICES, TraceStart, TraceStop, Transform, TransformPoint, TransRGBA, TransRGBAf, } from 'nanovg';
+import * as os from 'os';
+import * as std from 'std';
 
 let passed = 0;
 let failed = 0;
@@ -34,6 +36,22 @@ function safe(name, fn) {
   }
 }
 
+/* Promise-returning tests; settled before the results are printed */
+const pending = [];
+
+function safeAsync(name, fn) {
+  const fail = e => {
+    failed++;
+    failures.push(`${name} threw: ${e && e.message}`);
+    console.log(`THROW in ${name}:`, e && e.message);
+  };
+  try {
+    pending.push(fn().catch(fail));
+  } catch(e) {
+    fail(e);
+  }
+}
+
 /* ------------------------------------------------------------------ *
  * Group A — colour helpers (no GL context needed)                    *
  * ------------------------------------------------------------------ */
@@ -79,7 +97,7 @@ safe('RGBAf', () => {
 });
 
 /* nvgjs_tocolor — this is the buggy one. LerpRGBA / TransRGBA{,f} all rely
-   on it to unpack a NVGcolor from a Float32Array. */
+   on it to unpack a NVGcolor from a Color or array. */
 safe('LerpRGBA 4-elem colour', () => {
   const c0 = RGBA(200, 0, 0, 255);
   const c1 = RGBA(0, 200, 0, 255);
@@ -101,8 +119,8 @@ safe('LerpRGBA repeated (pending-exception check)', () => {
   const c1 = RGBA(0, 255, 0, 255);
   for(let i = 0; i < 32; i++) {
     const m = LerpRGBA(c0, c1, i / 32);
-    if(!(m instanceof Float32Array && m.length === 4)) {
-      throw new Error(`iteration ${i}: expected Float32Array(4), got ${m}`);
+    if(!(m instanceof Color && m.length === 4)) {
+      throw new Error(`iteration ${i}: expected Color, got ${m}`);
     }
   }
   assert(true, 'LerpRGBA in a loop keeps returning valid colours');
@@ -133,7 +151,7 @@ safe('LerpRGBA with plain-Array colours (nvgjs_tocolor RGB fallback)', () => {
      it and throws. After the fix, both paths cleanly return. */
   const mid = LerpRGBA([1, 0, 0], [0, 1, 0], 0.5);
   assert(
-    mid instanceof Float32Array &&
+    mid instanceof Color &&
       approx(mid[0], 0.5) &&
       approx(mid[1], 0.5) &&
       approx(mid[2], 0) &&
@@ -142,24 +160,39 @@ safe('LerpRGBA with plain-Array colours (nvgjs_tocolor RGB fallback)', () => {
   );
   /* A follow-up call verifies no exception leaked. */
   const c = RGB(10, 20, 30);
-  assert(c instanceof Float32Array, 'RGB after 3-element LerpRGBA still works');
+  assert(c instanceof Color, 'RGB after 3-element LerpRGBA still works');
 });
 
 safe('HSL / HSLA', () => {
   const h = HSL(0, 1, 0.5);
   assert(
-    h instanceof Float32Array && h.length === 4,
-    'HSL returns Float32Array(4)',
+    h instanceof Color && h.length === 4,
+    'HSL returns Color',
   );
   const ha = HSLA(0, 1, 0.5, 128);
   assert(
-    ha instanceof Float32Array &&
+    ha instanceof Color &&
       ha.length === 4 &&
       approx(ha[3], 128 / 255, 1e-3),
     'HSLA has correct alpha',
   );
 });
 
+safe('Color class: fields, indexing, spreading, constructor', () => {
+  const c = RGBAf(0.25, 0.5, 0.75, 1);
+  c.g = 0.125;
+  c[3] = 0.5;
+  assert(
+    approx(c.r, 0.25) && approx(c[1], 0.125) && approx(c.a, 0.5) && c.length === 4,
+    `Color getters/setters: [${[...c]}]`,
+  );
+  const d = new Color(c);
+  c.r = 0;
+  assert(d instanceof Color && approx(d.r, 0.25), 'new Color(color) copies');
+  const e = new Color(1, 0, 0);
+  assert(arrApprox([...e], [1, 0, 0, 1]), `new Color(r, g, b) defaults alpha: [${[...e]}]`);
+});
+
 /* ------------------------------------------------------------------ *
  * Group B — plain math helpers                                       *
  * ------------------------------------------------------------------ */
@@ -237,6 +270,17 @@ safe('Instance .Rotate composes', () => {
   );
 });
 
+safe('Transform class: chaining in place, constructor, fields', () => {
+  const t = new Transform();
+  const r = t.Translate(5, 7).Scale(2, 2);
+  assert(r === t && t instanceof Transform, 'chained calls return the same Transform');
+  assert(arrApprox([...t], [2, 0, 0, 2, 10, 14]), `Translate(5,7).Scale(2,2) got [${[...t]}]`);
+  const u = new Transform(t);
+  t.e = 0;
+  assert(approx(u.e, 10) && approx(t[4], 0) && t.length === 6, `copy is independent: u.e=${u.e} t[4]=${t[4]}`);
+  assert(arrApprox([...new Transform(1, 2, 3, 4, 5, 6)], [1, 2, 3, 4, 5, 6]), 'new Transform(a..f)');
+});
+
 /* nanovg's convention (see nvgTransformMultiply in nanovg.c):
      nvgTransformMultiply(t, s)   ==>  t := s * t   ("apply t first, then s")
      nvgTransformPremultiply(t,s) ==>  t := t * s   ("apply s first, then t")
@@ -290,6 +334,16 @@ safe('.Multiply and .Premultiply disagree (non-commutative sanity)', () => {
   );
 });
 
+safe('Instance methods called on the constructor throw a TypeError', () => {
+  let threw = false;
+  try {
+    Transform.prototype.Translate.call(Transform, 1, 2);
+  } catch(e) {
+    threw = e instanceof TypeError && e.message === 'not a Transform instance';
+  }
+  assert(threw, 'Transform.prototype.Translate.call(Transform)');
+});
+
 /* ------------------------------------------------------------------ *
  * Group E — TransformPoint free function                             *
  * ------------------------------------------------------------------ */
@@ -303,6 +357,14 @@ safe('TransformPoint applies matrix', () => {
   );
 });
 
+safe('Object-shaped points, matrices and colours', () => {
+  const dst = new Float32Array(2);
+  TransformPoint(dst, { a: 1, b: 0, c: 0, d: 1, e: 10, f: 20 }, { x: 1, y: 2 });
+  assert(approx(dst[0], 11) && approx(dst[1], 22), `TransformPoint({a..f}, {x,y}) got [${[...dst]}]`);
+  const c = LerpRGBA({ r: 1, g: 0, b: 0 }, { r: 0, g: 1, b: 0, a: 0 }, 0.5);
+  assert(arrApprox([...c], [0.5, 0.5, 0, 0.5]), `LerpRGBA({r,g,b}, {r,g,b,a}) got [${[...c]}]`);
+});
+
 /* ------------------------------------------------------------------ *
  * Group F — Transform.TransformPoint instance                        *
  * ------------------------------------------------------------------ */
@@ -350,10 +412,1053 @@ safe('nvgjs_transform_copy no longer pollutes Arrays with named props', () => {
   );
 });
 
-/* ------------------------------------------------------------------ */
-console.log(`\nRESULTS: ${passed} passed, ${failed} failed`);
-if(failed > 0) {
-  console.log('Failures:');
-  for(const f of failures) console.log('  -', f);
-  throw new Error(`${failed} test(s) failed`);
+/* ------------------------------------------------------------------ *
+ * Group H — retained Path objects (recording only, no GL needed)     *
+ * ------------------------------------------------------------------ */
+safe('Path records commands and chains', () => {
+  const p = new Path();
+  assert(p.length === 0, `new Path() is empty, length=${p.length}`);
+  /* MoveTo = 1+2 floats, LineTo = 1+2, Rect = 1+4, ClosePath = 1 */
+  const r = p.MoveTo(0, 0).LineTo(10, 0).Rect(1, 2, 3, 4).ClosePath();
+  assert(r === p, 'Path methods return the path for chaining');
+  assert(p.length === 3 + 3 + 5 + 1, `Path length after 4 commands: ${p.length}`);
+});
+
+safe('Path copy constructor and Clear', () => {
+  const a = new Path().Circle(5, 5, 2);
+  const b = new Path(a);
+  a.Clear();
+  assert(a.length === 0 && b.length === 4, `copy is independent: a=${a.length} b=${b.length}`);
+});
+
+safe('Path rejects integer arguments outside the range of an int', () => {
+  const p = new Path().MoveTo(0, 0);
+  for(const [name, fn] of [
+    ['Arc dir NaN', () => p.Arc(5, 5, 2, 0, 1, NaN)],
+    ['Arc dir 1e20', () => p.Arc(5, 5, 2, 0, 1, 1e20)],
+    ['PathWinding 1e20', () => p.PathWinding(1e20)],
+    ['PathWinding -Infinity', () => p.PathWinding(-Infinity)],
+  ]) {
+    let threw = false;
+    try {
+      fn();
+    } catch(e) {
+      threw = e instanceof RangeError;
+    }
+    assert(threw, `${name} throws RangeError`);
+  }
+  assert(p.length === 3, `nothing recorded: ${p.length}`);
+  assert(p.PathWinding(HOLE).Arc(5, 5, 2, 0, 1, 2).length === 3 + 2 + 7, 'in range');
+});
+
+/* ------------------------------------------------------------------ *
+ * Group I — image encoders (worker thread, settled by Poll)          *
+ * ------------------------------------------------------------------ */
+/* 2x2 RGBA, bottom row first as ReadPixels returns it */
+const pixels = new Uint8Array([1, 2, 3, 255, 4, 5, 6, 255, 7, 8, 9, 128, 10, 11, 12, 128]);
+
+safeAsync('EncodeImage ppm with flipY packs RGB top row first', () =>
+  EncodeImage(pixels, 2, 2, { format: 'ppm', flipY: true }).then(buf => {
+    const b = new Uint8Array(buf);
+    const header = String.fromCharCode(...b.slice(0, 11));
+    assert(header === 'P6\n2 2\n255\n', `PPM header: ${JSON.stringify(header)}`);
+    assert(
+      b.slice(11).join() === [7, 8, 9, 10, 11, 12, 1, 2, 3, 4, 5, 6].join(),
+      `PPM body flipped and packed: ${b.slice(11)}`,
+    );
+  }),
+);
+
+safeAsync('EncodeImage png/qoi signatures', () =>
+  Promise.all([EncodeImage(pixels.buffer, 2, 2), EncodeImage(pixels, 2, 2, { format: 'qoi', alpha: false })]).then(
+    ([png, qoi]) => {
+      const p = new Uint8Array(png);
+      const q = new Uint8Array(qoi);
+      assert(p[0] === 0x89 && String.fromCharCode(...p.slice(1, 4)) === 'PNG', 'PNG signature');
+      assert(p[25] === 6, `PNG colour type RGBA by default: ${p[25]}`);
+      assert(String.fromCharCode(...q.slice(0, 4)) === 'qoif' && q[12] === 3, 'QOI header with 3 channels');
+    },
+  ),
+);
+
+safe('EncodeImage rejects short buffers synchronously', () => {
+  let threw = false;
+  try {
+    EncodeImage(new Uint8Array(15), 2, 2);
+  } catch(e) {
+    threw = e instanceof RangeError;
+  }
+  assert(threw, 'buffer smaller than w*h*4 throws RangeError');
+});
+
+/* ------------------------------------------------------------------ *
+ * Group J — frame statistics and GPU timing                          *
+ * ------------------------------------------------------------------ */
+function statsFrame(nvg) {
+  nvg.BeginFrame(16, 16, 1);
+  nvg.BeginPath();
+  nvg.Rect(2, 2, 8, 8);
+  nvg.Circle(8, 8, 3);
+  nvg.FillColor(RGB(255, 0, 0));
+  nvg.Fill();
+  nvg.StrokeColor(RGB(0, 0, 255));
+  nvg.Stroke();
+  nvg.EndFrame();
 }
+
+safe('Context.stats counts the last frame in a reused Float64Array', () => {
+  const nvg = CreateSoftware(16, 16);
+  const stats = nvg.stats;
+  statsFrame(nvg);
+  assert(stats instanceof Float64Array && nvg.stats === stats, 'stats is the same Float64Array');
+  assert(
+    stats[STAT_FILLS] === 1 && stats[STAT_STROKES] === 1,
+    `fills/strokes: ${stats[STAT_FILLS]}/${stats[STAT_STROKES]}`,
+  );
+  assert(stats[STAT_PATHS] === 4, `two paths per fill and stroke: ${stats[STAT_PATHS]}`);
+  /* BeginFrame BeginPath Rect Circle FillColor Fill StrokeColor Stroke EndFrame */
+  assert(stats[STAT_CALLS] === 9, `binding calls: ${stats[STAT_CALLS]}`);
+  assert(stats[STAT_TRIANGLES] > 0 && stats[STAT_DRAWS] === 0, 'triangles counted, no GL draws');
+  assert(stats[STAT_FRAME_MS] >= 0, `frame time: ${stats[STAT_FRAME_MS]}`);
+  statsFrame(nvg);
+  assert(stats[STAT_FILLS] === 1, 'counters restart each frame');
+  DeleteSoftware(nvg);
+});
+
+safe('gpuTimeMs fills in a few frames later on headless GL', () => {
+  let hl;
+  try {
+    hl = CreateHeadless(16, 16);
+  } catch(e) {
+    console.log('skipped, no headless GL:', e.message);
+    return;
+  }
+  const nvg = hl.context;
+  const gpu = nvg.gpuTimeMs;
+  assert(gpu instanceof Float64Array && gpu.every(Number.isNaN), 'history starts out NaN');
+  for(let i = 0; i < 16; i++) statsFrame(nvg);
+  assert(nvg.stats[STAT_DRAWS] > 0, `GL draw calls: ${nvg.stats[STAT_DRAWS]}`);
+  assert(gpu[0] >= 0, `newest GPU time: ${gpu[0]}`);
+  DeleteHeadless(hl);
+});
+
+/* ------------------------------------------------------------------ *
+ * Group K — trace events                                             *
+ * ------------------------------------------------------------------ */
+safe('DumpTrace writes frame phases and sampled calls as trace events', () => {
+  const nvg = CreateSoftware(16, 16);
+  const path = `/tmp/qjs-nanovg-trace-${Date.now()}.json`;
+  const rect = nvg.Rect;
+  TraceStart({ sample: 1 });
+  assert(nvg.Rect !== rect, 'methods are wrapped while tracing');
+  statsFrame(nvg);
+  TraceStop();
+  assert(nvg.Rect === rect, 'TraceStop() restores the methods');
+  statsFrame(nvg);
+  const n = nvg.DumpTrace(path);
+  const trace = JSON.parse(std.loadFile(path));
+  std.remove(path);
+  const events = trace.traceEvents.filter(e => e.ph == 'X');
+  const names = events.map(e => e.name);
+  assert(n === events.length, `DumpTrace returns the event count: ${n}`);
+  assert(names.includes('BeginFrame') && names.includes('EndFrame'), 'frame phases recorded');
+  assert(events.some(e => e.cat == 'call' && e.name == 'Rect'), 'method calls recorded');
+  assert(events.filter(e => e.cat == 'frame' && e.name == 'EndFrame').length === 1, 'nothing recorded after TraceStop()');
+  assert(events.every(e => e.dur >= 0 && e.ts > 0), 'timestamps and durations');
+  DeleteSoftware(nvg);
+});
+
+safe('TraceStart({ sample: 0 }) records no calls, even through the profiling wrappers', () => {
+  const nvg = CreateSoftware(16, 16);
+  const path = `/tmp/qjs-nanovg-trace-${Date.now()}.json`;
+  TraceStart({ sample: 0 });
+  ProfileStart();
+  statsFrame(nvg);
+  ProfileStop();
+  TraceStop();
+  nvg.DumpTrace(path);
+  const events = JSON.parse(std.loadFile(path)).traceEvents.filter(e => e.ph == 'X');
+  std.remove(path);
+  assert(events.some(e => e.cat == 'frame'), 'frame phases recorded');
+  assert(!events.some(e => e.cat == 'call'), `no method calls: ${events.filter(e => e.cat == 'call').length}`);
+  DeleteSoftware(nvg);
+});
+
+safe('ProfileResults splits conversion from NanoVG time, sorted by cost', () => {
+  const nvg = CreateSoftware(16, 16);
+  const rect = nvg.Rect;
+  ProfileStart();
+  for(let i = 0; i < 3; i++) statsFrame(nvg);
+  try {
+    nvg.Rect();
+  } catch(e) {}
+  ProfileStop();
+  assert(nvg.Rect === rect, 'ProfileStop() restores the methods');
+  statsFrame(nvg);
+  const results = ProfileResults();
+  const names = Object.keys(results);
+  const r = results.Rect;
+  assert(r && r.calls === 4 && r.exceptions === 1, `Rect calls/exceptions: ${r?.calls}/${r?.exceptions}`);
+  assert(approx(r.convertMs + r.nanovgMs, r.totalMs, 1e-9), 'conversion and NanoVG time add up');
+  assert(results.EndFrame.nanovgMs > 0, `EndFrame NanoVG time: ${results.EndFrame.nanovgMs}`);
+  assert(names.every((n, i) => i == 0 || results[names[i - 1]].totalMs >= results[n].totalMs), 'sorted by total time');
+  assert(!('Ellipse' in results), 'methods never called are left out');
+  DeleteSoftware(nvg);
+});
+
+/* ------------------------------------------------------------------ *
+ * Group L — tessellation cache                                       *
+ * ------------------------------------------------------------------ */
+safe('Tessellation cache reuses vertices under translation, not scaling', () => {
+  const nvg = CreateSoftware(16, 16);
+  const path = new Path().MoveTo(1, 1).BezierTo(4, 12, 10, -4, 14, 8).Circle(8, 8, 3);
+  const frame = (x, s) => {
+    nvg.BeginFrame(16, 16, 1);
+    nvg.Translate(x, 0);
+    nvg.Scale(s, s);
+    nvg.FillPath(path);
+    nvg.StrokePath(path);
+    nvg.EndFrame();
+    return nvg.stats[STAT_TRIANGLES];
+  };
+  assert(nvg.TessellationCacheStats() === null, 'no cache by default');
+  const plain = frame(0, 1);
+  nvg.SetTessellationCache(1 << 20);
+  assert(frame(0, 1) === plain, 'a miss draws the same triangles');
+  assert(frame(3, 1) === plain && frame(0, 1) === plain, 'hits draw the same triangles');
+  let st = nvg.TessellationCacheStats();
+  assert(st.misses === 2 && st.hits === 4 && st.entries === 2, `hits/misses: ${st.hits}/${st.misses}`);
+  frame(0, 2);
+  path.LineTo(2, 2);
+  frame(0, 1);
+  st = nvg.TessellationCacheStats();
+  assert(st.misses === 6 && st.entries === 6, `scale and edits miss: ${st.misses}`);
+  assert(st.bytes > 0 && st.bytes <= st.maxBytes, `bytes: ${st.bytes}`);
+  nvg.BeginFrame(16, 16, 1);
+  nvg.FillPath(path);
+  assert(!nvg.IsPointInFill(8, 8), 'a hit leaves the current path empty');
+  nvg.EndFrame();
+  nvg.SetTessellationCache(1);
+  assert(nvg.TessellationCacheStats().entries === 0, 'shrinking evicts');
+  nvg.SetTessellationCache(0);
+  assert(nvg.TessellationCacheStats() === null, '0 disables');
+  DeleteSoftware(nvg);
+});
+
+safe('SetTessellationTolerance persists across frames, LOD thins zoomed-out lines', () => {
+  const nvg = CreateSoftware(16, 16);
+  const circle = new Path().Circle(8, 8, 7);
+  const line = new Path().MoveTo(0, 0);
+  for(let i = 1; i <= 2000; i++) line.LineTo(i * 0.1, Math.sin(i * 0.05) * 50);
+  const vertices = (path, s) => {
+    nvg.BeginFrame(16, 16, 1);
+    nvg.Scale(s, s);
+    nvg.StrokePath(path);
+    nvg.EndFrame();
+    return nvg.stats[STAT_VERTICES];
+  };
+  const fine = vertices(circle, 1), dense = vertices(line, 0.05);
+  nvg.SetTessellationTolerance(2, 0.01);
+  const coarse = vertices(circle, 1);
+  assert(coarse < fine && vertices(circle, 1) === coarse, `coarser and kept: ${coarse} < ${fine}`);
+  nvg.SetTessellationTolerance(0.25, 0.01, true);
+  assert(vertices(circle, 1) === fine, 'LOD changes nothing at scale 1');
+  const thin = vertices(line, 0.05);
+  assert(thin * 2 < dense, `LOD at scale 0.05: ${thin} vs ${dense} vertices`);
+  nvg.SetTessellationTolerance();
+  assert(vertices(line, 0.05) === dense, 'defaults restored');
+  let threw = false;
+  try {
+    nvg.SetTessellationTolerance(0, 0.01);
+  } catch(e) {
+    threw = e instanceof RangeError;
+  }
+  assert(threw, 'tess must be positive');
+  DeleteSoftware(nvg);
+});
+
+/* ------------------------------------------------------------------ *
+ * Group M — decimated polylines                                      *
+ * ------------------------------------------------------------------ */
+safe('PolylineDecimated keeps at most 4 vertices per pixel column', () => {
+  const nvg = CreateSoftware(16, 16);
+  const n = 100000, ys = new Float32Array(n), xy = new Float32Array(n * 2);
+  for(let i = 0; i < n; i++) {
+    ys[i] = Math.sin(i * 0.01) * 6 + (i % 7) * 0.1;
+    xy[i * 2] = i;
+    xy[i * 2 + 1] = ys[i];
+  }
+  ys[5] = NaN;
+  xy[11] = NaN;
+  nvg.BeginFrame(16, 16, 1);
+  nvg.Translate(0, 8);
+  nvg.Scale(16 / n, 1);
+  nvg.BeginPath();
+  const count = nvg.PolylineDecimated(ys, 0, 1);
+  assert(count > 16 && count <= 4 * 16, `vertices: ${count}`);
+  assert(nvg.PolylineDecimatedXY(xy) === count, 'the xy variant agrees');
+  assert(nvg.PolylineDecimated(ys, 0, 1, 1000, 0.5) <= 4, 'count and pixelWidth');
+  nvg.ResetTransform();
+  nvg.Stroke();
+  nvg.EndFrame();
+  assert(nvg.stats[STAT_STROKES] === 1, 'stroked');
+  let threw = false;
+  try {
+    nvg.PolylineDecimated(ys, 0, 1, n, 0);
+  } catch(e) {
+    threw = e instanceof RangeError;
+  }
+  assert(threw, 'pixelWidth must be positive');
+  threw = false;
+  try {
+    nvg.PolylineDecimated(ys, 0, 1, -1);
+  } catch(e) {
+    threw = e instanceof RangeError;
+  }
+  assert(threw, 'negative count throws');
+  DeleteSoftware(nvg);
+});
+
+/* ------------------------------------------------------------------ *
+ * Group N — OHLC candles                                             *
+ * ------------------------------------------------------------------ */
+safe('Candles draws all candles in one stroke and one fill per color', () => {
+  const nvg = CreateSoftware(16, 16);
+  const ohlc = new Float32Array([10, 12, 9, 11, 11, 11.5, 8, 9, 9, 9, 9, 9, NaN, 1, 1, 1]);
+  nvg.BeginFrame(16, 16, 1);
+  const n = nvg.Candles(ohlc, undefined, 2, 4, -1, 14, RGB(0, 255, 0), RGB(255, 0, 0), 2);
+  nvg.EndFrame();
+  const stats = nvg.stats;
+  assert(n === 3, `candles drawn: ${n}`);
+  assert(stats[STAT_STROKES] === 2 && stats[STAT_FILLS] === 2, `strokes/fills: ${stats[STAT_STROKES]}/${stats[STAT_FILLS]}`);
+  let threw = false;
+  try {
+    nvg.Candles(ohlc, 5, 0, 1, 1, 0, RGB(0, 0, 0), RGB(0, 0, 0), 1);
+  } catch(e) {
+    threw = e instanceof RangeError;
+  }
+  assert(threw, 'count beyond the array throws');
+  threw = false;
+  try {
+    nvg.Candles(ohlc, -1, 0, 1, 1, 0, RGB(0, 0, 0), RGB(0, 0, 0), 1);
+  } catch(e) {
+    threw = e instanceof RangeError;
+  }
+  assert(threw, 'negative count throws');
+  DeleteSoftware(nvg);
+});
+
+/* ------------------------------------------------------------------ *
+ * Group O — spatial index                                            *
+ * ------------------------------------------------------------------ */
+safe('SpatialIndex finds, updates and removes points', () => {
+  const index = new SpatialIndex(new Float32Array([0, 0, 10, 0, 10, 10, NaN, 0]));
+  const out = new Int32Array(8);
+  assert(index.length === 4 && index.cellSize > 0, `length ${index.length}, cellSize ${index.cellSize}`);
+  assert(index.Nearest(9, 1, 5) === 1, 'nearest point');
+  assert(index.Nearest(50, 50, 5) === -1, 'nothing within radius');
+  const n = index.QueryPoint(5, 0, 5, out);
+  const ids = Array.from(out.subarray(0, n)).sort();
+  assert(n === 2 && ids[0] === 0 && ids[1] === 1, `points on the radius: ${ids}`);
+  assert(index.QueryRect(11, 11, -1, -1, out) === 3, 'NaN entry left out');
+  index.Update(3, 1, 1);
+  index.Remove(0);
+  assert(index.QueryRect(-1, -1, 11, 11) === 3, 'updated and removed');
+  assert(index.Nearest(0, 0) === 3, 'nearest after update');
+  assert(index.Add(100, 100) === 4 && index.Nearest(90, 90, 20) === 4, 'added');
+  assert(index.QueryRect(-1e9, -1e9, 1e9, 1e9, out.subarray(0, 2)) === 4, 'count beyond out.length');
+  let threw = 0;
+  for(const f of [() => index.Update(5, 0, 0), () => new SpatialIndex(new Float32Array(3), 3)]) {
+    try {
+      f();
+    } catch(e) {
+      if(e instanceof RangeError) threw++;
+    }
+  }
+  assert(threw === 2, 'bad id and stride throw RangeError');
+});
+
+safe('SpatialIndex measures boxes to their edge', () => {
+  const index = new SpatialIndex(new Float32Array([0, 0, 100, 100, 200, 0, 300, 10]), 4);
+  assert(index.QueryPoint(50, 50, 0) === 1, 'point inside a box');
+  assert(index.Nearest(150, 5) === 1, 'ties go to the highest id');
+  assert(index.Nearest(150, 50) === 0, 'closest edge');
+  assert(index.QueryRect(99, 9, 201, 9) === 2, 'rectangle touching both');
+});
+
+safe('SpatialIndex agrees with a linear scan on many points', () => {
+  const n = 100000;
+  const xy = new Float32Array(n * 2);
+  for(let i = 0; i < xy.length; i++) xy[i] = Math.random() * 1000;
+  const index = new SpatialIndex(xy);
+  for(let q = 0; q < 20; q++) {
+    const x = Math.random() * 1000;
+    const y = Math.random() * 1000;
+    let best = -1;
+    let bestD2 = 25;
+    for(let i = 0; i < n; i++) {
+      const d2 = (xy[i * 2] - x) ** 2 + (xy[i * 2 + 1] - y) ** 2;
+      if(d2 <= bestD2) {
+        bestD2 = d2;
+        best = i;
+      }
+    }
+    const id = index.Nearest(x, y, 5);
+    /* single precision distances may order near-ties differently */
+    const d = id < 0 ? -1 : Math.hypot(xy[id * 2] - x, xy[id * 2 + 1] - y);
+    assert(id === best || Math.abs(d - Math.sqrt(bestD2)) < 1e-3, `query ${q}: ${id} vs ${best}`);
+  }
+});
+
+/* ------------------------------------------------------------------ *
+ * Group P — hit testing                                              *
+ * ------------------------------------------------------------------ */
+safe('IsPointInFill follows the non-zero rule and ignores the transform', () => {
+  const nvg = CreateSoftware(16, 16);
+  nvg.BeginFrame(16, 16, 1);
+  nvg.BeginPath();
+  nvg.Rect(0, 0, 100, 100);
+  nvg.Circle(50, 50, 20);
+  nvg.PathWinding(HOLE);
+  assert(nvg.IsPointInFill(10, 10), 'inside the rectangle');
+  assert(!nvg.IsPointInFill(50, 50), 'inside the hole');
+  assert(!nvg.IsPointInFill(150, 50), 'outside');
+  nvg.Translate(1000, 0);
+  assert(nvg.IsPointInFill(10, 10), 'frame coordinates');
+  const out = new Uint8Array(4);
+  const n = nvg.PointsInFill(new Float32Array([10, 10, 50, 50, 150, 50, 90, 90]), out);
+  assert(n === 2 && out.join() === '1,0,0,1', `batched: ${n} ${out.join()}`);
+  nvg.EndFrame();
+  DeleteSoftware(nvg);
+});
+
+safe('IsPointInStroke uses the stroke width, caps and transform scale', () => {
+  const nvg = CreateSoftware(16, 16);
+  nvg.BeginFrame(16, 16, 1);
+  nvg.BeginPath();
+  nvg.MoveTo(0, 0);
+  nvg.LineTo(100, 0);
+  nvg.StrokeWidth(10);
+  nvg.LineCap(BUTT);
+  assert(nvg.IsPointInStroke(50, 4) && !nvg.IsPointInStroke(50, 8), 'within half the width');
+  assert(!nvg.IsPointInStroke(-3, 0), 'butt cap');
+  assert(!nvg.IsPointInFill(50, 0), 'a line has no fill');
+  nvg.LineCap(ROUND);
+  assert(nvg.IsPointInStroke(-3, 0), 'round cap');
+  nvg.Scale(2, 2);
+  assert(nvg.IsPointInStroke(50, 8), 'width scaled by the transform');
+  assert(nvg.PointsInStroke(new Float32Array([50, 8, 50, 12])) === 1, 'batched without out');
+  nvg.EndFrame();
+  DeleteSoftware(nvg);
+});
+
+safe('IsPointInStroke leaves out the anti-aliasing fringe', () => {
+  let hl;
+  try {
+    hl = CreateHeadless(16, 16, ANTIALIAS);
+  } catch(e) {
+    console.log('skipped, no headless GL:', e.message);
+    return;
+  }
+  const nvg = hl.context;
+  nvg.BeginFrame(16, 16, 1);
+  nvg.BeginPath();
+  nvg.MoveTo(0, 0);
+  nvg.LineTo(100, 0);
+  nvg.StrokeWidth(10);
+  nvg.LineCap(BUTT);
+  assert(nvg.IsPointInStroke(50, 4.75), 'inside the stroke');
+  assert(!nvg.IsPointInStroke(50, 5.25), 'half a fringe outside');
+  nvg.EndFrame();
+  DeleteHeadless(hl);
+});
+
+safe('IsPointInFill tests a retained path and makes it current', () => {
+  const nvg = CreateSoftware(16, 16);
+  const path = new Path().Rect(0, 0, 10, 10);
+  nvg.BeginFrame(16, 16, 1);
+  nvg.BeginPath();
+  nvg.Rect(100, 100, 10, 10);
+  assert(nvg.IsPointInFill(5, 5, path), 'retained path');
+  assert(nvg.IsPointInFill(5, 5) && !nvg.IsPointInFill(105, 105), 'now the current path');
+  let threw = false;
+  try {
+    nvg.PointsInFill(new Float32Array(8), new Uint8Array(2));
+  } catch(e) {
+    threw = e instanceof RangeError;
+  }
+  assert(threw, 'out too short');
+  threw = false;
+  try {
+    nvg.PointsInFill(new Float32Array(3));
+  } catch(e) {
+    threw = e instanceof RangeError;
+  }
+  assert(threw, 'odd trailing float');
+  assert(nvg.PointsInFill([5, 5, 50, 50, 105, 105]) === 2, 'points in a plain Array');
+  nvg.EndFrame();
+  DeleteSoftware(nvg);
+});
+
+/* ------------------------------------------------------------------ *
+ * Group Q — software renderer pixels                                 *
+ * ------------------------------------------------------------------ */
+function pixelAt(nvg, x, y) {
+  const i = (y * nvg.width + x) * 4;
+  return [...new Uint8Array(nvg.pixels, i, 4)];
+}
+
+function softwareFrame(draw) {
+  const nvg = CreateSoftware(16, 16);
+  nvg.BeginFrame(16, 16, 1);
+  draw(nvg);
+  nvg.EndFrame();
+  return nvg;
+}
+
+safe('CreateSoftware fills whole pixels with the exact premultiplied colour', () => {
+  const nvg = softwareFrame(nvg => {
+    nvg.BeginPath();
+    nvg.Rect(4, 4, 8, 8);
+    nvg.FillColor(RGBA(0, 0, 255, 128));
+    nvg.Fill();
+    nvg.BeginPath();
+    nvg.Rect(0, 0, 2, 2);
+    nvg.FillColor(RGB(10, 20, 30));
+    nvg.Fill();
+  });
+  assert(pixelAt(nvg, 1, 1).join() === '10,20,30,255', `opaque: ${pixelAt(nvg, 1, 1)}`);
+  assert(pixelAt(nvg, 4, 4).join() === '0,0,128,128', `inside: ${pixelAt(nvg, 4, 4)}`);
+  assert(pixelAt(nvg, 11, 11).join() === '0,0,128,128', `last pixel: ${pixelAt(nvg, 11, 11)}`);
+  assert(pixelAt(nvg, 3, 4).join() === '0,0,0,0' && pixelAt(nvg, 12, 11).join() === '0,0,0,0', 'outside untouched');
+  DeleteSoftware(nvg);
+});
+
+safe('CreateSoftware blends a translucent span the same in SIMD blocks and the tail', () => {
+  const nvg = softwareFrame(nvg => {
+    nvg.BeginPath();
+    nvg.Rect(0, 0, 16, 16);
+    nvg.FillColor(RGB(255, 255, 255));
+    nvg.Fill();
+    /* 7 pixels: one block of 4 and a tail of 3 */
+    nvg.BeginPath();
+    nvg.Rect(1, 1, 7, 1);
+    nvg.FillColor(RGBA(255, 0, 0, 128));
+    nvg.Fill();
+  });
+  const row = [];
+  for(let x = 1; x < 8; x++) row.push(pixelAt(nvg, x, 1).join());
+  assert(row.every(p => p === '255,127,127,255'), `src-over on white: ${row.join(' ')}`);
+  assert(pixelAt(nvg, 8, 1).join() === '255,255,255,255', 'span ends on the edge');
+  DeleteSoftware(nvg);
+});
+
+safe('CreateSoftware covers a half-pixel edge by half', () => {
+  const nvg = softwareFrame(nvg => {
+    nvg.BeginPath();
+    nvg.Rect(4, 4, 4.5, 8);
+    nvg.FillColor(RGB(255, 0, 0));
+    nvg.Fill();
+  });
+  const [r, g, b, a] = pixelAt(nvg, 8, 6);
+  assert(Math.abs(a - 128) <= 1 && r === a && g === 0 && b === 0, `edge pixel: ${[r, g, b, a]}`);
+  assert(pixelAt(nvg, 7, 6)[3] === 255 && pixelAt(nvg, 9, 6)[3] === 0, 'neighbours fully in and out');
+  DeleteSoftware(nvg);
+});
+
+safe('CreateSoftware leaves the background in a HOLE subpath', () => {
+  const nvg = softwareFrame(nvg => {
+    nvg.BeginPath();
+    nvg.Rect(2, 2, 12, 12);
+    nvg.Rect(6, 6, 4, 4);
+    nvg.PathWinding(HOLE);
+    nvg.FillColor(RGB(0, 255, 0));
+    nvg.Fill();
+  });
+  assert(pixelAt(nvg, 3, 3).join() === '0,255,0,255', `solid part: ${pixelAt(nvg, 3, 3)}`);
+  assert(pixelAt(nvg, 7, 7).join() === '0,0,0,0' && pixelAt(nvg, 9, 9).join() === '0,0,0,0', 'hole is background');
+  assert(pixelAt(nvg, 5, 7).join() === '0,255,0,255', 'ring around the hole');
+  DeleteSoftware(nvg);
+});
+
+safe('CreateSoftware shades a linear gradient between its end colours', () => {
+  const nvg = softwareFrame(nvg => {
+    nvg.BeginPath();
+    nvg.Rect(0, 0, 16, 16);
+    nvg.FillPaint(nvg.LinearGradient(0, 0, 16, 0, RGB(255, 0, 0), RGB(0, 0, 255)));
+    nvg.Fill();
+  });
+  /* sampled at pixel centres: 0.5 / 16 and 15.5 / 16 along the gradient */
+  const close = (p, q) => p.every((v, i) => Math.abs(v - q[i]) <= 1);
+  assert(close(pixelAt(nvg, 0, 8), [247, 0, 8, 255]), `start: ${pixelAt(nvg, 0, 8)}`);
+  assert(close(pixelAt(nvg, 15, 8), [8, 0, 247, 255]), `end: ${pixelAt(nvg, 15, 8)}`);
+  assert(close(pixelAt(nvg, 8, 0), [120, 0, 135, 255]), `middle: ${pixelAt(nvg, 8, 0)}`);
+  DeleteSoftware(nvg);
+});
+
+safe('CreateSoftware clips a fill to the scissor', () => {
+  const nvg = softwareFrame(nvg => {
+    nvg.Scissor(4, 4, 4, 4);
+    nvg.BeginPath();
+    nvg.Rect(0, 0, 16, 16);
+    nvg.FillColor(RGB(255, 0, 0));
+    nvg.Fill();
+  });
+  const alpha = new Uint8Array(nvg.pixels).filter((v, i) => i % 4 == 3);
+  let inside = 0;
+  for(let y = 4; y < 8; y++) for(let x = 4; x < 8; x++) inside += pixelAt(nvg, x, y)[3] === 255;
+  assert(inside === 16, `scissor box filled: ${inside}`);
+  assert(alpha.reduce((n, a) => n + (a != 0), 0) === 16, 'nothing outside the scissor');
+  DeleteSoftware(nvg);
+});
+
+/* ------------------------------------------------------------------ *
+ * Group R — command streams                                          *
+ * ------------------------------------------------------------------ */
+function executeError(nvg, ...args) {
+  try {
+    nvg.Execute(...args);
+  } catch(e) {
+    return e instanceof RangeError ? e.message : `not a RangeError: ${e}`;
+  }
+  return null;
+}
+
+safe('Execute replays a Float32Array or an ArrayBuffer and counts the commands', () => {
+  const stream = new Float32Array([OP_BEGIN_PATH, OP_RECT, 4, 4, 8, 8, OP_FILL_COLOR, 1, 0, 0, 1, OP_FILL]);
+  let fromArray, fromBuffer;
+  const nvg = softwareFrame(nvg => {
+    fromArray = nvg.Execute(stream);
+    nvg.Translate(0, 8);
+    fromBuffer = nvg.Execute(stream.buffer);
+  });
+  assert(fromArray === 4 && fromBuffer === 4, `executed: ${fromArray}, ${fromBuffer}`);
+  assert(pixelAt(nvg, 5, 5).join() === '255,0,0,255', `filled: ${pixelAt(nvg, 5, 5)}`);
+  assert(pixelAt(nvg, 5, 13).join() === '255,0,0,255', `translated: ${pixelAt(nvg, 5, 13)}`);
+  assert(pixelAt(nvg, 1, 1).join() === '0,0,0,0', 'outside the rect untouched');
+  DeleteSoftware(nvg);
+});
+
+safe('Execute limits the stream to offset and count floats', () => {
+  /* red fill colour (5 floats), green fill colour (5), begin, rect (5), fill */
+  const stream = new Float32Array([
+    OP_FILL_COLOR, 1, 0, 0, 1,
+    OP_FILL_COLOR, 0, 1, 0, 1,
+    OP_BEGIN_PATH, OP_RECT, 0, 0, 16, 16, OP_FILL,
+  ]);
+  let n;
+  const nvg = softwareFrame(nvg => {
+    n = nvg.Execute(stream, 5, 12);
+    assert(nvg.Execute(stream, 5, 0) === 0 && nvg.Execute(stream, stream.length) === 0, 'empty ranges');
+    assert(/offset 5/.test(executeError(nvg, stream, 5, 3)), 'count cutting a command short');
+    assert(executeError(nvg, stream, -1) !== null, 'negative offset');
+    assert(executeError(nvg, stream, stream.length + 1) !== null, 'offset past the end');
+  });
+  assert(n === 4, `executed: ${n}`);
+  assert(pixelAt(nvg, 8, 8).join() === '0,255,0,255', `green, the red colour skipped: ${pixelAt(nvg, 8, 8)}`);
+  DeleteSoftware(nvg);
+});
+
+safe('Execute rejects truncated operands after applying the commands before them', () => {
+  const stream = new Float32Array([OP_BEGIN_PATH, OP_RECT, 0, 0, 16, 16, OP_FILL_COLOR, 0, 0, 1]);
+  let err;
+  const nvg = softwareFrame(nvg => {
+    err = executeError(nvg, stream);
+    nvg.FillColor(RGB(0, 0, 255));
+    nvg.Fill();
+  });
+  assert(/offset 6/.test(err), `error: ${err}`);
+  assert(pixelAt(nvg, 8, 8).join() === '0,0,255,255', `path from the stream filled: ${pixelAt(nvg, 8, 8)}`);
+  DeleteSoftware(nvg);
+});
+
+safe('Execute rejects unknown opcodes', () => {
+  const nvg = softwareFrame(nvg => {
+    assert(/offset 1/.test(executeError(nvg, new Float32Array([OP_NOP, 999]))), 'opcode past the table');
+    for(const op of [-1, 1.5, NaN, Infinity])
+      assert(/offset 0/.test(executeError(nvg, new Float32Array([op]))), `opcode ${op}`);
+  });
+  DeleteSoftware(nvg);
+});
+
+safe('Execute rejects integer operands outside the range of an int', () => {
+  const nvg = softwareFrame(nvg => {
+    assert(nvg.Execute(new Float32Array([OP_LINE_CAP, ROUND, OP_PATH_WINDING, HOLE])) === 2, 'in range');
+    for(const v of [1e30, -1e30, NaN, Infinity]) {
+      assert(executeError(nvg, new Float32Array([OP_LINE_CAP, v])) !== null, `line cap ${v}`);
+      assert(executeError(nvg, new Float32Array([OP_PATH_WINDING, v])) !== null, `winding ${v}`);
+      assert(executeError(nvg, new Float32Array([OP_ARC, 8, 8, 4, 0, 1, v])) !== null, `arc direction ${v}`);
+    }
+    assert(/offset 2/.test(executeError(nvg, new Float32Array([OP_LINE_JOIN, ROUND, OP_LINE_JOIN, 3e9]))),
+      'offset of the bad command');
+  });
+  DeleteSoftware(nvg);
+});
+
+/* ------------------------------------------------------------------ *
+ * Group S — polylines                                                *
+ * ------------------------------------------------------------------ */
+safe('Polygon closes a sub-path through packed vertices', () => {
+  const nvg = softwareFrame(nvg => {
+    nvg.BeginPath();
+    nvg.Polygon(new Float32Array([2, 2, 14, 2, 14, 14, 2, 14]));
+    assert(nvg.IsPointInFill(8, 8) && !nvg.IsPointInFill(1, 8), 'hit test');
+    nvg.FillColor(RGB(255, 0, 0));
+    nvg.Fill();
+  });
+  assert(pixelAt(nvg, 2, 2).join() === '255,0,0,255' && pixelAt(nvg, 13, 13).join() === '255,0,0,255', 'filled');
+  assert(pixelAt(nvg, 1, 8)[3] === 0 && pixelAt(nvg, 14, 8)[3] === 0, 'nothing outside');
+  DeleteSoftware(nvg);
+});
+
+safe('Polyline takes offset and count in vertices and closes on request', () => {
+  /* the first and last vertices are outside the range */
+  const pts = new Float32Array([0, 0, 2, 2, 14, 2, 14, 14, 100, 100]);
+  const nvg = softwareFrame(nvg => {
+    nvg.StrokeWidth(2);
+    nvg.BeginPath();
+    nvg.Polyline(pts, 1, 3);
+    assert(nvg.IsPointInStroke(8, 2) && nvg.IsPointInStroke(14, 8), 'the selected segments');
+    assert(!nvg.IsPointInStroke(8, 8), 'open: no closing segment');
+    assert(!nvg.IsPointInStroke(1, 1) && !nvg.IsPointInStroke(50, 50), 'vertices outside the range');
+    nvg.BeginPath();
+    nvg.Polyline(pts, 1, 3, true);
+    assert(nvg.IsPointInStroke(8, 8), 'closed');
+    nvg.BeginPath();
+    nvg.Polygon(pts, 1, 3);
+    assert(nvg.IsPointInStroke(8, 8) && nvg.IsPointInFill(10, 5), 'Polygon is closed');
+    nvg.BeginPath();
+    nvg.Polyline(pts, 5);
+    assert(!nvg.IsPointInFill(10, 5), 'offset at the end appends nothing');
+  });
+  DeleteSoftware(nvg);
+});
+
+safe('Polyline rejects offset and count outside the array', () => {
+  const pts = new Float32Array([0, 0, 2, 2, 14, 2]);
+  const nvg = softwareFrame(nvg => {
+    for(const args of [[-1], [4], [0, -1], [0, 4], [2, 2]]) {
+      let threw = false;
+      try {
+        nvg.Polyline(pts, ...args);
+      } catch(e) {
+        threw = e instanceof RangeError;
+      }
+      assert(threw, `offset, count ${args.join(', ')}`);
+    }
+    assert(nvg.Polyline(pts, 1, 2) === undefined, 'in range');
+  });
+  DeleteSoftware(nvg);
+});
+
+/* ------------------------------------------------------------------ *
+ * Group T — shape batches                                            *
+ * ------------------------------------------------------------------ */
+safe('Rects, Circles, Ellipses and RoundedRects append one shape per item', () => {
+  const counts = [];
+  const nvg = softwareFrame(nvg => {
+    nvg.BeginPath();
+    /* 6 floats: the partial second item is ignored */
+    counts.push(nvg.Rects(new Float32Array([0, 0, 4, 4, 12, 12])));
+    counts.push(nvg.Circles(new Float32Array([12, 4, 2, 12, 12, 2])));
+    counts.push(nvg.Ellipses(new Float32Array([8, 8, 3, 1])));
+    counts.push(nvg.RoundedRects(new Float32Array([0, 10, 4, 4, 2])));
+    assert(nvg.IsPointInFill(2, 2) && !nvg.IsPointInFill(5, 2), 'rect');
+    assert(nvg.IsPointInFill(12, 4) && nvg.IsPointInFill(12, 12) && !nvg.IsPointInFill(14, 6), 'circles');
+    assert(nvg.IsPointInFill(10.5, 8) && !nvg.IsPointInFill(8, 9.5), 'ellipse');
+    assert(nvg.IsPointInFill(2, 12) && !nvg.IsPointInFill(0.2, 10.2), 'rounded rect corner');
+    nvg.FillColor(RGB(255, 255, 255));
+    nvg.Fill();
+  });
+  assert(counts.join() === '1,2,1,1', `item counts: ${counts}`);
+  assert(nvg.stats[STAT_FILLS] === 1, 'one path, one fill');
+  assert(pixelAt(nvg, 1, 1).join() === '255,255,255,255' && pixelAt(nvg, 6, 1)[3] === 0, 'pixels');
+  DeleteSoftware(nvg);
+});
+
+safe('colors draw one fill per colour, in the order of first use', () => {
+  /* three overlapping columns: red, blue, red */
+  const rects = new Float32Array([0, 0, 8, 16, 4, 0, 8, 16, 8, 0, 8, 16]);
+  const colors = new Float32Array([1, 0, 0, 1, 0, 0, 1, 1, 1, 0, 0, 1]);
+  let fills;
+  const nvg = softwareFrame(nvg => (fills = nvg.Rects(rects, colors)));
+  assert(fills === 2, `fills: ${fills}`);
+  assert(nvg.stats[STAT_FILLS] === 2, `stats fills: ${nvg.stats[STAT_FILLS]}`);
+  /* BeginFrame Rects EndFrame */
+  assert(nvg.stats[STAT_CALLS] === 3, `one binding call: ${nvg.stats[STAT_CALLS]}`);
+  assert(pixelAt(nvg, 1, 8).join() === '255,0,0,255' && pixelAt(nvg, 14, 8).join() === '255,0,0,255', 'red');
+  assert(pixelAt(nvg, 5, 8).join() === '0,0,255,255', 'blue over the first red item');
+  /* the last red item was drawn with its group, beneath the blue one */
+  assert(pixelAt(nvg, 10, 8).join() === '0,0,255,255', `reordered across colours: ${pixelAt(nvg, 10, 8)}`);
+  DeleteSoftware(nvg);
+});
+
+safe('colors needs 4 floats per item', () => {
+  const nvg = softwareFrame(nvg => {
+    let threw = false;
+    try {
+      nvg.Circles(new Float32Array([4, 4, 2, 12, 12, 2]), new Float32Array(7));
+    } catch(e) {
+      threw = e instanceof RangeError;
+    }
+    assert(threw, 'short colors throws RangeError');
+    assert(nvg.Circles(new Float32Array([4, 4, 2]), new Float32Array([0, 1, 0, 1])) === 1, 'exact length');
+  });
+  DeleteSoftware(nvg);
+});
+
+/* ------------------------------------------------------------------ *
+ * Group U — headless GL and pixel read-back                          *
+ * ------------------------------------------------------------------ */
+function headlessOrSkip(w, h) {
+  try {
+    return CreateHeadless(w, h);
+  } catch(e) {
+    console.log('skipped, no headless GL:', e.message);
+    return null;
+  }
+}
+
+/* red top half, blue bottom half */
+function twoBands(nvg) {
+  nvg.BeginFrame(16, 16, 1);
+  nvg.BeginPath();
+  nvg.Rect(0, 0, 16, 8);
+  nvg.FillColor(RGB(255, 0, 0));
+  nvg.Fill();
+  nvg.BeginPath();
+  nvg.Rect(0, 8, 16, 8);
+  nvg.FillColor(RGB(0, 0, 255));
+  nvg.Fill();
+  nvg.EndFrame();
+}
+
+/* ReadPixels rows are bottom-up: the first pixel is blue, the last red */
+function bandsRead(buf) {
+  const b = new Uint8Array(buf.buffer ?? buf);
+  return b.slice(0, 4).join() === '0,0,255,255' && b.slice(-4).join() === '255,0,0,255';
+}
+
+safe('ReadPixels reads the framebuffer into a caller Uint8Array', () => {
+  const hl = headlessOrSkip(16, 16);
+  if(!hl) return;
+  twoBands(hl.context);
+  const target = new Uint8Array(16 * 16 * 4);
+  assert(ReadPixels(0, 0, 16, 16, target) === target && bandsRead(target), `into target: ${target.slice(0, 4)}`);
+  assert(ReadPixels(16, 16, new Uint8Array(target.length)).byteLength === target.length, 'origin form');
+  const region = ReadPixels(4, 4, 2, 2);
+  assert(region instanceof ArrayBuffer && region.byteLength === 16, 'new ArrayBuffer');
+  assert(hl.ReadPixels(target) === target && bandsRead(target), 'handle method');
+  for(const [name, fn] of [
+    ['short target', () => ReadPixels(0, 0, 16, 16, new Uint8Array(target.length - 1))],
+    ['negative size', () => ReadPixels(-1, 4)],
+    ['short async target', () => hl.ReadPixelsAsync(new Uint8Array(16))],
+  ]) {
+    let threw = false;
+    try {
+      fn();
+    } catch(e) {
+      threw = e instanceof RangeError;
+    }
+    assert(threw, `${name} throws RangeError`);
+  }
+  DeleteHeadless(hl);
+});
+
+safeAsync('ReadPixelsAsync resolves once EndFrame or Poll sees the fence', async () => {
+  const hl = headlessOrSkip(16, 16);
+  if(!hl) return;
+  twoBands(hl.context);
+  const target = new Uint8Array(16 * 16 * 4);
+  /* four reads: the fourth waits for the oldest of the three buffers */
+  const reads = [hl.ReadPixelsAsync(target), hl.ReadPixelsAsync(), hl.ReadPixelsAsync(), hl.ReadPixelsAsync()];
+  assert(reads.every(p => p instanceof Promise), 'promises');
+  twoBands(hl.context);
+  while(Poll(Infinity) > 0);
+  const [first, ...rest] = await Promise.all(reads);
+  assert(first === target && bandsRead(target), 'resolved to the target');
+  assert(rest.every(b => b instanceof ArrayBuffer && b.byteLength === target.length && bandsRead(b)), 'new buffers');
+  DeleteHeadless(hl);
+});
+
+safe('CreateHeadless rejects an empty framebuffer', () => {
+  let threw = false;
+  try {
+    CreateHeadless(0, 16);
+  } catch(e) {
+    threw = e instanceof RangeError;
+  }
+  assert(threw, 'zero width throws RangeError');
+});
+
+safe('Headless handles describe their framebuffer and MakeCurrent switches between them', () => {
+  const a = headlessOrSkip(16, 16);
+  if(!a) return;
+  assert(a.width === 16 && a.height === 16 && a.fbo > 0, `size and fbo: ${a.width}x${a.height} ${a.fbo}`);
+  assert(['egl', 'osmesa'].includes(a.backend), `backend: ${a.backend}`);
+  assert(a.context.headless === a, 'context points back to the handle');
+  twoBands(a.context);
+  /* creating b makes it current: draw into it without MakeCurrent */
+  const b = CreateHeadless(16, 16);
+  b.context.BeginFrame(16, 16, 1);
+  b.context.BeginPath();
+  b.context.Rect(0, 0, 16, 16);
+  b.context.FillColor(RGB(0, 255, 0));
+  b.context.Fill();
+  b.context.EndFrame();
+  const px = () => new Uint8Array(ReadPixels(0, 0, 1, 1)).join();
+  assert(px() === '0,255,0,255', `b is current: ${px()}`);
+  a.MakeCurrent();
+  assert(px() === '0,0,255,255', `a after MakeCurrent: ${px()}`);
+  b.MakeCurrent();
+  assert(px() === '0,255,0,255', `b after MakeCurrent: ${px()}`);
+  DeleteHeadless(b);
+  DeleteHeadless(a);
+});
+
+safe('DeleteHeadless detaches the Context and the handle', () => {
+  const hl = headlessOrSkip(16, 16);
+  if(!hl) return;
+  const nvg = hl.context;
+  DeleteHeadless(hl);
+  const error = fn => {
+    try {
+      fn();
+    } catch(e) {
+      return e.constructor.name;
+    }
+    return 'nothing';
+  };
+  assert(error(() => nvg.BeginFrame(16, 16, 1)) === 'TypeError', 'Context method after delete');
+  assert(error(() => nvg.Rect(0, 0, 1, 1)) === 'TypeError', 'path method after delete');
+  assert(error(() => hl.width) === 'ReferenceError', 'handle getter after delete');
+  assert(error(() => hl.MakeCurrent()) === 'ReferenceError', 'MakeCurrent after delete');
+  assert(error(() => hl.ReadPixels()) === 'ReferenceError', 'ReadPixels after delete');
+  assert(DeleteHeadless(hl) === undefined, 'deleting twice is a no-op');
+});
+
+safe('Headless handles and their Context are collected together', () => {
+  const first = headlessOrSkip(16, 16);
+  if(!first) return;
+  let threw = false;
+  try {
+    DeleteGL3(first.context);
+  } catch(e) {
+    threw = e instanceof TypeError;
+  }
+  assert(threw, 'DeleteGL3 of a headless context throws TypeError');
+  /* dropped with a frame drawn: the GC finalizes the pair in either order */
+  for(let i = 0; i < 4; i++) twoBands(CreateHeadless(16, 16).context);
+  std.gc();
+  /* the Context keeps its handle alive */
+  const nvg = CreateHeadless(16, 16).context;
+  std.gc();
+  nvg.headless.MakeCurrent();
+  twoBands(nvg);
+  assert(bandsRead(nvg.headless.ReadPixels()), 'Context without a reference to the handle');
+  DeleteHeadless(nvg.headless);
+  DeleteHeadless(first);
+});
+
+/* ------------------------------------------------------------------ *
+ * Group V — SVG output                                               *
+ * ------------------------------------------------------------------ */
+function svgDocument(output, draw) {
+  const nvg = CreateSVG(64, 48, output);
+  nvg.BeginFrame(64, 48, 1);
+  draw(nvg);
+  nvg.EndFrame();
+  return DeleteSVG(nvg);
+}
+
+function translucentRect(nvg) {
+  nvg.BeginPath();
+  nvg.Rect(10, 10, 20, 10);
+  nvg.FillColor(RGBA(255, 0, 0, 128));
+  nvg.Fill();
+}
+
+const svgText = buf => String.fromCharCode(...new Uint8Array(buf));
+
+safe('CreateSVG collects a well-formed document in memory', () => {
+  const buf = svgDocument(undefined, translucentRect);
+  assert(buf instanceof ArrayBuffer, 'DeleteSVG returns an ArrayBuffer');
+  const text = svgText(buf);
+  assert(text.startsWith('<?xml version="1.0" encoding="UTF-8"?>\n<svg '), 'XML declaration and root element');
+  assert(/<svg [^>]*width="64" height="48" viewBox="0 0 64 48">/.test(text), 'size and viewBox');
+  assert(text.endsWith('</svg>\n') && text.split('<svg ').length === 2, 'closed once');
+  assert(
+    text.includes('<path d="M10 10 10 20 30 20 30 10Z" fill="#ff0000" fill-opacity="0.502"/>'),
+    `path data and colour: ${text}`,
+  );
+});
+
+safe('CreateSVG puts a linear gradient in <defs> in user space', () => {
+  const text = svgText(
+    svgDocument(undefined, nvg => {
+      nvg.BeginPath();
+      nvg.Rect(10, 10, 20, 10);
+      nvg.FillPaint(nvg.LinearGradient(10, 0, 30, 0, RGB(255, 0, 0), RGB(0, 0, 255)));
+      nvg.Fill();
+    }),
+  );
+  const m = /<defs><linearGradient id="(p\d+)" gradientUnits="userSpaceOnUse" ([^>]*)>(.*?)<\/linearGradient><\/defs>/.exec(
+    text,
+  );
+  assert(m, `linearGradient in defs: ${text}`);
+  assert(m && m[2] === 'x1="10" y1="0" x2="30" y2="0"', `end points: ${m && m[2]}`);
+  assert(
+    m && m[3] === '<stop offset="0" stop-color="#ff0000"/><stop offset="1" stop-color="#0000ff"/>',
+    `stops: ${m && m[3]}`,
+  );
+  assert(m && text.includes(`<path d="M10 10 10 20 30 20 30 10Z" fill="url(#${m[1]})"/>`), 'path refers to it');
+});
+
+safe('CreateSVG turns the scissor into a clipPath', () => {
+  const text = svgText(
+    svgDocument(undefined, nvg => {
+      nvg.Scissor(20, 10, 10, 10);
+      translucentRect(nvg);
+      translucentRect(nvg);
+    }),
+  );
+  const m = /<defs><clipPath id="(c\d+)"><rect ([^>]*)\/><\/clipPath><\/defs>/.exec(text);
+  assert(m, `clipPath in defs: ${text}`);
+  assert(
+    m && m[2] === 'x="-5" y="-5" width="10" height="10" transform="matrix(1 0 0 1 25 15)"',
+    `scissor box: ${m && m[2]}`,
+  );
+  assert(text.split('<clipPath').length === 2, 'written once for an unchanged scissor');
+  assert(m && text.split(`clip-path="url(#${m[1]})"`).length === 3, 'both paths clipped');
+});
+
+safe('CreateSVG writes to a file name or descriptor and DeleteSVG returns the byte count', () => {
+  const expected = svgText(svgDocument(undefined, translucentRect));
+  const path = `/tmp/qjs-nanovg-${Date.now()}.svg`;
+  const written = svgDocument(path, translucentRect);
+  assert(written === expected.length && std.loadFile(path) === expected, `file name: ${written} bytes`);
+  const fd = os.open(path, os.O_WRONLY | os.O_TRUNC);
+  assert(svgDocument(fd, translucentRect) === expected.length, 'file descriptor');
+  assert(os.close(fd) === 0, 'descriptor left open');
+  assert(std.loadFile(path) === expected, 'same document');
+  os.remove(path);
+  let threw = false;
+  try {
+    DeleteSVG(CreateSoftware(4, 4));
+  } catch(e) {
+    threw = e instanceof TypeError;
+  }
+  assert(threw, 'DeleteSVG of another context throws TypeError');
+});
+
+while(Poll(Infinity) > 0);
+
+/* ------------------------------------------------------------------ */
+Promise.all(pending).then(() => {
+  console.log(`\nRESULTS: ${passed} passed, ${failed} failed`);
+  if(failed > 0) {
+    console.log('Failures:');
+    for(const f of failures) console.log('  -', f);
+    std.exit(1);
+  }
+});
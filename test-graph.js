@@ -4,11 +4,12 @@
 // random walk; ticks are aggregated into OHLC candles (one per `CANDLE_MS`),
 // exactly as a real feed would be. Run with: qjsm test-graph.js
 //
-// Press 's' to save the current frame to a PPM image (forex-<timestamp>.ppm).
+// Press 's' to save the current frame to a PNG image (forex-<timestamp>.png)
+// and 'v' to export it as vector graphics (forex-<timestamp>.svg): the same
+// draw() runs once more against an SVG context instead of the GL one.
 
 import * as glfw from 'glfw';
-import * as std from 'std';
-import { ALIGN_BOTTOM, ALIGN_LEFT, ALIGN_MIDDLE, ALIGN_RIGHT, ALIGN_TOP, ANTIALIAS, CreateGL3, DeleteGL3, ReadPixels, RGB, RGBA, STENCIL_STROKES } from 'nanovg';
+import { ALIGN_BOTTOM, ALIGN_LEFT, ALIGN_MIDDLE, ALIGN_RIGHT, ALIGN_TOP, ANTIALIAS, CreateGL3, CreateSVG, DeleteGL3, DeleteSVG, ReadPixelsAsync, RGB, RGBA, SaveImage, STENCIL_STROKES } from 'nanovg';
 
 const SYMBOL = 'EUR/USD';
 const CANDLE_MS = 1000; // duration of one candle
@@ -51,18 +52,21 @@ function main() {
   const window = (glfw.context.current = new glfw.Window(1024, 640, `Forex — ${SYMBOL}`));
   const { width, height } = window.size;
 
-  const nvg = CreateGL3(STENCIL_STROKES | ANTIALIAS);
+  let nvg = CreateGL3(STENCIL_STROKES | ANTIALIAS);
 
   // Load a font for the axis/HUD labels; degrade gracefully if unavailable.
-  let font = -1;
-  for(let path of ['/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf', '/usr/share/fonts/TTF/DejaVuSans.ttf', '/usr/share/fonts/dejavu/DejaVuSans.ttf']) {
-    if((font = nvg.CreateFont('sans', path)) >= 0) break;
+  function loadFont() {
+    for(let path of ['/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf', '/usr/share/fonts/TTF/DejaVuSans.ttf', '/usr/share/fonts/dejavu/DejaVuSans.ttf']) {
+      if(nvg.CreateFont('sans', path) >= 0) return true;
+    }
+    return false;
   }
-  const hasText = font >= 0;
+  const hasText = loadFont();
 
   // ---- Simulated price feed -------------------------------------------------
   let price = 1.1;
   const candles = [];
+  const ohlc = new Float32Array((MAX_CANDLES + 1) * 4);
 
   // Seed some history so the chart starts populated.
   for(let k = 0; k < MAX_CANDLES * 0.5; k++) {
@@ -80,12 +84,14 @@ function main() {
 
   let paused = false;
   let wantShot = false; // set on 's', consumed in the render loop
+  let wantSVG = false; // set on 'v'
 
   Object.assign(window, {
     handleKey(keyCode, scancode, action, mods) {
       if(!action) return;
       if(keyCode === glfw.KEY_ESCAPE || keyCode === glfw.KEY_Q) running = false;
       if(keyCode === glfw.KEY_S) wantShot = true;
+      if(keyCode === glfw.KEY_V) wantSVG = true;
     },
     handleCharMods(charCode) {
       if(String.fromCodePoint(charCode) === ' ') paused = !paused;
@@ -103,34 +109,46 @@ function main() {
     nvg.Text(x, y, str);
   }
 
-  // Grab the rendered frame and write it as a binary PPM (P6). ReadPixels
-  // returns RGBA bytes with a bottom-left origin, so rows are flipped here.
+  // Grab the rendered frame and save it as PNG. The read is queued into a
+  // pixel buffer object and lands in `capture` on a later EndFrame; encoding
+  // and writing happen on the module's worker thread, so the render loop never
+  // waits. ReadPixels rows are bottom-up, hence flipY.
+  let capture = null;
+  let capturing = false;
+
   function saveScreenshot() {
-    const rgba = new Uint8Array(ReadPixels(width, height));
-    const body = new Uint8Array(width * height * 3);
-
-    for(let y = 0; y < height; y++) {
-      const srcRow = (height - 1 - y) * width;
-      const dstRow = y * width;
-      for(let x = 0; x < width; x++) {
-        const s = (srcRow + x) * 4;
-        const d = (dstRow + x) * 3;
-        body[d] = rgba[s];
-        body[d + 1] = rgba[s + 1];
-        body[d + 2] = rgba[s + 2];
-      }
-    }
+    if(capturing) return;
+
+    if(!capture || capture.length != width * height * 4) capture = new Uint8Array(width * height * 4);
 
-    const name = `forex-${Date.now()}.ppm`;
-    const f = std.open(name, 'wb');
-    if(!f) {
-      console.log('screenshot: could not open', name);
-      return;
+    const name = `forex-${Date.now()}.png`;
+
+    capturing = true;
+    ReadPixelsAsync(0, 0, width, height, capture)
+      .then(rgba => SaveImage(name, rgba, width, height, { flipY: true }))
+      .then(() => console.log('screenshot saved:', name))
+      .catch(e => console.log('screenshot:', e.message))
+      .finally(() => (capturing = false));
+  }
+
+  // Render the current frame once more into an SVG file. draw() only knows
+  // `nvg`, so swapping the context is all it takes; fonts are per context.
+  function exportSVG() {
+    const gl = nvg;
+    const name = `forex-${Date.now()}.svg`;
+
+    try {
+      nvg = CreateSVG(width, height, name);
+      if(hasText) loadFont();
+      nvg.BeginFrame(width, height, 1);
+      draw();
+      nvg.EndFrame();
+      console.log('SVG saved:', name, DeleteSVG(nvg), 'bytes');
+    } catch(e) {
+      console.log('SVG export:', e.message);
+    } finally {
+      nvg = gl;
     }
-    f.puts(`P6\n${width} ${height}\n255\n`);
-    f.write(body.buffer, 0, body.byteLength);
-    f.close();
-    console.log('screenshot saved:', name);
   }
 
   function draw() {
@@ -173,31 +191,14 @@ function main() {
       text(M.left + plotW + 6, y, p.toFixed(5), { align: ALIGN_LEFT | ALIGN_MIDDLE });
     }
 
-    // Candles.
+    // Candles: wicks and bodies in one native call, one pass per colour.
     for(let i = 0; i < candles.length; i++) {
       const c = candles[i];
-      const x = xOf(i);
-      const bull = c.close >= c.open;
-      const color = bull ? COL.bull : COL.bear;
-
-      // Wick (high -> low).
-      nvg.BeginPath();
-      nvg.MoveTo(x, yOf(c.high));
-      nvg.LineTo(x, yOf(c.low));
-      nvg.StrokeColor(color);
-      nvg.StrokeWidth(1);
-      nvg.Stroke();
-
-      // Body (open <-> close).
-      const yo = yOf(c.open);
-      const yc = yOf(c.close);
-      const top = Math.min(yo, yc);
-      const h = Math.max(1, Math.abs(yc - yo));
-      nvg.BeginPath();
-      nvg.Rect(x - bodyW / 2, top, bodyW, h);
-      nvg.FillColor(color);
-      nvg.Fill();
+      ohlc.set([c.open, c.high, c.low, c.close], i * 4);
     }
+    const yScale = -plotH / (hi - lo);
+    nvg.StrokeWidth(1);
+    nvg.Candles(ohlc, candles.length, xOf(0), slotW, yScale, yOf(0), COL.bull, COL.bear, bodyW);
 
     // Last-price marker line + label.
     const lastY = yOf(price);
@@ -226,7 +227,7 @@ function main() {
       color: paused ? COL.last : COL.bull,
       align: ALIGN_RIGHT | ALIGN_TOP,
     });
-    text(M.left + 4, height - 8, 'space: pause/resume    s: screenshot    q/esc: quit', { size: 11 });
+    text(M.left + 4, height - 8, 'space: pause/resume    s: screenshot    v: SVG    q/esc: quit', { size: 11 });
   }
 
   while((running &&= !window.shouldClose)) {
@@ -251,6 +252,11 @@ function main() {
       wantShot = false;
     }
 
+    if(wantSVG) {
+      exportSVG();
+      wantSVG = false;
+    }
+
     window.swapBuffers();
     glfw.poll();
   }